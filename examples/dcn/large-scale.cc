@@ -4,28 +4,11 @@
 #include "ns3/point-to-point-module.h"
 #include "ns3/applications-module.h"
 #include "ns3/flow-monitor-module.h"
-#include "ns3/ipv4-global-routing-helper.h"
 #include "ns3/traffic-control-module.h"
 
-#include <vector>
-#include <map>
-#include <utility>
-#include <set>
+#include <sstream>
 
-// The CDF in TrafficGenerator
-extern "C"
-{
-#include "cdf.h"
-}
-
-#define LINK_CAPACITY_BASE    1000000000          // 1Gbps
-#define BUFFER_SIZE 250                           // 250 packets
-
-// The flow port range, each flow will be assigned a random port number within this range
-
-static uint16_t PORT = 1000;
-
-#define PACKET_SIZE 1400
+#include "leaf-spine.h"
 
 using namespace ns3;
 
@@ -36,125 +19,11 @@ enum AQM {
   ECNSharp
 };
 
-// Acknowledged to https://github.com/HKUST-SING/TrafficGenerator/blob/master/src/common/common.c
-double poission_gen_interval(double avg_rate)
-{
-  if (avg_rate > 0)
-    return -logf(1.0 - (double)rand() / RAND_MAX) / avg_rate;
-  else
-    return 0;
-}
-
-template<typename T>
-T rand_range (T min, T max)
-{
-  return min + ((double)max - min) * rand () / RAND_MAX;
-}
-
-void install_incast_applications (NodeContainer servers, long &flowCount, int SERVER_COUNT, int LEAF_COUNT, double START_TIME, double END_TIME, double FLOW_LAUNCH_END_TIME)
-{
-  NS_LOG_INFO ("Install incast applications:");
-  for (int i = 0; i < SERVER_COUNT; i++)
-    {
-      Ptr<Node> destServer = servers.Get (i);
-      Ptr<Ipv4> ipv4 = destServer->GetObject<Ipv4> ();
-      Ipv4InterfaceAddress destInterface = ipv4->GetAddress (1,0);
-      Ipv4Address destAddress = destInterface.GetLocal ();
-
-      uint32_t fanout = rand () % 50 + 100;
-      for (uint32_t j = 0; j < fanout; j++)
-        {
-          double startTime = START_TIME + static_cast<double> (rand () % 100) / 1000000;
-          while (startTime < FLOW_LAUNCH_END_TIME)
-            {
-              flowCount ++;
-              uint32_t fromServerIndex = rand () % SERVER_COUNT;
-              uint16_t port = PORT++;
-
-              BulkSendHelper source ("ns3::TcpSocketFactory", InetSocketAddress (destAddress, port));
-              uint32_t flowSize = rand () % 10000;
-              uint32_t tos = rand() % 5;
-
-              source.SetAttribute ("SendSize", UintegerValue (PACKET_SIZE));
-              source.SetAttribute ("MaxBytes", UintegerValue(flowSize));
-              source.SetAttribute ("SimpleTOS", UintegerValue (tos));
-
-              // Install apps
-              ApplicationContainer sourceApp = source.Install (servers.Get (fromServerIndex));
-              sourceApp.Start (Seconds (startTime));
-              sourceApp.Stop (Seconds (END_TIME));
-
-              // Install packet sinks
-              PacketSinkHelper sink ("ns3::TcpSocketFactory",
-                                     InetSocketAddress (Ipv4Address::GetAny (), port));
-              ApplicationContainer sinkApp = sink.Install (servers. Get (i));
-              sinkApp.Start (Seconds (START_TIME));
-              sinkApp.Stop (Seconds (END_TIME));
-
-              startTime += static_cast<double> (rand () % 1000) / 1000000;
-            }
-
-        }
-
-    }
-}
-
-void install_applications (int fromLeafId, NodeContainer servers, double requestRate, struct cdf_table *cdfTable,
-                           long &flowCount, long &totalFlowSize, int SERVER_COUNT, int LEAF_COUNT, double START_TIME, double END_TIME, double FLOW_LAUNCH_END_TIME)
-{
-  NS_LOG_INFO ("Install applications:");
-  for (int i = 0; i < SERVER_COUNT; i++)
-    {
-      int fromServerIndex = fromLeafId * SERVER_COUNT + i;
-
-      double startTime = START_TIME + poission_gen_interval (requestRate);
-      while (startTime < FLOW_LAUNCH_END_TIME)
-        {
-          flowCount ++;
-          uint16_t port = PORT++;
-
-          int destServerIndex = fromServerIndex;
-          while (destServerIndex >= fromLeafId * SERVER_COUNT && destServerIndex < fromLeafId * SERVER_COUNT + SERVER_COUNT)
-            {
-              destServerIndex = rand_range (0, SERVER_COUNT * LEAF_COUNT);
-            }
-
-          Ptr<Node> destServer = servers.Get (destServerIndex);
-          Ptr<Ipv4> ipv4 = destServer->GetObject<Ipv4> ();
-          Ipv4InterfaceAddress destInterface = ipv4->GetAddress (1,0);
-          Ipv4Address destAddress = destInterface.GetLocal ();
-
-          BulkSendHelper source ("ns3::TcpSocketFactory", InetSocketAddress (destAddress, port));
-          uint32_t flowSize = gen_random_cdf (cdfTable);
-          uint32_t tos = rand() % 5;
-
-          totalFlowSize += flowSize;
-
-          source.SetAttribute ("SendSize", UintegerValue (PACKET_SIZE));
-          source.SetAttribute ("MaxBytes", UintegerValue(flowSize));
-          source.SetAttribute ("SimpleTOS", UintegerValue (tos));
-
-          // Install apps
-          ApplicationContainer sourceApp = source.Install (servers.Get (fromServerIndex));
-          sourceApp.Start (Seconds (startTime));
-          sourceApp.Stop (Seconds (END_TIME));
-
-          // Install packet sinks
-          PacketSinkHelper sink ("ns3::TcpSocketFactory",
-                                 InetSocketAddress (Ipv4Address::GetAny (), port));
-          ApplicationContainer sinkApp = sink.Install (servers. Get (destServerIndex));
-          sinkApp.Start (Seconds (START_TIME));
-          sinkApp.Stop (Seconds (END_TIME));
-
-          startTime += poission_gen_interval (requestRate);
-        }
-    }
-}
-
 int main (int argc, char *argv[])
 {
 #if 1
   LogComponentEnable ("LargeScale", LOG_LEVEL_INFO);
+  LogComponentEnable ("LeafSpine", LOG_LEVEL_INFO);
 #endif
 
   // Command line parameters parsing
@@ -166,6 +35,9 @@ int main (int argc, char *argv[])
 
   std::string aqmStr = "ECNSharp";
 
+  std::string runModeStr = "ECMP";
+  double congaTableInterval = 0.0;
+
   // The simulation starting and ending time
   double START_TIME = 0.0;
   double END_TIME = 0.5;
@@ -209,6 +81,9 @@ int main (int argc, char *argv[])
 
   cmd.AddValue ("AQM", "AQM to use: TCN or ECNSharp", aqmStr);
 
+  cmd.AddValue ("runMode", "Load balancing scheme: ECMP or Conga", runModeStr);
+  cmd.AddValue ("congaTableInterval", "Interval of the Conga table dumps in seconds, 0 to disable", congaTableInterval);
+
   cmd.AddValue ("TCNThreshold", "The threshold for TCN", TCNThreshold);
 
   cmd.AddValue ("ECNShaprInterval", "The persistent interval for ECNSharp", ECNSharpInterval);
@@ -242,6 +117,20 @@ int main (int argc, char *argv[])
       return 0;
     }
 
+  RunMode runMode;
+  if (runModeStr.compare ("ECMP") == 0)
+    {
+      runMode = ECMP;
+    }
+  else if (runModeStr.compare ("Conga") == 0)
+    {
+      runMode = Conga;
+    }
+  else
+    {
+      return 0;
+    }
+
   if (transportProt.compare ("DcTcp") == 0)
     {
       NS_LOG_INFO ("Enabling DcTcp");
@@ -274,145 +163,29 @@ int main (int argc, char *argv[])
 
   Config::SetDefault ("ns3::Ipv4GlobalRouting::PerflowEcmpRouting", BooleanValue(true));
 
-  NodeContainer spines;
-  spines.Create (SPINE_COUNT);
-  NodeContainer leaves;
-  leaves.Create (LEAF_COUNT);
-  NodeContainer servers;
-  servers.Create (SERVER_COUNT * LEAF_COUNT);
-
-  NS_LOG_INFO ("Install Internet stacks");
-  InternetStackHelper internet;
-  Ipv4GlobalRoutingHelper globalRoutingHelper;
-
-  internet.SetRoutingHelper (globalRoutingHelper);
-
-
-  internet.Install (servers);
-  internet.Install (spines);
-  internet.Install (leaves);
-
-  NS_LOG_INFO ("Install channels and assign addresses");
-
-  PointToPointHelper p2p;
-  Ipv4AddressHelper ipv4;
-
-  NS_LOG_INFO ("Configuring servers");
-  // Setting servers
-  p2p.SetDeviceAttribute ("DataRate", DataRateValue (DataRate (LEAF_SERVER_CAPACITY)));
-  p2p.SetChannelAttribute ("Delay", TimeValue(LINK_LATENCY));
-  p2p.SetQueue ("ns3::DropTailQueue", "MaxPackets", UintegerValue (10));
-
-  ipv4.SetBase ("10.1.0.0", "255.255.255.0");
-
-  for (int i = 0; i < LEAF_COUNT; i++)
+  ObjectFactory aqmFactory;
+  if (aqm == TCN)
     {
-      ipv4.NewNetwork ();
-
-      for (int j = 0; j < SERVER_COUNT; j++)
-        {
-          int serverIndex = i * SERVER_COUNT + j;
-          NodeContainer nodeContainer = NodeContainer (leaves.Get (i), servers.Get (serverIndex));
-          NetDeviceContainer netDeviceContainer = p2p.Install (nodeContainer);
-
-          //TODO We should change this, at endhost we are not going to mark ECN but add delay using delay queue disc
-
-          Ptr<DelayQueueDisc> delayQueueDisc = CreateObject<DelayQueueDisc> ();
-          Ptr<Ipv4SimplePacketFilter> filter = CreateObject<Ipv4SimplePacketFilter> ();
-
-          delayQueueDisc->AddPacketFilter (filter);
-
-          delayQueueDisc->AddDelayClass (0, MicroSeconds (1));
-          delayQueueDisc->AddDelayClass (1, MicroSeconds (20));
-          delayQueueDisc->AddDelayClass (2, MicroSeconds (50));
-          delayQueueDisc->AddDelayClass (3, MicroSeconds (80));
-          delayQueueDisc->AddDelayClass (4, MicroSeconds (160));
-
-          ObjectFactory switchSideQueueFactory;
-
-          if (aqm == TCN)
-            {
-              switchSideQueueFactory.SetTypeId ("ns3::TCNQueueDisc");
-            }
-          else
-            {
-              switchSideQueueFactory.SetTypeId ("ns3::ECNSharpQueueDisc");
-            }
-          Ptr<QueueDisc> switchSideQueueDisc = switchSideQueueFactory.Create<QueueDisc> ();
-
-          Ptr<NetDevice> netDevice0 = netDeviceContainer.Get (0);
-          Ptr<TrafficControlLayer> tcl0 = netDevice0->GetNode ()->GetObject<TrafficControlLayer> ();
-
-          delayQueueDisc->SetNetDevice (netDevice0);
-          tcl0->SetRootQueueDiscOnDevice (netDevice0, delayQueueDisc);
-
-          Ptr<NetDevice> netDevice1 = netDeviceContainer.Get (1);
-          Ptr<TrafficControlLayer> tcl1 = netDevice1->GetNode ()->GetObject<TrafficControlLayer> ();
-          switchSideQueueDisc->SetNetDevice (netDevice1);
-          tcl1->SetRootQueueDiscOnDevice (netDevice1, switchSideQueueDisc);
-
-          Ipv4InterfaceContainer interfaceContainer = ipv4.Assign (netDeviceContainer);
-
-          NS_LOG_INFO ("Leaf - " << i << " is connected to Server - " << j << " with address "
-                       << interfaceContainer.GetAddress(0) << " <-> " << interfaceContainer.GetAddress (1)
-                       << " with port " << netDeviceContainer.Get (0)->GetIfIndex () << " <-> " << netDeviceContainer.Get (1)->GetIfIndex ());
-        }
+      aqmFactory.SetTypeId ("ns3::TCNQueueDisc");
     }
-
-  NS_LOG_INFO ("Configuring switches");
-  // Setting up switches
-  p2p.SetDeviceAttribute ("DataRate", DataRateValue (DataRate (SPINE_LEAF_CAPACITY)));
-
-  for (int i = 0; i < LEAF_COUNT; i++)
+  else
     {
-      for (int j = 0; j < SPINE_COUNT; j++)
-        {
-
-          for (int l = 0; l < LINK_COUNT; l++)
-            {
-              ipv4.NewNetwork ();
-
-              NodeContainer nodeContainer = NodeContainer (leaves.Get (i), spines.Get (j));
-              NetDeviceContainer netDeviceContainer = p2p.Install (nodeContainer);
-              ObjectFactory switchSideQueueFactory;
-
-              if (aqm == TCN)
-                {
-                  switchSideQueueFactory.SetTypeId ("ns3::TCNQueueDisc");
-                }
-              else
-                {
-                  switchSideQueueFactory.SetTypeId ("ns3::ECNSharpQueueDisc");
-                }
-
-              Ptr<QueueDisc> leafQueueDisc = switchSideQueueFactory.Create<QueueDisc> ();
-
-              Ptr<NetDevice> netDevice0 = netDeviceContainer.Get (0);
-              Ptr<TrafficControlLayer> tcl0 = netDevice0->GetNode ()->GetObject<TrafficControlLayer> ();
-              leafQueueDisc->SetNetDevice (netDevice0);
-              tcl0->SetRootQueueDiscOnDevice (netDevice0, leafQueueDisc);
-
-              Ptr<QueueDisc> spineQueueDisc = switchSideQueueFactory.Create<QueueDisc> ();
-
-              Ptr<NetDevice> netDevice1 = netDeviceContainer.Get (1);
-              Ptr<TrafficControlLayer> tcl1 = netDevice1->GetNode ()->GetObject<TrafficControlLayer> ();
-              spineQueueDisc->SetNetDevice (netDevice1);
-              tcl1->SetRootQueueDiscOnDevice (netDevice1, spineQueueDisc);
-
+      aqmFactory.SetTypeId ("ns3::ECNSharpQueueDisc");
+    }
 
-              Ipv4InterfaceContainer ipv4InterfaceContainer = ipv4.Assign (netDeviceContainer);
-              NS_LOG_INFO ("Leaf - " << i << " is connected to Spine - " << j << " with address "
-                           << ipv4InterfaceContainer.GetAddress(0) << " <-> " << ipv4InterfaceContainer.GetAddress (1)
-                           << " with port " << netDeviceContainer.Get (0)->GetIfIndex () << " <-> " << netDeviceContainer.Get (1)->GetIfIndex ()
-                           << " with data rate " << spineLeafCapacity);
+  LeafSpine topology;
+  build_leaf_spine (topology, runMode, &aqmFactory, SERVER_COUNT, SPINE_COUNT, LEAF_COUNT, LINK_COUNT,
+                    LEAF_SERVER_CAPACITY, SPINE_LEAF_CAPACITY, LINK_LATENCY);
+  NodeContainer servers = topology.servers;
 
-            }
-        }
+  if (runMode == Conga && congaTableInterval > 0.0)
+    {
+      std::stringstream congaTableFilename;
+      congaTableFilename << "Large_Scale_" << id << "_Conga_Tables.txt";
+      Ptr<OutputStreamWrapper> congaTableStream = Create<OutputStreamWrapper> (congaTableFilename.str (), std::ios::out);
+      Ipv4RoutingHelper::PrintRoutingTableAllEvery (Seconds (congaTableInterval), congaTableStream);
     }
 
-  NS_LOG_INFO ("Populate global routing tables");
-  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
-
   double oversubRatio = static_cast<double>(SERVER_COUNT * LEAF_SERVER_CAPACITY) / (SPINE_LEAF_CAPACITY * SPINE_COUNT * LINK_COUNT);
   NS_LOG_INFO ("Over-subscription ratio: " << oversubRatio);
 
@@ -0,0 +1,335 @@
+#include "leaf-spine.h"
+
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/ipv4-global-routing-helper.h"
+#include "ns3/ipv4-static-routing-helper.h"
+#include "ns3/ipv4-conga-routing-helper.h"
+#include "ns3/traffic-control-module.h"
+
+#include <vector>
+#include <utility>
+
+// The flow port range, each flow will be assigned a random port number within this range
+
+static uint16_t PORT = 1000;
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("LeafSpine");
+
+static void
+install_aqm (const ObjectFactory *aqmFactory, Ptr<NetDevice> netDevice)
+{
+  if (aqmFactory == 0)
+    {
+      return;
+    }
+  Ptr<QueueDisc> queueDisc = aqmFactory->Create<QueueDisc> ();
+  Ptr<TrafficControlLayer> tcl = netDevice->GetNode ()->GetObject<TrafficControlLayer> ();
+  queueDisc->SetNetDevice (netDevice);
+  tcl->SetRootQueueDiscOnDevice (netDevice, queueDisc);
+}
+
+void build_leaf_spine (LeafSpine &topology, RunMode runMode, const ObjectFactory *aqmFactory,
+                       int SERVER_COUNT, int SPINE_COUNT, int LEAF_COUNT, int LINK_COUNT,
+                       uint64_t LEAF_SERVER_CAPACITY, uint64_t SPINE_LEAF_CAPACITY, Time LINK_LATENCY)
+{
+  NodeContainer &spines = topology.spines;
+  spines.Create (SPINE_COUNT);
+  NodeContainer &leaves = topology.leaves;
+  leaves.Create (LEAF_COUNT);
+  NodeContainer &servers = topology.servers;
+  servers.Create (SERVER_COUNT * LEAF_COUNT);
+
+  NS_LOG_INFO ("Install Internet stacks");
+  InternetStackHelper internet;
+  Ipv4GlobalRoutingHelper globalRoutingHelper;
+  Ipv4StaticRoutingHelper staticRoutingHelper;
+  Ipv4CongaRoutingHelper congaRoutingHelper;
+
+  if (runMode == Conga)
+    {
+      // Servers use a default route to their leaf, switches run Conga
+      internet.SetRoutingHelper (staticRoutingHelper);
+      internet.Install (servers);
+
+      internet.SetRoutingHelper (congaRoutingHelper);
+      internet.Install (spines);
+      internet.Install (leaves);
+    }
+  else
+    {
+      internet.SetRoutingHelper (globalRoutingHelper);
+
+      internet.Install (servers);
+      internet.Install (spines);
+      internet.Install (leaves);
+    }
+
+  // Used to set up the Conga routes
+  std::vector<Ipv4Address> serverAddresses (SERVER_COUNT * LEAF_COUNT);
+  std::vector<uint32_t> serverPorts (SERVER_COUNT * LEAF_COUNT);
+  std::vector<Ipv4Address> leafNetworks (LEAF_COUNT);
+  std::vector<std::vector<std::pair<int, uint32_t> > > leafUplinks (LEAF_COUNT);
+  std::vector<std::vector<std::pair<int, uint32_t> > > spineDownlinks (SPINE_COUNT);
+
+  NS_LOG_INFO ("Install channels and assign addresses");
+
+  PointToPointHelper p2p;
+  Ipv4AddressHelper ipv4;
+
+  NS_LOG_INFO ("Configuring servers");
+  // Setting servers
+  p2p.SetDeviceAttribute ("DataRate", DataRateValue (DataRate (LEAF_SERVER_CAPACITY)));
+  p2p.SetChannelAttribute ("Delay", TimeValue(LINK_LATENCY));
+  p2p.SetQueue ("ns3::DropTailQueue", "MaxPackets", UintegerValue (10));
+
+  ipv4.SetBase ("10.1.0.0", "255.255.255.0");
+
+  for (int i = 0; i < LEAF_COUNT; i++)
+    {
+      ipv4.NewNetwork ();
+
+      for (int j = 0; j < SERVER_COUNT; j++)
+        {
+          int serverIndex = i * SERVER_COUNT + j;
+          NodeContainer nodeContainer = NodeContainer (leaves.Get (i), servers.Get (serverIndex));
+          NetDeviceContainer netDeviceContainer = p2p.Install (nodeContainer);
+
+          //TODO We should change this, at endhost we are not going to mark ECN but add delay using delay queue disc
+
+          Ptr<DelayQueueDisc> delayQueueDisc = CreateObject<DelayQueueDisc> ();
+          Ptr<Ipv4SimplePacketFilter> filter = CreateObject<Ipv4SimplePacketFilter> ();
+
+          delayQueueDisc->AddPacketFilter (filter);
+
+          delayQueueDisc->AddDelayClass (0, MicroSeconds (1));
+          delayQueueDisc->AddDelayClass (1, MicroSeconds (20));
+          delayQueueDisc->AddDelayClass (2, MicroSeconds (50));
+          delayQueueDisc->AddDelayClass (3, MicroSeconds (80));
+          delayQueueDisc->AddDelayClass (4, MicroSeconds (160));
+
+          Ptr<NetDevice> netDevice0 = netDeviceContainer.Get (0);
+          Ptr<TrafficControlLayer> tcl0 = netDevice0->GetNode ()->GetObject<TrafficControlLayer> ();
+
+          delayQueueDisc->SetNetDevice (netDevice0);
+          tcl0->SetRootQueueDiscOnDevice (netDevice0, delayQueueDisc);
+
+          install_aqm (aqmFactory, netDeviceContainer.Get (1));
+          topology.aqmDevices.Add (netDeviceContainer.Get (1));
+
+          Ipv4InterfaceContainer interfaceContainer = ipv4.Assign (netDeviceContainer);
+
+          serverAddresses[serverIndex] = interfaceContainer.GetAddress (1);
+          serverPorts[serverIndex] = interfaceContainer.Get (0).second;
+          leafNetworks[i] = interfaceContainer.GetAddress (0).CombineMask (Ipv4Mask ("255.255.255.0"));
+
+          if (runMode == Conga)
+            {
+              Ptr<Ipv4StaticRouting> serverRouting =
+                staticRoutingHelper.GetStaticRouting (servers.Get (serverIndex)->GetObject<Ipv4> ());
+              serverRouting->SetDefaultRoute (interfaceContainer.GetAddress (0), interfaceContainer.Get (1).second);
+            }
+
+          NS_LOG_INFO ("Leaf - " << i << " is connected to Server - " << j << " with address "
+                       << interfaceContainer.GetAddress(0) << " <-> " << interfaceContainer.GetAddress (1)
+                       << " with port " << netDeviceContainer.Get (0)->GetIfIndex () << " <-> " << netDeviceContainer.Get (1)->GetIfIndex ());
+        }
+    }
+
+  NS_LOG_INFO ("Configuring switches");
+  // Setting up switches
+  p2p.SetDeviceAttribute ("DataRate", DataRateValue (DataRate (SPINE_LEAF_CAPACITY)));
+
+  for (int i = 0; i < LEAF_COUNT; i++)
+    {
+      for (int j = 0; j < SPINE_COUNT; j++)
+        {
+
+          for (int l = 0; l < LINK_COUNT; l++)
+            {
+              ipv4.NewNetwork ();
+
+              NodeContainer nodeContainer = NodeContainer (leaves.Get (i), spines.Get (j));
+              NetDeviceContainer netDeviceContainer = p2p.Install (nodeContainer);
+
+              install_aqm (aqmFactory, netDeviceContainer.Get (0));
+              install_aqm (aqmFactory, netDeviceContainer.Get (1));
+              topology.aqmDevices.Add (netDeviceContainer);
+
+              Ipv4InterfaceContainer ipv4InterfaceContainer = ipv4.Assign (netDeviceContainer);
+              leafUplinks[i].push_back (std::make_pair (j, ipv4InterfaceContainer.Get (0).second));
+              spineDownlinks[j].push_back (std::make_pair (i, ipv4InterfaceContainer.Get (1).second));
+              NS_LOG_INFO ("Leaf - " << i << " is connected to Spine - " << j << " with address "
+                           << ipv4InterfaceContainer.GetAddress(0) << " <-> " << ipv4InterfaceContainer.GetAddress (1)
+                           << " with port " << netDeviceContainer.Get (0)->GetIfIndex () << " <-> " << netDeviceContainer.Get (1)->GetIfIndex ()
+                           << " with data rate " << SPINE_LEAF_CAPACITY);
+
+            }
+        }
+    }
+
+  if (runMode == Conga)
+    {
+      NS_LOG_INFO ("Configuring Conga routing");
+      for (int i = 0; i < LEAF_COUNT; i++)
+        {
+          Ptr<Ipv4CongaRouting> congaLeaf = congaRoutingHelper.GetCongaRouting (leaves.Get (i)->GetObject<Ipv4> ());
+          congaLeaf->SetLeafId (i);
+          congaLeaf->SetLinkCapacity (DataRate (SPINE_LEAF_CAPACITY));
+          for (int k = 0; k < SERVER_COUNT * LEAF_COUNT; k++)
+            {
+              congaLeaf->AddAddressToLeafIdMap (serverAddresses[k], k / SERVER_COUNT);
+            }
+
+          // Downlinks to the servers of the leaf
+          for (int j = 0; j < SERVER_COUNT; j++)
+            {
+              int serverIndex = i * SERVER_COUNT + j;
+              congaLeaf->AddRoute (serverAddresses[serverIndex], Ipv4Mask ("255.255.255.255"), serverPorts[serverIndex]);
+            }
+
+          // Uplinks to the servers of the other leaves
+          for (int k = 0; k < LEAF_COUNT; k++)
+            {
+              if (k == i)
+                {
+                  continue;
+                }
+              std::vector<std::pair<int, uint32_t> >::iterator uplinkItr = leafUplinks[i].begin ();
+              for ( ; uplinkItr != leafUplinks[i].end (); ++uplinkItr)
+                {
+                  congaLeaf->AddRoute (leafNetworks[k], Ipv4Mask ("255.255.255.0"), uplinkItr->second);
+                  congaLeaf->InitCongestion (k, uplinkItr->second, 0);
+                }
+            }
+        }
+
+      for (int j = 0; j < SPINE_COUNT; j++)
+        {
+          Ptr<Ipv4CongaRouting> congaSpine = congaRoutingHelper.GetCongaRouting (spines.Get (j)->GetObject<Ipv4> ());
+          congaSpine->SetLinkCapacity (DataRate (SPINE_LEAF_CAPACITY));
+          std::vector<std::pair<int, uint32_t> >::iterator downlinkItr = spineDownlinks[j].begin ();
+          for ( ; downlinkItr != spineDownlinks[j].end (); ++downlinkItr)
+            {
+              congaSpine->AddRoute (leafNetworks[downlinkItr->first], Ipv4Mask ("255.255.255.0"), downlinkItr->second);
+            }
+        }
+    }
+  else
+    {
+      NS_LOG_INFO ("Populate global routing tables");
+      Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+    }
+}
+
+// Acknowledged to https://github.com/HKUST-SING/TrafficGenerator/blob/master/src/common/common.c
+double poission_gen_interval(double avg_rate)
+{
+  if (avg_rate > 0)
+    return -logf(1.0 - (double)rand() / RAND_MAX) / avg_rate;
+  else
+    return 0;
+}
+
+void install_incast_applications (NodeContainer servers, long &flowCount, int SERVER_COUNT, int LEAF_COUNT, double START_TIME, double END_TIME, double FLOW_LAUNCH_END_TIME)
+{
+  NS_LOG_INFO ("Install incast applications:");
+  for (int i = 0; i < SERVER_COUNT; i++)
+    {
+      Ptr<Node> destServer = servers.Get (i);
+      Ptr<Ipv4> ipv4 = destServer->GetObject<Ipv4> ();
+      Ipv4InterfaceAddress destInterface = ipv4->GetAddress (1,0);
+      Ipv4Address destAddress = destInterface.GetLocal ();
+
+      uint32_t fanout = rand () % 50 + 100;
+      for (uint32_t j = 0; j < fanout; j++)
+        {
+          double startTime = START_TIME + static_cast<double> (rand () % 100) / 1000000;
+          while (startTime < FLOW_LAUNCH_END_TIME)
+            {
+              flowCount ++;
+              uint32_t fromServerIndex = rand () % SERVER_COUNT;
+              uint16_t port = PORT++;
+
+              BulkSendHelper source ("ns3::TcpSocketFactory", InetSocketAddress (destAddress, port));
+              uint32_t flowSize = rand () % 10000;
+              uint32_t tos = rand() % 5;
+
+              source.SetAttribute ("SendSize", UintegerValue (PACKET_SIZE));
+              source.SetAttribute ("MaxBytes", UintegerValue(flowSize));
+              source.SetAttribute ("SimpleTOS", UintegerValue (tos));
+
+              // Install apps
+              ApplicationContainer sourceApp = source.Install (servers.Get (fromServerIndex));
+              sourceApp.Start (Seconds (startTime));
+              sourceApp.Stop (Seconds (END_TIME));
+
+              // Install packet sinks
+              PacketSinkHelper sink ("ns3::TcpSocketFactory",
+                                     InetSocketAddress (Ipv4Address::GetAny (), port));
+              ApplicationContainer sinkApp = sink.Install (servers. Get (i));
+              sinkApp.Start (Seconds (START_TIME));
+              sinkApp.Stop (Seconds (END_TIME));
+
+              startTime += static_cast<double> (rand () % 1000) / 1000000;
+            }
+
+        }
+
+    }
+}
+
+void install_applications (int fromLeafId, NodeContainer servers, double requestRate, struct cdf_table *cdfTable,
+                           long &flowCount, long &totalFlowSize, int SERVER_COUNT, int LEAF_COUNT, double START_TIME, double END_TIME, double FLOW_LAUNCH_END_TIME)
+{
+  NS_LOG_INFO ("Install applications:");
+  for (int i = 0; i < SERVER_COUNT; i++)
+    {
+      int fromServerIndex = fromLeafId * SERVER_COUNT + i;
+
+      double startTime = START_TIME + poission_gen_interval (requestRate);
+      while (startTime < FLOW_LAUNCH_END_TIME)
+        {
+          flowCount ++;
+          uint16_t port = PORT++;
+
+          int destServerIndex = fromServerIndex;
+          while (destServerIndex >= fromLeafId * SERVER_COUNT && destServerIndex < fromLeafId * SERVER_COUNT + SERVER_COUNT)
+            {
+              destServerIndex = rand_range (0, SERVER_COUNT * LEAF_COUNT);
+            }
+
+          Ptr<Node> destServer = servers.Get (destServerIndex);
+          Ptr<Ipv4> ipv4 = destServer->GetObject<Ipv4> ();
+          Ipv4InterfaceAddress destInterface = ipv4->GetAddress (1,0);
+          Ipv4Address destAddress = destInterface.GetLocal ();
+
+          BulkSendHelper source ("ns3::TcpSocketFactory", InetSocketAddress (destAddress, port));
+          uint32_t flowSize = gen_random_cdf (cdfTable);
+          uint32_t tos = rand() % 5;
+
+          totalFlowSize += flowSize;
+
+          source.SetAttribute ("SendSize", UintegerValue (PACKET_SIZE));
+          source.SetAttribute ("MaxBytes", UintegerValue(flowSize));
+          source.SetAttribute ("SimpleTOS", UintegerValue (tos));
+
+          // Install apps
+          ApplicationContainer sourceApp = source.Install (servers.Get (fromServerIndex));
+          sourceApp.Start (Seconds (startTime));
+          sourceApp.Stop (Seconds (END_TIME));
+
+          // Install packet sinks
+          PacketSinkHelper sink ("ns3::TcpSocketFactory",
+                                 InetSocketAddress (Ipv4Address::GetAny (), port));
+          ApplicationContainer sinkApp = sink.Install (servers. Get (destServerIndex));
+          sinkApp.Start (Seconds (START_TIME));
+          sinkApp.Stop (Seconds (END_TIME));
+
+          startTime += poission_gen_interval (requestRate);
+        }
+    }
+}
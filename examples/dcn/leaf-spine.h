@@ -0,0 +1,57 @@
+#ifndef LEAF_SPINE_H
+#define LEAF_SPINE_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <stdint.h>
+#include <cstdlib>
+
+// The CDF in TrafficGenerator
+extern "C"
+{
+#include "cdf.h"
+}
+
+// The leaf-spine topology and the traffic shared by large-scale and sweep
+
+#define LINK_CAPACITY_BASE    1000000000          // 1Gbps
+#define BUFFER_SIZE 250                           // 250 packets
+
+#define PACKET_SIZE 1400
+
+enum RunMode {
+  ECMP,
+  Conga
+};
+
+struct LeafSpine
+{
+  ns3::NodeContainer spines;
+  ns3::NodeContainer leaves;
+  ns3::NodeContainer servers;
+  // The devices which get the AQM queue discs
+  ns3::NetDeviceContainer aqmDevices;
+};
+
+// Build the nodes, links, addresses and routes of the topology. The AQM
+// devices get a queue disc of aqmFactory, or the default one when it is
+// null.
+void build_leaf_spine (LeafSpine &topology, RunMode runMode, const ns3::ObjectFactory *aqmFactory,
+                       int SERVER_COUNT, int SPINE_COUNT, int LEAF_COUNT, int LINK_COUNT,
+                       uint64_t LEAF_SERVER_CAPACITY, uint64_t SPINE_LEAF_CAPACITY, ns3::Time LINK_LATENCY);
+
+double poission_gen_interval(double avg_rate);
+
+template<typename T>
+T rand_range (T min, T max)
+{
+  return min + ((double)max - min) * rand () / RAND_MAX;
+}
+
+void install_incast_applications (ns3::NodeContainer servers, long &flowCount, int SERVER_COUNT, int LEAF_COUNT, double START_TIME, double END_TIME, double FLOW_LAUNCH_END_TIME);
+
+void install_applications (int fromLeafId, ns3::NodeContainer servers, double requestRate, struct cdf_table *cdfTable,
+                           long &flowCount, long &totalFlowSize, int SERVER_COUNT, int LEAF_COUNT, double START_TIME, double END_TIME, double FLOW_LAUNCH_END_TIME);
+
+#endif
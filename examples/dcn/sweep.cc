@@ -0,0 +1,256 @@
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/flow-monitor-module.h"
+#include "ns3/traffic-control-module.h"
+#include "ns3/sweep-runner.h"
+
+#include <vector>
+#include <map>
+#include <sstream>
+
+#include "leaf-spine.h"
+
+// A sweep of the large-scale topology: the topology is built once, then
+// every AQM, load and seed runs in a worker process forked from it.
+//
+// ./waf --run "sweep --loads=0.3,0.5,0.7 --AQMs=TCN,ECNSharp --seeds=3"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("Sweep");
+
+std::vector<std::string> split_list (std::string list)
+{
+  std::vector<std::string> items;
+  std::istringstream iss (list);
+  std::string item;
+  while (std::getline (iss, item, ','))
+    {
+      if (!item.empty ())
+        {
+          items.push_back (item);
+        }
+    }
+  return items;
+}
+
+int main (int argc, char *argv[])
+{
+  std::string output = "sweep.tsv";
+  std::string cdfFileName = "examples/rtt-variations/DCTCP_CDF.txt";
+  std::string loads = "0.3,0.5,0.7";
+  std::string aqms = "TCN,ECNSharp";
+  std::string runModeStr = "ECMP";
+  uint32_t seeds = 1;
+  uint32_t firstRun = 1;
+  uint32_t parallel = 0;
+
+  double START_TIME = 0.0;
+  double END_TIME = 0.5;
+  double FLOW_LAUNCH_END_TIME = 0.2;
+
+  uint32_t linkLatency = 10;
+
+  int SERVER_COUNT = 8;
+  int SPINE_COUNT = 4;
+  int LEAF_COUNT = 4;
+  int LINK_COUNT = 1;
+
+  uint64_t spineLeafCapacity = 10;
+  uint64_t leafServerCapacity = 10;
+
+  uint32_t TCNThreshold = 80;
+
+  uint32_t ECNSharpInterval = 150;
+  uint32_t ECNSharpTarget = 10;
+  uint32_t ECNSharpMarkingThreshold = 80;
+
+  CommandLine cmd;
+  cmd.AddValue ("output", "Name of the merged FCT file", output);
+  cmd.AddValue ("loads", "Comma separated loads of the network, 0.0 - 1.0", loads);
+  cmd.AddValue ("AQMs", "Comma separated AQMs: TCN, ECNSharp", aqms);
+  cmd.AddValue ("runMode", "Load balancing scheme of the topology: ECMP or Conga", runModeStr);
+  cmd.AddValue ("seeds", "Number of replications of each load and AQM", seeds);
+  cmd.AddValue ("firstRun", "Run number of the first replication", firstRun);
+  cmd.AddValue ("parallel", "Number of workers at a time, 0 for every processor", parallel);
+  cmd.AddValue ("cdfFileName", "File name for flow distribution", cdfFileName);
+  cmd.AddValue ("StartTime", "Start time of the simulation", START_TIME);
+  cmd.AddValue ("EndTime", "End time of the simulation", END_TIME);
+  cmd.AddValue ("FlowLaunchEndTime", "End time of the flow launch period", FLOW_LAUNCH_END_TIME);
+  cmd.AddValue ("linkLatency", "Link latency, should be in MicroSeconds", linkLatency);
+  cmd.AddValue ("serverCount", "The Server count", SERVER_COUNT);
+  cmd.AddValue ("spineCount", "The Spine count", SPINE_COUNT);
+  cmd.AddValue ("leafCount", "The Leaf count", LEAF_COUNT);
+  cmd.AddValue ("linkCount", "The Link count", LINK_COUNT);
+  cmd.AddValue ("spineLeafCapacity", "Spine <-> Leaf capacity in Gbps", spineLeafCapacity);
+  cmd.AddValue ("leafServerCapacity", "Leaf <-> Server capacity in Gbps", leafServerCapacity);
+  cmd.AddValue ("TCNThreshold", "The threshold for TCN", TCNThreshold);
+  cmd.AddValue ("ECNShaprInterval", "The persistent interval for ECNSharp", ECNSharpInterval);
+  cmd.AddValue ("ECNSharpTarget", "The persistent target for ECNShapr", ECNSharpTarget);
+  cmd.AddValue ("ECNShaprMarkingThreshold", "The instantaneous marking threshold for ECNSharp", ECNSharpMarkingThreshold);
+  cmd.Parse (argc, argv);
+
+  uint64_t SPINE_LEAF_CAPACITY = spineLeafCapacity * LINK_CAPACITY_BASE;
+  uint64_t LEAF_SERVER_CAPACITY = leafServerCapacity * LINK_CAPACITY_BASE;
+  Time LINK_LATENCY = MicroSeconds (linkLatency);
+
+  RunMode runMode;
+  if (runModeStr.compare ("ECMP") == 0)
+    {
+      runMode = ECMP;
+    }
+  else if (runModeStr.compare ("Conga") == 0)
+    {
+      runMode = Conga;
+    }
+  else
+    {
+      NS_LOG_ERROR ("Unknown load balancing scheme " << runModeStr);
+      return 1;
+    }
+
+  SweepRunner runner;
+  runner.AddParameter ("AQM");
+  runner.AddParameter ("load");
+  runner.AddColumn ("flow");
+  runner.AddColumn ("sourcePort");
+  runner.AddColumn ("destinationPort");
+  runner.AddColumn ("txBytes");
+  runner.AddColumn ("rxBytes");
+  runner.AddColumn ("start");
+  runner.AddColumn ("fct");
+  runner.AddColumn ("lostPackets");
+  std::vector<std::string> aqmList = split_list (aqms);
+  std::vector<std::string> loadList = split_list (loads);
+  for (uint32_t i = 0; i < aqmList.size (); i++)
+    {
+      if (aqmList[i] != "TCN" && aqmList[i] != "ECNSharp")
+        {
+          NS_LOG_ERROR ("Unknown AQM " << aqmList[i]);
+          return 1;
+        }
+      for (uint32_t j = 0; j < loadList.size (); j++)
+        {
+          double load = atof (loadList[j].c_str ());
+          if (load <= 0.0 || load >= 1.0)
+            {
+              NS_LOG_ERROR ("The network load should within 0.0 and 1.0");
+              return 1;
+            }
+          std::vector<std::string> values;
+          values.push_back (aqmList[i]);
+          values.push_back (loadList[j]);
+          runner.AddJob (values);
+        }
+    }
+  runner.SetReplications (seeds);
+  runner.SetFirstRun (firstRun);
+  if (parallel > 0)
+    {
+      runner.SetParallel (parallel);
+    }
+
+  Config::SetDefault ("ns3::TcpL4Protocol::SocketType", TypeIdValue (TcpDCTCP::GetTypeId ()));
+
+  Config::SetDefault ("ns3::TCNQueueDisc::Mode", StringValue ("QUEUE_MODE_PACKETS"));
+  Config::SetDefault ("ns3::TCNQueueDisc::MaxPackets", UintegerValue (BUFFER_SIZE));
+  Config::SetDefault ("ns3::TCNQueueDisc::Threshold", TimeValue (MicroSeconds (TCNThreshold)));
+
+  Config::SetDefault ("ns3::ECNSharpQueueDisc::Mode", StringValue ("QUEUE_MODE_PACKETS"));
+  Config::SetDefault ("ns3::ECNSharpQueueDisc::MaxPackets", UintegerValue (BUFFER_SIZE));
+  Config::SetDefault ("ns3::ECNSharpQueueDisc::InstantaneousMarkingThreshold", TimeValue (MicroSeconds (ECNSharpMarkingThreshold)));
+  Config::SetDefault ("ns3::ECNSharpQueueDisc::PersistentMarkingTarget", TimeValue (MicroSeconds (ECNSharpTarget)));
+  Config::SetDefault ("ns3::ECNSharpQueueDisc::PersistentMarkingInterval", TimeValue (MicroSeconds (ECNSharpInterval)));
+
+  Config::SetDefault ("ns3::TcpSocket::SegmentSize", UintegerValue(PACKET_SIZE));
+  Config::SetDefault ("ns3::TcpSocket::DelAckCount", UintegerValue (0));
+  Config::SetDefault ("ns3::TcpSocket::ConnTimeout", TimeValue (MilliSeconds (5)));
+  Config::SetDefault ("ns3::TcpSocket::InitialCwnd", UintegerValue (10));
+  Config::SetDefault ("ns3::TcpSocketBase::MinRto", TimeValue (MilliSeconds (5)));
+  Config::SetDefault ("ns3::TcpSocketBase::ClockGranularity", TimeValue (MicroSeconds (100)));
+  Config::SetDefault ("ns3::RttEstimator::InitialEstimation", TimeValue (MicroSeconds (80)));
+  Config::SetDefault ("ns3::TcpSocket::SndBufSize", UintegerValue (160000000));
+  Config::SetDefault ("ns3::TcpSocket::RcvBufSize", UintegerValue (160000000));
+
+  Config::SetDefault ("ns3::Ipv4GlobalRouting::PerflowEcmpRouting", BooleanValue(true));
+
+  NS_LOG_INFO ("Build the topology");
+  // The default queue discs of the AQM devices are replaced in each worker
+  LeafSpine topology;
+  build_leaf_spine (topology, runMode, 0, SERVER_COUNT, SPINE_COUNT, LEAF_COUNT, LINK_COUNT,
+                    LEAF_SERVER_CAPACITY, SPINE_LEAF_CAPACITY, LINK_LATENCY);
+
+  double oversubRatio = static_cast<double>(SERVER_COUNT * LEAF_SERVER_CAPACITY) / (SPINE_LEAF_CAPACITY * SPINE_COUNT * LINK_COUNT);
+
+  struct cdf_table* cdfTable = new cdf_table ();
+  init_cdf (cdfTable);
+  load_cdf (cdfTable, cdfFileName.c_str ());
+
+  // Every worker continues from here, with its own job and replication
+  if (runner.Fork () < 0)
+    {
+      free_cdf (cdfTable);
+      bool ok = runner.Merge (output);
+      NS_LOG_INFO ("Merged the flows in " << output);
+      return ok ? 0 : 1;
+    }
+
+  std::string aqm = runner.GetParameter ("AQM");
+  double load = atof (runner.GetParameter ("load").c_str ());
+  NS_LOG_INFO ("Worker " << aqm << " " << load << " run " << runner.GetRun ());
+
+  ObjectFactory queueDiscFactory;
+  queueDiscFactory.SetTypeId (aqm == "TCN" ? "ns3::TCNQueueDisc" : "ns3::ECNSharpQueueDisc");
+  for (uint32_t i = 0; i < topology.aqmDevices.GetN (); i++)
+    {
+      Ptr<NetDevice> device = topology.aqmDevices.Get (i);
+      Ptr<TrafficControlLayer> tcl = device->GetNode ()->GetObject<TrafficControlLayer> ();
+      // Replace the default queue disc installed with the address
+      tcl->DeleteRootQueueDiscOnDevice (device);
+      Ptr<QueueDisc> queueDisc = queueDiscFactory.Create<QueueDisc> ();
+      queueDisc->SetNetDevice (device);
+      tcl->SetRootQueueDiscOnDevice (device, queueDisc);
+    }
+
+  double requestRate = load * LEAF_SERVER_CAPACITY * SERVER_COUNT / oversubRatio / (8 * avg_cdf (cdfTable)) / SERVER_COUNT;
+
+  long flowCount = 0;
+  long totalFlowSize = 0;
+  for (int fromLeafId = 0; fromLeafId < LEAF_COUNT; fromLeafId ++)
+    {
+      install_applications (fromLeafId, topology.servers, requestRate, cdfTable, flowCount, totalFlowSize, SERVER_COUNT, LEAF_COUNT, START_TIME, END_TIME, FLOW_LAUNCH_END_TIME);
+    }
+  NS_LOG_INFO ("Total flow: " << flowCount);
+
+  FlowMonitorHelper flowHelper;
+  Ptr<FlowMonitor> flowMonitor = flowHelper.InstallAll ();
+
+  Simulator::Stop (Seconds (END_TIME));
+  Simulator::Run ();
+
+  flowMonitor->CheckForLostPackets ();
+  Ptr<Ipv4FlowClassifier> classifier = DynamicCast<Ipv4FlowClassifier> (flowHelper.GetClassifier ());
+  std::map<FlowId, FlowMonitor::FlowStats> stats = flowMonitor->GetFlowStats ();
+  for (std::map<FlowId, FlowMonitor::FlowStats>::const_iterator it = stats.begin (); it != stats.end (); ++it)
+    {
+      Ipv4FlowClassifier::FiveTuple tuple = classifier->FindFlow (it->first);
+      const FlowMonitor::FlowStats &flow = it->second;
+      std::vector<double> row;
+      row.push_back (it->first);
+      row.push_back (tuple.sourcePort);
+      row.push_back (tuple.destinationPort);
+      row.push_back (flow.txBytes);
+      row.push_back (flow.rxBytes);
+      row.push_back (flow.timeFirstTxPacket.GetSeconds ());
+      row.push_back (flow.rxPackets > 0 ? (flow.timeLastRxPacket - flow.timeFirstTxPacket).GetSeconds () : 0);
+      row.push_back (flow.lostPackets);
+      runner.AddRow (row);
+    }
+
+  Simulator::Destroy ();
+  free_cdf (cdfTable);
+  return 0;
+}
@@ -19,6 +19,7 @@ Ipv4Clove::Ipv4Clove () :
     m_disToUncongestedPath (false)
 {
     NS_LOG_FUNCTION (this);
+    m_rand = CreateObject<UniformRandomVariable> ();
 }
 
 Ipv4Clove::Ipv4Clove (const Ipv4Clove &other) :
@@ -28,6 +29,7 @@ Ipv4Clove::Ipv4Clove (const Ipv4Clove &other) :
     m_disToUncongestedPath (other.m_disToUncongestedPath)
 {
     NS_LOG_FUNCTION (this);
+    m_rand = CreateObject<UniformRandomVariable> ();
 }
 
 TypeId
@@ -132,6 +134,14 @@ Ipv4Clove::FindTorId (Ipv4Address daddr, uint32_t &destTorId)
     return true;
 }
 
+int64_t
+Ipv4Clove::AssignStreams (int64_t stream)
+{
+    NS_LOG_FUNCTION (this << stream);
+    m_rand->SetStream (stream);
+    return 1;
+}
+
 uint32_t
 Ipv4Clove::CalPath (uint32_t destTor)
 {
@@ -143,11 +153,11 @@ Ipv4Clove::CalPath (uint32_t destTor)
     std::vector<uint32_t> paths = itr->second;
     if (m_runMode == CLOVE_RUNMODE_EDGE_FLOWLET)
     {
-        return paths[rand() % paths.size ()];
+        return paths[m_rand->GetInteger (0, paths.size () - 1)];
     }
     else if (m_runMode == CLOVE_RUNMODE_ECN)
     {
-        double r = ((double) rand () / RAND_MAX);
+        double r = m_rand->GetValue ();
         std::vector<uint32_t>::iterator itr = paths.begin ();
         double weightSum = 0.0;
         for ( ; itr != paths.end (); ++itr)
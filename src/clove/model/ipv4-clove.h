@@ -5,6 +5,7 @@
 #include "ns3/object.h"
 #include "ns3/nstime.h"
 #include "ns3/ipv4-address.h"
+#include "ns3/random-variable-stream.h"
 
 #include <vector>
 #include <map>
@@ -38,6 +39,9 @@ public:
 
     bool FindTorId (Ipv4Address daddr, uint32_t &torId);
 
+    // Use fixed streams for the random path choices, returns the number of streams assigned
+    int64_t AssignStreams (int64_t stream);
+
 private:
     uint32_t CalPath (uint32_t destTor);
 
@@ -53,6 +57,8 @@ private:
     bool m_disToUncongestedPath;
     std::map<std::pair<uint32_t, uint32_t>, double> m_pathWeight;
     std::map<std::pair<uint32_t, uint32_t>, Time> m_pathECNSeen;
+
+    Ptr<UniformRandomVariable> m_rand; // Random path choices
 };
 
 }
@@ -5,12 +5,14 @@
 #include "ns3/log.h"
 #include "ns3/simulator.h"
 #include "ns3/net-device.h"
-#include "ns3/channel.h"
+#include "ns3/ipv4-egress-route-cache.h"
 #include "ns3/node.h"
 #include "ns3/flow-id-tag.h"
+#include "ns3/pointer.h"
 #include "ipv4-conga-tag.h"
 
 #include <algorithm>
+#include <iomanip>
 
 #define LOOPBACK_PORT 0
 
@@ -20,6 +22,70 @@ NS_LOG_COMPONENT_DEFINE("Ipv4CongaRouting");
 
 NS_OBJECT_ENSURE_REGISTERED (Ipv4CongaRouting);
 
+namespace {
+
+uint32_t
+PopCount (uint64_t x)
+{
+  x = x - ((x >> 1) & 0x5555555555555555ULL);
+  x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+  x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+  return static_cast<uint32_t> ((x * 0x0101010101010101ULL) >> 56);
+}
+
+uint32_t
+LowestSetBit (uint64_t x)
+{
+  return PopCount ((x & (~x + 1)) - 1);
+}
+
+// Position of the n-th set bit (from 0) of a bitmap
+uint32_t
+NthSetBit (const uint64_t *bitmap, uint32_t nWords, uint32_t n)
+{
+  for (uint32_t w = 0; w < nWords; w++)
+  {
+    uint32_t count = PopCount (bitmap[w]);
+    if (n < count)
+    {
+      uint64_t word = bitmap[w];
+      for ( ; n > 0; n--)
+      {
+        word &= word - 1;
+      }
+      return w * 64 + LowestSetBit (word);
+    }
+    n -= count;
+  }
+  NS_FATAL_ERROR ("Bitmap has fewer set bits than requested");
+  return 0;
+}
+
+// Position of the first set bit at or after from, wrapping around,
+// or nWords * 64 if no bit is set
+uint32_t
+NextSetBit (const uint64_t *bitmap, uint32_t nWords, uint32_t from)
+{
+  if (from >= nWords * 64)
+  {
+    from = 0;
+  }
+  uint32_t w = from / 64;
+  uint64_t word = bitmap[w] & (~static_cast<uint64_t> (0) << (from % 64));
+  for (uint32_t i = 0; i <= nWords; i++)
+  {
+    if (word != 0)
+    {
+      return w * 64 + LowestSetBit (word);
+    }
+    w = (w + 1) % nWords;
+    word = bitmap[w];
+  }
+  return nWords * 64;
+}
+
+} // anonymous namespace
+
 Ipv4CongaRouting::Ipv4CongaRouting ():
     // Parameters
     m_isLeaf (false),
@@ -35,9 +101,15 @@ Ipv4CongaRouting::Ipv4CongaRouting ():
     m_feedbackIndex (0),
     m_dreEvent (),
     m_agingEvent (),
-    m_ipv4 (0)
+    m_ipv4 (0),
+    m_nLeaves (0),
+    m_nPorts (0),
+    m_nWords (0)
 {
   NS_LOG_FUNCTION (this);
+  m_flowletTable = CreateObject<Ipv4FlowletTable> ();
+  m_flowletTable->SetTimeout (m_flowletTimeout);
+  m_rand = CreateObject<UniformRandomVariable> ();
 }
 
 Ipv4CongaRouting::~Ipv4CongaRouting ()
@@ -51,7 +123,12 @@ Ipv4CongaRouting::GetTypeId (void)
   static TypeId tid = TypeId("ns3::Ipv4CongaRouting")
       .SetParent<Object>()
       .SetGroupName ("Internet")
-      .AddConstructor<Ipv4CongaRouting> ();
+      .AddConstructor<Ipv4CongaRouting> ()
+      .AddAttribute ("FlowletTable", "The flowlet table",
+                     PointerValue (),
+                     MakePointerAccessor (&Ipv4CongaRouting::m_flowletTable),
+                     MakePointerChecker<Ipv4FlowletTable> ())
+  ;
 
   return tid;
 }
@@ -67,6 +144,7 @@ void
 Ipv4CongaRouting::SetFlowletTimeout (Time timeout)
 {
   m_flowletTimeout = timeout;
+  m_flowletTable->SetTimeout (timeout);
 }
 
 void
@@ -103,6 +181,7 @@ void
 Ipv4CongaRouting::AddAddressToLeafIdMap (Ipv4Address addr, uint32_t leafId)
 {
   m_ipLeafIdMap[addr] = leafId;
+  ResizeLeafTables (leafId, 0);
 }
 
 void
@@ -114,18 +193,65 @@ Ipv4CongaRouting::EnableEcmpMode ()
 void
 Ipv4CongaRouting::InitCongestion (uint32_t leafId, uint32_t port, uint32_t congestion)
 {
-  std::map<uint32_t, std::map<uint32_t, std::pair<Time, uint32_t> > >::iterator itr =
-      m_congaToLeafTable.find(leafId);
-  if (itr != m_congaToLeafTable.end ())
+  ResizeLeafTables (leafId, port);
+  FeedbackInfo &info = m_congaToLeafTable[leafId * m_nPorts + port];
+  info.ce = congestion;
+  info.updateTime = Simulator::Now ();
+  m_congaToLeafValid[leafId * m_nWords + port / 64] |= 1ULL << (port % 64);
+}
+
+void
+Ipv4CongaRouting::ResizeLeafTables (uint32_t leafId, uint32_t port)
+{
+  if (leafId < m_nLeaves && port < m_nPorts)
   {
-    (itr->second)[port] = std::make_pair(Simulator::Now (), congestion);
+    return;
   }
-  else
+  uint32_t nLeaves = std::max (m_nLeaves, leafId + 1);
+  uint32_t nPorts = std::max (m_nPorts, port + 1);
+  uint32_t nWords = (nPorts + 63) / 64;
+
+  // Leaf ids and ports are known when the switch is set up, so the tables
+  // are rarely laid out again after the first packet
+  FeedbackInfo empty;
+  empty.ce = 0;
+  std::vector<FeedbackInfo> toLeaf (nLeaves * nPorts, empty);
+  std::vector<FeedbackInfo> fromLeaf (nLeaves * nPorts, empty);
+  std::vector<uint64_t> toLeafValid (nLeaves * nWords, 0);
+  std::vector<uint64_t> fromLeafValid (nLeaves * nWords, 0);
+  std::vector<uint64_t> fromLeafChanged (nLeaves * nWords, 0);
+  for (uint32_t leaf = 0; leaf < m_nLeaves; leaf++)
   {
-    std::map<uint32_t, std::pair<Time, uint32_t> > newMap;
-    newMap[port] = std::make_pair(Simulator::Now (), congestion);
-    m_congaToLeafTable[leafId] = newMap;
+    std::copy (m_congaToLeafTable.begin () + leaf * m_nPorts,
+               m_congaToLeafTable.begin () + (leaf + 1) * m_nPorts,
+               toLeaf.begin () + leaf * nPorts);
+    std::copy (m_congaFromLeafTable.begin () + leaf * m_nPorts,
+               m_congaFromLeafTable.begin () + (leaf + 1) * m_nPorts,
+               fromLeaf.begin () + leaf * nPorts);
+    for (uint32_t w = 0; w < m_nWords; w++)
+    {
+      toLeafValid[leaf * nWords + w] = m_congaToLeafValid[leaf * m_nWords + w];
+      fromLeafValid[leaf * nWords + w] = m_congaFromLeafValid[leaf * m_nWords + w];
+      fromLeafChanged[leaf * nWords + w] = m_congaFromLeafChanged[leaf * m_nWords + w];
+    }
   }
+  m_congaToLeafTable.swap (toLeaf);
+  m_congaFromLeafTable.swap (fromLeaf);
+  m_congaToLeafValid.swap (toLeafValid);
+  m_congaFromLeafValid.swap (fromLeafValid);
+  m_congaFromLeafChanged.swap (fromLeafChanged);
+  m_congaFromLeafSize.resize (nLeaves, 0);
+  m_nLeaves = nLeaves;
+  m_nPorts = nPorts;
+  m_nWords = nWords;
+}
+
+int64_t
+Ipv4CongaRouting::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  m_rand->SetStream (stream);
+  return 1;
 }
 
 void
@@ -137,6 +263,7 @@ Ipv4CongaRouting::AddRoute (Ipv4Address network, Ipv4Mask networkMask, uint32_t
   congaRouteEntry.networkMask = networkMask;
   congaRouteEntry.port = port;
   m_routeEntryList.push_back (congaRouteEntry);
+  m_portTable.AddRoute (network, networkMask, port);
 }
 
 std::vector<CongaRouteEntry>
@@ -157,17 +284,7 @@ Ipv4CongaRouting::LookupCongaRouteEntries (Ipv4Address dest)
 Ptr<Ipv4Route>
 Ipv4CongaRouting::ConstructIpv4Route (uint32_t port, Ipv4Address destAddress)
 {
-  Ptr<NetDevice> dev = m_ipv4->GetNetDevice (port);
-  Ptr<Channel> channel = dev->GetChannel ();
-  uint32_t otherEnd = (channel->GetDevice (0) == dev) ? 1 : 0;
-  Ptr<Node> nextHop = channel->GetDevice (otherEnd)->GetNode ();
-  uint32_t nextIf = channel->GetDevice (otherEnd)->GetIfIndex ();
-  Ipv4Address nextHopAddr = nextHop->GetObject<Ipv4>()->GetAddress(nextIf,0).GetLocal();
-  Ptr<Ipv4Route> route = Create<Ipv4Route> ();
-  route->SetOutputDevice (m_ipv4->GetNetDevice (port));
-  route->SetGateway (nextHopAddr);
-  route->SetSource (m_ipv4->GetAddress (port, 0).GetLocal ());
-  route->SetDestination (destAddress);
+  Ptr<Ipv4Route> route = m_routeCache->GetRoute (port);
   return route;
 }
 
@@ -221,9 +338,9 @@ Ipv4CongaRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr
   }
   flowId = flowIdTag.GetFlowId ();
 
-  std::vector<CongaRouteEntry> routeEntries = Ipv4CongaRouting::LookupCongaRouteEntries (destAddress);
+  const Ipv4EgressPortTable::PortList &ports = m_portTable.Lookup (destAddress);
 
-  if (routeEntries.empty ())
+  if (ports.empty ())
   {
     NS_LOG_ERROR (this << " Conga routing cannot find routing entry");
     ecb (packet, header, Socket::ERROR_NOROUTETOHOST);
@@ -233,8 +350,14 @@ Ipv4CongaRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr
   // Dev use
   if (m_ecmpMode)
   {
-    uint32_t selectedPort = routeEntries[flowId % routeEntries.size ()].port;
+    uint32_t selectedPort = ports[flowId % ports.size ()];
     Ptr<Ipv4Route> route = Ipv4CongaRouting::ConstructIpv4Route (selectedPort, destAddress);
+    if (route == 0)
+    {
+      NS_LOG_LOGIC (this << " No usable next hop on port: " << selectedPort);
+      ecb (packet, header, Socket::ERROR_NOROUTETOHOST);
+      return false;
+    }
     ucb (route, packet, header);
   }
 
@@ -270,10 +393,6 @@ Ipv4CongaRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr
       // Build an empty Conga header (as the packet tag)
       // Determine the port and fill the header fields
 
-      Ipv4CongaRouting::PrintDreTable ();
-      Ipv4CongaRouting::PrintCongaToLeafTable ();
-      Ipv4CongaRouting::PrintFlowletTable ();
-
       // Determine the dest switch leaf id
       std::map<Ipv4Address, uint32_t>::iterator itr = m_ipLeafIdMap.find(destAddress);
       if (itr == m_ipLeafIdMap.end ())
@@ -284,36 +403,30 @@ Ipv4CongaRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr
       }
       uint32_t destLeafId = itr->second;
 
-      // Check piggyback information
-      std::map<uint32_t, std::map<uint32_t, FeedbackInfo> >::iterator fbItr =
-          m_congaFromLeafTable.find (destLeafId);
-
       uint32_t fbLbTag = LOOPBACK_PORT;
       uint32_t fbMetric = 0;
 
       // Piggyback according to round robin and favoring those that has been changed
-      if (fbItr != m_congaFromLeafTable.end ())
+      if (destLeafId < m_nLeaves && m_congaFromLeafSize[destLeafId] > 0)
       {
-        std::map<uint32_t, FeedbackInfo>::iterator innerFbItr = (fbItr->second).begin ();
-        std::advance (innerFbItr, m_feedbackIndex++ % (fbItr->second).size ()); // round robin
+        const uint64_t *valid = &m_congaFromLeafValid[destLeafId * m_nWords];
+        uint64_t *changed = &m_congaFromLeafChanged[destLeafId * m_nWords];
+
+        // round robin
+        uint32_t port = NthSetBit (valid, m_nWords, m_feedbackIndex++ % m_congaFromLeafSize[destLeafId]);
 
-        if ((innerFbItr->second).change == false)  // prefer the changed ones
+        if ((changed[port / 64] & (1ULL << (port % 64))) == 0)  // prefer the changed ones
         {
-          for (unsigned loopIndex = 0; loopIndex < (fbItr->second).size (); loopIndex ++) // prevent infinite looping
+          uint32_t changedPort = NextSetBit (changed, m_nWords, port + 1);
+          if (changedPort < m_nWords * 64)
           {
-            if (++innerFbItr == (fbItr->second).end ()) {
-              innerFbItr = (fbItr->second).begin (); // start from the beginning
-            }
-            if ((innerFbItr->second).change == true)
-            {
-              break;
-            }
+            port = changedPort;
           }
         }
 
-        fbLbTag = innerFbItr->first;
-        fbMetric = (innerFbItr->second).ce;
-        (innerFbItr->second).change = false;
+        fbLbTag = port;
+        fbMetric = m_congaFromLeafTable[destLeafId * m_nPorts + port].ce;
+        changed[port / 64] &= ~(1ULL << (port % 64));
       }
 
       // Port determination logic:
@@ -321,15 +434,12 @@ Ipv4CongaRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr
       // If not hit, determine the port based on the congestion degree of the link
 
       // Flowlet table look up
-      struct Flowlet *flowlet = NULL;
+      Ipv4Flowlet *flowlet = m_flowletTable->Find (flowId);
 
       // If the flowlet table entry is valid, return the port
-      std::map<uint32_t, struct Flowlet *>::iterator flowletItr = m_flowletTable.find (flowId);
-      if (flowletItr != m_flowletTable.end ())
+      if (flowlet != NULL)
       {
-        flowlet = flowletItr->second;
-        if (flowlet != NULL && // Impossible in normal cases
-            now - flowlet->activeTime <= m_flowletTimeout)
+        if (now - flowlet->activeTime <= m_flowletTimeout)
         {
           // Do not forget to update the flowlet active time
           flowlet->activeTime = now;
@@ -350,6 +460,12 @@ Ipv4CongaRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr
           Ipv4CongaRouting::UpdateLocalDre (header, packet, selectedPort);
 
           Ptr<Ipv4Route> route = Ipv4CongaRouting::ConstructIpv4Route (selectedPort, destAddress);
+          if (route == 0)
+          {
+            NS_LOG_LOGIC (this << " No usable next hop on port: " << selectedPort);
+            ecb (packet, header, Socket::ERROR_NOROUTETOHOST);
+            return false;
+          }
           ucb (route, packet, header);
 
           NS_LOG_LOGIC (this << " Sending Conga on leaf switch (flowlet hit): " << m_leafId << " - LbTag: " << selectedPort << ", CE: " << 0 << ", FbLbTag: " << fbLbTag << ", FbMetric: " << fbMetric);
@@ -362,8 +478,8 @@ Ipv4CongaRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr
       // Not hit. Determine the port
 
       // 1. Select port congestion information based on dest leaf switch id
-      std::map<uint32_t, std::map<uint32_t, std::pair<Time, uint32_t> > >::iterator
-          congaToLeafItr = m_congaToLeafTable.find (destLeafId);
+      const FeedbackInfo *congaToLeaf = destLeafId < m_nLeaves ?
+          &m_congaToLeafTable[destLeafId * m_nPorts] : NULL;
 
       // 2. Prepare the candidate port
       // For a new flowlet, we pick the uplink port that minimizes the maximum of the local metric (from the local DREs)
@@ -371,11 +487,11 @@ Ipv4CongaRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr
       uint32_t minPortCongestion = (std::numeric_limits<uint32_t>::max)();
 
       std::vector<uint32_t> portCandidates;
-      std::vector<CongaRouteEntry>::iterator routeEntryItr = routeEntries.begin ();
+      Ipv4EgressPortTable::PortList::const_iterator portItr = ports.begin ();
 
-      for ( ; routeEntryItr != routeEntries.end (); ++routeEntryItr)
+      for ( ; portItr != ports.end (); ++portItr)
       {
-        uint32_t port = (*routeEntryItr).port;
+        uint32_t port = *portItr;
         uint32_t localCongestion = 0;
         uint32_t remoteCongestion = 0;
 
@@ -385,11 +501,9 @@ Ipv4CongaRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr
           localCongestion = Ipv4CongaRouting::QuantizingX (port, localCongestionItr->second);
         }
 
-        std::map<uint32_t, std::pair<Time, uint32_t> >::iterator remoteCongestionItr =
-            (congaToLeafItr->second).find (port);
-        if (remoteCongestionItr != (congaToLeafItr->second).end ())
+        if (congaToLeaf != NULL && port < m_nPorts)
         {
-          remoteCongestion = (remoteCongestionItr->second).second;
+          remoteCongestion = congaToLeaf[port].ce;
         }
 
         uint32_t congestionDegree = std::max (localCongestion, remoteCongestion);
@@ -420,19 +534,13 @@ Ipv4CongaRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr
       else
       {
         // If there are no cached ports, we randomly choose a good port
-        selectedPort = portCandidates[rand() % portCandidates.size ()];
+        selectedPort = portCandidates[m_rand->GetInteger (0, portCandidates.size () - 1)];
         if (flowlet == NULL)
         {
-          struct Flowlet *newFlowlet = new Flowlet;
-          newFlowlet->port = selectedPort;
-          newFlowlet->activeTime = now;
-          m_flowletTable[flowId] = newFlowlet;
-        }
-        else
-        {
-          flowlet->port = selectedPort;
-          flowlet->activeTime = now;
+          flowlet = m_flowletTable->Insert (flowId, now);
         }
+        flowlet->port = selectedPort;
+        flowlet->activeTime = now;
       }
 
       // 4. Construct Conga Header for the packet
@@ -448,6 +556,12 @@ Ipv4CongaRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr
       Ipv4CongaRouting::UpdateLocalDre (header, packet, selectedPort);
 
       Ptr<Ipv4Route> route = Ipv4CongaRouting::ConstructIpv4Route (selectedPort, destAddress);
+      if (route == 0)
+      {
+        NS_LOG_LOGIC (this << " No usable next hop on port: " << selectedPort);
+        ecb (packet, header, Socket::ERROR_NOROUTETOHOST);
+        return false;
+      }
       ucb (route, packet, header);
 
       NS_LOG_LOGIC (this << " Sending Conga on leaf switch: " << m_leafId << " - LbTag: " << selectedPort << ", CE: " << 0 << ", FbLbTag: " << fbLbTag << ", FbMetric: " << fbMetric);
@@ -474,54 +588,32 @@ Ipv4CongaRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr
       uint32_t sourceLeafId = itr->second;
 
       // 1. Update the CongaFromLeafTable
-      std::map<uint32_t, std::map<uint32_t, FeedbackInfo> >::iterator fromLeafItr = m_congaFromLeafTable.find (sourceLeafId);
+      uint32_t lbTag = ipv4CongaTag.GetLbTag ();
+      ResizeLeafTables (sourceLeafId, lbTag);
 
-      if (fromLeafItr == m_congaFromLeafTable.end ())
-      {
-        std::map<uint32_t, FeedbackInfo> newMap;
-        FeedbackInfo feedbackInfo;
-        feedbackInfo.ce = ipv4CongaTag.GetCe ();
-        feedbackInfo.change = true;
-        feedbackInfo.updateTime = Simulator::Now ();
-        newMap[ipv4CongaTag.GetLbTag ()] = feedbackInfo;
-        m_congaFromLeafTable[sourceLeafId] = newMap;
-      }
-      else
+      FeedbackInfo &fromLeaf = m_congaFromLeafTable[sourceLeafId * m_nPorts + lbTag];
+      fromLeaf.ce = ipv4CongaTag.GetCe ();
+      fromLeaf.updateTime = Simulator::Now ();
+
+      uint64_t bit = 1ULL << (lbTag % 64);
+      uint32_t word = sourceLeafId * m_nWords + lbTag / 64;
+      if ((m_congaFromLeafValid[word] & bit) == 0)
       {
-        std::map<uint32_t, FeedbackInfo>::iterator innerItr = (fromLeafItr->second).find (ipv4CongaTag.GetLbTag ());
-        if (innerItr == (fromLeafItr->second).end ())
-        {
-          FeedbackInfo feedbackInfo;
-          feedbackInfo.ce = ipv4CongaTag.GetCe ();
-          feedbackInfo.change = true;
-          feedbackInfo.updateTime = Simulator::Now ();
-          (fromLeafItr->second)[ipv4CongaTag.GetLbTag ()] = feedbackInfo;
-        }
-        else
-        {
-          (innerItr->second).ce = ipv4CongaTag.GetCe ();
-          (innerItr->second).change = true;
-          (innerItr->second).updateTime = Simulator::Now ();
-        }
+        m_congaFromLeafValid[word] |= bit;
+        m_congaFromLeafSize[sourceLeafId]++;
       }
+      m_congaFromLeafChanged[word] |= bit;
 
       // 2. Update the CongaToLeafTable
       if (ipv4CongaTag.GetFbLbTag () != LOOPBACK_PORT)
       {
-        std::map<uint32_t, std::map<uint32_t, std::pair<Time, uint32_t> > >::iterator toLeafItr =
-            m_congaToLeafTable.find(sourceLeafId);
-        if (toLeafItr != m_congaToLeafTable.end ())
-        {
-          (toLeafItr->second)[ipv4CongaTag.GetFbLbTag ()] =
-              std::make_pair(Simulator::Now (), ipv4CongaTag.GetFbMetric ());
-        }
-        else
-        {
-          std::map<uint32_t, std::pair<Time, uint32_t> > newMap;
-          newMap[ipv4CongaTag.GetFbLbTag ()] =
-              std::make_pair(Simulator::Now (), ipv4CongaTag.GetFbMetric ());
-          m_congaToLeafTable[sourceLeafId] = newMap;
-        }
+        uint32_t fbLbTag = ipv4CongaTag.GetFbLbTag ();
+        ResizeLeafTables (sourceLeafId, fbLbTag);
+
+        FeedbackInfo &toLeaf = m_congaToLeafTable[sourceLeafId * m_nPorts + fbLbTag];
+        toLeaf.ce = ipv4CongaTag.GetFbMetric ();
+        toLeaf.updateTime = Simulator::Now ();
+        m_congaToLeafValid[sourceLeafId * m_nWords + fbLbTag / 64] |= 1ULL << (fbLbTag % 64);
       }
 
       // Not necessary
@@ -529,17 +621,19 @@ Ipv4CongaRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr
       packet->RemovePacketTag (ipv4CongaTag);
 
       // Pick port using standard ECMP
-      uint32_t selectedPort = routeEntries[flowId % routeEntries.size ()].port;
+      uint32_t selectedPort = ports[flowId % ports.size ()];
 
       Ipv4CongaRouting::UpdateLocalDre (header, packet, selectedPort);
 
       Ptr<Ipv4Route> route = Ipv4CongaRouting::ConstructIpv4Route (selectedPort, destAddress);
+      if (route == 0)
+      {
+        NS_LOG_LOGIC (this << " No usable next hop on port: " << selectedPort);
+        ecb (packet, header, Socket::ERROR_NOROUTETOHOST);
+        return false;
+      }
       ucb (route, packet, header);
 
-      Ipv4CongaRouting::PrintDreTable ();
-      Ipv4CongaRouting::PrintCongaToLeafTable ();
-      Ipv4CongaRouting::PrintCongaFromLeafTable ();
-
       return true;
     }
   }
@@ -557,7 +651,7 @@ Ipv4CongaRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr
     }
 
     // Determine the port using standard ECMP
-    uint32_t selectedPort = routeEntries[flowId % routeEntries.size ()].port;
+    uint32_t selectedPort = ports[flowId % ports.size ()];
 
     // Update local dre
     uint32_t X = Ipv4CongaRouting::UpdateLocalDre (header, packet, selectedPort);
@@ -577,6 +671,12 @@ Ipv4CongaRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr
     }
 
     Ptr<Ipv4Route> route = Ipv4CongaRouting::ConstructIpv4Route (selectedPort, destAddress);
+    if (route == 0)
+    {
+      NS_LOG_LOGIC (this << " No usable next hop on port: " << selectedPort);
+      ecb (packet, header, Socket::ERROR_NOROUTETOHOST);
+      return false;
+    }
     ucb (route, packet, header);
 
     return true;
@@ -586,21 +686,25 @@ Ipv4CongaRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr
 void
 Ipv4CongaRouting::NotifyInterfaceUp (uint32_t interface)
 {
+  m_routeCache->Refresh (interface);
 }
 
 void
 Ipv4CongaRouting::NotifyInterfaceDown (uint32_t interface)
 {
+  m_routeCache->Invalidate (interface);
 }
 
 void
 Ipv4CongaRouting::NotifyAddAddress (uint32_t interface, Ipv4InterfaceAddress address)
 {
+  m_routeCache->Refresh (interface);
 }
 
 void
 Ipv4CongaRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress address)
 {
+  m_routeCache->Invalidate (interface);
 }
 
 void
@@ -609,25 +713,97 @@ Ipv4CongaRouting::SetIpv4 (Ptr<Ipv4> ipv4)
   NS_LOG_LOGIC (this << "Setting up Ipv4: " << ipv4);
   NS_ASSERT (m_ipv4 == 0 && ipv4 != 0);
   m_ipv4 = ipv4;
+  m_routeCache = Ipv4EgressRouteCache::GetCache (ipv4);
 }
 
 void
 Ipv4CongaRouting::PrintRoutingTable (Ptr<OutputStreamWrapper> stream) const
 {
+  std::ostream* os = stream->GetStream ();
+
+  *os << "Node: " << m_ipv4->GetObject<Node> ()->GetId ()
+      << ", Time: " << Now ().As (Time::S)
+      << ", Ipv4CongaRouting table of "
+      << (m_isLeaf ? "leaf switch " : "spine switch");
+  if (m_isLeaf)
+  {
+    *os << m_leafId;
+  }
+  *os << std::endl;
+
+  *os << "Destination     Genmask         Iface" << std::endl;
+  std::vector<CongaRouteEntry>::const_iterator routeItr = m_routeEntryList.begin ();
+  for ( ; routeItr != m_routeEntryList.end (); ++routeItr)
+  {
+    std::ostringstream dest, mask;
+    dest << routeItr->network;
+    mask << routeItr->networkMask;
+    *os << std::setiosflags (std::ios::left) << std::setw (16) << dest.str ()
+        << std::setw (16) << mask.str () << routeItr->port << std::endl;
+  }
+
+  *os << "Local DRE" << std::endl
+      << "Port  X           Quantized X" << std::endl;
+  std::map<uint32_t, uint32_t>::const_iterator dreItr = m_XMap.begin ();
+  for ( ; dreItr != m_XMap.end (); ++dreItr)
+  {
+    *os << std::setw (6) << dreItr->first << std::setw (12) << dreItr->second
+        << QuantizingX (dreItr->first, dreItr->second) << std::endl;
+  }
+
+  if (m_isLeaf)
+  {
+    *os << "Congestion To Leaf Table" << std::endl
+        << "Leaf  Port  CE    Update time" << std::endl;
+    for (uint32_t leafId = 0; leafId < m_nLeaves; leafId++)
+    {
+      for (uint32_t port = 0; port < m_nPorts; port++)
+      {
+        if ((m_congaToLeafValid[leafId * m_nWords + port / 64] & (1ULL << (port % 64))) == 0)
+        {
+          continue;
+        }
+        const FeedbackInfo &toLeaf = m_congaToLeafTable[leafId * m_nPorts + port];
+        *os << std::setw (6) << leafId << std::setw (6) << port << std::setw (6) << toLeaf.ce
+            << toLeaf.updateTime.As (Time::S) << std::endl;
+      }
+    }
+
+    *os << "Congestion From Leaf Table" << std::endl
+        << "Leaf  Port  CE    Changed Update time" << std::endl;
+    for (uint32_t leafId = 0; leafId < m_nLeaves; leafId++)
+    {
+      for (uint32_t port = 0; port < m_nPorts; port++)
+      {
+        uint64_t bit = 1ULL << (port % 64);
+        uint32_t word = leafId * m_nWords + port / 64;
+        if ((m_congaFromLeafValid[word] & bit) == 0)
+        {
+          continue;
+        }
+        const FeedbackInfo &fromLeaf = m_congaFromLeafTable[leafId * m_nPorts + port];
+        *os << std::setw (6) << leafId << std::setw (6) << port << std::setw (6) << fromLeaf.ce
+            << std::setw (8) << ((m_congaFromLeafChanged[word] & bit) != 0)
+            << fromLeaf.updateTime.As (Time::S) << std::endl;
+      }
+    }
+
+    *os << "Flowlet Table" << std::endl;
+    m_flowletTable->Print (*os);
+  }
+  *os << std::resetiosflags (std::ios::left) << std::endl;
 }
 
 
 void
 Ipv4CongaRouting::DoDispose (void)
 {
-  std::map<uint32_t, Flowlet *>::iterator itr = m_flowletTable.begin ();
-  for ( ; itr != m_flowletTable.end (); ++itr )
-  {
-    delete (itr->second);
-  }
   m_dreEvent.Cancel ();
   m_agingEvent.Cancel ();
   m_ipv4=0;
+  m_routeCache = 0;
+  m_flowletTable = 0;
+  m_rand = 0;
   Ipv4RoutingProtocol::DoDispose ();
 }
 
@@ -662,8 +838,7 @@ Ipv4CongaRouting::DreEvent ()
     }
   }
 
-  NS_LOG_LOGIC (this << " Dre event finished, the dre table is now: ");
-  Ipv4CongaRouting::PrintDreTable ();
+  NS_LOG_LOGIC (this << " Dre event finished");
 
   if (!moveToIdleStatus)
   {
@@ -679,17 +854,19 @@ void
 Ipv4CongaRouting::AgingEvent ()
 {
     bool moveToIdleStatus = true;
-    std::map<uint32_t, std::map<uint32_t, std::pair<Time, uint32_t> > >::iterator itr =
-        m_congaToLeafTable.begin ();
-    for ( ; itr != m_congaToLeafTable.end (); ++itr)
+    Time now = Simulator::Now ();
+
+    // Only the valid entries are visited
+    for (uint32_t word = 0; word < m_congaToLeafValid.size (); ++word)
     {
-      std::map<uint32_t, std::pair<Time, uint32_t> >::iterator innerItr =
-        (itr->second).begin ();
-      for (; innerItr != (itr->second).end (); ++innerItr)
+      uint32_t leafId = word / m_nWords;
+      for (uint64_t bits = m_congaToLeafValid[word]; bits != 0; bits &= bits - 1)
       {
-        if (Simulator::Now () - (innerItr->second).first > m_agingTime)
+        uint32_t port = (word % m_nWords) * 64 + LowestSetBit (bits);
+        FeedbackInfo &toLeaf = m_congaToLeafTable[leafId * m_nPorts + port];
+        if (now - toLeaf.updateTime > m_agingTime)
         {
-          (innerItr->second).second = 0;
+          toLeaf.ce = 0;
         }
         else
         {
@@ -697,30 +874,27 @@ Ipv4CongaRouting::AgingEvent ()
         }
       }
     }
-    std::map<uint32_t, std::map<uint32_t, FeedbackInfo> >::iterator itr2 =
-        m_congaFromLeafTable.begin ();
-    for ( ; itr2 != m_congaFromLeafTable.end (); ++itr2 )
+
+    for (uint32_t word = 0; word < m_congaFromLeafValid.size (); ++word)
     {
-        std::map<uint32_t, FeedbackInfo>::iterator innerItr2 =
-          (itr2->second).begin ();
-        for ( ; innerItr2 != (itr2->second).end (); ++innerItr2)
+      uint32_t leafId = word / m_nWords;
+      for (uint64_t bits = m_congaFromLeafValid[word]; bits != 0; bits &= bits - 1)
+      {
+        uint64_t bit = bits & (~bits + 1);
+        uint32_t port = (word % m_nWords) * 64 + LowestSetBit (bits);
+        if (now - m_congaFromLeafTable[leafId * m_nPorts + port].updateTime > m_agingTime)
         {
-          if (Simulator::Now () - (innerItr2->second).updateTime > m_agingTime)
-          {
-            (itr2->second).erase (innerItr2);
-            if ((itr2->second).empty ())
-            {
-                m_congaFromLeafTable.erase (itr2);
-            }
-          }
-          else
-          {
-            moveToIdleStatus = false;
-          }
+          m_congaFromLeafValid[word] &= ~bit;
+          m_congaFromLeafChanged[word] &= ~bit;
+          m_congaFromLeafSize[leafId]--;
+        }
+        else
+        {
+          moveToIdleStatus = false;
         }
+      }
     }
 
-
     if (!moveToIdleStatus)
     {
       m_agingEvent = Simulator::Schedule(m_agingTime / 4, &Ipv4CongaRouting::AgingEvent, this);
@@ -732,10 +906,10 @@ Ipv4CongaRouting::AgingEvent ()
 }
 
 uint32_t
-Ipv4CongaRouting::QuantizingX (uint32_t interface, uint32_t X)
+Ipv4CongaRouting::QuantizingX (uint32_t interface, uint32_t X) const
 {
   DataRate c = m_C;
-  std::map<uint32_t, DataRate>::iterator itr = m_Cs.find (interface);
+  std::map<uint32_t, DataRate>::const_iterator itr = m_Cs.find (interface);
   if (itr != m_Cs.end ())
   {
     c = itr->second;
@@ -745,92 +919,4 @@ Ipv4CongaRouting::QuantizingX (uint32_t interface, uint32_t X)
   return static_cast<uint32_t>(ratio * std::pow(2, m_Q));
 }
 
-void
-Ipv4CongaRouting::PrintCongaToLeafTable ()
-{
-/*
-  std::ostringstream oss;
-  oss << "===== CongaToLeafTable For Leaf: " << m_leafId <<"=====" << std::endl;
-  std::map<uint32_t, std::map<uint32_t, uint32_t> >::iterator itr = m_congaToLeafTable.begin ();
-  for ( ; itr != m_congaToLeafTable.end (); ++itr )
-  {
-    oss << "Leaf ID: " << itr->first << std::endl<<"\t";
-    std::map<uint32_t, uint32_t>::iterator innerItr = (itr->second).begin ();
-    for ( ; innerItr != (itr->second).end (); ++innerItr)
-    {
-      oss << "{ port: "
-          << innerItr->first << ", ce: "  << (innerItr->second)
-          << " } ";
-    }
-    oss << std::endl;
-  }
-  oss << "============================";
-  NS_LOG_LOGIC (oss.str ());
-*/
-}
-
-void
-Ipv4CongaRouting::PrintCongaFromLeafTable ()
-{
-/*
-  std::ostringstream oss;
-  oss << "===== CongaFromLeafTable For Leaf: " << m_leafId << "=====" <<std::endl;
-  std::map<uint32_t, std::map<uint32_t, FeedbackInfo> >::iterator itr = m_congaFromLeafTable.begin ();
-  for ( ; itr != m_congaFromLeafTable.end (); ++itr )
-  {
-    oss << "Leaf ID: " << itr->first << std::endl << "\t";
-    std::map<uint32_t, FeedbackInfo>::iterator innerItr = (itr->second).begin ();
-    for ( ; innerItr != (itr->second).end (); ++innerItr)
-    {
-      oss << "{ port: "
-          << innerItr->first << ", ce: "  << (innerItr->second).ce
-          << ", change: " << (innerItr->second).change
-          << " } ";
-    }
-    oss << std::endl;
-  }
-  oss << "==============================";
-  NS_LOG_LOGIC (oss.str ());
-*/
-}
-
-void
-Ipv4CongaRouting::PrintFlowletTable ()
-{
-/*
-  std::ostringstream oss;
-  oss << "===== Flowlet For Leaf: " << m_leafId << "=====" << std::endl;
-  std::map<uint32_t, Flowlet*>::iterator itr = m_flowletTable.begin ();
-  for ( ; itr != m_flowletTable.end(); ++itr )
-  {
-    oss << "flowId: " << itr->first << std::endl << "\t"
-        << "port: " << (itr->second)->port << "\t"
-        << "activeTime" << (itr->second)->activeTime << std::endl;
-  }
-  oss << "===================";
-  NS_LOG_LOGIC (oss.str ());
-*/
 }
-
-void
-Ipv4CongaRouting::PrintDreTable ()
-{
-/*
-  std::ostringstream oss;
-  std::string switchType = m_isLeaf == true ? "leaf switch" : "spine switch";
-  oss << "==== Local Dre for " << switchType << " ====" <<std::endl;
-  std::map<uint32_t, uint32_t>::iterator itr = m_XMap.begin ();
-  for ( ; itr != m_XMap.end (); ++itr)
-  {
-    oss << "port: " << itr->first <<
-      ", X: " << itr->second <<
-      ", Quantized X: " << Ipv4CongaRouting::QuantizingX (itr->second) <<std::endl;
-  }
-  oss << "=================================";
-  NS_LOG_LOGIC (oss.str ());
-*/
-}
-
-
-}
-
@@ -3,6 +3,9 @@
 #define IPV4_CONGA_ROUTING_H
 
 #include "ns3/ipv4-routing-protocol.h"
+#include "ns3/ipv4-egress-route-cache.h"
+#include "ns3/ipv4-egress-port-table.h"
+#include "ns3/ipv4-flowlet-table.h"
 #include "ns3/ipv4-route.h"
 #include "ns3/object.h"
 #include "ns3/packet.h"
@@ -10,20 +13,15 @@
 #include "ns3/data-rate.h"
 #include "ns3/nstime.h"
 #include "ns3/event-id.h"
+#include "ns3/random-variable-stream.h"
 
 #include <map>
 #include <vector>
 
 namespace ns3 {
 
-struct Flowlet {
-  uint32_t port;
-  Time activeTime;
-};
-
 struct FeedbackInfo {
   uint32_t ce;
-  bool change;
   Time updateTime;
 };
 
@@ -63,6 +61,16 @@ public:
 
   void EnableEcmpMode ();
 
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by this model.  Return the number of streams (possibly zero) that
+   * have been assigned.
+   *
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned by this model
+   */
+  int64_t AssignStreams (int64_t stream);
+
   /* Inherit From Ipv4RoutingProtocol */
   virtual Ptr<Ipv4Route> RouteOutput (Ptr<Packet> p, const Ipv4Header &header, Ptr<NetDevice> oif, Socket::SocketErrno &sockerr);
   virtual bool RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr<const NetDevice> idev,
@@ -119,21 +127,41 @@ private:
   // Ipv4 associated with this router
   Ptr<Ipv4> m_ipv4;
 
+  // Routes through each port, shared with the other routing protocols of the node
+  Ptr<Ipv4EgressRouteCache> m_routeCache;
+
   // Route table
   std::vector<CongaRouteEntry> m_routeEntryList;
 
+  // Ports reaching each destination, compiled from the route table
+  Ipv4EgressPortTable m_portTable;
+
   // Ip and leaf switch map,
   // used to determine the which leaf switch the packet would go through
   std::map<Ipv4Address, uint32_t> m_ipLeafIdMap;
 
+  // Dimensions of the leaf tables below, indexed by leaf id * m_nPorts + port
+  uint32_t m_nLeaves;
+  uint32_t m_nPorts;
+
+  // Words of a leaf in the bitmaps below, bit i of a leaf is port i
+  uint32_t m_nWords;
+
   // Congestion To Leaf Table
-  std::map<uint32_t, std::map<uint32_t, std::pair<Time, uint32_t> > > m_congaToLeafTable;
+  std::vector<FeedbackInfo> m_congaToLeafTable;
+  std::vector<uint64_t> m_congaToLeafValid;
 
-  // Congestion From Leaf Table
-  std::map<uint32_t, std::map<uint32_t, FeedbackInfo> > m_congaFromLeafTable;
+  // Congestion From Leaf Table, with the entries not yet fed back to the leaf
+  std::vector<FeedbackInfo> m_congaFromLeafTable;
+  std::vector<uint64_t> m_congaFromLeafValid;
+  std::vector<uint64_t> m_congaFromLeafChanged;
+  std::vector<uint32_t> m_congaFromLeafSize;
 
   // Flowlet Table
-  std::map<uint32_t, Flowlet *> m_flowletTable;
+  Ptr<Ipv4FlowletTable> m_flowletTable;
+
+  // Draws a good port when none is cached
+  Ptr<UniformRandomVariable> m_rand;
 
   // Parameters
   // DRE
@@ -149,18 +177,14 @@ private:
 
   // Quantizing X to metrics degree
   // X is bytes here and we quantizing it to 0 - 2^Q
-  uint32_t QuantizingX (uint32_t interface, uint32_t X);
+  uint32_t QuantizingX (uint32_t interface, uint32_t X) const;
+
+  // Grow the leaf tables to hold the entry of a leaf and port
+  void ResizeLeafTables (uint32_t leafId, uint32_t port);
 
   std::vector<CongaRouteEntry> LookupCongaRouteEntries (Ipv4Address dest);
 
   Ptr<Ipv4Route> ConstructIpv4Route (uint32_t port, Ipv4Address destAddress);
-
-  // Debug use
-  void PrintCongaToLeafTable ();
-  void PrintCongaFromLeafTable ();
-  void PrintFlowletTable ();
-  void PrintDreTable ();
-
 };
 
 }
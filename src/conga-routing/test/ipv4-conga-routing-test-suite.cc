@@ -6,6 +6,14 @@
 // An essential include is test.h
 #include "ns3/test.h"
 
+#include "ns3/ipv4-conga-tag.h"
+#include "ns3/flow-id-tag.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/node-container.h"
+#include "ns3/simulator.h"
+
 // Do not put your test classes in namespace ns3.  You may find it useful
 // to use the using directive to access the ns3 namespace directly
 using namespace ns3;
@@ -46,6 +54,205 @@ Ipv4CongaRoutingTestCase1::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ_TOL (0.01, 0.01, 0.001, "Numbers are not equal within tolerance");
 }
 
+/**
+ * \brief Check which Congestion-From-Leaf entry a leaf feeds back, and the
+ * aging of the Congestion-From-Leaf and Congestion-To-Leaf entries.
+ *
+ * The leaf has four ports: 1 to 3 reach leaf 1, 4 reaches its own host.
+ */
+class Ipv4CongaRoutingFeedbackTestCase : public TestCase
+{
+public:
+  Ipv4CongaRoutingFeedbackTestCase ();
+  virtual ~Ipv4CongaRoutingFeedbackTestCase ();
+
+private:
+  /**
+   * \brief Route a packet coming from leaf 1.
+   * \param lbTag the uplink port of leaf 1 the packet went through
+   * \param ce the congestion of its path
+   * \param fbLbTag the port of this leaf fed back by leaf 1
+   * \param fbMetric the congestion fed back for fbLbTag
+   */
+  void Receive (uint32_t lbTag, uint32_t ce, uint32_t fbLbTag, uint32_t fbMetric);
+  /**
+   * \brief Route a packet going to leaf 1, keeping its Conga tag.
+   * \param flowId the flow of the packet
+   */
+  void Send (uint32_t flowId);
+  /**
+   * \brief Check the feedback of the last packet sent.
+   * \param fbLbTag the expected port fed back
+   * \param fbMetric the expected congestion fed back
+   */
+  void CheckFeedback (uint32_t fbLbTag, uint32_t fbMetric);
+  /// Check the tables once every entry has aged
+  void CheckAged (void);
+  /**
+   * \brief Keep a forwarded packet.
+   * \param route the route of the packet
+   * \param p the packet
+   * \param header the IPv4 header of the packet
+   */
+  void Forward (Ptr<Ipv4Route> route, Ptr<const Packet> p, const Ipv4Header &header);
+  /**
+   * \brief Record a dropped packet.
+   * \param p the packet
+   * \param header the IPv4 header of the packet
+   * \param sockerr the error
+   */
+  void Drop (Ptr<const Packet> p, const Ipv4Header &header, Socket::SocketErrno sockerr);
+  virtual void DoRun (void);
+
+  Ptr<Ipv4CongaRouting> m_routing;   //!< The routing of the leaf
+  Ptr<Ipv4> m_ipv4;                  //!< The Ipv4 of the leaf
+  Ipv4CongaTag m_tag;                //!< Conga tag of the last packet sent
+  uint32_t m_drops;                  //!< Number of dropped packets
+};
+
+Ipv4CongaRoutingFeedbackTestCase::Ipv4CongaRoutingFeedbackTestCase ()
+  : TestCase ("Conga feedback selection and aging"),
+    m_drops (0)
+{
+}
+
+Ipv4CongaRoutingFeedbackTestCase::~Ipv4CongaRoutingFeedbackTestCase ()
+{
+}
+
+void
+Ipv4CongaRoutingFeedbackTestCase::Forward (Ptr<Ipv4Route> route, Ptr<const Packet> p, const Ipv4Header &header)
+{
+  p->PeekPacketTag (m_tag);
+}
+
+void
+Ipv4CongaRoutingFeedbackTestCase::Drop (Ptr<const Packet> p, const Ipv4Header &header, Socket::SocketErrno sockerr)
+{
+  m_drops++;
+}
+
+void
+Ipv4CongaRoutingFeedbackTestCase::Receive (uint32_t lbTag, uint32_t ce, uint32_t fbLbTag, uint32_t fbMetric)
+{
+  Ptr<Packet> packet = Create<Packet> (100);
+  packet->AddPacketTag (FlowIdTag (100));
+  Ipv4CongaTag tag;
+  tag.SetLbTag (lbTag);
+  tag.SetCe (ce);
+  tag.SetFbLbTag (fbLbTag);
+  tag.SetFbMetric (fbMetric);
+  packet->AddPacketTag (tag);
+  Ipv4Header header;
+  header.SetSource (Ipv4Address ("10.2.0.1"));
+  header.SetDestination (Ipv4Address ("10.1.0.1"));
+  m_routing->RouteInput (packet, header, m_ipv4->GetNetDevice (1),
+                         MakeCallback (&Ipv4CongaRoutingFeedbackTestCase::Forward, this),
+                         MakeNullCallback<void, Ptr<Ipv4MulticastRoute>, Ptr<const Packet>, const Ipv4Header &> (),
+                         MakeNullCallback<void, Ptr<const Packet>, const Ipv4Header &, uint32_t> (),
+                         MakeCallback (&Ipv4CongaRoutingFeedbackTestCase::Drop, this));
+}
+
+void
+Ipv4CongaRoutingFeedbackTestCase::Send (uint32_t flowId)
+{
+  Ptr<Packet> packet = Create<Packet> (100);
+  packet->AddPacketTag (FlowIdTag (flowId));
+  Ipv4Header header;
+  header.SetSource (Ipv4Address ("10.1.0.1"));
+  header.SetDestination (Ipv4Address ("10.2.0.1"));
+  m_tag = Ipv4CongaTag ();
+  m_tag.SetFbLbTag (12345);
+  m_routing->RouteInput (packet, header, m_ipv4->GetNetDevice (4),
+                         MakeCallback (&Ipv4CongaRoutingFeedbackTestCase::Forward, this),
+                         MakeNullCallback<void, Ptr<Ipv4MulticastRoute>, Ptr<const Packet>, const Ipv4Header &> (),
+                         MakeNullCallback<void, Ptr<const Packet>, const Ipv4Header &, uint32_t> (),
+                         MakeCallback (&Ipv4CongaRoutingFeedbackTestCase::Drop, this));
+}
+
+void
+Ipv4CongaRoutingFeedbackTestCase::CheckFeedback (uint32_t fbLbTag, uint32_t fbMetric)
+{
+  NS_TEST_EXPECT_MSG_EQ (m_tag.GetFbLbTag (), fbLbTag, "Wrong port fed back at " << Simulator::Now ().GetMilliSeconds () << " ms");
+  NS_TEST_EXPECT_MSG_EQ (m_tag.GetFbMetric (), fbMetric, "Wrong congestion fed back for port " << fbLbTag);
+}
+
+void
+Ipv4CongaRoutingFeedbackTestCase::CheckAged (void)
+{
+  // The Congestion-From-Leaf entries are 15 ms old: nothing to feed back
+  Send (1);
+  CheckFeedback (0, 0);
+
+  // The congestion of port 2 to leaf 1 aged to zero, ports 1 and 3 are
+  // fresh and congested: a new flowlet goes through port 2
+  Receive (1, 0, 1, 5);
+  Receive (1, 0, 3, 5);
+  Send (2);
+  NS_TEST_EXPECT_MSG_EQ (m_tag.GetLbTag (), 2, "The aged port is not the least congested");
+}
+
+void
+Ipv4CongaRoutingFeedbackTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (2);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  SimpleNetDeviceHelper devHelper;
+  Ipv4AddressHelper address;
+  address.SetBase ("10.0.1.0", "255.255.255.0");
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      address.Assign (devHelper.Install (nodes));
+      address.NewNetwork ();
+    }
+
+  m_ipv4 = nodes.Get (0)->GetObject<Ipv4> ();
+  m_routing = CreateObject<Ipv4CongaRouting> ();
+  m_routing->SetIpv4 (m_ipv4);
+  m_routing->SetLeafId (0);
+  m_routing->AddAddressToLeafIdMap (Ipv4Address ("10.1.0.1"), 0);
+  m_routing->AddAddressToLeafIdMap (Ipv4Address ("10.2.0.1"), 1);
+  for (uint32_t port = 1; port <= 3; port++)
+    {
+      m_routing->AddRoute (Ipv4Address ("10.2.0.0"), Ipv4Mask ("/16"), port);
+    }
+  m_routing->AddRoute (Ipv4Address ("10.1.0.0"), Ipv4Mask ("/16"), 4);
+
+  // Leaf 1 reports its uplinks 1, 2 and 70, the last one in the second
+  // word of the bitmaps, and the congestion of port 2 to it
+  Receive (1, 3, 2, 7);
+  Receive (2, 4, 0, 0);
+  Receive (70, 5, 0, 0);
+
+  // Each changed entry is fed back once, in the round robin order
+  Send (1);
+  CheckFeedback (1, 3);
+  Send (1);
+  CheckFeedback (2, 4);
+  Send (1);
+  CheckFeedback (70, 5);
+  // Nothing changed: the round robin goes on
+  Send (1);
+  CheckFeedback (1, 3);
+  // The round robin is at port 2, but the changed port 70 is preferred
+  Receive (70, 6, 0, 0);
+  Send (1);
+  CheckFeedback (70, 6);
+  Send (1);
+  CheckFeedback (70, 6);
+
+  Simulator::Schedule (MilliSeconds (15), &Ipv4CongaRoutingFeedbackTestCase::CheckAged, this);
+  Simulator::Stop (MilliSeconds (100));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_drops, 0, "Unexpected drops");
+
+  m_routing = 0;
+  m_ipv4 = 0;
+  Simulator::Destroy ();
+}
+
 // The TestSuite class names the TestSuite, identifies what type of TestSuite,
 // and enables the TestCases to be run.  Typically, only the constructor for
 // this class must be defined
@@ -61,6 +268,7 @@ CongaRoutingTestSuite::CongaRoutingTestSuite ()
 {
   // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
   AddTestCase (new Ipv4CongaRoutingTestCase1, TestCase::QUICK);
+  AddTestCase (new Ipv4CongaRoutingFeedbackTestCase, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite
@@ -52,12 +52,6 @@ CongestionProbing::GetTypeId (void)
     return tid;
 }
 
-template<typename T>
-T rand_range (T min, T max)
-{
-    return min + ((double)max - min) * rand () / RAND_MAX;
-}
-
 TypeId
 CongestionProbing::GetInstanceTypeId () const
 {
@@ -75,6 +69,7 @@ CongestionProbing::CongestionProbing ()
       m_probeTimeout (Seconds (0.1))
 {
     NS_LOG_FUNCTION (this);
+    m_rand = CreateObject<UniformRandomVariable> ();
 }
 
 CongestionProbing::CongestionProbing (const CongestionProbing &other)
@@ -90,6 +85,7 @@ CongestionProbing::CongestionProbing (const CongestionProbing &other)
       m_probingTimeoutCallback (other.m_probingTimeoutCallback)
 {
     NS_LOG_FUNCTION (this);
+    m_rand = CreateObject<UniformRandomVariable> ();
 }
 
 CongestionProbing::~CongestionProbing ()
@@ -97,6 +93,14 @@ CongestionProbing::~CongestionProbing ()
     NS_LOG_FUNCTION (this);
 }
 
+int64_t
+CongestionProbing::AssignStreams (int64_t stream)
+{
+    NS_LOG_FUNCTION (this << stream);
+    m_rand->SetStream (stream);
+    return 1;
+}
+
 void
 CongestionProbing::DoDispose ()
 {
@@ -192,7 +196,7 @@ CongestionProbing::ProbeEvent ()
     // Add timeout
     m_probingTimeoutMap[m_id] = Simulator::Schedule (m_probeTimeout, &CongestionProbing::ProbeEventTimeout, this, m_id);
 
-    double noise = rand_range (0.0, m_probeTimeout.GetSeconds ());
+    double noise = m_rand->GetValue (0.0, m_probeTimeout.GetSeconds ());
     Time noiseTime = Seconds (noise);
 
     m_probeEvent = Simulator::Schedule (m_probeInterval + noiseTime, &CongestionProbing::ProbeEvent, this);
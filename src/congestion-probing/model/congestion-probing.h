@@ -8,6 +8,7 @@
 #include "ns3/ipv4-address.h"
 #include "ns3/nstime.h"
 #include "ns3/event-id.h"
+#include "ns3/random-variable-stream.h"
 #include <vector>
 #include <map>
 
@@ -50,6 +51,9 @@ public:
 
     void ReceivePacket (Ptr<Socket> socket);
 
+    // Use fixed streams for the probe jitter, returns the number of streams assigned
+    int64_t AssignStreams (int64_t stream);
+
     typedef void (*ProbingCallback)
         (uint32_t pathId, Ptr<Packet> packet, Ipv4Header header, Time rtt, bool isCE);
 
@@ -80,6 +84,8 @@ private:
     TracedCallback <uint32_t, Ptr<Packet>, Ipv4Header ,Time, bool> m_probingCallback;
 
     TracedCallback <uint32_t> m_probingTimeoutCallback;
+
+    Ptr<UniformRandomVariable> m_rand; // Jitter of the probes
 };
 
 }
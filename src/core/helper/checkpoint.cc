@@ -0,0 +1,56 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "checkpoint.h"
+#include "sweep-runner.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+
+/**
+ * \file
+ * \ingroup simulator
+ * ns3::Checkpoint implementation.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("Checkpoint");
+
+void
+Checkpoint::Fork (SweepRunner *runner, Callback<void, uint32_t> job)
+{
+  NS_LOG_FUNCTION (runner);
+  int32_t i = runner->Fork ();
+  if (i < 0)
+    {
+      Simulator::Stop ();
+    }
+  else if (!job.IsNull ())
+    {
+      job (i);
+    }
+}
+
+void
+Checkpoint::Schedule (const Time &time, SweepRunner *runner,
+                      Callback<void, uint32_t> job)
+{
+  NS_LOG_FUNCTION (time << runner);
+  Simulator::Schedule (time - Simulator::Now (), &Checkpoint::Fork,
+                       runner, job);
+}
+
+} // namespace ns3
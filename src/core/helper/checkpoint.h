@@ -0,0 +1,74 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "ns3/nstime.h"
+#include "ns3/callback.h"
+#include <stdint.h>
+
+/**
+ * \file
+ * \ingroup simulator
+ * ns3::Checkpoint declaration.
+ */
+
+namespace ns3 {
+
+class SweepRunner;
+
+/**
+ * \ingroup simulator
+ * \brief Fork the workers of a sweep from a warmed up simulation.
+ *
+ * A checkpoint does not save the state of the simulation: the pending
+ * events hold bound callbacks and raw pointers, and the queues, sockets
+ * and routing protocols have no serialization.  It forks the workers of
+ * a SweepRunner at a given simulation time instead, so that they share
+ * the warm up copy on write and only run their measurement window.
+ */
+class Checkpoint
+{
+public:
+  /**
+   * Fork the workers of a sweep at a given time.
+   *
+   * At \p time, call SweepRunner::Fork.  Each worker calls \p job with
+   * the number of its job and continues the simulation.  The original
+   * process stops its simulation once all workers exited, and then
+   * merges the rows with SweepRunner::Merge.
+   *
+   * \param [in] time The time of the checkpoint.
+   * \param [in] runner The sweep, with its jobs.
+   * \param [in] job The function called in each worker.
+   */
+  static void Schedule (const Time &time, SweepRunner *runner,
+                        Callback<void, uint32_t> job);
+
+private:
+  /**
+   * Fork the workers of a sweep.
+   *
+   * \param [in] runner The sweep.
+   * \param [in] job The function called in each worker.
+   */
+  static void Fork (SweepRunner *runner, Callback<void, uint32_t> job);
+};
+
+} // namespace ns3
+
+#endif /* CHECKPOINT_H */
@@ -0,0 +1,275 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "sweep-runner.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/assert.h"
+#include "ns3/fatal-error.h"
+#include "ns3/log.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SweepRunner");
+
+SweepRunner::SweepRunner ()
+  : m_replications (1),
+    m_firstRun (1),
+    m_parallel (0),
+    m_worker (-1),
+    m_running (0),
+    m_failures (0)
+{
+  NS_LOG_FUNCTION (this);
+  long processors = sysconf (_SC_NPROCESSORS_ONLN);
+  m_parallel = processors > 0 ? processors : 1;
+}
+
+void
+SweepRunner::AddParameter (const std::string &name)
+{
+  NS_LOG_FUNCTION (this << name);
+  NS_ASSERT_MSG (m_jobs.empty (), "Add the parameters before the jobs");
+  m_parameters.push_back (name);
+}
+
+void
+SweepRunner::AddColumn (const std::string &name)
+{
+  NS_LOG_FUNCTION (this << name);
+  m_columns.push_back (name);
+}
+
+uint32_t
+SweepRunner::AddJob (const std::vector<std::string> &values)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT_MSG (values.size () == m_parameters.size (), "Wrong number of parameter values");
+  m_jobs.push_back (values);
+  return m_jobs.size () - 1;
+}
+
+void
+SweepRunner::SetReplications (uint32_t replications)
+{
+  NS_LOG_FUNCTION (this << replications);
+  NS_ASSERT (replications > 0);
+  m_replications = replications;
+}
+
+void
+SweepRunner::SetFirstRun (uint64_t run)
+{
+  NS_LOG_FUNCTION (this << run);
+  m_firstRun = run;
+}
+
+void
+SweepRunner::SetParallel (uint32_t parallel)
+{
+  NS_LOG_FUNCTION (this << parallel);
+  NS_ASSERT (parallel > 0);
+  m_parallel = parallel;
+}
+
+std::string
+SweepRunner::GetPartName (uint32_t worker) const
+{
+  std::ostringstream oss;
+  oss << m_partDir << "/" << worker << ".part";
+  return oss.str ();
+}
+
+int32_t
+SweepRunner::Fork (void)
+{
+  NS_LOG_FUNCTION (this);
+  const char *tmp = std::getenv ("TMPDIR");
+  std::string dir = std::string (tmp != 0 ? tmp : "/tmp") + "/ns3-sweep-XXXXXX";
+  std::vector<char> name (dir.begin (), dir.end ());
+  name.push_back ('\0');
+  if (mkdtemp (&name[0]) == 0)
+    {
+      NS_FATAL_ERROR ("Cannot create " << dir << ": " << std::strerror (errno));
+    }
+  m_partDir = &name[0];
+  uint32_t workers = m_jobs.size () * m_replications;
+  NS_LOG_INFO ("Run " << workers << " workers, " << m_parallel << " at a time");
+  // The workers would write the buffered output again
+  std::cout.flush ();
+  std::cerr.flush ();
+  std::fflush (0);
+  for (uint32_t worker = 0; worker < workers; worker++)
+    {
+      while (m_running >= m_parallel)
+        {
+          Wait ();
+        }
+      pid_t pid = fork ();
+      if (pid < 0)
+        {
+          NS_FATAL_ERROR ("Cannot fork worker " << worker << ": " << std::strerror (errno));
+        }
+      if (pid == 0)
+        {
+          m_worker = worker;
+          m_running = 0;
+          m_failures = 0;
+          RngSeedManager::SetRun (GetRun ());
+          RandomVariableStream::ReseedAll ();
+          std::srand (GetRun ());
+          m_part.open (GetPartName (worker).c_str ());
+          m_part.precision (15);
+          return GetJob ();
+        }
+      NS_LOG_DEBUG ("worker " << worker << " pid " << pid);
+      m_running++;
+    }
+  while (m_running > 0)
+    {
+      Wait ();
+    }
+  return -1;
+}
+
+void
+SweepRunner::Wait (void)
+{
+  int status;
+  pid_t pid;
+  do
+    {
+      pid = waitpid (-1, &status, 0);
+    }
+  while (pid < 0 && errno == EINTR);
+  if (pid < 0)
+    {
+      NS_FATAL_ERROR ("Cannot wait for the workers: " << std::strerror (errno));
+    }
+  if (!WIFEXITED (status) || WEXITSTATUS (status) != 0)
+    {
+      NS_LOG_WARN ("Worker process " << pid << " failed with status " << status);
+      m_failures++;
+    }
+  m_running--;
+}
+
+bool
+SweepRunner::Merge (const std::string &filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+  NS_ASSERT_MSG (m_worker < 0, "Only the original process merges the rows");
+  std::ofstream out (filename.c_str ());
+  if (!out.is_open ())
+    {
+      NS_FATAL_ERROR ("Cannot open " << filename);
+    }
+  for (uint32_t i = 0; i < m_parameters.size (); i++)
+    {
+      out << m_parameters[i] << "\t";
+    }
+  out << "replication\trun";
+  for (uint32_t i = 0; i < m_columns.size (); i++)
+    {
+      out << "\t" << m_columns[i];
+    }
+  out << "\n";
+  bool ok = m_failures == 0;
+  uint32_t workers = m_jobs.size () * m_replications;
+  for (uint32_t worker = 0; worker < workers; worker++)
+    {
+      std::string name = GetPartName (worker);
+      std::ifstream part (name.c_str ());
+      if (!part.is_open ())
+        {
+          NS_LOG_WARN ("No rows from worker " << worker);
+          ok = false;
+          continue;
+        }
+      if (part.peek () != std::ifstream::traits_type::eof ())
+        {
+          out << part.rdbuf ();
+        }
+      part.close ();
+      std::remove (name.c_str ());
+    }
+  rmdir (m_partDir.c_str ());
+  return ok;
+}
+
+uint32_t
+SweepRunner::GetJob (void) const
+{
+  NS_ASSERT (m_worker >= 0);
+  return m_worker / m_replications;
+}
+
+uint32_t
+SweepRunner::GetReplication (void) const
+{
+  NS_ASSERT (m_worker >= 0);
+  return m_worker % m_replications;
+}
+
+uint64_t
+SweepRunner::GetRun (void) const
+{
+  return m_firstRun + GetReplication ();
+}
+
+std::string
+SweepRunner::GetParameter (const std::string &name) const
+{
+  for (uint32_t i = 0; i < m_parameters.size (); i++)
+    {
+      if (m_parameters[i] == name)
+        {
+          return m_jobs[GetJob ()][i];
+        }
+    }
+  NS_FATAL_ERROR ("No parameter " << name);
+  return "";
+}
+
+void
+SweepRunner::AddRow (const std::vector<double> &values)
+{
+  NS_ASSERT_MSG (m_worker >= 0, "Only the workers write rows");
+  NS_ASSERT_MSG (values.size () == m_columns.size (), "Wrong number of values");
+  const std::vector<std::string> &job = m_jobs[GetJob ()];
+  for (uint32_t i = 0; i < job.size (); i++)
+    {
+      m_part << job[i] << "\t";
+    }
+  m_part << GetReplication () << "\t" << GetRun ();
+  for (uint32_t i = 0; i < values.size (); i++)
+    {
+      m_part << "\t" << values[i];
+    }
+  m_part << "\n";
+}
+
+} // namespace ns3
@@ -0,0 +1,168 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SWEEP_RUNNER_H
+#define SWEEP_RUNNER_H
+
+#include <stdint.h>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief Run the points of a parameter sweep in worker processes forked
+ * from one built topology.
+ *
+ * The program builds the part of the simulation shared by every point,
+ * like the nodes, links, addresses and routes, then calls Fork.  Fork
+ * starts one worker per job and replication, at most one per processor
+ * at a time.  Each worker shares the built
+ * topology copy on write, sets up its job, runs it and writes its
+ * results with AddRow.  The original process merges the rows of the
+ * workers, in the order of the jobs, in one file of tab separated
+ * columns: the parameters of the job, the replication, the run and the
+ * result columns.
+ *
+ * The run of a replication is the first run plus the number of the
+ * replication, whatever the job: the jobs of a replication draw the same
+ * random numbers.  Each worker sets its run with RngSeedManager::SetRun,
+ * then seeds again the random streams of the built topology, like the
+ * ones of the routing protocols and of ARP, with
+ * RandomVariableStream::ReseedAll, and seeds the libc rand () with its
+ * run.  Every stream of a worker thus draws from the run of the worker,
+ * not from the one of the original process.
+ *
+ * The workers write their rows in a temporary directory, under TMPDIR
+ * or /tmp, which Merge removes.
+ *
+ * \code
+ *   SweepRunner runner;
+ *   runner.AddParameter ("load");
+ *   runner.AddColumn ("fct");
+ *   runner.AddJob (std::vector<std::string> (1, "0.5"));
+ *   runner.SetReplications (3);
+ *   // build the topology
+ *   if (runner.Fork () < 0)
+ *     {
+ *       return runner.Merge ("sweep.tsv") ? 0 : 1;
+ *     }
+ *   // set up the job runner.GetJob (), run, then runner.AddRow (...)
+ * \endcode
+ */
+class SweepRunner
+{
+public:
+  SweepRunner ();
+
+  /**
+   * Add a parameter column, set by each job.
+   * \param [in] name The name of the column.
+   */
+  void AddParameter (const std::string &name);
+  /**
+   * Add a result column, written by the workers.
+   * \param [in] name The name of the column.
+   */
+  void AddColumn (const std::string &name);
+  /**
+   * Add a job.
+   * \param [in] values The values of the parameters of the job.
+   * \returns The number of the job.
+   */
+  uint32_t AddJob (const std::vector<std::string> &values);
+  /**
+   * \param [in] replications The number of replications of each job.
+   */
+  void SetReplications (uint32_t replications);
+  /**
+   * \param [in] run The run of the first replication.
+   */
+  void SetFirstRun (uint64_t run);
+  /**
+   * \param [in] parallel The maximum number of workers run at the same
+   *            time, by default the number of processors.
+   */
+  void SetParallel (uint32_t parallel);
+
+  /**
+   * Fork the workers.
+   *
+   * \returns The number of the job in a worker, or -1 in the original
+   *          process once all workers exited.
+   */
+  int32_t Fork (void);
+  /**
+   * Merge the rows of the workers, in the original process.
+   * \param [in] filename The name of the output file.
+   * \returns \c true if every worker succeeded.
+   */
+  bool Merge (const std::string &filename);
+
+  /** \returns The number of the job of this worker. */
+  uint32_t GetJob (void) const;
+  /** \returns The replication of this worker. */
+  uint32_t GetReplication (void) const;
+  /** \returns The run of this worker. */
+  uint64_t GetRun (void) const;
+  /**
+   * \param [in] name The name of a parameter.
+   * \returns The value of the parameter in the job of this worker.
+   */
+  std::string GetParameter (const std::string &name) const;
+  /**
+   * Write a row of results, in a worker.
+   * \param [in] values The values of the result columns.
+   */
+  void AddRow (const std::vector<double> &values);
+
+private:
+  /**
+   * \param [in] worker The number of a worker.
+   * \returns The name of the temporary file of the worker.
+   */
+  std::string GetPartName (uint32_t worker) const;
+  /** Wait for a worker to exit and record its status. */
+  void Wait (void);
+
+  /** The names of the parameters. */
+  std::vector<std::string> m_parameters;
+  /** The names of the result columns. */
+  std::vector<std::string> m_columns;
+  /** The values of the parameters of each job. */
+  std::vector<std::vector<std::string> > m_jobs;
+  /** The number of replications of each job. */
+  uint32_t m_replications;
+  /** The run of the first replication. */
+  uint64_t m_firstRun;
+  /** The maximum number of workers at the same time. */
+  uint32_t m_parallel;
+  /** The directory of the rows of the workers. */
+  std::string m_partDir;
+  /** The worker of this process, or -1. */
+  int32_t m_worker;
+  /** The number of running workers, in the original process. */
+  uint32_t m_running;
+  /** The number of workers which exited with an error or a signal. */
+  uint32_t m_failures;
+  /** The rows of this worker. */
+  std::ofstream m_part;
+};
+
+} // namespace ns3
+
+#endif /* SWEEP_RUNNER_H */
@@ -0,0 +1,144 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef ATOMIC_COUNT_H
+#define ATOMIC_COUNT_H
+
+#include "ns3/core-config.h"
+
+/**
+ * \file
+ * \ingroup thread
+ * Counters shared by the threads of the multithreaded simulator.
+ *
+ * The reference counts of the smart pointers and of the packet data,
+ * the packet uid and the RNG stream counters are only touched by one
+ * thread, unless ns-3 is configured with --enable-multithreaded-simulator.
+ * These functions are atomic operations in that configuration, and plain
+ * arithmetic otherwise, so that sequential simulations do not pay for
+ * the locked instructions.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup thread
+ * Increment a counter.
+ *
+ * \tparam T \deduced The type of the counter.
+ * \param [in,out] count The counter.
+ */
+template <typename T>
+inline void
+AtomicIncrement (T *count)
+{
+#ifdef ENABLE_MULTITHREADED_SIMULATOR
+  __atomic_add_fetch (count, 1, __ATOMIC_RELAXED);
+#else
+  (*count)++;
+#endif
+}
+
+/**
+ * \ingroup thread
+ * Decrement a counter, releasing the writes of this thread to the one
+ * which sees it drop to zero.
+ *
+ * \tparam T \deduced The type of the counter.
+ * \param [in,out] count The counter.
+ * \returns The new value of the counter.
+ */
+template <typename T>
+inline T
+AtomicDecrement (T *count)
+{
+#ifdef ENABLE_MULTITHREADED_SIMULATOR
+  return __atomic_sub_fetch (count, 1, __ATOMIC_ACQ_REL);
+#else
+  return --(*count);
+#endif
+}
+
+/**
+ * \ingroup thread
+ * Increment a counter.
+ *
+ * \tparam T \deduced The type of the counter.
+ * \param [in,out] count The counter.
+ * \returns The value of the counter before the increment.
+ */
+template <typename T>
+inline T
+AtomicFetchAndIncrement (T *count)
+{
+#ifdef ENABLE_MULTITHREADED_SIMULATOR
+  return __atomic_fetch_add (count, 1, __ATOMIC_RELAXED);
+#else
+  return (*count)++;
+#endif
+}
+
+/**
+ * \ingroup thread
+ * Read a value, with the writes released by its last update.
+ *
+ * \tparam T \deduced The type of the value.
+ * \param [in] value The value.
+ * \returns The value.
+ */
+template <typename T>
+inline T
+AtomicLoad (const T *value)
+{
+#ifdef ENABLE_MULTITHREADED_SIMULATOR
+  return __atomic_load_n (value, __ATOMIC_ACQUIRE);
+#else
+  return *value;
+#endif
+}
+
+/**
+ * \ingroup thread
+ * Replace a value if it equals the expected one.
+ *
+ * \tparam T \deduced The type of the value.
+ * \param [in,out] value The value.
+ * \param [in,out] expected The expected value, set to the current value
+ *                 if the replacement failed.
+ * \param [in] desired The new value.
+ * \returns \c true if the value was replaced.
+ */
+template <typename T>
+inline bool
+AtomicCompareExchange (T *value, T *expected, T desired)
+{
+#ifdef ENABLE_MULTITHREADED_SIMULATOR
+  return __atomic_compare_exchange_n (value, expected, desired,
+                                      false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+#else
+  if (*value == *expected)
+    {
+      *value = desired;
+      return true;
+    }
+  *expected = *value;
+  return false;
+#endif
+}
+
+} // namespace ns3
+
+#endif /* ATOMIC_COUNT_H */
@@ -0,0 +1,248 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "dary-heap-scheduler.h"
+#include "event-impl.h"
+#include "assert.h"
+#include "log.h"
+
+#include <algorithm>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Implementation of ns3::DaryHeapScheduler class.
+ */
+
+namespace {
+
+/** Index of the root of the heap. */
+const uint32_t ROOT = 3;
+/** Number of keys in a cache line. */
+const uint32_t KEYS_PER_LINE = 4;
+/** Size of a cache line. */
+const uintptr_t CACHE_LINE = 64;
+/** Initial number of indexes. */
+const uint32_t INITIAL_CAPACITY = 256;
+
+} // anonymous namespace
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("DaryHeapScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED (DaryHeapScheduler);
+
+TypeId
+DaryHeapScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::DaryHeapScheduler")
+    .SetParent<Scheduler> ()
+    .SetGroupName ("Core")
+    .AddConstructor<DaryHeapScheduler> ()
+  ;
+  return tid;
+}
+
+DaryHeapScheduler::DaryHeapScheduler ()
+  : m_keys (0),
+    m_capacity (0),
+    m_last (ROOT - 1)
+{
+  NS_LOG_FUNCTION (this);
+  Grow ();
+}
+
+DaryHeapScheduler::~DaryHeapScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint32_t
+DaryHeapScheduler::Parent (uint32_t id)
+{
+  return id / KEYS_PER_LINE + 2;
+}
+
+uint32_t
+DaryHeapScheduler::FirstChild (uint32_t id)
+{
+  return KEYS_PER_LINE * (id - 2);
+}
+
+void
+DaryHeapScheduler::Grow (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t capacity = m_capacity == 0 ? INITIAL_CAPACITY : 2 * m_capacity;
+  std::vector<Scheduler::EventKey> buffer (capacity + KEYS_PER_LINE);
+  Scheduler::EventKey *keys = &buffer[0];
+  uintptr_t address = reinterpret_cast<uintptr_t> (keys);
+  if (address % sizeof (Scheduler::EventKey) == 0)
+    {
+      keys += ((CACHE_LINE - address % CACHE_LINE) % CACHE_LINE) / sizeof (Scheduler::EventKey);
+    }
+  if (m_keys != 0)
+    {
+      std::copy (m_keys + ROOT, m_keys + m_last + 1, keys + ROOT);
+    }
+  m_buffer.swap (buffer);
+  m_keys = keys;
+  m_impls.resize (capacity);
+  m_capacity = capacity;
+}
+
+void
+DaryHeapScheduler::SiftUp (uint32_t hole, const Event &ev)
+{
+  while (hole > ROOT)
+    {
+      uint32_t parent = Parent (hole);
+      if (!(ev.key < m_keys[parent]))
+        {
+          break;
+        }
+      m_keys[hole] = m_keys[parent];
+      m_impls[hole] = m_impls[parent];
+      m_impls[hole]->SetSchedulerIndex (hole);
+      hole = parent;
+    }
+  m_keys[hole] = ev.key;
+  m_impls[hole] = ev.impl;
+  ev.impl->SetSchedulerIndex (hole);
+}
+
+void
+DaryHeapScheduler::SiftDown (uint32_t hole, const Event &ev)
+{
+  while (true)
+    {
+      uint32_t first = FirstChild (hole);
+      if (first > m_last)
+        {
+          break;
+        }
+      uint32_t end = std::min (first + KEYS_PER_LINE, m_last + 1);
+      uint32_t smallest = first;
+      for (uint32_t child = first + 1; child < end; child++)
+        {
+          if (m_keys[child] < m_keys[smallest])
+            {
+              smallest = child;
+            }
+        }
+      if (!(m_keys[smallest] < ev.key))
+        {
+          break;
+        }
+      m_keys[hole] = m_keys[smallest];
+      m_impls[hole] = m_impls[smallest];
+      m_impls[hole]->SetSchedulerIndex (hole);
+      hole = smallest;
+    }
+  m_keys[hole] = ev.key;
+  m_impls[hole] = ev.impl;
+  ev.impl->SetSchedulerIndex (hole);
+}
+
+void
+DaryHeapScheduler::Insert (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  if (m_last + 1 == m_capacity)
+    {
+      Grow ();
+    }
+  m_last++;
+  SiftUp (m_last, ev);
+}
+
+bool
+DaryHeapScheduler::IsEmpty (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_last < ROOT;
+}
+
+Scheduler::Event
+DaryHeapScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  Event next;
+  next.impl = m_impls[ROOT];
+  next.key = m_keys[ROOT];
+  return next;
+}
+
+Scheduler::Event
+DaryHeapScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  Event next = PeekNext ();
+  Event last;
+  last.impl = m_impls[m_last];
+  last.key = m_keys[m_last];
+  m_last--;
+  if (!IsEmpty ())
+    {
+      SiftDown (ROOT, last);
+    }
+  return next;
+}
+
+bool
+DaryHeapScheduler::RemoveCancelled (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_uid);
+  Remove (ev);
+  return true;
+}
+
+void
+DaryHeapScheduler::Remove (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  uint32_t uid = ev.key.m_uid;
+  uint32_t i = ev.impl->GetSchedulerIndex ();
+  if (i < ROOT || i > m_last || m_keys[i].m_uid != uid)
+    {
+      // The same EventImpl was scheduled more than once
+      for (i = ROOT; i <= m_last && m_keys[i].m_uid != uid; i++)
+        {
+        }
+    }
+  NS_ASSERT (i <= m_last);
+  NS_ASSERT (m_impls[i] == ev.impl);
+  Event last;
+  last.impl = m_impls[m_last];
+  last.key = m_keys[m_last];
+  m_last--;
+  if (i <= m_last)
+    {
+      if (i > ROOT && last.key < m_keys[Parent (i)])
+        {
+          SiftUp (i, last);
+        }
+      else
+        {
+          SiftDown (i, last);
+        }
+    }
+}
+
+} // namespace ns3
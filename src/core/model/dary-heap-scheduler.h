@@ -0,0 +1,120 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef DARY_HEAP_SCHEDULER_H
+#define DARY_HEAP_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Declaration of ns3::DaryHeapScheduler class.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup scheduler
+ * \brief a 4-ary heap event scheduler laid out for cache lines
+ *
+ * The heap keeps the event keys and the event pointers in two parallel
+ * arrays, so that the comparisons of a heap operation only touch the
+ * keys.  A key takes 16 bytes: the four children of a node are stored
+ * together in one 64 byte cache line, which a top-down heapify loads
+ * once per level.  A 4-ary heap of n events has half the levels of a
+ * binary heap, at the cost of three comparisons per level instead of one.
+ *
+ * To align the sibling groups, the root is stored at index 3 of the key
+ * array: the children of the node at index \c i are at indexes
+ * 4(i-2) to 4(i-2)+3, and the first index of each group is a multiple
+ * of 4.  The array itself starts on a cache line boundary.
+ *
+ * Both heapify loops move a hole instead of exchanging the entries.
+ * Every event records its index in the heap, so an arbitrary event, like
+ * a cancelled one, is removed in place in logarithmic time.
+ */
+class DaryHeapScheduler : public Scheduler
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  DaryHeapScheduler ();
+  /** Destructor. */
+  virtual ~DaryHeapScheduler ();
+
+  // Inherited
+  virtual void Insert (const Scheduler::Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Scheduler::Event PeekNext (void) const;
+  virtual Scheduler::Event RemoveNext (void);
+  virtual void Remove (const Scheduler::Event &ev);
+  virtual bool RemoveCancelled (const Scheduler::Event &ev);
+
+private:
+  /**
+   * Get the parent index of a given entry.
+   *
+   * \param [in] id The child index.
+   * \return The index of the parent of \p id.
+   */
+  static inline uint32_t Parent (uint32_t id);
+  /**
+   * Get the first child of a given entry.
+   *
+   * \param [in] id The parent index.
+   * \returns The index of the first of the four children.
+   */
+  static inline uint32_t FirstChild (uint32_t id);
+  /**
+   * Move an entry up from a hole until its parent is smaller.
+   *
+   * \param [in] hole The index of the hole.
+   * \param [in] ev The entry to store.
+   */
+  void SiftUp (uint32_t hole, const Scheduler::Event &ev);
+  /**
+   * Move an entry down from a hole until its children are larger.
+   *
+   * \param [in] hole The index of the hole.
+   * \param [in] ev The entry to store.
+   */
+  void SiftDown (uint32_t hole, const Scheduler::Event &ev);
+  /** Double the capacity of the arrays. */
+  void Grow (void);
+
+  /** Storage of the keys, with room to align m_keys. */
+  std::vector<Scheduler::EventKey> m_buffer;
+  /** The keys of the events, in m_buffer. */
+  Scheduler::EventKey *m_keys;
+  /** The events, at the index of their key. */
+  std::vector<EventImpl *> m_impls;
+  /** The number of indexes in m_keys and m_impls. */
+  uint32_t m_capacity;
+  /** The index of the last event. */
+  uint32_t m_last;
+};
+
+} // namespace ns3
+
+#endif /* DARY_HEAP_SCHEDULER_H */
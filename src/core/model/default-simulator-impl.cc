@@ -25,6 +25,8 @@
 
 #include "ptr.h"
 #include "pointer.h"
+#include "double.h"
+#include "uinteger.h"
 #include "assert.h"
 #include "log.h"
 
@@ -53,11 +55,24 @@ DefaultSimulatorImpl::GetTypeId (void)
     .SetParent<SimulatorImpl> ()
     .SetGroupName ("Core")
     .AddConstructor<DefaultSimulatorImpl> ()
+    .AddAttribute ("CompactionRatio",
+                   "The share of cancelled events in the event list which "
+                   "triggers their removal, when the scheduler keeps them.",
+                   DoubleValue (0.5),
+                   MakeDoubleAccessor (&DefaultSimulatorImpl::m_compactionRatio),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+    .AddAttribute ("CompactionMinimum",
+                   "The minimum number of cancelled events in the event list "
+                   "before they are removed.",
+                   UintegerValue (1024),
+                   MakeUintegerAccessor (&DefaultSimulatorImpl::m_compactionMinimum),
+                   MakeUintegerChecker<uint32_t> ())
   ;
   return tid;
 }
 
 DefaultSimulatorImpl::DefaultSimulatorImpl ()
+  : m_eventsWithContext (1024)
 {
   NS_LOG_FUNCTION (this);
   m_stop = false;
@@ -71,7 +86,10 @@ DefaultSimulatorImpl::DefaultSimulatorImpl ()
   m_currentTs = 0;
   m_currentContext = 0xffffffff;
   m_unscheduledEvents = 0;
-  m_eventsWithContextEmpty = true;
+  m_deadEvents = 0;
+  m_compactions = 0;
+  m_batchNext = 0;
+  m_eventsWithContextOverflowing = false;
   m_main = SystemThread::Self();
 }
 
@@ -114,6 +132,7 @@ void
 DefaultSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
 {
   NS_LOG_FUNCTION (this << schedulerFactory);
+  m_schedulerFactory = schedulerFactory;
   Ptr<Scheduler> scheduler = schedulerFactory.Create<Scheduler> ();
 
   if (m_events != 0)
@@ -135,19 +154,36 @@ DefaultSimulatorImpl::GetSystemId (void) const
 }
 
 void
-DefaultSimulatorImpl::ProcessOneEvent (void)
+DefaultSimulatorImpl::ProcessEventBatch (void)
 {
-  Scheduler::Event next = m_events->RemoveNext ();
-
-  NS_ASSERT (next.key.m_ts >= m_currentTs);
-  m_unscheduledEvents--;
-
-  NS_LOG_LOGIC ("handle " << next.key.m_ts);
-  m_currentTs = next.key.m_ts;
-  m_currentContext = next.key.m_context;
-  m_currentUid = next.key.m_uid;
-  next.impl->Invoke ();
-  next.impl->Unref ();
+  NS_ASSERT (m_batch.empty ());
+  m_events->RemoveNextBatch (m_batch);
+
+  NS_ASSERT (m_batch.front ().key.m_ts >= m_currentTs);
+  NS_LOG_LOGIC ("handle " << m_batch.front ().key.m_ts << ", " << m_batch.size () << " events");
+  m_currentTs = m_batch.front ().key.m_ts;
+  // The events scheduled now by the batch get a bigger uid and run after it
+  for (m_batchNext = 0; m_batchNext < m_batch.size () && !m_stop; )
+    {
+      Scheduler::Event next = m_batch[m_batchNext];
+      m_batchNext++;
+      m_unscheduledEvents--;
+      if (next.impl->IsCancelled ())
+        {
+          m_deadEvents--;
+        }
+      m_currentContext = next.key.m_context;
+      m_currentUid = next.key.m_uid;
+      next.impl->Invoke ();
+      next.impl->Unref ();
+    }
+  // Keep the events left by Stop for the next Run
+  for (; m_batchNext < m_batch.size (); m_batchNext++)
+    {
+      m_events->Insert (m_batch[m_batchNext]);
+    }
+  m_batch.clear ();
+  m_batchNext = 0;
 
   ProcessEventsWithContext ();
 }
@@ -155,36 +191,46 @@ DefaultSimulatorImpl::ProcessOneEvent (void)
 bool 
 DefaultSimulatorImpl::IsFinished (void) const
 {
-  return m_events->IsEmpty () || m_stop;
+  return (m_events->IsEmpty () && m_batchNext == m_batch.size ()) || m_stop;
+}
+
+void
+DefaultSimulatorImpl::InsertEventWithContext (const EventWithContext &event)
+{
+  Scheduler::Event ev;
+  ev.impl = event.event;
+  ev.key.m_ts = m_currentTs + event.timestamp;
+  ev.key.m_context = event.context;
+  ev.key.m_uid = m_uid;
+  m_uid++;
+  m_unscheduledEvents++;
+  m_events->Insert (ev);
 }
 
 void
 DefaultSimulatorImpl::ProcessEventsWithContext (void)
 {
-  if (m_eventsWithContextEmpty)
+  EventWithContext event;
+  while (m_eventsWithContext.TryPop (event))
     {
-      return;
+      InsertEventWithContext (event);
     }
 
-  // swap queues
+  // The overflow events are later than every event of the ring
+  if (!__atomic_load_n (&m_eventsWithContextOverflowing, __ATOMIC_ACQUIRE)
+      || !m_eventsWithContext.IsEmpty ())
+    {
+      return;
+    }
   EventsWithContext eventsWithContext;
   {
     CriticalSection cs (m_eventsWithContextMutex);
-    m_eventsWithContext.swap(eventsWithContext);
-    m_eventsWithContextEmpty = true;
+    m_eventsWithContextOverflow.swap (eventsWithContext);
+    __atomic_store_n (&m_eventsWithContextOverflowing, false, __ATOMIC_RELEASE);
   }
-  while (!eventsWithContext.empty ())
+  for (EventsWithContext::const_iterator i = eventsWithContext.begin (); i != eventsWithContext.end (); ++i)
     {
-       EventWithContext event = eventsWithContext.front ();
-       eventsWithContext.pop_front ();
-       Scheduler::Event ev;
-       ev.impl = event.event;
-       ev.key.m_ts = m_currentTs + event.timestamp;
-       ev.key.m_context = event.context;
-       ev.key.m_uid = m_uid;
-       m_uid++;
-       m_unscheduledEvents++;
-       m_events->Insert (ev);
+      InsertEventWithContext (*i);
     }
 }
 
@@ -199,7 +245,7 @@ DefaultSimulatorImpl::Run (void)
 
   while (!m_events->IsEmpty () && !m_stop) 
     {
-      ProcessOneEvent ();
+      ProcessEventBatch ();
     }
 
   // If the simulator stopped naturally by lack of events, make a
@@ -269,11 +315,15 @@ DefaultSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay,
       // Current time added in ProcessEventsWithContext()
       ev.timestamp = delay.GetTimeStep ();
       ev.event = event;
-      {
-        CriticalSection cs (m_eventsWithContextMutex);
-        m_eventsWithContext.push_back(ev);
-        m_eventsWithContextEmpty = false;
-      }
+      // Once an event overflows, the next ones follow it until the main
+      // thread moves them, so the events of a thread keep their order
+      if (__atomic_load_n (&m_eventsWithContextOverflowing, __ATOMIC_ACQUIRE)
+          || !m_eventsWithContext.TryPush (ev))
+        {
+          CriticalSection cs (m_eventsWithContextMutex);
+          m_eventsWithContextOverflow.push_back (ev);
+          __atomic_store_n (&m_eventsWithContextOverflowing, true, __ATOMIC_RELEASE);
+        }
     }
 }
 
@@ -344,6 +394,19 @@ DefaultSimulatorImpl::Remove (const EventId &id)
     {
       return;
     }
+  if (id.GetTs () == m_currentTs)
+    {
+      // The event may wait in the current batch, out of m_events
+      for (uint32_t i = m_batchNext; i < m_batch.size (); i++)
+        {
+          if (m_batch[i].key.m_uid == id.GetUid ())
+            {
+              m_batch[i].impl->Cancel ();
+              m_deadEvents++;
+              return;
+            }
+        }
+    }
   Scheduler::Event event;
   event.impl = id.PeekEventImpl ();
   event.key.m_ts = id.GetTs ();
@@ -360,10 +423,75 @@ DefaultSimulatorImpl::Remove (const EventId &id)
 void
 DefaultSimulatorImpl::Cancel (const EventId &id)
 {
-  if (!IsExpired (id))
+  if (IsExpired (id))
+    {
+      return;
+    }
+  Scheduler::Event event;
+  event.impl = id.PeekEventImpl ();
+  event.key.m_ts = id.GetTs ();
+  event.key.m_context = id.GetContext ();
+  event.key.m_uid = id.GetUid ();
+  event.impl->Cancel ();
+  if (event.key.m_uid == 2)
+    {
+      // destroy events.
+      return;
+    }
+  // An event of the current timestamp may wait in the current batch
+  if (event.key.m_ts != m_currentTs && m_events->RemoveCancelled (event))
+    {
+      event.impl->Unref ();
+      m_unscheduledEvents--;
+      return;
+    }
+  m_deadEvents++;
+  if (m_deadEvents >= m_compactionMinimum
+      && m_deadEvents >= m_compactionRatio * m_unscheduledEvents)
+    {
+      Compact ();
+    }
+}
+
+void
+DefaultSimulatorImpl::Compact (void)
+{
+  NS_LOG_FUNCTION (this << m_unscheduledEvents << m_deadEvents);
+  Ptr<Scheduler> scheduler = m_schedulerFactory.Create<Scheduler> ();
+  while (!m_events->IsEmpty ())
     {
-      id.PeekEventImpl ()->Cancel ();
+      Scheduler::Event next = m_events->RemoveNext ();
+      if (next.impl->IsCancelled ())
+        {
+          next.impl->Unref ();
+          m_unscheduledEvents--;
+          m_deadEvents--;
+        }
+      else
+        {
+          scheduler->Insert (next);
+        }
     }
+  m_events = scheduler;
+  m_compactions++;
+}
+
+uint32_t
+DefaultSimulatorImpl::GetLiveEventCount (void) const
+{
+  return m_unscheduledEvents - m_deadEvents;
+}
+
+uint32_t
+DefaultSimulatorImpl::GetDeadEventCount (void) const
+{
+  return m_deadEvents;
+}
+
+uint32_t
+DefaultSimulatorImpl::GetCompactionCount (void) const
+{
+  return m_compactions;
 }
 
 bool
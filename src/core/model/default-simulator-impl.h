@@ -26,10 +26,12 @@
 #include "event-impl.h"
 #include "system-thread.h"
 #include "ns3/system-mutex.h"
+#include "mpsc-ring.h"
 
 #include "ptr.h"
 
 #include <list>
+#include <vector>
 
 /**
  * \file
@@ -78,13 +80,37 @@ public:
   virtual uint32_t GetSystemId (void) const; 
   virtual uint32_t GetContext (void) const;
 
+  /**
+   * \returns The number of events waiting to run, not counting the
+   *          events run by Simulator::Destroy.
+   */
+  uint32_t GetLiveEventCount (void) const;
+  /**
+   * Cancelled events stay in the event list until their time comes,
+   * unless the scheduler removes them in place (see
+   * Scheduler::RemoveCancelled), or too many of them trigger a
+   * compaction of the event list.
+   *
+   * \returns The number of cancelled events in the event list.
+   */
+  uint32_t GetDeadEventCount (void) const;
+  /** \returns The number of compactions of the event list. */
+  uint32_t GetCompactionCount (void) const;
+
 private:
   virtual void DoDispose (void);
 
-  /** Process the next event. */
-  void ProcessOneEvent (void);
+  /**
+   * Process the events with the next timestamp.
+   *
+   * The events are removed from the scheduler in one call and run in
+   * the order of their uid, until Stop is called.
+   */
+  void ProcessEventBatch (void);
   /** Move events from a different context into the main event queue. */
   void ProcessEventsWithContext (void);
+  /** Move the live events to a new scheduler, dropping the cancelled ones. */
+  void Compact (void);
  
   /** Wrap an event with its execution context. */
   struct EventWithContext {
@@ -95,16 +121,23 @@ private:
     /** The event implementation. */
     EventImpl *event;
   };
+  /**
+   * Insert an event from a different context in the main event queue.
+   * \param [in] event The event, with its delay from now.
+   */
+  void InsertEventWithContext (const EventWithContext &event);
   /** Container type for the events from a different context. */
   typedef std::list<struct EventWithContext> EventsWithContext;
-  /** The container of events from a different context. */
-  EventsWithContext m_eventsWithContext;
+  /** The events from a different context, pushed without lock. */
+  MpscRing<EventWithContext> m_eventsWithContext;
   /**
-   * Flag \c true if all events with context have been moved to the
-   * primary event queue.
+   * The events from a different context pushed while the ring was full,
+   * and after them until the main thread moves them.
    */
-  bool m_eventsWithContextEmpty;
-  /** Mutex to control access to the list of events with context. */
+  EventsWithContext m_eventsWithContextOverflow;
+  /** Flag \c true if m_eventsWithContextOverflow holds events. */
+  bool m_eventsWithContextOverflowing;
+  /** Mutex to control access to the overflow list of events with context. */
   SystemMutex m_eventsWithContextMutex;
 
   /** Container type for the events to run at Simulator::Destroy() */
@@ -115,6 +148,12 @@ private:
   bool m_stop;
   /** The event priority queue. */
   Ptr<Scheduler> m_events;
+  /** The factory of m_events. */
+  ObjectFactory m_schedulerFactory;
+  /** The events with the current timestamp, removed from m_events. */
+  std::vector<Scheduler::Event> m_batch;
+  /** Index of the next event to run in m_batch. */
+  uint32_t m_batchNext;
 
   /** Next event unique id. */
   uint32_t m_uid;
@@ -129,6 +168,14 @@ private:
    *  not counting the Destroy events; this is used for validation
    */
   int m_unscheduledEvents;
+  /** Number of cancelled events in m_events and m_batch. */
+  uint32_t m_deadEvents;
+  /** Number of compactions of m_events. */
+  uint32_t m_compactions;
+  /** CompactionRatio attribute. */
+  double m_compactionRatio;
+  /** CompactionMinimum attribute. */
+  uint32_t m_compactionMinimum;
 
   /** Main execution thread. */
   SystemThread::ThreadId m_main;
@@ -20,6 +20,13 @@
 
 #include "event-impl.h"
 #include "log.h"
+#include "ns3/core-config.h"
+
+#include <algorithm>
+#include <new>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
 
 /**
  * \file
@@ -27,17 +34,226 @@
  * ns3::EventImpl definitions.
  */
 
+namespace {
+
+/** Step between the size classes of the events. */
+const std::size_t EVENT_GRAIN = 16;
+/** Number of size classes, the biggest one holds 128 bytes. */
+const uint32_t EVENT_CLASSES = 8;
+/** Number of blocks moved between a thread and the depot. */
+const uint32_t EVENT_BATCH = 64;
+
+/** A free block of event memory. */
+struct FreeBlock
+{
+  FreeBlock *next;      //!< Next block of the list
+  FreeBlock *nextBatch; //!< Next batch of the depot, in the first block of a batch
+};
+
+/** The free blocks of a thread. */
+struct EventCache
+{
+  FreeBlock *head[EVENT_CLASSES];   //!< Free list of each size class
+  uint32_t count[EVENT_CLASSES];    //!< Length of each free list
+  bool registered;                  //!< Whether the cache is flushed on exit
+};
+
+/**
+ * The free blocks of the current thread.
+ *
+ * The initial exec model reaches the cache at a fixed offset from the
+ * thread pointer, without the call to __tls_get_addr a shared library
+ * otherwise makes on each allocation.
+ */
+__thread EventCache g_eventCache __attribute__ ((tls_model ("initial-exec")));
+
+/** Batches of free blocks given back by the threads. */
+FreeBlock *g_eventDepot[EVENT_CLASSES];
+/** Spin lock of g_eventDepot. */
+bool g_eventDepotLock;
+
+/**
+ * Add a batch of blocks to the depot.
+ * \param sizeClass the size class of the blocks
+ * \param batch the list of blocks
+ */
+void
+PushBatch (uint32_t sizeClass, FreeBlock *batch)
+{
+  while (__atomic_test_and_set (&g_eventDepotLock, __ATOMIC_ACQUIRE))
+    {
+    }
+  batch->nextBatch = g_eventDepot[sizeClass];
+  g_eventDepot[sizeClass] = batch;
+  __atomic_clear (&g_eventDepotLock, __ATOMIC_RELEASE);
+}
+
+/**
+ * Take a batch of blocks from the depot.
+ * \param sizeClass the size class of the blocks
+ * \return the list of blocks, or 0 if the depot is empty
+ */
+FreeBlock *
+PopBatch (uint32_t sizeClass)
+{
+  while (__atomic_test_and_set (&g_eventDepotLock, __ATOMIC_ACQUIRE))
+    {
+    }
+  FreeBlock *batch = g_eventDepot[sizeClass];
+  if (batch != 0)
+    {
+      g_eventDepot[sizeClass] = batch->nextBatch;
+    }
+  __atomic_clear (&g_eventDepotLock, __ATOMIC_RELEASE);
+  return batch;
+}
+
+/**
+ * Give blocks of a thread back to the depot.
+ * \param cache the blocks of the thread
+ * \param sizeClass the size class of the blocks
+ * \param keep the number of blocks the thread keeps
+ */
+void
+FlushCache (EventCache *cache, uint32_t sizeClass, uint32_t keep)
+{
+  while (cache->count[sizeClass] > keep)
+    {
+      uint32_t n = std::min (cache->count[sizeClass] - keep, EVENT_BATCH);
+      FreeBlock *batch = cache->head[sizeClass];
+      FreeBlock *last = batch;
+      for (uint32_t i = 1; i < n; i++)
+        {
+          last = last->next;
+        }
+      cache->head[sizeClass] = last->next;
+      cache->count[sizeClass] -= n;
+      last->next = 0;
+      PushBatch (sizeClass, batch);
+    }
+}
+
+#ifdef HAVE_PTHREAD_H
+/** Key whose destructor flushes the cache of an exiting thread. */
+pthread_key_t g_eventCacheKey;
+/** Creation of g_eventCacheKey. */
+pthread_once_t g_eventCacheOnce = PTHREAD_ONCE_INIT;
+
+/**
+ * Give all the blocks of an exiting thread back to the depot.
+ * \param cache the blocks of the thread
+ */
+void
+ReleaseCache (void *cache)
+{
+  for (uint32_t i = 0; i < EVENT_CLASSES; i++)
+    {
+      FlushCache (static_cast<EventCache *> (cache), i, 0);
+    }
+}
+
+/** Create g_eventCacheKey. */
+void
+CreateCacheKey (void)
+{
+  pthread_key_create (&g_eventCacheKey, &ReleaseCache);
+}
+#endif /* HAVE_PTHREAD_H */
+
+/**
+ * Fill the empty free list of a thread, from the depot or from a new slab.
+ * \param cache the blocks of the thread
+ * \param sizeClass the size class of the blocks
+ */
+void
+RefillCache (EventCache *cache, uint32_t sizeClass)
+{
+#ifdef HAVE_PTHREAD_H
+  if (!cache->registered)
+    {
+      pthread_once (&g_eventCacheOnce, &CreateCacheKey);
+      pthread_setspecific (g_eventCacheKey, cache);
+      cache->registered = true;
+    }
+#endif /* HAVE_PTHREAD_H */
+  FreeBlock *batch = PopBatch (sizeClass);
+  uint32_t count = 0;
+  if (batch != 0)
+    {
+      for (FreeBlock *block = batch; block != 0; block = block->next)
+        {
+          count++;
+        }
+    }
+  else
+    {
+      std::size_t size = (sizeClass + 1) * EVENT_GRAIN;
+      char *slab = static_cast<char *> (::operator new (EVENT_BATCH * size));
+      for (uint32_t i = 0; i < EVENT_BATCH; i++)
+        {
+          FreeBlock *block = reinterpret_cast<FreeBlock *> (slab + i * size);
+          block->next = i + 1 < EVENT_BATCH ? reinterpret_cast<FreeBlock *> (slab + (i + 1) * size) : 0;
+        }
+      batch = reinterpret_cast<FreeBlock *> (slab);
+      count = EVENT_BATCH;
+    }
+  cache->head[sizeClass] = batch;
+  cache->count[sizeClass] = count;
+}
+
+} // anonymous namespace
+
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("EventImpl");
 
+void *
+EventImpl::operator new (std::size_t size)
+{
+  if (size > EVENT_GRAIN * EVENT_CLASSES)
+    {
+      return ::operator new (size);
+    }
+  uint32_t sizeClass = (size - 1) / EVENT_GRAIN;
+  EventCache *cache = &g_eventCache;
+  if (cache->head[sizeClass] == 0)
+    {
+      RefillCache (cache, sizeClass);
+    }
+  FreeBlock *block = cache->head[sizeClass];
+  cache->head[sizeClass] = block->next;
+  cache->count[sizeClass]--;
+  return block;
+}
+
+void
+EventImpl::operator delete (void *p, std::size_t size)
+{
+  if (size > EVENT_GRAIN * EVENT_CLASSES)
+    {
+      ::operator delete (p);
+      return;
+    }
+  uint32_t sizeClass = (size - 1) / EVENT_GRAIN;
+  EventCache *cache = &g_eventCache;
+  FreeBlock *block = static_cast<FreeBlock *> (p);
+  block->next = cache->head[sizeClass];
+  cache->head[sizeClass] = block;
+  cache->count[sizeClass]++;
+  if (cache->count[sizeClass] >= 2 * EVENT_BATCH)
+    {
+      FlushCache (cache, sizeClass, EVENT_BATCH);
+    }
+}
+
 EventImpl::~EventImpl ()
 {
   NS_LOG_FUNCTION (this);
 }
 
 EventImpl::EventImpl ()
-  : m_cancel (false)
+  : m_schedulerIndex (0),
+    m_cancel (false)
 {
   NS_LOG_FUNCTION (this);
 }
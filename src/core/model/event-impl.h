@@ -21,6 +21,7 @@
 #define EVENT_IMPL_H
 
 #include <stdint.h>
+#include <cstddef>
 #include "simple-ref-count.h"
 
 /**
@@ -66,6 +67,39 @@ public:
    */
   bool IsCancelled (void);
 
+  /**
+   * Allocate an event.
+   *
+   * The events up to 128 bytes come from per-thread free lists of
+   * 16 byte size classes, refilled by batches of 64 blocks from a shared
+   * depot or from a new slab; the bigger events come from the global
+   * operator new.  The threads of a multithreaded simulation may free
+   * an event allocated by another thread.
+   *
+   * \param [in] size The size of the event.
+   * \returns The memory of the event.
+   */
+  static void *operator new (std::size_t size);
+  /**
+   * Release the memory of an event.
+   *
+   * \param [in] p The memory of the event.
+   * \param [in] size The size of the event.
+   */
+  static void operator delete (void *p, std::size_t size);
+
+  /**
+   * \name Scheduler Helpers.
+   * \brief These methods are normally invoked only by the subclasses
+   * of the Scheduler base class which remove events in place.
+   */
+  /**@{*/
+  /** \return The position of the event in the scheduler. */
+  uint32_t GetSchedulerIndex (void) const;
+  /** \param [in] index The position of the event in the scheduler. */
+  void SetSchedulerIndex (uint32_t index);
+  /**@}*/
+
 protected:
   /**
    * Implementation for Invoke().
@@ -76,9 +110,22 @@ protected:
   virtual void Notify (void) = 0;
 
 private:
+  uint32_t m_schedulerIndex;  /**< Position of the event in the scheduler. */
   bool m_cancel;  /**< Has this event been cancelled. */
 };
 
+inline uint32_t
+EventImpl::GetSchedulerIndex (void) const
+{
+  return m_schedulerIndex;
+}
+
+inline void
+EventImpl::SetSchedulerIndex (uint32_t index)
+{
+  m_schedulerIndex = index;
+}
+
 } // namespace ns3
 
 #endif /* EVENT_IMPL_H */
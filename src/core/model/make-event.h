@@ -36,6 +36,9 @@ class EventImpl;
  *
  * Create EventImpl instances from class member functions which take
  * varying numbers of arguments.
+ *
+ * The object and the arguments are passed down by reference and copied
+ * once, into the event.
  */
 /**
  * \ingroup makeeventmemptr
@@ -52,7 +55,7 @@ class EventImpl;
  * \returns The constructed EventImpl.
  */
 template <typename MEM, typename OBJ>
-EventImpl * MakeEvent (MEM mem_ptr, OBJ obj);
+EventImpl * MakeEvent (MEM mem_ptr, const OBJ &obj);
 
 /**
  * \copybrief MakeEvent(MEM,OBJ)
@@ -66,7 +69,7 @@ EventImpl * MakeEvent (MEM mem_ptr, OBJ obj);
  */
 template <typename MEM, typename OBJ,
           typename T1>
-EventImpl * MakeEvent (MEM mem_ptr, OBJ obj, T1 a1);
+EventImpl * MakeEvent (MEM mem_ptr, const OBJ &obj, const T1 &a1);
 
 /**
  * \copybrief MakeEvent(MEM,OBJ)
@@ -82,7 +85,7 @@ EventImpl * MakeEvent (MEM mem_ptr, OBJ obj, T1 a1);
  */
 template <typename MEM, typename OBJ,
           typename T1, typename T2>
-EventImpl * MakeEvent (MEM mem_ptr, OBJ obj, T1 a1, T2 a2);
+EventImpl * MakeEvent (MEM mem_ptr, const OBJ &obj, const T1 &a1, const T2 &a2);
 
 /**
  * \copybrief MakeEvent(MEM,OBJ)
@@ -100,7 +103,7 @@ EventImpl * MakeEvent (MEM mem_ptr, OBJ obj, T1 a1, T2 a2);
  */
 template <typename MEM, typename OBJ,
           typename T1, typename T2, typename T3>
-EventImpl * MakeEvent (MEM mem_ptr, OBJ obj, T1 a1, T2 a2, T3 a3);
+EventImpl * MakeEvent (MEM mem_ptr, const OBJ &obj, const T1 &a1, const T2 &a2, const T3 &a3);
 
 /**
  * \copybrief MakeEvent(MEM,OBJ)
@@ -120,7 +123,8 @@ EventImpl * MakeEvent (MEM mem_ptr, OBJ obj, T1 a1, T2 a2, T3 a3);
  */
 template <typename MEM, typename OBJ,
           typename T1, typename T2, typename T3, typename T4>
-EventImpl * MakeEvent (MEM mem_ptr, OBJ obj, T1 a1, T2 a2, T3 a3, T4 a4);
+EventImpl * MakeEvent (MEM mem_ptr, const OBJ &obj, const T1 &a1, const T2 &a2,
+                       const T3 &a3, const T4 &a4);
 
 /**
  * \copybrief MakeEvent(MEM,OBJ)
@@ -142,8 +146,8 @@ EventImpl * MakeEvent (MEM mem_ptr, OBJ obj, T1 a1, T2 a2, T3 a3, T4 a4);
  */
 template <typename MEM, typename OBJ,
           typename T1, typename T2, typename T3, typename T4, typename T5>
-EventImpl * MakeEvent (MEM mem_ptr, OBJ obj,
-                       T1 a1, T2 a2, T3 a3, T4 a4, T5 a5);
+EventImpl * MakeEvent (MEM mem_ptr, const OBJ &obj,
+                       const T1 &a1, const T2 &a2, const T3 &a3, const T4 &a4, const T5 &a5);
 /**@}*/
   
 /**
@@ -174,7 +178,7 @@ EventImpl * MakeEvent (void (*f)(void));
  */
 template <typename U1,
           typename T1>
-EventImpl * MakeEvent (void (*f)(U1), T1 a1);
+EventImpl * MakeEvent (void (*f)(U1), const T1 &a1);
 
 /**
  * \copybrief MakeEvent(void(*f)(void))
@@ -189,7 +193,7 @@ EventImpl * MakeEvent (void (*f)(U1), T1 a1);
  */
 template <typename U1, typename U2,
           typename T1, typename T2>
-EventImpl * MakeEvent (void (*f)(U1,U2), T1 a1, T2 a2);
+EventImpl * MakeEvent (void (*f)(U1,U2), const T1 &a1, const T2 &a2);
 
 /**
  * \copybrief MakeEvent(void(*f)(void))
@@ -207,7 +211,7 @@ EventImpl * MakeEvent (void (*f)(U1,U2), T1 a1, T2 a2);
  */
 template <typename U1, typename U2, typename U3,
           typename T1, typename T2, typename T3>
-EventImpl * MakeEvent (void (*f)(U1,U2,U3), T1 a1, T2 a2, T3 a3);
+EventImpl * MakeEvent (void (*f)(U1,U2,U3), const T1 &a1, const T2 &a2, const T3 &a3);
 
 /**
  * \copybrief MakeEvent(void(*f)(void))
@@ -228,7 +232,8 @@ EventImpl * MakeEvent (void (*f)(U1,U2,U3), T1 a1, T2 a2, T3 a3);
  */
 template <typename U1, typename U2, typename U3, typename U4,
           typename T1, typename T2, typename T3, typename T4>
-EventImpl * MakeEvent (void (*f)(U1,U2,U3,U4), T1 a1, T2 a2, T3 a3, T4 a4);
+EventImpl * MakeEvent (void (*f)(U1,U2,U3,U4), const T1 &a1, const T2 &a2,
+                       const T3 &a3, const T4 &a4);
 
 /**
  * \copybrief MakeEvent(void(*f)(void))
@@ -252,7 +257,8 @@ EventImpl * MakeEvent (void (*f)(U1,U2,U3,U4), T1 a1, T2 a2, T3 a3, T4 a4);
  */
 template <typename U1, typename U2, typename U3, typename U4, typename U5,
           typename T1, typename T2, typename T3, typename T4, typename T5>
-EventImpl * MakeEvent (void (*f)(U1,U2,U3,U4,U5), T1 a1, T2 a2, T3 a3, T4 a4, T5 a5);
+EventImpl * MakeEvent (void (*f)(U1,U2,U3,U4,U5), const T1 &a1, const T2 &a2,
+                       const T3 &a3, const T4 &a4, const T5 &a5);
 /**@}*/
 
 } // namespace ns3
@@ -303,13 +309,13 @@ struct EventMemberImplObjTraits<T *>
 };
 
 template <typename MEM, typename OBJ>
-EventImpl * MakeEvent (MEM mem_ptr, OBJ obj)
+EventImpl * MakeEvent (MEM mem_ptr, const OBJ &obj)
 {
   // zero argument version
   class EventMemberImpl0 : public EventImpl
   {
 public:
-    EventMemberImpl0 (OBJ obj, MEM function)
+    EventMemberImpl0 (const OBJ &obj, MEM function)
       : m_obj (obj),
         m_function (function)
     {
@@ -331,13 +337,13 @@ private:
 
 template <typename MEM, typename OBJ,
           typename T1>
-EventImpl * MakeEvent (MEM mem_ptr, OBJ obj, T1 a1)
+EventImpl * MakeEvent (MEM mem_ptr, const OBJ &obj, const T1 &a1)
 {
   // one argument version
   class EventMemberImpl1 : public EventImpl
   {
 public:
-    EventMemberImpl1 (OBJ obj, MEM function, T1 a1)
+    EventMemberImpl1 (const OBJ &obj, MEM function, const T1 &a1)
       : m_obj (obj),
         m_function (function),
         m_a1 (a1)
@@ -361,13 +367,13 @@ private:
 
 template <typename MEM, typename OBJ,
           typename T1, typename T2>
-EventImpl * MakeEvent (MEM mem_ptr, OBJ obj, T1 a1, T2 a2)
+EventImpl * MakeEvent (MEM mem_ptr, const OBJ &obj, const T1 &a1, const T2 &a2)
 {
   // two argument version
   class EventMemberImpl2 : public EventImpl
   {
 public:
-    EventMemberImpl2 (OBJ obj, MEM function, T1 a1, T2 a2)
+    EventMemberImpl2 (const OBJ &obj, MEM function, const T1 &a1, const T2 &a2)
       : m_obj (obj),
         m_function (function),
         m_a1 (a1),
@@ -393,13 +399,13 @@ private:
 
 template <typename MEM, typename OBJ,
           typename T1, typename T2, typename T3>
-EventImpl * MakeEvent (MEM mem_ptr, OBJ obj, T1 a1, T2 a2, T3 a3)
+EventImpl * MakeEvent (MEM mem_ptr, const OBJ &obj, const T1 &a1, const T2 &a2, const T3 &a3)
 {
   // three argument version
   class EventMemberImpl3 : public EventImpl
   {
 public:
-    EventMemberImpl3 (OBJ obj, MEM function, T1 a1, T2 a2, T3 a3)
+    EventMemberImpl3 (const OBJ &obj, MEM function, const T1 &a1, const T2 &a2, const T3 &a3)
       : m_obj (obj),
         m_function (function),
         m_a1 (a1),
@@ -427,13 +433,15 @@ private:
 
 template <typename MEM, typename OBJ,
           typename T1, typename T2, typename T3, typename T4>
-EventImpl * MakeEvent (MEM mem_ptr, OBJ obj, T1 a1, T2 a2, T3 a3, T4 a4)
+EventImpl * MakeEvent (MEM mem_ptr, const OBJ &obj, const T1 &a1, const T2 &a2,
+                       const T3 &a3, const T4 &a4)
 {
   // four argument version
   class EventMemberImpl4 : public EventImpl
   {
 public:
-    EventMemberImpl4 (OBJ obj, MEM function, T1 a1, T2 a2, T3 a3, T4 a4)
+    EventMemberImpl4 (const OBJ &obj, MEM function, const T1 &a1, const T2 &a2,
+                      const T3 &a3, const T4 &a4)
       : m_obj (obj),
         m_function (function),
         m_a1 (a1),
@@ -463,14 +471,15 @@ private:
 
 template <typename MEM, typename OBJ,
           typename T1, typename T2, typename T3, typename T4, typename T5>
-EventImpl * MakeEvent (MEM mem_ptr, OBJ obj,
-                       T1 a1, T2 a2, T3 a3, T4 a4, T5 a5)
+EventImpl * MakeEvent (MEM mem_ptr, const OBJ &obj,
+                       const T1 &a1, const T2 &a2, const T3 &a3, const T4 &a4, const T5 &a5)
 {
   // five argument version
   class EventMemberImpl5 : public EventImpl
   {
 public:
-    EventMemberImpl5 (OBJ obj, MEM function, T1 a1, T2 a2, T3 a3, T4 a4, T5 a5)
+    EventMemberImpl5 (const OBJ &obj, MEM function, const T1 &a1, const T2 &a2,
+                      const T3 &a3, const T4 &a4, const T5 &a5)
       : m_obj (obj),
         m_function (function),
         m_a1 (a1),
@@ -501,7 +510,7 @@ private:
 }
 
 template <typename U1, typename T1>
-EventImpl * MakeEvent (void (*f)(U1), T1 a1)
+EventImpl * MakeEvent (void (*f)(U1), const T1 &a1)
 {
   // one arg version
   class EventFunctionImpl1 : public EventImpl
@@ -509,7 +518,7 @@ EventImpl * MakeEvent (void (*f)(U1), T1 a1)
 public:
     typedef void (*F)(U1);
 
-    EventFunctionImpl1 (F function, T1 a1)
+    EventFunctionImpl1 (F function, const T1 &a1)
       : m_function (function),
         m_a1 (a1)
     {
@@ -530,7 +539,7 @@ private:
 }
 
 template <typename U1, typename U2, typename T1, typename T2>
-EventImpl * MakeEvent (void (*f)(U1,U2), T1 a1, T2 a2)
+EventImpl * MakeEvent (void (*f)(U1,U2), const T1 &a1, const T2 &a2)
 {
   // two arg version
   class EventFunctionImpl2 : public EventImpl
@@ -538,7 +547,7 @@ EventImpl * MakeEvent (void (*f)(U1,U2), T1 a1, T2 a2)
 public:
     typedef void (*F)(U1, U2);
 
-    EventFunctionImpl2 (F function, T1 a1, T2 a2)
+    EventFunctionImpl2 (F function, const T1 &a1, const T2 &a2)
       : m_function (function),
         m_a1 (a1),
         m_a2 (a2)
@@ -562,7 +571,7 @@ private:
 
 template <typename U1, typename U2, typename U3,
           typename T1, typename T2, typename T3>
-EventImpl * MakeEvent (void (*f)(U1,U2,U3), T1 a1, T2 a2, T3 a3)
+EventImpl * MakeEvent (void (*f)(U1,U2,U3), const T1 &a1, const T2 &a2, const T3 &a3)
 {
   // three arg version
   class EventFunctionImpl3 : public EventImpl
@@ -570,7 +579,7 @@ EventImpl * MakeEvent (void (*f)(U1,U2,U3), T1 a1, T2 a2, T3 a3)
 public:
     typedef void (*F)(U1, U2, U3);
 
-    EventFunctionImpl3 (F function, T1 a1, T2 a2, T3 a3)
+    EventFunctionImpl3 (F function, const T1 &a1, const T2 &a2, const T3 &a3)
       : m_function (function),
         m_a1 (a1),
         m_a2 (a2),
@@ -596,7 +605,8 @@ private:
 
 template <typename U1, typename U2, typename U3, typename U4,
           typename T1, typename T2, typename T3, typename T4>
-EventImpl * MakeEvent (void (*f)(U1,U2,U3,U4), T1 a1, T2 a2, T3 a3, T4 a4)
+EventImpl * MakeEvent (void (*f)(U1,U2,U3,U4), const T1 &a1, const T2 &a2,
+                       const T3 &a3, const T4 &a4)
 {
   // four arg version
   class EventFunctionImpl4 : public EventImpl
@@ -604,7 +614,7 @@ EventImpl * MakeEvent (void (*f)(U1,U2,U3,U4), T1 a1, T2 a2, T3 a3, T4 a4)
 public:
     typedef void (*F)(U1, U2, U3, U4);
 
-    EventFunctionImpl4 (F function, T1 a1, T2 a2, T3 a3, T4 a4)
+    EventFunctionImpl4 (F function, const T1 &a1, const T2 &a2, const T3 &a3, const T4 &a4)
       : m_function (function),
         m_a1 (a1),
         m_a2 (a2),
@@ -632,7 +642,8 @@ private:
 
 template <typename U1, typename U2, typename U3, typename U4, typename U5,
           typename T1, typename T2, typename T3, typename T4, typename T5>
-EventImpl * MakeEvent (void (*f)(U1,U2,U3,U4,U5), T1 a1, T2 a2, T3 a3, T4 a4, T5 a5)
+EventImpl * MakeEvent (void (*f)(U1,U2,U3,U4,U5), const T1 &a1, const T2 &a2,
+                       const T3 &a3, const T4 &a4, const T5 &a5)
 {
   // five arg version
   class EventFunctionImpl5 : public EventImpl
@@ -640,7 +651,8 @@ EventImpl * MakeEvent (void (*f)(U1,U2,U3,U4,U5), T1 a1, T2 a2, T3 a3, T4 a4, T5
 public:
     typedef void (*F)(U1,U2,U3,U4,U5);
 
-    EventFunctionImpl5 (F function, T1 a1, T2 a2, T3 a3, T4 a4, T5 a5)
+    EventFunctionImpl5 (F function, const T1 &a1, const T2 &a2,
+                        const T3 &a3, const T4 &a4, const T5 &a5)
       : m_function (function),
         m_a1 (a1),
         m_a2 (a2),
@@ -100,6 +100,34 @@ MapScheduler::RemoveNext (void)
   return ev;
 }
 
+void
+MapScheduler::RemoveNextBatch (std::vector<Event> &events)
+{
+  NS_LOG_FUNCTION (this);
+  EventMapI begin = m_list.begin ();
+  NS_ASSERT (begin != m_list.end ());
+  uint64_t ts = begin->first.m_ts;
+  EventMapI end = begin;
+  while (end != m_list.end () && end->first.m_ts == ts)
+    {
+      Event ev;
+      ev.impl = end->second;
+      ev.key = end->first;
+      events.push_back (ev);
+      ++end;
+    }
+  m_list.erase (begin, end);
+}
+
+bool
+MapScheduler::RemoveCancelled (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_uid);
+  // The key finds the event in logarithmic time
+  Remove (ev);
+  return true;
+}
+
 void
 MapScheduler::Remove (const Event &ev)
 {
@@ -61,6 +61,8 @@ public:
   virtual Scheduler::Event PeekNext (void) const;
   virtual Scheduler::Event RemoveNext (void);
   virtual void Remove (const Scheduler::Event &ev);
+  virtual void RemoveNextBatch (std::vector<Scheduler::Event> &events);
+  virtual bool RemoveCancelled (const Scheduler::Event &ev);
 
 private:
   /** Event list type: a Map from EventKey to EventImpl. */
@@ -0,0 +1,195 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MPSC_RING_H
+#define MPSC_RING_H
+
+#include "assert.h"
+#include <stdint.h>
+
+/**
+ * \file
+ * \ingroup thread
+ * ns3::MpscRing declaration and template implementation.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup thread
+ * \brief A bounded lock-free queue with many producer threads and one
+ * consumer thread.
+ *
+ * The items live in a ring of cells.  Each cell carries a sequence
+ * number, which tells whether the cell is free for the push of a given
+ * position or holds the item of that position.  A producer reserves a
+ * position with a compare and swap on the tail, writes the item, then
+ * publishes it with the sequence number of the cell; the consumer reads
+ * the cell at the head once its sequence number shows the item.  The items
+ * of a producer are popped in the order of their push.
+ *
+ * TryPush fails when the ring is full, and TryPop when the item at the
+ * head is not published yet, even if later positions are: IsEmpty tells
+ * whether a push is still in progress.
+ *
+ * \tparam T \explicit The type of the items, copied in and out of the ring.
+ */
+template <typename T>
+class MpscRing
+{
+public:
+  /**
+   * Constructor.
+   * \param [in] capacity The number of cells, a power of two.
+   */
+  explicit MpscRing (uint32_t capacity);
+  /** Destructor. */
+  ~MpscRing ();
+
+  /**
+   * Add an item at the tail, from any thread.
+   * \param [in] item The item.
+   * \returns \c false if the ring is full.
+   */
+  bool TryPush (const T &item);
+  /**
+   * Remove the item at the head, from the consumer thread.
+   * \param [out] item The item.
+   * \returns \c false if the head holds no published item.
+   */
+  bool TryPop (T &item);
+  /**
+   * Called from the consumer thread.
+   * \returns \c true if no item was pushed or is being pushed since the
+   *          last TryPop.
+   */
+  bool IsEmpty (void) const;
+
+private:
+  /** A cell of the ring. */
+  struct Cell
+  {
+    uint32_t sequence;  //!< Position the cell is free for, or holds plus one
+    T item;             //!< The item
+  };
+
+  /**
+   * Copy constructor, not implemented.
+   * \param [in] o The ring to copy.
+   */
+  MpscRing (const MpscRing &o);
+  /**
+   * Assignment operator, not implemented.
+   * \param [in] o The ring to copy.
+   * \returns This ring.
+   */
+  MpscRing &operator = (const MpscRing &o);
+
+  Cell *m_cells;        //!< The ring
+  uint32_t m_mask;      //!< Mask of the index of a position in m_cells
+  uint32_t m_tail;      //!< Next position to push, shared by the producers
+  char m_pad[64];       //!< Keep the head off the cache line of the tail
+  uint32_t m_head;      //!< Next position to pop, owned by the consumer
+};
+
+} // namespace ns3
+
+
+/********************************************************************
+ *  Implementation of the templates declared above.
+ ********************************************************************/
+
+namespace ns3 {
+
+template <typename T>
+MpscRing<T>::MpscRing (uint32_t capacity)
+  : m_cells (new Cell [capacity]),
+    m_mask (capacity - 1),
+    m_tail (0),
+    m_head (0)
+{
+  NS_ASSERT_MSG (capacity > 0 && (capacity & m_mask) == 0, "The capacity must be a power of two");
+  for (uint32_t i = 0; i < capacity; i++)
+    {
+      m_cells[i].sequence = i;
+    }
+}
+
+template <typename T>
+MpscRing<T>::~MpscRing ()
+{
+  delete [] m_cells;
+}
+
+template <typename T>
+bool
+MpscRing<T>::TryPush (const T &item)
+{
+  uint32_t pos = __atomic_load_n (&m_tail, __ATOMIC_RELAXED);
+  while (true)
+    {
+      Cell *cell = &m_cells[pos & m_mask];
+      uint32_t sequence = __atomic_load_n (&cell->sequence, __ATOMIC_ACQUIRE);
+      int32_t diff = (int32_t)(sequence - pos);
+      if (diff == 0)
+        {
+          // On failure, pos is updated to the current tail
+          if (__atomic_compare_exchange_n (&m_tail, &pos, pos + 1, true,
+                                           __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            {
+              cell->item = item;
+              __atomic_store_n (&cell->sequence, pos + 1, __ATOMIC_RELEASE);
+              return true;
+            }
+        }
+      else if (diff < 0)
+        {
+          // The cell still holds the item of the previous turn
+          return false;
+        }
+      else
+        {
+          pos = __atomic_load_n (&m_tail, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+template <typename T>
+bool
+MpscRing<T>::TryPop (T &item)
+{
+  Cell *cell = &m_cells[m_head & m_mask];
+  uint32_t sequence = __atomic_load_n (&cell->sequence, __ATOMIC_ACQUIRE);
+  if (sequence != m_head + 1)
+    {
+      return false;
+    }
+  item = cell->item;
+  __atomic_store_n (&cell->sequence, m_head + m_mask + 1, __ATOMIC_RELEASE);
+  m_head++;
+  return true;
+}
+
+template <typename T>
+bool
+MpscRing<T>::IsEmpty (void) const
+{
+  return __atomic_load_n (&m_tail, __ATOMIC_ACQUIRE) == m_head;
+}
+
+} // namespace ns3
+
+#endif /* MPSC_RING_H */
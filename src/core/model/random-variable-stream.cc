@@ -33,8 +33,10 @@
 #include "log.h"
 #include "rng-stream.h"
 #include "rng-seed-manager.h"
+#include "system-mutex.h"
 #include <cmath>
 #include <iostream>
+#include <set>
 
 /**
  * \file
@@ -46,6 +48,34 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("RandomVariableStream");
 
+namespace {
+
+/**
+ * \ingroup randomvariable
+ * \returns The mutex of the set of existing streams.
+ */
+SystemMutex &
+GetStreamsMutex (void)
+{
+  // Never destroyed: a stream may outlive the static destructors
+  static SystemMutex *mutex = new SystemMutex ();
+  return *mutex;
+}
+
+/**
+ * \ingroup randomvariable
+ * \returns The set of existing streams, seeded again by
+ *          RandomVariableStream::ReseedAll.
+ */
+std::set<RandomVariableStream *> &
+GetStreams (void)
+{
+  static std::set<RandomVariableStream *> *streams = new std::set<RandomVariableStream *> ();
+  return *streams;
+}
+
+} // anonymous namespace
+
 NS_OBJECT_ENSURE_REGISTERED (RandomVariableStream);
 
 TypeId 
@@ -75,10 +105,14 @@ RandomVariableStream::RandomVariableStream()
   : m_rng (0)
 {
   NS_LOG_FUNCTION (this);
+  CriticalSection critical (GetStreamsMutex ());
+  GetStreams ().insert (this);
 }
 RandomVariableStream::~RandomVariableStream()
 {
   NS_LOG_FUNCTION (this);
+  CriticalSection critical (GetStreamsMutex ());
+  GetStreams ().erase (this);
   delete m_rng;
 }
 
@@ -107,22 +141,38 @@ RandomVariableStream::SetStream (int64_t stream)
       // number assignment.
       uint64_t nextStream = RngSeedManager::GetNextStreamIndex ();
       NS_ASSERT(nextStream <= ((1ULL)<<63));
-      m_rng = new RngStream (RngSeedManager::GetSeed (),
-                             nextStream,
-                             RngSeedManager::GetRun ());
+      m_index = nextStream;
     }
   else
     {
       // The last 2^63 streams are reserved for deterministic stream
       // number assignment.
       uint64_t base = ((1ULL)<<63);
-      uint64_t target = base + stream;
-      m_rng = new RngStream (RngSeedManager::GetSeed (),
-                             target,
-                             RngSeedManager::GetRun ());
+      m_index = base + stream;
     }
+  m_rng = new RngStream (RngSeedManager::GetSeed (),
+                         m_index,
+                         RngSeedManager::GetRun ());
   m_stream = stream;
 }
+void
+RandomVariableStream::ReseedAll (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  CriticalSection critical (GetStreamsMutex ());
+  std::set<RandomVariableStream *> &streams = GetStreams ();
+  for (std::set<RandomVariableStream *>::iterator i = streams.begin (); i != streams.end (); ++i)
+    {
+      RandomVariableStream *stream = *i;
+      if (stream->m_rng != 0)
+        {
+          delete stream->m_rng;
+          stream->m_rng = new RngStream (RngSeedManager::GetSeed (),
+                                         stream->m_index,
+                                         RngSeedManager::GetRun ());
+        }
+    }
+}
 int64_t
 RandomVariableStream::GetStream(void) const
 {
@@ -137,6 +137,19 @@ public:
    */
   bool IsAntithetic(void) const;
 
+  /**
+   * \brief Seed every existing stream again with the current seed and
+   * run of RngSeedManager.
+   *
+   * A stream is seeded when its stream number is set, so changing the
+   * run only applies to the streams created after the change.  After
+   * this call, each existing stream restarts at the beginning of its
+   * substream in the current run, with its stream number, as if it had
+   * been created after the change.  The values a distribution keeps
+   * between two draws, like the second value of a normal pair, are kept.
+   */
+  static void ReseedAll (void);
+
   /**
    * \brief Get the next random value as a double drawn from the distribution.
    * \return A floating point random value.
@@ -186,6 +199,9 @@ private:
   /** The stream number for this RNG stream. */
   int64_t m_stream;
 
+  /** The index of the underlying RNG stream, derived from m_stream. */
+  uint64_t m_index;
+
 };  // class RandomVariableStream
 
   
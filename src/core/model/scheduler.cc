@@ -49,4 +49,23 @@ Scheduler::GetTypeId (void)
   return tid;
 }
 
+bool
+Scheduler::RemoveCancelled (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_uid);
+  return false;
+}
+
+void
+Scheduler::RemoveNextBatch (std::vector<Event> &events)
+{
+  NS_LOG_FUNCTION (this);
+  Event next = RemoveNext ();
+  events.push_back (next);
+  while (!IsEmpty () && PeekNext ().key.m_ts == next.key.m_ts)
+    {
+      events.push_back (RemoveNext ());
+    }
+}
+
 } // namespace ns3
@@ -22,6 +22,7 @@
 #define SCHEDULER_H
 
 #include <stdint.h>
+#include <vector>
 #include "object.h"
 
 /**
@@ -135,6 +136,27 @@ public:
    * \param [in] ev The event to remove
    */
   virtual void Remove (const Event &ev) = 0;
+  /**
+   * Remove all the events with the timestamp of the earliest event.
+   *
+   * This method cannot be invoked if the list is empty.  The default
+   * implementation calls RemoveNext until the timestamp changes.
+   *
+   * \param [out] events The vector the events are appended to, in the
+   *      order of their keys.
+   */
+  virtual void RemoveNextBatch (std::vector<Event> &events);
+  /**
+   * Remove a cancelled event from the event list, if the scheduler can
+   * find it without a search.
+   *
+   * The default implementation keeps the event, which the simulator
+   * drops when it comes up.
+   *
+   * \param [in] ev The cancelled event.
+   * \returns \c true if the event was removed.
+   */
+  virtual bool RemoveCancelled (const Event &ev);
 };
 
 /**
@@ -131,6 +131,12 @@ public:
   virtual EventId Schedule (const Time &delay) = 0;
   /** Invoke the expire function. */
   virtual void Invoke (void) = 0;
+  /**
+   * Copy the expire function and its arguments.
+   *
+   * \returns A new TimerImpl, owned by the caller.
+   */
+  virtual TimerImpl *Copy (void) const = 0;
 };
 
 } // namespace ns3
@@ -279,6 +285,10 @@ MakeTimerImpl (IntToType<0>, FN fn)
       m_fn ();
     }
     FN m_fn;
+    virtual TimerImpl *Copy (void) const
+    {
+      return new FnTimerImplZero (*this);
+    }
   } *function = new FnTimerImplZero (fn);
   return function;
 }
@@ -315,6 +325,10 @@ MakeTimerImpl (IntToType<1>, FN fn)
     }
     FN m_fn;
     T1Stored m_a1;
+    virtual TimerImpl *Copy (void) const
+    {
+      return new FnTimerImplOne (*this);
+    }
   } *function = new FnTimerImplOne (fn);
   return function;
 }
@@ -356,6 +370,10 @@ MakeTimerImpl (IntToType<2>, FN fn)
     FN m_fn;
     T1Stored m_a1;
     T2Stored m_a2;
+    virtual TimerImpl *Copy (void) const
+    {
+      return new FnTimerImplTwo (*this);
+    }
   } *function = new FnTimerImplTwo (fn);
   return function;
 }
@@ -402,6 +420,10 @@ MakeTimerImpl (IntToType<3>, FN fn)
     T1Stored m_a1;
     T2Stored m_a2;
     T3Stored m_a3;
+    virtual TimerImpl *Copy (void) const
+    {
+      return new FnTimerImplThree (*this);
+    }
   } *function = new FnTimerImplThree (fn);
   return function;
 }
@@ -453,6 +475,10 @@ MakeTimerImpl (IntToType<4>, FN fn)
     T2Stored m_a2;
     T3Stored m_a3;
     T4Stored m_a4;
+    virtual TimerImpl *Copy (void) const
+    {
+      return new FnTimerImplFour (*this);
+    }
   } *function = new FnTimerImplFour (fn);
   return function;
 }
@@ -509,6 +535,10 @@ MakeTimerImpl (IntToType<5>, FN fn)
     T3Stored m_a3;
     T4Stored m_a4;
     T5Stored m_a5;
+    virtual TimerImpl *Copy (void) const
+    {
+      return new FnTimerImplFive (*this);
+    }
   } *function = new FnTimerImplFive (fn);
   return function;
 }
@@ -570,6 +600,10 @@ MakeTimerImpl (IntToType<6>, FN fn)
     T4Stored m_a4;
     T5Stored m_a5;
     T6Stored m_a6;
+    virtual TimerImpl *Copy (void) const
+    {
+      return new FnTimerImplSix (*this);
+    }
   } *function = new FnTimerImplSix (fn);
   return function;
 }
@@ -655,6 +689,10 @@ MakeTimerImpl (IntToType<0>, MEM_PTR memPtr, OBJ_PTR objPtr)
     }
     MEM_PTR m_memPtr;
     OBJ_PTR m_objPtr;
+    virtual TimerImpl *Copy (void) const
+    {
+      return new MemFnTimerImplZero (*this);
+    }
   } *function = new MemFnTimerImplZero (memPtr, objPtr);
   return function;
 }
@@ -693,6 +731,10 @@ MakeTimerImpl (IntToType<1>, MEM_PTR memPtr, OBJ_PTR objPtr)
     MEM_PTR m_memPtr;
     OBJ_PTR m_objPtr;
     T1Stored m_a1;
+    virtual TimerImpl *Copy (void) const
+    {
+      return new MemFnTimerImplOne (*this);
+    }
   } *function = new MemFnTimerImplOne (memPtr, objPtr);
   return function;
 }
@@ -736,6 +778,10 @@ MakeTimerImpl (IntToType<2>, MEM_PTR memPtr, OBJ_PTR objPtr)
     OBJ_PTR m_objPtr;
     T1Stored m_a1;
     T2Stored m_a2;
+    virtual TimerImpl *Copy (void) const
+    {
+      return new MemFnTimerImplTwo (*this);
+    }
   } *function = new MemFnTimerImplTwo (memPtr, objPtr);
   return function;
 }
@@ -784,6 +830,10 @@ MakeTimerImpl (IntToType<3>, MEM_PTR memPtr, OBJ_PTR objPtr)
     T1Stored m_a1;
     T2Stored m_a2;
     T3Stored m_a3;
+    virtual TimerImpl *Copy (void) const
+    {
+      return new MemFnTimerImplThree (*this);
+    }
   } *function = new MemFnTimerImplThree (memPtr, objPtr);
   return function;
 }
@@ -837,6 +887,10 @@ MakeTimerImpl (IntToType<4>, MEM_PTR memPtr, OBJ_PTR objPtr)
     T2Stored m_a2;
     T3Stored m_a3;
     T4Stored m_a4;
+    virtual TimerImpl *Copy (void) const
+    {
+      return new MemFnTimerImplFour (*this);
+    }
   } *function = new MemFnTimerImplFour (memPtr, objPtr);
   return function;
 }
@@ -895,6 +949,10 @@ MakeTimerImpl (IntToType<5>, MEM_PTR memPtr, OBJ_PTR objPtr)
     T3Stored m_a3;
     T4Stored m_a4;
     T5Stored m_a5;
+    virtual TimerImpl *Copy (void) const
+    {
+      return new MemFnTimerImplFive (*this);
+    }
   } *function = new MemFnTimerImplFive (memPtr, objPtr);
   return function;
 }
@@ -958,6 +1016,10 @@ MakeTimerImpl (IntToType<6>, MEM_PTR memPtr, OBJ_PTR objPtr)
     T4Stored m_a4;
     T5Stored m_a5;
     T6Stored m_a6;
+    virtual TimerImpl *Copy (void) const
+    {
+      return new MemFnTimerImplSix (*this);
+    }
   } *function = new MemFnTimerImplSix (memPtr, objPtr);
   return function;
 }
@@ -0,0 +1,333 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "timer-wheel.h"
+#include "simulator.h"
+#include "assert.h"
+#include "log.h"
+
+#include <algorithm>
+
+/**
+ * \file
+ * \ingroup timer
+ * ns3::TimerWheel implementation.
+ */
+
+namespace {
+
+/** Number of levels. */
+const uint32_t LEVELS = 4;
+/** Number of bits of the index of a slot. */
+const uint32_t SLOT_BITS = 6;
+/** Number of slots in a level. */
+const uint32_t SLOTS = 1 << SLOT_BITS;
+/** Mask of the index of a slot. */
+const uint64_t SLOT_MASK = SLOTS - 1;
+
+/**
+ * \param [in] level A level, or LEVELS for the overflow list.
+ * \returns The number of bits of the ticks covered by a slot of the level.
+ */
+inline uint32_t
+Shift (uint32_t level)
+{
+  return SLOT_BITS * level;
+}
+
+} // anonymous namespace
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TimerWheel");
+
+TimerWheel::Entry::Entry ()
+  : m_next (0),
+    m_pprev (0),
+    m_expiry (0),
+    m_level (0),
+    m_slot (0)
+{
+}
+
+TimerWheel::Entry::Entry (const Entry &o)
+  : m_next (0),
+    m_pprev (0),
+    m_expiry (0),
+    m_level (0),
+    m_slot (0),
+    m_expire (o.m_expire)
+{
+}
+
+TimerWheel::Entry &
+TimerWheel::Entry::operator = (const Entry &o)
+{
+  NS_ASSERT_MSG (!IsArmed (), "Assigning to an armed entry");
+  m_expire = o.m_expire;
+  return *this;
+}
+
+void
+TimerWheel::Entry::SetFunction (Callback<void> expire)
+{
+  m_expire = expire;
+}
+
+bool
+TimerWheel::Entry::IsArmed (void) const
+{
+  return m_pprev != 0;
+}
+
+TimerWheel::TimerWheel (const Time &tick)
+  : m_tick (tick.GetTimeStep ()),
+    m_now (0),
+    m_overflow (0),
+    m_size (0),
+    m_eventTick (0)
+{
+  NS_LOG_FUNCTION (this << tick);
+  NS_ASSERT_MSG (tick.IsStrictlyPositive (), "The tick must be positive");
+  for (uint32_t level = 0; level < LEVELS; level++)
+    {
+      for (uint32_t slot = 0; slot < SLOTS; slot++)
+        {
+          m_slots[level][slot] = 0;
+        }
+      m_occupied[level] = 0;
+    }
+}
+
+TimerWheel::~TimerWheel ()
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t level = 0; level <= LEVELS; level++)
+    {
+      for (uint32_t slot = 0; slot < (level < LEVELS ? SLOTS : 1); slot++)
+        {
+          Entry *entry = level < LEVELS ? m_slots[level][slot] : m_overflow;
+          while (entry != 0)
+            {
+              entry->m_pprev = 0;
+              entry = entry->m_next;
+            }
+        }
+    }
+  m_event.Cancel ();
+}
+
+Time
+TimerWheel::GetTick (void) const
+{
+  return TimeStep (m_tick);
+}
+
+uint32_t
+TimerWheel::GetSize (void) const
+{
+  return m_size;
+}
+
+void
+TimerWheel::File (Entry *entry)
+{
+  uint64_t expiry = entry->m_expiry;
+  Entry **head;
+  uint32_t level = 0;
+  while (level < LEVELS
+         && (expiry >> Shift (level + 1)) != (m_now >> Shift (level + 1)))
+    {
+      level++;
+    }
+  if (level == LEVELS)
+    {
+      head = &m_overflow;
+      entry->m_slot = 0;
+    }
+  else
+    {
+      uint32_t slot = (expiry >> Shift (level)) & SLOT_MASK;
+      head = &m_slots[level][slot];
+      entry->m_slot = slot;
+      m_occupied[level] |= uint64_t (1) << slot;
+    }
+  entry->m_level = level;
+  entry->m_next = *head;
+  if (*head != 0)
+    {
+      (*head)->m_pprev = &entry->m_next;
+    }
+  *head = entry;
+  entry->m_pprev = head;
+}
+
+void
+TimerWheel::Unlink (Entry *entry)
+{
+  *entry->m_pprev = entry->m_next;
+  if (entry->m_next != 0)
+    {
+      entry->m_next->m_pprev = entry->m_pprev;
+    }
+  if (entry->m_level < LEVELS && m_slots[entry->m_level][entry->m_slot] == 0)
+    {
+      m_occupied[entry->m_level] &= ~(uint64_t (1) << entry->m_slot);
+    }
+  entry->m_next = 0;
+  entry->m_pprev = 0;
+}
+
+void
+TimerWheel::Arm (Entry *entry, const Time &delay)
+{
+  NS_LOG_FUNCTION (this << entry << delay);
+  NS_ASSERT_MSG (!entry->IsArmed (), "The timer is already armed");
+  NS_ASSERT (!delay.IsStrictlyNegative ());
+  uint64_t now = Simulator::Now ().GetTimeStep ();
+  if (m_size == 0)
+    {
+      m_now = now / m_tick;
+    }
+  else
+    {
+      // m_now only moves at the event of the wheel: bring it up to the
+      // current tick, so that the timer is not filed in a slot the time
+      // has already passed.  The event is at the first tick which expires
+      // or moves timers, so no slot is crossed before it, and the slots
+      // of the armed timers stay after m_now.
+      m_now = std::max (m_now, std::min (now / m_tick, m_eventTick - 1));
+    }
+  uint64_t expiry = (now + delay.GetTimeStep () + m_tick - 1) / m_tick;
+  entry->m_expiry = std::max (expiry, m_now + 1);
+  File (entry);
+  m_size++;
+  Reschedule ();
+}
+
+void
+TimerWheel::Disarm (Entry *entry)
+{
+  NS_LOG_FUNCTION (this << entry);
+  if (!entry->IsArmed ())
+    {
+      return;
+    }
+  Unlink (entry);
+  m_size--;
+  if (m_size == 0)
+    {
+      m_event.Cancel ();
+    }
+}
+
+Time
+TimerWheel::GetDelayLeft (const Entry *entry) const
+{
+  NS_ASSERT (entry->IsArmed ());
+  return TimeStep (entry->m_expiry * m_tick) - Simulator::Now ();
+}
+
+uint64_t
+TimerWheel::GetNextTick (void) const
+{
+  uint64_t next = ~uint64_t (0);
+  for (uint32_t level = 0; level < LEVELS; level++)
+    {
+      // The slots of a level after the current one, in the current slot of
+      // the level above
+      uint32_t current = (m_now >> Shift (level)) & SLOT_MASK;
+      uint64_t after = m_occupied[level] & ~((uint64_t (2) << current) - 1);
+      if (after != 0)
+        {
+          uint64_t slot = __builtin_ctzll (after);
+          uint64_t tick = ((m_now >> Shift (level + 1)) << Shift (level + 1))
+            | (slot << Shift (level));
+          next = std::min (next, tick);
+        }
+    }
+  if (m_overflow != 0)
+    {
+      next = std::min (next, ((m_now >> Shift (LEVELS)) + 1) << Shift (LEVELS));
+    }
+  return next;
+}
+
+void
+TimerWheel::Reschedule (void)
+{
+  uint64_t next = GetNextTick ();
+  if (m_event.IsRunning ())
+    {
+      if (m_eventTick == next)
+        {
+          return;
+        }
+      m_event.Cancel ();
+    }
+  m_eventTick = next;
+  Time delay = TimeStep (next * m_tick) - Simulator::Now ();
+  m_event = Simulator::Schedule (delay, &TimerWheel::Expire, this);
+}
+
+void
+TimerWheel::Cascade (uint32_t level, uint32_t slot)
+{
+  Entry **head = level < LEVELS ? &m_slots[level][slot] : &m_overflow;
+  Entry *entry = *head;
+  *head = 0;
+  if (level < LEVELS)
+    {
+      m_occupied[level] &= ~(uint64_t (1) << slot);
+    }
+  while (entry != 0)
+    {
+      Entry *next = entry->m_next;
+      File (entry);
+      entry = next;
+    }
+}
+
+void
+TimerWheel::Expire (void)
+{
+  NS_LOG_FUNCTION (this << m_eventTick);
+  m_now = m_eventTick;
+  // Move the timers down from the top, so that each lands in its final slot
+  for (uint32_t level = LEVELS; level > 0; level--)
+    {
+      if ((m_now & ((uint64_t (1) << Shift (level)) - 1)) == 0)
+        {
+          Cascade (level, (m_now >> Shift (level)) & SLOT_MASK);
+        }
+    }
+  // The expiry of a timer armed by the functions is after m_now
+  uint32_t slot = m_now & SLOT_MASK;
+  while (m_slots[0][slot] != 0)
+    {
+      Entry *entry = m_slots[0][slot];
+      NS_ASSERT (entry->m_expiry == m_now);
+      Unlink (entry);
+      m_size--;
+      entry->m_expire ();
+    }
+  if (m_size > 0)
+    {
+      Reschedule ();
+    }
+}
+
+} // namespace ns3
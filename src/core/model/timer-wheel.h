@@ -0,0 +1,172 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include "nstime.h"
+#include "event-id.h"
+#include "callback.h"
+#include "simple-ref-count.h"
+#include <stdint.h>
+
+/**
+ * \file
+ * \ingroup timer
+ * ns3::TimerWheel declaration.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup timer
+ * \brief A hierarchical timing wheel which runs many coarse timers from
+ * one simulator event.
+ *
+ * The time is cut in ticks.  A timer armed on the wheel expires at the
+ * first tick boundary at or after its delay, and never in the tick being
+ * processed: the wheel trades precision for a single pending simulator
+ * event, however many timers are armed.  Arming and disarming a timer
+ * only link and unlink its Entry, in constant time.
+ *
+ * The wheel has four levels of 64 slots.  The level 0 slots hold the
+ * timers of the next 64 ticks, one tick per slot; each slot of level
+ * \c l covers 64^l ticks, and its timers move down a level when the wheel
+ * reaches the slot.  The timers beyond 64^4 ticks wait in an overflow
+ * list.  The wheel only schedules its event for the ticks which expire
+ * timers or move them down.
+ *
+ * A Timer uses a wheel after Timer::SetWheel; other users arm an Entry
+ * directly.  An Entry must be disarmed before it is destroyed.
+ */
+class TimerWheel : public SimpleRefCount<TimerWheel>
+{
+public:
+  /** A timer of the wheel, embedded in its user. */
+  class Entry
+  {
+public:
+    /** Constructor: the entry is not armed. */
+    Entry ();
+    /**
+     * Copy constructor: the copy has the function of \p o, but it is
+     * not armed, since an armed entry is linked into its slot.
+     * \param [in] o The entry to copy.
+     */
+    Entry (const Entry &o);
+    /**
+     * Assignment operator: take the function of \p o.  This entry
+     * must not be armed, and it stays unarmed.
+     * \param [in] o The entry to copy.
+     * \returns This entry.
+     */
+    Entry & operator = (const Entry &o);
+    /**
+     * Set the function called when the timer expires.
+     * \param [in] expire The function.
+     */
+    void SetFunction (Callback<void> expire);
+    /** \returns \c true if the timer is armed. */
+    bool IsArmed (void) const;
+
+private:
+    friend class TimerWheel;
+    Entry *m_next;           //!< Next entry of the slot
+    Entry **m_pprev;         //!< Link to this entry, or 0 if not armed
+    uint64_t m_expiry;       //!< The tick of expiry
+    uint8_t m_level;         //!< The level of the slot
+    uint8_t m_slot;          //!< The slot in the level
+    Callback<void> m_expire; //!< The function called on expiry
+  };
+
+  /**
+   * Constructor.
+   * \param [in] tick The duration of a tick.
+   */
+  explicit TimerWheel (const Time &tick);
+  /** Destructor: disarm the remaining timers. */
+  ~TimerWheel ();
+
+  /** \returns The duration of a tick. */
+  Time GetTick (void) const;
+  /**
+   * Arm a timer.
+   * \param [in] entry The timer, which must not be armed.
+   * \param [in] delay The delay before the timer expires.
+   */
+  void Arm (Entry *entry, const Time &delay);
+  /**
+   * Disarm a timer.  Do nothing if it is not armed.
+   * \param [in] entry The timer.
+   */
+  void Disarm (Entry *entry);
+  /**
+   * \param [in] entry An armed timer.
+   * \returns The time left until the timer expires.
+   */
+  Time GetDelayLeft (const Entry *entry) const;
+  /** \returns The number of armed timers. */
+  uint32_t GetSize (void) const;
+
+private:
+  /**
+   * Copy constructor, not implemented.
+   * \param [in] o The wheel to copy.
+   */
+  TimerWheel (const TimerWheel &o);
+  /**
+   * Assignment operator, not implemented.
+   * \param [in] o The wheel to copy.
+   * \returns This wheel.
+   */
+  TimerWheel &operator = (const TimerWheel &o);
+
+  /**
+   * Link an entry in the slot of its expiry, relative to m_now.
+   * \param [in] entry The entry.
+   */
+  void File (Entry *entry);
+  /**
+   * Unlink an entry from its slot.
+   * \param [in] entry The armed entry.
+   */
+  void Unlink (Entry *entry);
+  /**
+   * Link the entries of a slot again, relative to m_now.
+   * \param [in] level The level.
+   * \param [in] slot The slot.
+   */
+  void Cascade (uint32_t level, uint32_t slot);
+  /** \returns The next tick which expires or moves timers. */
+  uint64_t GetNextTick (void) const;
+  /** Schedule the event of the wheel for its next tick. */
+  void Reschedule (void);
+  /** Process the tick of the event of the wheel. */
+  void Expire (void);
+
+  uint64_t m_tick;          //!< Duration of a tick, in time steps
+  uint64_t m_now;           //!< The tick the slots are relative to
+  Entry *m_slots[4][64];    //!< The slots of the levels
+  uint64_t m_occupied[4];   //!< Bitmaps of the non empty slots
+  Entry *m_overflow;        //!< The timers beyond the top level
+  uint32_t m_size;          //!< Number of armed timers
+  EventId m_event;          //!< The event of the wheel
+  uint64_t m_eventTick;     //!< The tick of m_event
+};
+
+} // namespace ns3
+
+#endif /* TIMER_WHEEL_H */
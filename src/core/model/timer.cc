@@ -50,16 +50,57 @@ Timer::Timer (enum DestroyPolicy destroyPolicy)
   NS_LOG_FUNCTION (this << destroyPolicy);
 }
 
+Timer::Timer (const Timer &o)
+  : m_flags (o.m_flags & ~TIMER_SUSPENDED),
+    m_delay (o.m_delay),
+    m_event (),
+    m_impl (o.m_impl != 0 ? o.m_impl->Copy () : 0),
+    m_wheel (o.m_wheel)
+{
+  NS_LOG_FUNCTION (this << &o);
+  if (m_wheel != 0)
+    {
+      m_entry.SetFunction (MakeCallback (&Timer::Expire, this));
+    }
+}
+
+Timer &
+Timer::operator = (const Timer &o)
+{
+  NS_LOG_FUNCTION (this << &o);
+  if (this == &o)
+    {
+      return *this;
+    }
+  NS_ASSERT_MSG (!IsPending () && !IsSuspended (), "The timer is running or suspended");
+  TimerImpl *impl = o.m_impl != 0 ? o.m_impl->Copy () : 0;
+  delete m_impl;
+  m_impl = impl;
+  m_flags = o.m_flags & ~TIMER_SUSPENDED;
+  m_delay = o.m_delay;
+  m_event = EventId ();
+  m_wheel = o.m_wheel;
+  if (m_wheel != 0)
+    {
+      m_entry.SetFunction (MakeCallback (&Timer::Expire, this));
+    }
+  return *this;
+}
+
 Timer::~Timer ()
 {
   NS_LOG_FUNCTION (this);
   if (m_flags & CHECK_ON_DESTROY)
     {
-      if (m_event.IsRunning ())
+      if (IsPending ())
         {
           NS_FATAL_ERROR ("Event is still running while destroying.");
         }
     }
+  else if (m_wheel != 0)
+    {
+      m_wheel->Disarm (&m_entry);
+    }
   else if (m_flags & CANCEL_ON_DESTROY)
     {
       m_event.Cancel ();
@@ -90,6 +131,10 @@ Timer::GetDelayLeft (void) const
   switch (GetState ())
     {
     case Timer::RUNNING:
+      if (m_wheel != 0)
+        {
+          return m_wheel->GetDelayLeft (&m_entry);
+        }
       return Simulator::GetDelayLeft (m_event);
       break;
     case Timer::EXPIRED:
@@ -109,25 +154,44 @@ void
 Timer::Cancel (void)
 {
   NS_LOG_FUNCTION (this);
+  if (m_wheel != 0)
+    {
+      m_wheel->Disarm (&m_entry);
+      return;
+    }
   Simulator::Cancel (m_event);
 }
 void
 Timer::Remove (void)
 {
   NS_LOG_FUNCTION (this);
+  if (m_wheel != 0)
+    {
+      m_wheel->Disarm (&m_entry);
+      return;
+    }
   Simulator::Remove (m_event);
 }
 bool
+Timer::IsPending (void) const
+{
+  if (m_wheel != 0)
+    {
+      return m_entry.IsArmed ();
+    }
+  return m_event.IsRunning ();
+}
+bool
 Timer::IsExpired (void) const
 {
   NS_LOG_FUNCTION (this);
-  return !IsSuspended () && m_event.IsExpired ();
+  return !IsSuspended () && !IsPending ();
 }
 bool
 Timer::IsRunning (void) const
 {
   NS_LOG_FUNCTION (this);
-  return !IsSuspended () && m_event.IsRunning ();
+  return !IsSuspended () && IsPending ();
 }
 bool
 Timer::IsSuspended (void) const
@@ -166,10 +230,15 @@ Timer::Schedule (Time delay)
 {
   NS_LOG_FUNCTION (this << delay);
   NS_ASSERT (m_impl != 0);
-  if (m_event.IsRunning ())
+  if (IsPending ())
     {
       NS_FATAL_ERROR ("Event is still running while re-scheduling.");
     }
+  if (m_wheel != 0)
+    {
+      m_wheel->Arm (&m_entry, delay);
+      return;
+    }
   m_event = m_impl->Schedule (delay);
 }
 
@@ -178,8 +247,8 @@ Timer::Suspend (void)
 {
   NS_LOG_FUNCTION (this);
   NS_ASSERT (IsRunning ());
-  m_delayLeft = Simulator::GetDelayLeft (m_event);
-  Simulator::Remove (m_event);
+  m_delayLeft = GetDelayLeft ();
+  Remove ();
   m_flags |= TIMER_SUSPENDED;
 }
 
@@ -188,8 +257,30 @@ Timer::Resume (void)
 {
   NS_LOG_FUNCTION (this);
   NS_ASSERT (m_flags & TIMER_SUSPENDED);
-  m_event = m_impl->Schedule (m_delayLeft);
   m_flags &= ~TIMER_SUSPENDED;
+  Schedule (m_delayLeft);
+}
+
+void
+Timer::SetWheel (Ptr<TimerWheel> wheel)
+{
+  NS_LOG_FUNCTION (this << wheel);
+  NS_ASSERT_MSG (!IsPending () && !IsSuspended (), "The timer is running or suspended");
+  m_wheel = wheel;
+  m_entry.SetFunction (MakeCallback (&Timer::Expire, this));
+}
+
+Ptr<TimerWheel>
+Timer::GetWheel (void) const
+{
+  return m_wheel;
+}
+
+void
+Timer::Expire (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_impl->Invoke ();
 }
 
 
@@ -24,6 +24,8 @@
 #include "nstime.h"
 #include "event-id.h"
 #include "int-to-type.h"
+#include "timer-wheel.h"
+#include "ptr.h"
 
 /**
  * \file
@@ -68,6 +70,10 @@ class TimerImpl;
  * management policies. These policies are specified at construction time
  * and cannot be changed after.
  *
+ * A timer set on a TimerWheel runs on the wheel instead of scheduling
+ * its own event: it expires at the first tick of the wheel after its
+ * delay.
+ *
  * \see Watchdog for a simpler interface for a watchdog timer.
  */
 class Timer
@@ -112,6 +118,26 @@ public:
    * to use for destroy events
    */
   Timer (enum DestroyPolicy destroyPolicy);
+  /**
+   * Copy constructor.
+   *
+   * The copy gets its own copy of the function, the arguments, the
+   * delay, the destroy policy and the wheel of \p o, but it starts
+   * expired: the pending expiry of \p o is not copied.
+   *
+   * \param [in] o The timer to copy.
+   */
+  Timer (const Timer &o);
+  /**
+   * Assignment operator.
+   *
+   * This timer must not be running or suspended.  It takes the same
+   * state as a timer copy constructed from \p o.
+   *
+   * \param [in] o The timer to copy.
+   * \returns This timer.
+   */
+  Timer & operator = (const Timer &o);
   ~Timer ();
 
   /**
@@ -262,6 +288,17 @@ public:
    */
   void Resume (void);
 
+  /**
+   * \param [in] wheel The wheel, or 0 to schedule the events of this
+   *            timer in the simulator.
+   *
+   * Run this timer on a TimerWheel.  The timer must not be running or
+   * suspended.
+   */
+  void SetWheel (Ptr<TimerWheel> wheel);
+  /** \returns The wheel of this timer, or 0. */
+  Ptr<TimerWheel> GetWheel (void) const;
+
 private:
   /** Internal bit marking the suspended state. */
   enum InternalSuspended
@@ -269,6 +306,14 @@ private:
     TIMER_SUSPENDED = (1 << 7)  /** Timer suspended. */
   };
 
+  /**
+   * \returns \c true if the event of the timer, or its entry in the
+   * wheel, is pending.
+   */
+  bool IsPending (void) const;
+  /** Invoke the function of a timer on a wheel. */
+  void Expire (void);
+
   /**
    * Bitfield for Timer State, DestroyPolicy and InternalSuspended.
    *
@@ -290,6 +335,10 @@ private:
   TimerImpl *m_impl;
   /** The amount of time left on the Timer while it is suspended. */
   Time m_delayLeft;
+  /** The wheel of the timer, if any. */
+  Ptr<TimerWheel> m_wheel;
+  /** The entry of the timer in m_wheel. */
+  TimerWheel::Entry m_entry;
 };
 
 } // namespace ns3
@@ -0,0 +1,267 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "timing-wheel-scheduler.h"
+#include "event-impl.h"
+#include "uinteger.h"
+#include "assert.h"
+#include "log.h"
+
+#include <algorithm>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Implementation of ns3::TimingWheelScheduler class.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TimingWheelScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED (TimingWheelScheduler);
+
+TypeId
+TimingWheelScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TimingWheelScheduler")
+    .SetParent<Scheduler> ()
+    .SetGroupName ("Core")
+    .AddConstructor<TimingWheelScheduler> ()
+    .AddAttribute ("BucketWidth",
+                   "The duration of a bucket of the wheel.",
+                   TimeValue (NanoSeconds (100)),
+                   MakeTimeAccessor (&TimingWheelScheduler::m_bucketWidth),
+                   MakeTimeChecker (TimeStep (1)))
+    .AddAttribute ("Buckets",
+                   "The number of buckets of the wheel, rounded up to a power of two.",
+                   UintegerValue (4096),
+                   MakeUintegerAccessor (&TimingWheelScheduler::m_nBuckets),
+                   MakeUintegerChecker<uint32_t> (1, 1 << 24))
+  ;
+  return tid;
+}
+
+TimingWheelScheduler::TimingWheelScheduler ()
+  : m_width (0),
+    m_mask (0),
+    m_inWheel (0),
+    m_current (0),
+    m_size (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TimingWheelScheduler::~TimingWheelScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+bool
+TimingWheelScheduler::EventLater::operator () (const Scheduler::Event &a,
+                                              const Scheduler::Event &b) const
+{
+  return b < a;
+}
+
+void
+TimingWheelScheduler::Init (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_width = m_bucketWidth.GetTimeStep ();
+  uint32_t nBuckets = 1;
+  while (nBuckets < m_nBuckets)
+    {
+      nBuckets <<= 1;
+    }
+  m_mask = nBuckets - 1;
+  m_buckets.resize (nBuckets);
+  NS_LOG_DEBUG ("width=" << m_width << " buckets=" << nBuckets);
+}
+
+uint64_t
+TimingWheelScheduler::GetBucket (uint64_t ts) const
+{
+  return ts / m_width;
+}
+
+void
+TimingWheelScheduler::Insert (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  if (m_buckets.empty ())
+    {
+      Init ();
+    }
+  uint64_t bucket = GetBucket (ev.key.m_ts);
+  if (bucket <= m_current)
+    {
+      Bucket::iterator pos = std::upper_bound (m_sorted.begin (), m_sorted.end (), ev, EventLater ());
+      m_sorted.insert (pos, ev);
+    }
+  else if (bucket <= m_current + m_mask)
+    {
+      m_buckets[bucket & m_mask].push_back (ev);
+      m_inWheel++;
+    }
+  else
+    {
+      m_overflow.push_back (ev);
+      std::push_heap (m_overflow.begin (), m_overflow.end (), EventLater ());
+    }
+  m_size++;
+}
+
+bool
+TimingWheelScheduler::IsEmpty (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_size == 0;
+}
+
+void
+TimingWheelScheduler::Advance (void)
+{
+  NS_LOG_FUNCTION (this << m_current << m_inWheel << m_overflow.size ());
+  NS_ASSERT (m_sorted.empty () && m_size > 0);
+  if (m_inWheel == 0)
+    {
+      m_current = GetBucket (m_overflow.front ().key.m_ts);
+    }
+  else
+    {
+      do
+        {
+          m_current++;
+        }
+      while (m_buckets[m_current & m_mask].empty ());
+    }
+  Bucket &bucket = m_buckets[m_current & m_mask];
+  m_inWheel -= bucket.size ();
+  m_sorted.swap (bucket);
+
+  // The wheel now reaches m_current + m_mask
+  while (!m_overflow.empty ()
+         && GetBucket (m_overflow.front ().key.m_ts) <= m_current + m_mask)
+    {
+      Event ev = m_overflow.front ();
+      std::pop_heap (m_overflow.begin (), m_overflow.end (), EventLater ());
+      m_overflow.pop_back ();
+      uint64_t next = GetBucket (ev.key.m_ts);
+      if (next == m_current)
+        {
+          m_sorted.push_back (ev);
+        }
+      else
+        {
+          m_buckets[next & m_mask].push_back (ev);
+          m_inWheel++;
+        }
+    }
+  std::sort (m_sorted.begin (), m_sorted.end (), EventLater ());
+}
+
+Scheduler::Event
+TimingWheelScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  if (m_sorted.empty ())
+    {
+      // Turning the wheel does not change the order of the events
+      const_cast<TimingWheelScheduler *> (this)->Advance ();
+    }
+  return m_sorted.back ();
+}
+
+Scheduler::Event
+TimingWheelScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  if (m_sorted.empty ())
+    {
+      Advance ();
+    }
+  Event next = m_sorted.back ();
+  m_sorted.pop_back ();
+  m_size--;
+  return next;
+}
+
+void
+TimingWheelScheduler::RemoveNextBatch (std::vector<Event> &events)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  if (m_sorted.empty ())
+    {
+      Advance ();
+    }
+  // The simultaneous events are all in the current bucket
+  uint64_t ts = m_sorted.back ().key.m_ts;
+  while (!m_sorted.empty () && m_sorted.back ().key.m_ts == ts)
+    {
+      events.push_back (m_sorted.back ());
+      m_sorted.pop_back ();
+      m_size--;
+    }
+}
+
+void
+TimingWheelScheduler::Remove (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  NS_ASSERT (!IsEmpty ());
+  uint64_t bucket = GetBucket (ev.key.m_ts);
+  if (bucket <= m_current)
+    {
+      Bucket::iterator pos = std::lower_bound (m_sorted.begin (), m_sorted.end (), ev, EventLater ());
+      NS_ASSERT (pos != m_sorted.end () && pos->key.m_uid == ev.key.m_uid);
+      NS_ASSERT (pos->impl == ev.impl);
+      m_sorted.erase (pos);
+    }
+  else if (bucket <= m_current + m_mask)
+    {
+      Bucket &events = m_buckets[bucket & m_mask];
+      Bucket::iterator pos = events.begin ();
+      while (pos != events.end () && pos->key.m_uid != ev.key.m_uid)
+        {
+          ++pos;
+        }
+      NS_ASSERT (pos != events.end ());
+      NS_ASSERT (pos->impl == ev.impl);
+      *pos = events.back ();
+      events.pop_back ();
+      m_inWheel--;
+    }
+  else
+    {
+      Bucket::iterator pos = m_overflow.begin ();
+      while (pos != m_overflow.end () && pos->key.m_uid != ev.key.m_uid)
+        {
+          ++pos;
+        }
+      NS_ASSERT (pos != m_overflow.end ());
+      NS_ASSERT (pos->impl == ev.impl);
+      *pos = m_overflow.back ();
+      m_overflow.pop_back ();
+      std::make_heap (m_overflow.begin (), m_overflow.end (), EventLater ());
+    }
+  m_size--;
+}
+
+} // namespace ns3
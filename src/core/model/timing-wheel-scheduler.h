@@ -0,0 +1,131 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TIMING_WHEEL_SCHEDULER_H
+#define TIMING_WHEEL_SCHEDULER_H
+
+#include "scheduler.h"
+#include "nstime.h"
+#include <stdint.h>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Declaration of ns3::TimingWheelScheduler class.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup scheduler
+ * \brief a fixed width timing wheel event scheduler with an overflow heap
+ *
+ * The time is cut in buckets of BucketWidth.  The events of the next
+ * Buckets buckets sit unsorted in a circular array of buckets: an insertion
+ * is a push_back in the bucket of the event.  The events further away wait
+ * in a heap, and move to the wheel when it turns to reach them.
+ *
+ * The events of the current bucket are sorted, once, when the wheel turns
+ * to that bucket, like the bottom rung of a ladder queue: the next event
+ * is removed from the end of a sorted array.  An event inserted in the
+ * current bucket, like one scheduled with a delay shorter than the bucket
+ * width, is inserted at its place in the sorted array.
+ *
+ * Unlike CalendarScheduler, the width never changes with the number of
+ * events, so a sudden change of event density, like the start of an
+ * incast, costs no resize.  The width should hold a few events: a tenth of
+ * the transmission time of a packet at the fastest link rate is a good
+ * start.  The wheel skips the empty buckets one by one, and jumps to the
+ * overflow heap when the wheel is empty.
+ *
+ * The attributes are read when the first event is inserted.
+ */
+class TimingWheelScheduler : public Scheduler
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  TimingWheelScheduler ();
+  /** Destructor. */
+  virtual ~TimingWheelScheduler ();
+
+  // Inherited
+  virtual void Insert (const Scheduler::Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Scheduler::Event PeekNext (void) const;
+  virtual Scheduler::Event RemoveNext (void);
+  virtual void Remove (const Scheduler::Event &ev);
+  virtual void RemoveNextBatch (std::vector<Scheduler::Event> &events);
+
+private:
+  /** Bucket type: a vector of Events. */
+  typedef std::vector<Scheduler::Event> Bucket;
+
+  /** Orders the events the latest first. */
+  struct EventLater
+  {
+    /**
+     * \param [in] a The first event.
+     * \param [in] b The second event.
+     * \returns \c true if \p a is later than \p b.
+     */
+    bool operator () (const Scheduler::Event &a, const Scheduler::Event &b) const;
+  };
+
+  /** Allocate the wheel from the attributes. */
+  void Init (void);
+  /**
+   * Get the bucket of a timestamp.
+   *
+   * \param [in] ts The timestamp.
+   * \returns The number of the bucket, counted from time 0.
+   */
+  inline uint64_t GetBucket (uint64_t ts) const;
+  /** Turn the wheel to the next bucket with events and sort it. */
+  void Advance (void);
+
+  /** BucketWidth attribute. */
+  Time m_bucketWidth;
+  /** Buckets attribute. */
+  uint32_t m_nBuckets;
+
+  /** Duration of a bucket, in time steps. */
+  uint64_t m_width;
+  /** Mask of the index of a bucket in m_buckets. */
+  uint64_t m_mask;
+  /** The buckets after the current one. */
+  std::vector<Bucket> m_buckets;
+  /** Number of events in m_buckets. */
+  uint32_t m_inWheel;
+  /** The events up to the current bucket, the latest first. */
+  Bucket m_sorted;
+  /** Heap of the events beyond the wheel. */
+  Bucket m_overflow;
+  /** The current bucket. */
+  uint64_t m_current;
+  /** Number of events. */
+  uint32_t m_size;
+};
+
+} // namespace ns3
+
+#endif /* TIMING_WHEEL_SCHEDULER_H */
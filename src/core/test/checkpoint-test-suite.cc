@@ -0,0 +1,169 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/checkpoint.h"
+#include "ns3/sweep-runner.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/simulator.h"
+#include "ns3/test.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+using namespace ns3;
+
+class CheckpointTestCase : public TestCase
+{
+public:
+  CheckpointTestCase ();
+  virtual void DoRun (void);
+  void Event (void);
+  void Job (uint32_t job);
+  SweepRunner *m_runner;
+  uint32_t m_events;
+  uint32_t m_sum;
+  uint32_t m_step;
+};
+
+CheckpointTestCase::CheckpointTestCase ()
+  : TestCase ("Check that the workers continue from the checkpoint")
+{
+}
+
+void
+CheckpointTestCase::Event (void)
+{
+  m_events++;
+  m_sum += m_step;
+}
+
+void
+CheckpointTestCase::Job (uint32_t job)
+{
+  m_step = std::atoi (m_runner->GetParameter ("step").c_str ());
+}
+
+void
+CheckpointTestCase::DoRun (void)
+{
+  m_runner = new SweepRunner ();
+  m_runner->AddParameter ("step");
+  for (uint32_t step = 2; step < 6; step++)
+    {
+      std::ostringstream oss;
+      oss << step;
+      m_runner->AddJob (std::vector<std::string> (1, oss.str ()));
+    }
+  m_runner->SetParallel (2);
+  m_events = 0;
+  m_sum = 0;
+  m_step = 1;
+  for (uint32_t i = 1; i <= 10; i++)
+    {
+      Simulator::Schedule (Seconds (i), &CheckpointTestCase::Event, this);
+    }
+  Checkpoint::Schedule (Seconds (5.5), m_runner,
+                        MakeCallback (&CheckpointTestCase::Job, this));
+  Simulator::Run ();
+  Simulator::Destroy ();
+  if (m_step > 1)
+    {
+      // The worker ran the 5 events after the checkpoint with its step
+      bool ok = m_events == 10 && m_sum == 5 + 5 * m_step;
+      delete m_runner;
+      _exit (ok ? 0 : 1);
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_events, 5, "The original process did not stop at the checkpoint");
+  NS_TEST_EXPECT_MSG_EQ (m_sum, 5, "Wrong state in the original process");
+  bool ok = m_runner->Merge (CreateTempDirFilename ("checkpoint.tsv"));
+  NS_TEST_EXPECT_MSG_EQ (ok, true, "A worker did not continue from the checkpoint");
+  delete m_runner;
+}
+
+class SweepRunnerTestCase : public TestCase
+{
+public:
+  SweepRunnerTestCase ();
+  virtual void DoRun (void);
+};
+
+SweepRunnerTestCase::SweepRunnerTestCase ()
+  : TestCase ("Check the merged rows of the workers of a sweep")
+{
+}
+
+void
+SweepRunnerTestCase::DoRun (void)
+{
+  SweepRunner *runner = new SweepRunner ();
+  runner->AddParameter ("x");
+  runner->AddColumn ("value");
+  runner->AddColumn ("run");
+  runner->AddColumn ("reseeded");
+  runner->AddJob (std::vector<std::string> (1, "1"));
+  runner->AddJob (std::vector<std::string> (1, "2"));
+  runner->AddJob (std::vector<std::string> (1, "3"));
+  runner->SetReplications (2);
+  runner->SetFirstRun (7);
+  runner->SetParallel (2);
+  // A stream of the built topology, seeded with the run of this process
+  Ptr<UniformRandomVariable> built = CreateObject<UniformRandomVariable> ();
+  built->SetStream (3);
+  int32_t job = runner->Fork ();
+  if (job >= 0)
+    {
+      double x = std::atof (runner->GetParameter ("x").c_str ());
+      Ptr<UniformRandomVariable> fresh = CreateObject<UniformRandomVariable> ();
+      fresh->SetStream (3);
+      std::vector<double> values;
+      values.push_back (x * 10 + runner->GetReplication ());
+      values.push_back (RngSeedManager::GetRun ());
+      values.push_back (built->GetValue () == fresh->GetValue ());
+      runner->AddRow (values);
+      delete runner;
+      _exit (0);
+    }
+  std::string filename = CreateTempDirFilename ("sweep.tsv");
+  NS_TEST_EXPECT_MSG_EQ (runner->Merge (filename), true, "A worker failed");
+  delete runner;
+
+  std::ifstream in (filename.c_str ());
+  std::ostringstream content;
+  content << in.rdbuf ();
+  NS_TEST_EXPECT_MSG_EQ (content.str (),
+                         "x\treplication\trun\tvalue\trun\treseeded\n"
+                         "1\t0\t7\t10\t7\t1\n"
+                         "1\t1\t8\t11\t8\t1\n"
+                         "2\t0\t7\t20\t7\t1\n"
+                         "2\t1\t8\t21\t8\t1\n"
+                         "3\t0\t7\t30\t7\t1\n"
+                         "3\t1\t8\t31\t8\t1\n",
+                         "Wrong rows in the merged file");
+}
+
+static class CheckpointTestSuite : public TestSuite
+{
+public:
+  CheckpointTestSuite ()
+    : TestSuite ("checkpoint", UNIT)
+  {
+    AddTestCase (new CheckpointTestCase (), TestCase::QUICK);
+    AddTestCase (new SweepRunnerTestCase (), TestCase::QUICK);
+  }
+} g_checkpointTestSuite;
@@ -21,8 +21,16 @@
 #include "ns3/simulator.h"
 #include "ns3/list-scheduler.h"
 #include "ns3/heap-scheduler.h"
+#include "ns3/dary-heap-scheduler.h"
 #include "ns3/map-scheduler.h"
 #include "ns3/calendar-scheduler.h"
+#include "ns3/timing-wheel-scheduler.h"
+#include "ns3/default-simulator-impl.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+
+#include <sstream>
+#include <vector>
 
 using namespace ns3;
 
@@ -459,6 +467,206 @@ SimulatorTemplateTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+class SimulatorOrderTestCase : public TestCase
+{
+public:
+  SimulatorOrderTestCase (ObjectFactory schedulerFactory);
+  virtual void DoRun (void);
+  void Event (uint32_t seq);
+  void ScheduleEvent (void);
+  uint32_t Random (void);
+  Time GetDelay (void);
+  std::vector<uint64_t> m_ts;
+  std::vector<uint32_t> m_seq;
+  uint32_t m_nextSeq;
+  uint32_t m_state;
+  ObjectFactory m_schedulerFactory;
+};
+
+SimulatorOrderTestCase::SimulatorOrderTestCase (ObjectFactory schedulerFactory)
+  : TestCase ("Check the order of many simultaneous and removed events with " +
+              schedulerFactory.GetTypeId ().GetName ()),
+    m_schedulerFactory (schedulerFactory)
+{
+}
+
+uint32_t
+SimulatorOrderTestCase::Random (void)
+{
+  m_state = m_state * 1103515245 + 12345;
+  return m_state >> 16;
+}
+
+Time
+SimulatorOrderTestCase::GetDelay (void)
+{
+  // Mostly short delays, with some simultaneous events and some far ones
+  uint32_t delay = Random () % 500;
+  return NanoSeconds (m_nextSeq % 7 == 0 ? delay * 2000 : delay);
+}
+
+void
+SimulatorOrderTestCase::ScheduleEvent (void)
+{
+  Simulator::Schedule (GetDelay (), &SimulatorOrderTestCase::Event, this, m_nextSeq);
+  m_nextSeq++;
+}
+
+void
+SimulatorOrderTestCase::Event (uint32_t seq)
+{
+  m_ts.push_back (Simulator::Now ().GetTimeStep ());
+  m_seq.push_back (seq);
+  if (seq % 3 == 0 && m_nextSeq < 6000)
+    {
+      ScheduleEvent ();
+    }
+}
+
+void
+SimulatorOrderTestCase::DoRun (void)
+{
+  m_nextSeq = 0;
+  m_state = 1;
+  Simulator::SetScheduler (m_schedulerFactory);
+
+  uint32_t removed = 0;
+  for (uint32_t i = 0; i < 3000; i++)
+    {
+      EventId id = Simulator::Schedule (GetDelay (), &SimulatorOrderTestCase::Event, this, m_nextSeq);
+      m_nextSeq++;
+      if (i % 5 == 4)
+        {
+          Simulator::Remove (id);
+          removed++;
+        }
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_ts.size (), m_nextSeq - removed, "Wrong number of events");
+  for (uint32_t i = 1; i < m_ts.size (); i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ ((m_ts[i - 1] <= m_ts[i]), true, "Event " << i << " out of order");
+      if (m_ts[i - 1] == m_ts[i])
+        {
+          NS_TEST_ASSERT_MSG_LT (m_seq[i - 1], m_seq[i], "Simultaneous event " << i << " out of order");
+        }
+    }
+}
+
+class SimulatorBatchTestCase : public TestCase
+{
+public:
+  SimulatorBatchTestCase (ObjectFactory schedulerFactory);
+  virtual void DoRun (void);
+  void Event (uint32_t n);
+  std::ostringstream m_log;
+  EventId m_ids[5];
+  ObjectFactory m_schedulerFactory;
+};
+
+SimulatorBatchTestCase::SimulatorBatchTestCase (ObjectFactory schedulerFactory)
+  : TestCase ("Check Remove and Stop between simultaneous events with " +
+              schedulerFactory.GetTypeId ().GetName ()),
+    m_schedulerFactory (schedulerFactory)
+{
+}
+
+void
+SimulatorBatchTestCase::Event (uint32_t n)
+{
+  m_log << n << " ";
+  switch (n)
+    {
+    case 0:
+      Simulator::ScheduleNow (&SimulatorBatchTestCase::Event, this, 9);
+      break;
+    case 1:
+      NS_TEST_EXPECT_MSG_EQ (m_ids[3].IsExpired (), false, "Simultaneous event expired");
+      Simulator::Remove (m_ids[3]);
+      NS_TEST_EXPECT_MSG_EQ (m_ids[3].IsExpired (), true, "Removed event not expired");
+      break;
+    case 2:
+      Simulator::Stop ();
+      break;
+    }
+}
+
+void
+SimulatorBatchTestCase::DoRun (void)
+{
+  Simulator::SetScheduler (m_schedulerFactory);
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      m_ids[i] = Simulator::Schedule (MicroSeconds (10), &SimulatorBatchTestCase::Event, this, i);
+    }
+  Simulator::Schedule (MicroSeconds (11), &SimulatorBatchTestCase::Event, this, 5);
+  Simulator::Run ();
+  m_log << "| ";
+  NS_TEST_EXPECT_MSG_EQ (Simulator::Now (), MicroSeconds (10), "Stopped at the wrong time");
+  NS_TEST_EXPECT_MSG_EQ (m_ids[4].IsExpired (), false, "Event left by Stop expired");
+  Simulator::Run ();
+  Simulator::Destroy ();
+  NS_TEST_EXPECT_MSG_EQ (m_log.str (), "0 1 2 | 4 9 5 ", "Wrong order of the events");
+}
+
+class SimulatorCancelTestCase : public TestCase
+{
+public:
+  SimulatorCancelTestCase (ObjectFactory schedulerFactory, uint32_t dead);
+  virtual void DoRun (void);
+  void Event (void);
+  uint32_t m_count;
+  uint32_t m_dead;
+  ObjectFactory m_schedulerFactory;
+};
+
+SimulatorCancelTestCase::SimulatorCancelTestCase (ObjectFactory schedulerFactory, uint32_t dead)
+  : TestCase ("Check the cancelled events left in the event list with " +
+              schedulerFactory.GetTypeId ().GetName ()),
+    m_count (0),
+    m_dead (dead),
+    m_schedulerFactory (schedulerFactory)
+{
+}
+
+void
+SimulatorCancelTestCase::Event (void)
+{
+  m_count++;
+}
+
+void
+SimulatorCancelTestCase::DoRun (void)
+{
+  Simulator::SetScheduler (m_schedulerFactory);
+  Ptr<DefaultSimulatorImpl> impl = DynamicCast<DefaultSimulatorImpl> (Simulator::GetImplementation ());
+  NS_TEST_ASSERT_MSG_NE (impl, 0, "Not the default simulator");
+  impl->SetAttribute ("CompactionMinimum", UintegerValue (100));
+  impl->SetAttribute ("CompactionRatio", DoubleValue (0.5));
+
+  std::vector<EventId> ids;
+  for (uint32_t i = 0; i < 300; i++)
+    {
+      ids.push_back (Simulator::Schedule (MicroSeconds (i + 1), &SimulatorCancelTestCase::Event, this));
+    }
+  for (uint32_t i = 0; i < 200; i++)
+    {
+      Simulator::Cancel (ids[(i * 3) % 299]);
+      NS_TEST_EXPECT_MSG_EQ (impl->GetLiveEventCount (), 300 - i - 1, "Wrong number of live events");
+    }
+  // Without removal in place, the 150th cancel compacts the event list
+  NS_TEST_EXPECT_MSG_EQ (impl->GetDeadEventCount (), m_dead, "Wrong number of dead events");
+  NS_TEST_EXPECT_MSG_EQ (impl->GetCompactionCount (), (m_dead == 0 ? 0 : 1), "Wrong number of compactions");
+  Simulator::Cancel (ids[0]);
+  NS_TEST_EXPECT_MSG_EQ (impl->GetLiveEventCount (), 100, "Cancel twice changed the count");
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_count, 100, "Wrong number of events run");
+  NS_TEST_EXPECT_MSG_EQ (impl->GetDeadEventCount (), 0, "Dead events left");
+  Simulator::Destroy ();
+}
+
 class SimulatorTestSuite : public TestSuite
 {
 public:
@@ -475,5 +683,36 @@ public:
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
     factory.SetTypeId (CalendarScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (DaryHeapScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (TimingWheelScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+
+    factory.SetTypeId (MapScheduler::GetTypeId ());
+    AddTestCase (new SimulatorBatchTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (HeapScheduler::GetTypeId ());
+    AddTestCase (new SimulatorBatchTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (TimingWheelScheduler::GetTypeId ());
+    AddTestCase (new SimulatorBatchTestCase (factory), TestCase::QUICK);
+
+    factory.SetTypeId (MapScheduler::GetTypeId ());
+    AddTestCase (new SimulatorCancelTestCase (factory, 0), TestCase::QUICK);
+    factory.SetTypeId (DaryHeapScheduler::GetTypeId ());
+    AddTestCase (new SimulatorCancelTestCase (factory, 0), TestCase::QUICK);
+    factory.SetTypeId (HeapScheduler::GetTypeId ());
+    AddTestCase (new SimulatorCancelTestCase (factory, 50), TestCase::QUICK);
+
+    factory.SetTypeId (MapScheduler::GetTypeId ());
+    AddTestCase (new SimulatorOrderTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (HeapScheduler::GetTypeId ());
+    AddTestCase (new SimulatorOrderTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (DaryHeapScheduler::GetTypeId ());
+    AddTestCase (new SimulatorOrderTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (TimingWheelScheduler::GetTypeId ());
+    AddTestCase (new SimulatorOrderTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (TimingWheelScheduler::GetTypeId ());
+    factory.Set ("BucketWidth", TimeValue (NanoSeconds (7)));
+    factory.Set ("Buckets", UintegerValue (16));
+    AddTestCase (new SimulatorOrderTestCase (factory), TestCase::QUICK);
   }
 } g_simulatorTestSuite;
@@ -225,6 +225,109 @@ ThreadedSimulatorEventsTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (m_a, m_d, "Bad scheduling");
 }
 
+/**
+ * Several threads inject events as fast as they can, with
+ * Simulator::ScheduleWithContext and no delay.  Every event must run
+ * exactly once, and the events of a thread in the order of their
+ * injection.
+ */
+class ThreadedInjectionStressTestCase : public TestCase
+{
+public:
+  ThreadedInjectionStressTestCase (unsigned int threads, uint32_t events);
+  void Receive (unsigned int threadno, uint32_t seq);
+  void Poll (void);
+  static void InjectingThread (std::pair<ThreadedInjectionStressTestCase *, unsigned int> context);
+  unsigned int m_threads;
+  uint32_t m_events;
+  uint32_t m_next[MAXTHREADS];
+  uint64_t m_received;
+  uint64_t m_polls;
+  std::string m_error;
+
+private:
+  virtual void DoRun (void);
+};
+
+ThreadedInjectionStressTestCase::ThreadedInjectionStressTestCase (unsigned int threads, uint32_t events)
+  : TestCase ("Check that events injected by many threads run once and in order"),
+    m_threads (threads),
+    m_events (events)
+{
+}
+
+void
+ThreadedInjectionStressTestCase::InjectingThread (std::pair<ThreadedInjectionStressTestCase *, unsigned int> context)
+{
+  ThreadedInjectionStressTestCase *me = context.first;
+  unsigned int threadno = context.second;
+  for (uint32_t seq = 0; seq < me->m_events; seq++)
+    {
+      Simulator::ScheduleWithContext (threadno, Seconds (0),
+                                      &ThreadedInjectionStressTestCase::Receive, me, threadno, seq);
+    }
+}
+
+void
+ThreadedInjectionStressTestCase::Receive (unsigned int threadno, uint32_t seq)
+{
+  if (Simulator::GetContext () != threadno)
+    {
+      m_error = "Wrong context";
+    }
+  if (seq != m_next[threadno])
+    {
+      m_error = "Events out of order";
+    }
+  m_next[threadno] = seq + 1;
+  m_received++;
+}
+
+void
+ThreadedInjectionStressTestCase::Poll (void)
+{
+  m_polls++;
+  if (m_received < uint64_t (m_threads) * m_events)
+    {
+      Simulator::Schedule (MicroSeconds (1), &ThreadedInjectionStressTestCase::Poll, this);
+    }
+}
+
+void
+ThreadedInjectionStressTestCase::DoRun (void)
+{
+  m_received = 0;
+  m_polls = 0;
+  m_error = "";
+  for (unsigned int i = 0; i < m_threads; ++i)
+    {
+      m_next[i] = 0;
+    }
+  Simulator::Schedule (MicroSeconds (1), &ThreadedInjectionStressTestCase::Poll, this);
+
+  std::list<Ptr<SystemThread> > threads;
+  for (unsigned int i = 0; i < m_threads; ++i)
+    {
+      threads.push_back (Create<SystemThread> (MakeBoundCallback (
+          &ThreadedInjectionStressTestCase::InjectingThread,
+          std::pair<ThreadedInjectionStressTestCase *, unsigned int> (this, i))));
+      threads.back ()->Start ();
+    }
+  Simulator::Run ();
+  for (std::list<Ptr<SystemThread> >::iterator it = threads.begin (); it != threads.end (); ++it)
+    {
+      (*it)->Join ();
+    }
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_error.empty (), true, m_error);
+  NS_TEST_EXPECT_MSG_EQ (m_received, uint64_t (m_threads) * m_events, "Lost events");
+  for (unsigned int i = 0; i < m_threads; ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_next[i], m_events, "Lost events of thread " << i);
+    }
+}
+
 class ThreadedSimulatorTestSuite : public TestSuite
 {
 public:
@@ -262,5 +365,7 @@ public:
               }
           }
       }
+    AddTestCase (new ThreadedInjectionStressTestCase (4, 100000), TestCase::QUICK);
+    AddTestCase (new ThreadedInjectionStressTestCase (8, 500000), TestCase::EXTENSIVE);
   }
 } g_threadedSimulatorTestSuite;
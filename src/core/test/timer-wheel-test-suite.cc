@@ -0,0 +1,307 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/timer-wheel.h"
+#include "ns3/timer.h"
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/nstime.h"
+
+#include <vector>
+
+using namespace ns3;
+
+class TimerWheelTestCase : public TestCase
+{
+public:
+  TimerWheelTestCase ();
+  virtual void DoRun (void);
+
+  /** A timer of the test. */
+  struct Item
+  {
+    TimerWheelTestCase *test;
+    uint32_t index;
+    TimerWheel::Entry entry;
+    void Expire (void)
+    {
+      test->Expire (index);
+    }
+  };
+
+  void Expire (uint32_t index);
+  void Disarm (uint32_t index);
+  Ptr<TimerWheel> m_wheel;
+  std::vector<Item> m_items;
+  std::vector<Time> m_expected;
+  uint32_t m_expired;
+  uint32_t m_rearmed;
+};
+
+TimerWheelTestCase::TimerWheelTestCase ()
+  : TestCase ("Check the expiry of the timers on each level of a wheel")
+{
+}
+
+void
+TimerWheelTestCase::Expire (uint32_t index)
+{
+  NS_TEST_EXPECT_MSG_EQ (Simulator::Now (), m_expected[index], "Timer " << index << " expired at the wrong time");
+  m_expired++;
+  if (index % 11 == 0 && m_rearmed < 100)
+    {
+      // Arm again from the expiry, in the same tick as other timers
+      m_rearmed++;
+      m_expected[index] = Simulator::Now () + MicroSeconds (index + 1);
+      m_wheel->Arm (&m_items[index].entry, MicroSeconds (index + 1));
+    }
+}
+
+void
+TimerWheelTestCase::Disarm (uint32_t index)
+{
+  m_wheel->Disarm (&m_items[index].entry);
+}
+
+void
+TimerWheelTestCase::DoRun (void)
+{
+  m_wheel = Create<TimerWheel> (MicroSeconds (1));
+  m_expired = 0;
+  m_rearmed = 0;
+  uint32_t n = 2000;
+  m_items.resize (n);
+  m_expected.resize (n);
+  uint32_t disarmed = 0;
+  uint64_t state = 12345;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      m_items[i].test = this;
+      m_items[i].index = i;
+      m_items[i].entry.SetFunction (MakeCallback (&Item::Expire, &m_items[i]));
+    }
+  for (uint32_t i = 0; i < n; i++)
+    {
+      state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+      // Spread the delays over the levels and the overflow list
+      uint64_t range = 1ULL << (6 * (i % 5) + 6);
+      Time delay = NanoSeconds ((state >> 20) % (range * 1000));
+      m_expected[i] = MicroSeconds ((delay.GetNanoSeconds () + 999) / 1000);
+      if (m_expected[i].IsZero ())
+        {
+          m_expected[i] = MicroSeconds (1);
+        }
+      m_wheel->Arm (&m_items[i].entry, delay);
+      if (i % 7 == 0)
+        {
+          Simulator::Schedule (delay / 2, &TimerWheelTestCase::Disarm, this, i);
+          disarmed++;
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_wheel->GetSize (), n, "Wrong number of armed timers");
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_expired, n - disarmed + m_rearmed, "Wrong number of expired timers");
+  NS_TEST_EXPECT_MSG_EQ (m_wheel->GetSize (), 0, "Timers left on the wheel");
+  Simulator::Destroy ();
+}
+
+class TimerWheelLateArmTestCase : public TestCase
+{
+public:
+  TimerWheelLateArmTestCase ();
+  virtual void DoRun (void);
+  void Expire (uint32_t index);
+  void Arm (uint32_t index, Time delay);
+  Ptr<TimerWheel> m_wheel;
+  TimerWheel::Entry m_entries[3];
+  Time m_expiredTime[3];
+};
+
+TimerWheelLateArmTestCase::TimerWheelLateArmTestCase ()
+  : TestCase ("Check a timer armed long after the last tick of a busy wheel")
+{
+}
+
+void
+TimerWheelLateArmTestCase::Expire (uint32_t index)
+{
+  m_expiredTime[index] = Simulator::Now ();
+}
+
+void
+TimerWheelLateArmTestCase::Arm (uint32_t index, Time delay)
+{
+  m_wheel->Arm (&m_entries[index], delay);
+}
+
+void
+TimerWheelLateArmTestCase::DoRun (void)
+{
+  m_wheel = Create<TimerWheel> (MicroSeconds (1));
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      m_entries[i].SetFunction (MakeCallback (&TimerWheelLateArmTestCase::Expire, this).Bind (i));
+      m_expiredTime[i] = Seconds (-1);
+    }
+  // Scheduled before the event of the wheel for 1 s, so it arms the
+  // third timer at 1 s, before the first one expires
+  Simulator::Schedule (Seconds (1), &TimerWheelLateArmTestCase::Arm, this, 2, MicroSeconds (1));
+  m_wheel->Arm (&m_entries[0], Seconds (1));
+  // The second timer falls in a slot of level 3 which started at 262 ms
+  Simulator::Schedule (MilliSeconds (500), &TimerWheelLateArmTestCase::Arm, this, 1, MicroSeconds (1));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_expiredTime[0], Seconds (1), "First timer expired at the wrong time");
+  NS_TEST_EXPECT_MSG_EQ (m_expiredTime[1], MilliSeconds (500) + MicroSeconds (1), "Second timer expired at the wrong time");
+  NS_TEST_EXPECT_MSG_EQ (m_expiredTime[2], Seconds (1) + MicroSeconds (1), "Third timer expired at the wrong time");
+  NS_TEST_EXPECT_MSG_EQ (m_wheel->GetSize (), 0, "Timers left on the wheel");
+  Simulator::Destroy ();
+}
+
+class TimerOnWheelTestCase : public TestCase
+{
+public:
+  TimerOnWheelTestCase ();
+  virtual void DoRun (void);
+  void Expire (void);
+  void Check (Timer *timer);
+  uint32_t m_expired;
+  Time m_expiredTime;
+};
+
+TimerOnWheelTestCase::TimerOnWheelTestCase ()
+  : TestCase ("Check a Timer set on a wheel")
+{
+}
+
+void
+TimerOnWheelTestCase::Expire (void)
+{
+  m_expired++;
+  m_expiredTime = Simulator::Now ();
+}
+
+void
+TimerOnWheelTestCase::Check (Timer *timer)
+{
+  NS_TEST_EXPECT_MSG_EQ (timer->IsRunning (), true, "Timer not running");
+  NS_TEST_EXPECT_MSG_EQ (timer->GetDelayLeft (), MicroSeconds (2), "Wrong delay left");
+  timer->Suspend ();
+  NS_TEST_EXPECT_MSG_EQ (timer->IsSuspended (), true, "Timer not suspended");
+  NS_TEST_EXPECT_MSG_EQ (timer->GetWheel ()->GetSize (), 0, "Suspended timer left on the wheel");
+  timer->Resume ();
+  NS_TEST_EXPECT_MSG_EQ (timer->GetState (), Timer::RUNNING, "Timer not resumed");
+}
+
+void
+TimerOnWheelTestCase::DoRun (void)
+{
+  m_expired = 0;
+  Ptr<TimerWheel> wheel = Create<TimerWheel> (MicroSeconds (1));
+  Timer timer (Timer::CANCEL_ON_DESTROY);
+  timer.SetFunction (&TimerOnWheelTestCase::Expire, this);
+  timer.SetWheel (wheel);
+  timer.SetDelay (NanoSeconds (2500));
+  timer.Schedule ();
+  NS_TEST_EXPECT_MSG_EQ (timer.GetState (), Timer::RUNNING, "Timer not running");
+  NS_TEST_EXPECT_MSG_EQ (timer.GetDelayLeft (), MicroSeconds (3), "Delay not rounded up to a tick");
+  Simulator::Schedule (MicroSeconds (1), &TimerOnWheelTestCase::Check, this, &timer);
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_expired, 1, "Timer did not expire once");
+  NS_TEST_EXPECT_MSG_EQ (m_expiredTime, MicroSeconds (3), "Timer expired at the wrong time");
+  NS_TEST_EXPECT_MSG_EQ (timer.IsExpired (), true, "Timer not expired");
+
+  timer.Schedule (MicroSeconds (5));
+  timer.Cancel ();
+  NS_TEST_EXPECT_MSG_EQ (timer.IsExpired (), true, "Cancelled timer not expired");
+  timer.Schedule (MicroSeconds (5));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_expired, 2, "Timer did not expire after a cancel");
+  NS_TEST_EXPECT_MSG_EQ (m_expiredTime, MicroSeconds (8), "Timer expired at the wrong time");
+  Simulator::Destroy ();
+}
+
+class TimerCopyTestCase : public TestCase
+{
+public:
+  TimerCopyTestCase ();
+  virtual void DoRun (void);
+  void Expire (uint32_t index);
+  uint32_t m_expired[2];
+  Time m_expiredTime[2];
+};
+
+TimerCopyTestCase::TimerCopyTestCase ()
+  : TestCase ("Check that a copied Timer starts unarmed")
+{
+}
+
+void
+TimerCopyTestCase::Expire (uint32_t index)
+{
+  m_expired[index]++;
+  m_expiredTime[index] = Simulator::Now ();
+}
+
+void
+TimerCopyTestCase::DoRun (void)
+{
+  m_expired[0] = 0;
+  m_expired[1] = 0;
+  Ptr<TimerWheel> wheel = Create<TimerWheel> (MicroSeconds (1));
+  Timer timer (Timer::CANCEL_ON_DESTROY);
+  timer.SetFunction (&TimerCopyTestCase::Expire, this);
+  timer.SetArguments (static_cast<uint32_t> (0));
+  timer.SetWheel (wheel);
+  timer.SetDelay (MicroSeconds (2));
+  timer.Schedule ();
+  Timer copy (timer);
+  NS_TEST_EXPECT_MSG_EQ (copy.IsExpired (), true, "Copy of a running timer not expired");
+  NS_TEST_EXPECT_MSG_EQ (copy.GetWheel (), wheel, "Copy not set on the wheel");
+  NS_TEST_EXPECT_MSG_EQ (wheel->GetSize (), 1, "Copy armed on the wheel");
+  copy.SetArguments (static_cast<uint32_t> (1));
+  copy.Schedule (MicroSeconds (5));
+  NS_TEST_EXPECT_MSG_EQ (wheel->GetSize (), 2, "Copy not armed on the wheel");
+
+  Timer assigned;
+  assigned = copy;
+  NS_TEST_EXPECT_MSG_EQ (assigned.IsExpired (), true, "Assigned timer not expired");
+  NS_TEST_EXPECT_MSG_EQ (assigned.GetDelay (), MicroSeconds (2), "Delay not assigned");
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_expired[0], 1, "Timer did not expire once");
+  NS_TEST_EXPECT_MSG_EQ (m_expiredTime[0], MicroSeconds (2), "Timer expired at the wrong time");
+  NS_TEST_EXPECT_MSG_EQ (m_expired[1], 1, "Copy did not expire once");
+  NS_TEST_EXPECT_MSG_EQ (m_expiredTime[1], MicroSeconds (5), "Copy expired at the wrong time");
+
+  assigned.Schedule ();
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_expired[1], 2, "Assigned timer did not call the copied function");
+  NS_TEST_EXPECT_MSG_EQ (m_expiredTime[1], MicroSeconds (7), "Assigned timer expired at the wrong time");
+  NS_TEST_EXPECT_MSG_EQ (m_expired[0], 1, "Timer expired again");
+  Simulator::Destroy ();
+}
+
+static class TimerWheelTestSuite : public TestSuite
+{
+public:
+  TimerWheelTestSuite ()
+    : TestSuite ("timer-wheel", UNIT)
+  {
+    AddTestCase (new TimerWheelTestCase (), TestCase::QUICK);
+    AddTestCase (new TimerWheelLateArmTestCase (), TestCase::QUICK);
+    AddTestCase (new TimerOnWheelTestCase (), TestCase::QUICK);
+    AddTestCase (new TimerCopyTestCase (), TestCase::QUICK);
+  }
+} g_timerWheelTestSuite;
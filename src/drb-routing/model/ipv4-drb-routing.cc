@@ -35,6 +35,7 @@ Ipv4DrbRouting::Ipv4DrbRouting () :
     m_mode (PER_FLOW)
 {
   NS_LOG_FUNCTION (this);
+  m_rand = CreateObject<UniformRandomVariable> ();
 }
 
 Ipv4DrbRouting::~Ipv4DrbRouting ()
@@ -42,6 +43,14 @@ Ipv4DrbRouting::~Ipv4DrbRouting ()
   NS_LOG_FUNCTION (this);
 }
 
+int64_t
+Ipv4DrbRouting::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  m_rand->SetStream (stream);
+  return 1;
+}
+
 bool
 Ipv4DrbRouting::AddPath (uint32_t path)
 {
@@ -161,7 +170,7 @@ Ipv4DrbRouting::RouteOutput (Ptr<Packet> p, const Ipv4Header &header, Ptr<NetDev
   }
   /* Breathe a fresh air to celebrate the end of ugly code */
 
-  uint32_t index = rand () % paths.size ();
+  uint32_t index = m_rand->GetInteger (0, paths.size () - 1);
   std::map<uint32_t, uint32_t>::iterator itr = m_indexMap.find (flowIndentify);
   if (itr != m_indexMap.end ())
   {
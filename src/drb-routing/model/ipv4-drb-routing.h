@@ -8,6 +8,7 @@
 #include "ns3/packet.h"
 #include "ns3/ipv4-header.h"
 #include "ns3/ipv4-address.h"
+#include "ns3/random-variable-stream.h"
 
 #include <set>
 
@@ -36,6 +37,9 @@ public:
           const std::set<Ipv4Address>& exclusiveIPs = std::set<Ipv4Address> ());
   bool AddWeightedPath (Ipv4Address destAddr, uint32_t weight, uint32_t path);
 
+  // Use fixed streams for the first path of the flows, returns the number of streams assigned
+  int64_t AssignStreams (int64_t stream);
+
   /* Inherit From Ipv4RoutingProtocol */
   virtual Ptr<Ipv4Route> RouteOutput (Ptr<Packet> p, const Ipv4Header &header, Ptr<NetDevice> oif, Socket::SocketErrno &sockerr);
   virtual bool RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr<const NetDevice> idev,
@@ -57,6 +61,9 @@ private:
   enum DrbRoutingMode m_mode;
 
   Ptr<Ipv4> m_ipv4;
+
+  // First path of the flows
+  Ptr<UniformRandomVariable> m_rand;
 };
 
 }
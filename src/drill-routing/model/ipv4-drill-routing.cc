@@ -3,7 +3,7 @@
 #include "ns3/log.h"
 #include "ns3/simulator.h"
 #include "ns3/net-device.h"
-#include "ns3/channel.h"
+#include "ns3/ipv4-egress-route-cache.h"
 #include "ns3/node.h"
 #include "ns3/ipv4-l3-protocol.h"
 #include "ns3/traffic-control-layer.h"
@@ -38,6 +38,7 @@ Ipv4DrillRouting::Ipv4DrillRouting ()
     : m_d (2)
 {
   NS_LOG_FUNCTION (this);
+  m_rand = CreateObject<UniformRandomVariable> ();
 }
 
 Ipv4DrillRouting::~Ipv4DrillRouting ()
@@ -45,6 +46,14 @@ Ipv4DrillRouting::~Ipv4DrillRouting ()
   NS_LOG_FUNCTION (this);
 }
 
+int64_t
+Ipv4DrillRouting::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  m_rand->SetStream (stream);
+  return 1;
+}
+
 void
 Ipv4DrillRouting::AddRoute (Ipv4Address network, Ipv4Mask networkMask, uint32_t port)
 {
@@ -54,6 +63,8 @@ Ipv4DrillRouting::AddRoute (Ipv4Address network, Ipv4Mask networkMask, uint32_t
   drillRouteEntry.networkMask = networkMask;
   drillRouteEntry.port = port;
   m_routeEntryList.push_back (drillRouteEntry);
+  m_portTable.AddRoute (network, networkMask, port);
+  m_destinations.clear ();
 }
 
 std::vector<DrillRouteEntry>
@@ -71,40 +82,69 @@ Ipv4DrillRouting::LookupDrillRouteEntries (Ipv4Address dest)
   return drillRouteEntries;
 }
 
+DrillDestination *
+Ipv4DrillRouting::LookupDestination (Ipv4Address dest)
+{
+  std::map<Ipv4Address, DrillDestination>::iterator itr = m_destinations.find (dest);
+  if (itr != m_destinations.end ())
+  {
+    return &itr->second;
+  }
+
+  DrillDestination &destination = m_destinations[dest];
+  destination.hasPreviousBest = false;
+  destination.previousBest = 0;
+  destination.ports = m_portTable.Lookup (dest);
+  return &destination;
+}
+
 uint32_t
 Ipv4DrillRouting::CalculateQueueLength (uint32_t interface)
 {
-  Ptr<Ipv4L3Protocol> ipv4L3Protocol = DynamicCast<Ipv4L3Protocol> (m_ipv4);
-  if (!ipv4L3Protocol)
+  if (interface >= m_portQueues.size ())
   {
-    NS_LOG_ERROR (this << " Drill routing cannot work other than Ipv4L3Protocol");
-    return 0;
+    DrillPortQueues empty;
+    empty.cached = false;
+    m_portQueues.resize (interface + 1, empty);
   }
 
-  uint32_t totalLength = 0;
+  DrillPortQueues &queues = m_portQueues[interface];
+  if (!queues.cached)
+  {
+    Ptr<Ipv4L3Protocol> ipv4L3Protocol = DynamicCast<Ipv4L3Protocol> (m_ipv4);
+    if (!ipv4L3Protocol)
+    {
+      NS_LOG_ERROR (this << " Drill routing cannot work other than Ipv4L3Protocol");
+      return 0;
+    }
 
-  const Ptr<NetDevice> netDevice = this->m_ipv4->GetNetDevice (interface);
+    const Ptr<NetDevice> netDevice = this->m_ipv4->GetNetDevice (interface);
 
-  if (netDevice->IsPointToPoint ())
-  {
-    Ptr<PointToPointNetDevice> p2pNetDevice = DynamicCast<PointToPointNetDevice> (netDevice);
-    if (p2pNetDevice)
+    if (netDevice->IsPointToPoint ())
     {
-      totalLength += p2pNetDevice->GetQueue ()->GetNBytes ();
+      Ptr<PointToPointNetDevice> p2pNetDevice = DynamicCast<PointToPointNetDevice> (netDevice);
+      if (p2pNetDevice)
+      {
+        queues.deviceQueue = p2pNetDevice->GetQueue ();
+      }
     }
-  }
 
-  Ptr<TrafficControlLayer> tc = ipv4L3Protocol->GetNode ()->GetObject<TrafficControlLayer> ();
+    Ptr<TrafficControlLayer> tc = ipv4L3Protocol->GetNode ()->GetObject<TrafficControlLayer> ();
+    if (tc)
+    {
+      queues.queueDisc = tc->GetRootQueueDiscOnDevice (netDevice);
+    }
+    queues.cached = true;
+  }
 
-  if (!tc)
+  uint32_t totalLength = 0;
+  if (queues.deviceQueue)
   {
-    return totalLength;
+    totalLength += queues.deviceQueue->GetNBytes ();
   }
-
-  Ptr<QueueDisc> queueDisc = tc->GetRootQueueDiscOnDevice (netDevice);
-  if (queueDisc)
+  if (queues.queueDisc)
   {
-    totalLength += queueDisc->GetNBytes ();
+    totalLength += queues.queueDisc->GetNBytes ();
   }
 
   return totalLength;
@@ -113,17 +153,7 @@ Ipv4DrillRouting::CalculateQueueLength (uint32_t interface)
 Ptr<Ipv4Route>
 Ipv4DrillRouting::ConstructIpv4Route (uint32_t port, Ipv4Address destAddress)
 {
-  Ptr<NetDevice> dev = m_ipv4->GetNetDevice (port);
-  Ptr<Channel> channel = dev->GetChannel ();
-  uint32_t otherEnd = (channel->GetDevice (0) == dev) ? 1 : 0;
-  Ptr<Node> nextHop = channel->GetDevice (otherEnd)->GetNode ();
-  uint32_t nextIf = channel->GetDevice (otherEnd)->GetIfIndex ();
-  Ipv4Address nextHopAddr = nextHop->GetObject<Ipv4>()->GetAddress(nextIf,0).GetLocal();
-  Ptr<Ipv4Route> route = Create<Ipv4Route> ();
-  route->SetOutputDevice (m_ipv4->GetNetDevice (port));
-  route->SetGateway (nextHopAddr);
-  route->SetSource (m_ipv4->GetAddress (port, 0).GetLocal ());
-  route->SetDestination (destAddress);
+  Ptr<Ipv4Route> route = m_routeCache->GetRoute (port);
   return route;
 }
 
@@ -164,7 +194,8 @@ Ipv4DrillRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr
     return false;
   }
 
-  std::vector<DrillRouteEntry> allPorts = Ipv4DrillRouting::LookupDrillRouteEntries (destAddress);
+  DrillDestination *destination = Ipv4DrillRouting::LookupDestination (destAddress);
+  std::vector<uint32_t> &allPorts = destination->ports;
 
   if (allPorts.empty ())
   {
@@ -173,59 +204,99 @@ Ipv4DrillRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr
     return false;
   }
 
-  uint32_t leastLoadInterface = 0;
-  uint32_t leastLoad = std::numeric_limits<uint32_t>::max ();
-
-  std::random_shuffle (allPorts.begin (), allPorts.end ());
-
-  std::map<Ipv4Address, uint32_t>::iterator itr = m_previousBestQueueMap.find (destAddress);
+  uint32_t sampleNum = m_d < allPorts.size () ? m_d : allPorts.size ();
+  m_samplePorts.resize (sampleNum + 1);
+  m_sampleLoads.resize (sampleNum + 1);
+  uint32_t nSamples = 0;
 
-  if (itr != m_previousBestQueueMap.end ())
+  // The previous best port is sampled first, so it wins the ties
+  if (destination->hasPreviousBest)
   {
-    leastLoadInterface = itr->second;
-    leastLoad = CalculateQueueLength (itr->second);
+    m_samplePorts[nSamples] = destination->previousBest;
+    m_sampleLoads[nSamples] = CalculateQueueLength (destination->previousBest);
+    nSamples++;
   }
 
-  uint32_t sampleNum = m_d < allPorts.size () ? m_d : allPorts.size ();
-
+  // Sample d distinct ports: a partial Fisher-Yates shuffle of the ports in place
   for (uint32_t samplePort = 0; samplePort < sampleNum; samplePort ++)
   {
-    uint32_t sampleLoad = Ipv4DrillRouting::CalculateQueueLength (allPorts[samplePort].port);
-    if (sampleLoad < leastLoad)
-    {
-      leastLoad = sampleLoad;
-      leastLoadInterface = allPorts[samplePort].port;
-    }
+    std::swap (allPorts[samplePort], allPorts[m_rand->GetInteger (samplePort, allPorts.size () - 1)]);
+    m_samplePorts[nSamples] = allPorts[samplePort];
+    m_sampleLoads[nSamples] = Ipv4DrillRouting::CalculateQueueLength (allPorts[samplePort]);
+    nSamples++;
+  }
+
+  // Minimum over the contiguous loads, a loop the compiler can vectorize,
+  // then its first position
+  const uint32_t *loads = &m_sampleLoads[0];
+  uint32_t leastLoad = std::numeric_limits<uint32_t>::max ();
+  for (uint32_t i = 0; i < nSamples; i++)
+  {
+    leastLoad = std::min (leastLoad, loads[i]);
+  }
+  uint32_t leastLoadIndex = 0;
+  while (loads[leastLoadIndex] != leastLoad)
+  {
+    leastLoadIndex++;
   }
+  uint32_t leastLoadInterface = m_samplePorts[leastLoadIndex];
 
   NS_LOG_INFO (this << " Drill routing chooses interface: " << leastLoadInterface << ", since its load is: " << leastLoad);
 
-  m_previousBestQueueMap[destAddress] = leastLoadInterface;
+  destination->hasPreviousBest = true;
+  destination->previousBest = leastLoadInterface;
 
   Ptr<Ipv4Route> route = Ipv4DrillRouting::ConstructIpv4Route (leastLoadInterface, destAddress);
+  if (route == 0)
+  {
+    NS_LOG_LOGIC (this << " No usable next hop on port: " << leastLoadInterface);
+    ecb (packet, header, Socket::ERROR_NOROUTETOHOST);
+    return false;
+  }
   ucb (route, packet, header);
 
   return true;
 }
 
+void
+Ipv4DrillRouting::InvalidatePortQueues (uint32_t interface)
+{
+  // The queues are looked up again on the next sample, in case the
+  // device or its root queue disc was replaced meanwhile
+  if (interface < m_portQueues.size ())
+  {
+    m_portQueues[interface].cached = false;
+    m_portQueues[interface].deviceQueue = 0;
+    m_portQueues[interface].queueDisc = 0;
+  }
+}
+
 void
 Ipv4DrillRouting::NotifyInterfaceUp (uint32_t interface)
 {
+  m_routeCache->Refresh (interface);
+  InvalidatePortQueues (interface);
 }
 
 void
 Ipv4DrillRouting::NotifyInterfaceDown (uint32_t interface)
 {
+  m_routeCache->Invalidate (interface);
+  InvalidatePortQueues (interface);
 }
 
 void
 Ipv4DrillRouting::NotifyAddAddress (uint32_t interface, Ipv4InterfaceAddress address)
 {
+  m_routeCache->Refresh (interface);
+  InvalidatePortQueues (interface);
 }
 
 void
 Ipv4DrillRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress address)
 {
+  m_routeCache->Invalidate (interface);
+  InvalidatePortQueues (interface);
 }
 
 void
@@ -234,6 +305,7 @@ Ipv4DrillRouting::SetIpv4 (Ptr<Ipv4> ipv4)
   NS_LOG_LOGIC (this << "Setting up Ipv4: " << ipv4);
   NS_ASSERT (m_ipv4 == 0 && ipv4 != 0);
   m_ipv4 = ipv4;
+  m_routeCache = Ipv4EgressRouteCache::GetCache (ipv4);
 }
 
 void
@@ -244,6 +316,12 @@ Ipv4DrillRouting::PrintRoutingTable (Ptr<OutputStreamWrapper> stream) const
 void
 Ipv4DrillRouting::DoDispose (void)
 {
+  m_portQueues.clear ();
+  m_destinations.clear ();
+  m_ipv4 = 0;
+  m_routeCache = 0;
+  m_rand = 0;
+  Ipv4RoutingProtocol::DoDispose ();
 }
 }
 
@@ -3,11 +3,16 @@
 #define IPV4_DRILL_ROUTING_H
 
 #include "ns3/ipv4-routing-protocol.h"
+#include "ns3/ipv4-egress-route-cache.h"
+#include "ns3/ipv4-egress-port-table.h"
 #include "ns3/ipv4-route.h"
 #include "ns3/object.h"
 #include "ns3/packet.h"
 #include "ns3/ipv4-header.h"
 #include "ns3/ipv4-address.h"
+#include "ns3/queue.h"
+#include "ns3/queue-disc.h"
+#include "ns3/random-variable-stream.h"
 
 #include <vector>
 #include <map>
@@ -20,6 +25,20 @@ struct DrillRouteEntry {
   uint32_t port;
 };
 
+// Ports towards a destination, sampled in place
+struct DrillDestination {
+  std::vector<uint32_t> ports;
+  bool hasPreviousBest;
+  uint32_t previousBest;
+};
+
+// Queues of an output port, looked up on first use
+struct DrillPortQueues {
+  bool cached;
+  Ptr<Queue> deviceQueue;
+  Ptr<QueueDisc> queueDisc;
+};
+
 
 class Ipv4DrillRouting : public Ipv4RoutingProtocol {
 
@@ -35,6 +54,16 @@ public:
   uint32_t CalculateQueueLength (uint32_t interface);
   Ptr<Ipv4Route> ConstructIpv4Route (uint32_t port, Ipv4Address destAddress);
 
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by this model.  Return the number of streams (possibly zero) that
+   * have been assigned.
+   *
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned by this model
+   */
+  int64_t AssignStreams (int64_t stream);
+
 
   /* Inherit From Ipv4RoutingProtocol */
   virtual Ptr<Ipv4Route> RouteOutput (Ptr<Packet> p, const Ipv4Header &header, Ptr<NetDevice> oif, Socket::SocketErrno &sockerr);
@@ -51,11 +80,32 @@ public:
   virtual void DoDispose (void);
 
 private:
+  DrillDestination *LookupDestination (Ipv4Address dest);
+
+  // Drop the queues cached for a port
+  void InvalidatePortQueues (uint32_t interface);
+
   uint32_t m_d;
-  std::map<Ipv4Address, uint32_t> m_previousBestQueueMap;
+
+  // Per destination ports and previous best port, cleared when a route is added
+  std::map<Ipv4Address, DrillDestination> m_destinations;
+
+  // Queues of each port, indexed by interface
+  std::vector<DrillPortQueues> m_portQueues;
+
+  // Sampled ports and their loads, reused for every packet
+  std::vector<uint32_t> m_samplePorts;
+  std::vector<uint32_t> m_sampleLoads;
+
+  // Draws the sampled ports
+  Ptr<UniformRandomVariable> m_rand;
 
   Ptr<Ipv4> m_ipv4;
+  Ptr<Ipv4EgressRouteCache> m_routeCache;
   std::vector<DrillRouteEntry> m_routeEntryList;
+
+  // Ports reaching each destination, compiled from the route table
+  Ipv4EgressPortTable m_portTable;
 };
 
 }
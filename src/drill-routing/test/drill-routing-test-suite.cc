@@ -2,10 +2,30 @@
 
 // Include a header file from your module to test.
 #include "ns3/ipv4-drill-routing.h"
+#include "ns3/ipv4-drill-routing-helper.h"
 
 // An essential include is test.h
 #include "ns3/test.h"
 
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-queue-disc-item.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/traffic-control-helper.h"
+#include "ns3/traffic-control-layer.h"
+#include "ns3/node-container.h"
+#include "ns3/simulator.h"
+#include "ns3/simulator-impl.h"
+#include "ns3/core-config.h"
+#include "ns3/node-list.h"
+#include "ns3/ipv4-static-routing-helper.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+
+#include <sstream>
+
 // Do not put your test classes in namespace ns3.  You may find it useful
 // to use the using directive to access the ns3 namespace directly
 using namespace ns3;
@@ -46,6 +66,264 @@ DrillRoutingTestCase1::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ_TOL (0.01, 0.01, 0.001, "Numbers are not equal within tolerance");
 }
 
+/**
+ * \brief Check that the sampled queue length of a port follows the
+ * replacement of its root queue disc while the port is down or has no
+ * address.
+ */
+class DrillRoutingQueueDiscTestCase : public TestCase
+{
+public:
+  DrillRoutingQueueDiscTestCase ();
+  virtual ~DrillRoutingQueueDiscTestCase ();
+
+private:
+  /**
+   * \brief Replace the root queue disc of a device.
+   * \param device the device
+   * \param packets the number of packets to enqueue in the new queue disc
+   * \return the new queue disc
+   */
+  Ptr<QueueDisc> ReplaceQueueDisc (Ptr<NetDevice> device, uint32_t packets);
+  virtual void DoRun (void);
+};
+
+DrillRoutingQueueDiscTestCase::DrillRoutingQueueDiscTestCase ()
+  : TestCase ("DrillRouting queue length after a queue disc replacement")
+{
+}
+
+DrillRoutingQueueDiscTestCase::~DrillRoutingQueueDiscTestCase ()
+{
+}
+
+Ptr<QueueDisc>
+DrillRoutingQueueDiscTestCase::ReplaceQueueDisc (Ptr<NetDevice> device, uint32_t packets)
+{
+  Ptr<TrafficControlLayer> tc = device->GetNode ()->GetObject<TrafficControlLayer> ();
+  tc->DeleteRootQueueDiscOnDevice (device);
+  TrafficControlHelper tch = TrafficControlHelper::Default ();
+  Ptr<QueueDisc> qd = tch.Install (device).Get (0);
+  qd->Initialize ();
+  for (uint32_t i = 0; i < packets; i++)
+    {
+      qd->Enqueue (Create<Ipv4QueueDiscItem> (Create<Packet> (1000), device->GetBroadcast (), 0x0800, Ipv4Header ()));
+    }
+  return qd;
+}
+
+void
+DrillRoutingQueueDiscTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (2);
+  PointToPointHelper p2p;
+  NetDeviceContainer devices = p2p.Install (nodes);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  Ipv4AddressHelper address;
+  address.SetBase ("10.1.1.0", "255.255.255.0");
+  address.Assign (devices);
+
+  Ptr<Ipv4> ipv4 = nodes.Get (0)->GetObject<Ipv4> ();
+  Ptr<Ipv4DrillRouting> drill = CreateObject<Ipv4DrillRouting> ();
+  ipv4->SetRoutingProtocol (drill);
+
+  Ptr<QueueDisc> qd = ReplaceQueueDisc (devices.Get (0), 1);
+  NS_TEST_ASSERT_MSG_GT (qd->GetNBytes (), 0, "Nothing enqueued");
+  NS_TEST_EXPECT_MSG_EQ (drill->CalculateQueueLength (1), qd->GetNBytes (), "Wrong queue length");
+
+  // Replaced while the interface is down
+  ipv4->SetDown (1);
+  qd = ReplaceQueueDisc (devices.Get (0), 2);
+  NS_TEST_EXPECT_MSG_EQ (drill->CalculateQueueLength (1), qd->GetNBytes (), "Queue length of the old queue disc after a down");
+  ipv4->SetUp (1);
+  NS_TEST_EXPECT_MSG_EQ (drill->CalculateQueueLength (1), qd->GetNBytes (), "Wrong queue length after an up");
+
+  // Replaced while the interface has no address
+  ipv4->RemoveAddress (1, 0);
+  qd = ReplaceQueueDisc (devices.Get (0), 3);
+  NS_TEST_EXPECT_MSG_EQ (drill->CalculateQueueLength (1), qd->GetNBytes (), "Queue length of the old queue disc after an address removal");
+
+  Simulator::Destroy ();
+}
+
+#ifdef ENABLE_MULTITHREADED_SIMULATOR
+/**
+ * \ingroup drill-routing
+ * \ingroup tests
+ *
+ * \brief DRILL gives the same results on MultithreadedSimulatorImpl as on
+ * DefaultSimulatorImpl.
+ *
+ * Two leaves and two spines run DRILL, each host sends UDP to a host of
+ * the other leaf at more than the rate of the uplinks, so the sampled
+ * ports, the queues and the drops depend on the random draws of every
+ * switch.  The arrivals at each host must be the same on both simulators.
+ */
+class DrillRoutingSimulatorTestCase : public TestCase
+{
+public:
+  DrillRoutingSimulatorTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \brief Run the topology.
+   * \param impl the simulator implementation
+   * \return the digest of the packets received by each node
+   */
+  std::vector<uint64_t> RunTopology (std::string impl);
+  /**
+   * \brief Send a packet, then schedule the next one.
+   * \param socket the socket
+   * \param left the number of packets left to send
+   */
+  void Send (Ptr<Socket> socket, uint32_t left);
+  /**
+   * \brief Fold the received packets into the digest of their node.
+   * \param socket the socket
+   */
+  void Receive (Ptr<Socket> socket);
+
+  std::vector<uint64_t> m_digests; //!< Digest of the packets received by each node
+};
+
+DrillRoutingSimulatorTestCase::DrillRoutingSimulatorTestCase ()
+  : TestCase ("DrillRouting on the multithreaded and default simulators")
+{
+}
+
+void
+DrillRoutingSimulatorTestCase::Send (Ptr<Socket> socket, uint32_t left)
+{
+  socket->Send (Create<Packet> (1000));
+  if (left > 1)
+    {
+      Simulator::Schedule (MicroSeconds (3), &DrillRoutingSimulatorTestCase::Send, this, socket, left - 1);
+    }
+}
+
+void
+DrillRoutingSimulatorTestCase::Receive (Ptr<Socket> socket)
+{
+  // Only touched by the thread of the node
+  uint64_t &digest = m_digests[socket->GetNode ()->GetId ()];
+  Ptr<Packet> packet;
+  while ((packet = socket->Recv ()))
+    {
+      digest = digest * 1000003 + Simulator::Now ().GetNanoSeconds () + packet->GetSize ();
+    }
+}
+
+std::vector<uint64_t>
+DrillRoutingSimulatorTestCase::RunTopology (std::string impl)
+{
+  ObjectFactory factory;
+  factory.SetTypeId (impl);
+  if (impl == "ns3::MultithreadedSimulatorImpl")
+    {
+      factory.Set ("ThreadCount", UintegerValue (2));
+    }
+  Simulator::SetImplementation (factory.Create<SimulatorImpl> ());
+
+  const uint32_t nLeaves = 2;
+  const uint32_t nSpines = 2;
+  const uint32_t nHosts = 2;
+  NodeContainer spines, leaves, hosts;
+  spines.Create (nSpines);
+  leaves.Create (nLeaves);
+  hosts.Create (nLeaves * nHosts);
+  InternetStackHelper internet;
+  internet.Install (hosts);
+  Ipv4DrillRoutingHelper drill;
+  internet.SetRoutingHelper (drill);
+  internet.Install (spines);
+  internet.Install (leaves);
+
+  PointToPointHelper p2p;
+  p2p.SetChannelAttribute ("Delay", StringValue ("10us"));
+  p2p.SetDeviceAttribute ("DataRate", StringValue ("10Gbps"));
+  Ipv4AddressHelper address;
+  Ipv4StaticRoutingHelper staticRouting;
+  std::vector<Ipv4Address> hostAddresses;
+  for (uint32_t l = 0; l < nLeaves; l++)
+    {
+      Ptr<Ipv4DrillRouting> routing = drill.GetDrillRouting (leaves.Get (l)->GetObject<Ipv4> ());
+      for (uint32_t h = 0; h < nHosts; h++)
+        {
+          Ptr<Node> host = hosts.Get (l * nHosts + h);
+          std::ostringstream network;
+          network << "10." << l << "." << h << ".0";
+          address.SetBase (network.str ().c_str (), "255.255.255.0");
+          Ipv4InterfaceContainer interfaces = address.Assign (p2p.Install (leaves.Get (l), host));
+          hostAddresses.push_back (interfaces.GetAddress (1));
+          routing->AddRoute (interfaces.GetAddress (1), Ipv4Mask ("255.255.255.255"), interfaces.Get (0).second);
+          staticRouting.GetStaticRouting (host->GetObject<Ipv4> ())->SetDefaultRoute (interfaces.GetAddress (0), 1);
+        }
+    }
+  p2p.SetDeviceAttribute ("DataRate", StringValue ("1Gbps"));
+  for (uint32_t l = 0; l < nLeaves; l++)
+    {
+      for (uint32_t s = 0; s < nSpines; s++)
+        {
+          std::ostringstream network;
+          network << "10." << 100 + l << "." << s << ".0";
+          address.SetBase (network.str ().c_str (), "255.255.255.0");
+          Ipv4InterfaceContainer interfaces = address.Assign (p2p.Install (leaves.Get (l), spines.Get (s)));
+          // The hosts of leaf l are in 10.l.0.0/16
+          Ipv4Address down (Ipv4Address ("10.0.0.0").Get () + (l << 16));
+          Ipv4Address up (Ipv4Address ("10.0.0.0").Get () + ((1 - l) << 16));
+          drill.GetDrillRouting (spines.Get (s)->GetObject<Ipv4> ())->AddRoute (down, Ipv4Mask ("255.255.0.0"), interfaces.Get (1).second);
+          drill.GetDrillRouting (leaves.Get (l)->GetObject<Ipv4> ())->AddRoute (up, Ipv4Mask ("255.255.0.0"), interfaces.Get (0).second);
+        }
+    }
+
+  // The stream counter goes on from the previous run
+  int64_t stream = 0;
+  for (uint32_t i = 0; i < nSpines; i++)
+    {
+      stream += drill.GetDrillRouting (spines.Get (i)->GetObject<Ipv4> ())->AssignStreams (stream);
+    }
+  for (uint32_t i = 0; i < nLeaves; i++)
+    {
+      stream += drill.GetDrillRouting (leaves.Get (i)->GetObject<Ipv4> ())->AssignStreams (stream);
+    }
+
+  m_digests.assign (NodeList::GetNNodes (), 0);
+  for (uint32_t i = 0; i < hosts.GetN (); i++)
+    {
+      Ptr<Socket> sink = Socket::CreateSocket (hosts.Get (i), UdpSocketFactory::GetTypeId ());
+      sink->Bind (InetSocketAddress (Ipv4Address::GetAny (), 9));
+      sink->SetRecvCallback (MakeCallback (&DrillRoutingSimulatorTestCase::Receive, this));
+
+      uint32_t peer = (i + nHosts) % hosts.GetN ();
+      Ptr<Socket> source = Socket::CreateSocket (hosts.Get (i), UdpSocketFactory::GetTypeId ());
+      source->Bind ();
+      source->Connect (InetSocketAddress (hostAddresses[peer], 9));
+      Simulator::ScheduleWithContext (hosts.Get (i)->GetId (), NanoSeconds (100 * i),
+                                      &DrillRoutingSimulatorTestCase::Send, this, source, 500);
+    }
+  Simulator::Stop (MilliSeconds (10));
+  Simulator::Run ();
+  Simulator::Destroy ();
+  return m_digests;
+}
+
+void
+DrillRoutingSimulatorTestCase::DoRun (void)
+{
+  std::vector<uint64_t> sequential = RunTopology ("ns3::DefaultSimulatorImpl");
+  std::vector<uint64_t> multithreaded = RunTopology ("ns3::MultithreadedSimulatorImpl");
+  NS_TEST_ASSERT_MSG_EQ (multithreaded.size (), sequential.size (), "Not the same nodes");
+  for (uint32_t i = 0; i < sequential.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (multithreaded[i], sequential[i], "Node " << i << " received other packets");
+    }
+  NS_TEST_EXPECT_MSG_NE (sequential.back (), 0, "The last host received nothing");
+}
+#endif /* ENABLE_MULTITHREADED_SIMULATOR */
+
 // The TestSuite class names the TestSuite, identifies what type of TestSuite,
 // and enables the TestCases to be run.  Typically, only the constructor for
 // this class must be defined
@@ -61,6 +339,10 @@ DrillRoutingTestSuite::DrillRoutingTestSuite ()
 {
   // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
   AddTestCase (new DrillRoutingTestCase1, TestCase::QUICK);
+  AddTestCase (new DrillRoutingQueueDiscTestCase, TestCase::QUICK);
+#ifdef ENABLE_MULTITHREADED_SIMULATOR
+  AddTestCase (new DrillRoutingSimulatorTestCase, TestCase::QUICK);
+#endif
 }
 
 // Do not forget to allocate an instance of this TestSuite
@@ -20,6 +20,7 @@
 
 #include "flow-monitor.h"
 #include "ns3/simulator.h"
+#include "ns3/simulator-impl.h"
 #include "ns3/log.h"
 #include "ns3/double.h"
 #include <fstream>
@@ -390,6 +391,10 @@ FlowMonitor::StartRightNow ()
     {
       return;
     }
+  if (Simulator::GetImplementation ()->GetInstanceTypeId ().GetName () == "ns3::MultithreadedSimulatorImpl")
+    {
+      NS_FATAL_ERROR ("The flow monitor shares its tables between the nodes, it cannot run on MultithreadedSimulatorImpl");
+    }
   m_enabled = true;
 }
 
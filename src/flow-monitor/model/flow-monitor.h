@@ -161,6 +161,10 @@ public:
   /// \param time delta time to stop
   void Stop (const Time &time);
   /// Begin monitoring flows *right now*
+  ///
+  /// The probes of every node update the tables of the monitor, so it
+  /// cannot run on the threads of ns3::MultithreadedSimulatorImpl: this
+  /// is a fatal error with that simulator.
   void StartRightNow ();
   /// End monitoring flows *right now*
   void StopRightNow ();
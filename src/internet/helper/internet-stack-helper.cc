@@ -239,8 +239,9 @@ InternetStackHelper::InternetStackHelper ()
     m_ipv6Enabled (true),
     m_ipv4ArpJitterEnabled (true),
     m_ipv6NsRsJitterEnabled (true),
-    m_drb (false)
-
+    m_drb (false),
+    m_TLBEnabled (false),
+    m_cloveEnabled (false)
 {
   Initialize ();
 }
@@ -277,6 +278,9 @@ InternetStackHelper::InternetStackHelper (const InternetStackHelper &o)
   m_tcpFactory = o.m_tcpFactory;
   m_ipv4ArpJitterEnabled = o.m_ipv4ArpJitterEnabled;
   m_ipv6NsRsJitterEnabled = o.m_ipv6NsRsJitterEnabled;
+  m_drb = o.m_drb;
+  m_TLBEnabled = o.m_TLBEnabled;
+  m_cloveEnabled = o.m_cloveEnabled;
 }
 
 InternetStackHelper &
@@ -21,6 +21,7 @@ Ipv4Drb::GetTypeId (void)
 Ipv4Drb::Ipv4Drb ()
 {
   NS_LOG_FUNCTION (this);
+  m_rand = CreateObject<UniformRandomVariable> ();
 }
 
 Ipv4Drb::~Ipv4Drb ()
@@ -28,6 +29,14 @@ Ipv4Drb::~Ipv4Drb ()
   NS_LOG_FUNCTION (this);
 }
 
+int64_t
+Ipv4Drb::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  m_rand->SetStream (stream);
+  return 1;
+}
+
 Ipv4Address
 Ipv4Drb::GetCoreSwitchAddress (uint32_t flowId)
 {
@@ -40,7 +49,7 @@ Ipv4Drb::GetCoreSwitchAddress (uint32_t flowId)
     return Ipv4Address ();
   }
 
-  uint32_t index = rand () % listSize;
+  uint32_t index = m_rand->GetInteger (0, listSize - 1);
 
   std::map<uint32_t, uint32_t>::iterator itr = m_indexMap.find (flowId);
 
@@ -5,6 +5,7 @@
 #include <vector>
 #include "ns3/object.h"
 #include "ns3/ipv4-address.h"
+#include "ns3/random-variable-stream.h"
 
 namespace ns3 {
 
@@ -22,9 +23,13 @@ public:
   void AddCoreSwitchAddress (Ipv4Address address);
   void AddCoreSwitchAddress (uint32_t k, Ipv4Address address);
 
+  // Use fixed streams for the first core switch of the flows, returns the number of streams assigned
+  int64_t AssignStreams (int64_t stream);
+
 private:
   std::vector<Ipv4Address> m_coreSwitchAddressList;
   std::map<uint32_t, uint32_t> m_indexMap;
+  Ptr<UniformRandomVariable> m_rand;
 };
 
 }
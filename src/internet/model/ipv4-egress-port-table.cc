@@ -0,0 +1,195 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ipv4-egress-port-table.h"
+
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("Ipv4EgressPortTable");
+
+const uint32_t Ipv4EgressPortTable::LINEAR_CACHE_SIZE;
+
+Ipv4EgressPortTable::Ipv4EgressPortTable ()
+  : m_valid (false),
+    m_linear (false)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+Ipv4EgressPortTable::AddRoute (Ipv4Address network, Ipv4Mask networkMask, uint32_t port)
+{
+  NS_LOG_FUNCTION (this << network << networkMask << port);
+  Route route;
+  route.network = network;
+  route.networkMask = networkMask;
+  route.port = port;
+  m_routes.push_back (route);
+  m_valid = false;
+}
+
+void
+Ipv4EgressPortTable::Build (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_trie.clear ();
+  m_groups.clear ();
+  m_linearGroups.clear ();
+  m_linearCache.clear ();
+  m_valid = true;
+
+  m_linear = false;
+  for (std::vector<Route>::const_iterator it = m_routes.begin (); it != m_routes.end (); ++it)
+    {
+      uint32_t inverse = ~it->networkMask.Get ();
+      if ((inverse & (inverse + 1)) != 0)
+        {
+          NS_LOG_LOGIC (this << " Non contiguous mask " << it->networkMask << ", routes are scanned");
+          m_linear = true;
+          return;
+        }
+    }
+
+  // Insert the prefixes; a node is always created after its parent
+  TrieNode root;
+  root.child[0] = root.child[1] = -1;
+  root.group = -1;
+  m_trie.push_back (root);
+  std::vector<int32_t> parent (1, -1);
+  std::vector<std::vector<uint32_t> > nodeRoutes (1);
+  for (uint32_t i = 0; i < m_routes.size (); i++)
+    {
+      uint32_t prefix = m_routes[i].network.Get () & m_routes[i].networkMask.Get ();
+      uint16_t length = m_routes[i].networkMask.GetPrefixLength ();
+      int32_t node = 0;
+      for (uint16_t b = 0; b < length; b++)
+        {
+          uint32_t bit = (prefix >> (31 - b)) & 1;
+          if (m_trie[node].child[bit] < 0)
+            {
+              m_trie[node].child[bit] = m_trie.size ();
+              m_trie.push_back (root);
+              parent.push_back (node);
+              nodeRoutes.push_back (std::vector<uint32_t> ());
+            }
+          node = m_trie[node].child[bit];
+        }
+      nodeRoutes[node].push_back (i);
+    }
+
+  // Each node gets the routes of its path, in insertion order
+  std::vector<std::vector<uint32_t> > groupRoutes;
+  for (uint32_t node = 0; node < m_trie.size (); node++)
+    {
+      int32_t inherited = node == 0 ? -1 : m_trie[parent[node]].group;
+      if (nodeRoutes[node].empty ())
+        {
+          m_trie[node].group = inherited;
+          continue;
+        }
+      std::vector<uint32_t> routes = nodeRoutes[node];
+      if (inherited >= 0)
+        {
+          routes.insert (routes.end (), groupRoutes[inherited].begin (), groupRoutes[inherited].end ());
+          std::sort (routes.begin (), routes.end ());
+        }
+      PortList ports;
+      for (std::vector<uint32_t>::const_iterator it = routes.begin (); it != routes.end (); ++it)
+        {
+          ports.push_back (m_routes[*it].port);
+        }
+      m_trie[node].group = m_groups.size ();
+      m_groups.push_back (ports);
+      groupRoutes.push_back (routes);
+    }
+  NS_LOG_LOGIC (this << " " << m_routes.size () << " routes compiled into " << m_trie.size ()
+                     << " trie nodes and " << m_groups.size () << " port lists");
+}
+
+const Ipv4EgressPortTable::PortList &
+Ipv4EgressPortTable::Lookup (Ipv4Address dest)
+{
+  if (!m_valid)
+    {
+      Build ();
+    }
+
+  if (m_linear)
+    {
+      std::map<Ipv4Address, const PortList *>::const_iterator cached = m_linearCache.find (dest);
+      if (cached != m_linearCache.end ())
+        {
+          return *cached->second;
+        }
+      PortList ports;
+      for (std::vector<Route>::const_iterator it = m_routes.begin (); it != m_routes.end (); ++it)
+        {
+          if (it->networkMask.IsMatch (dest, it->network))
+            {
+              ports.push_back (it->port);
+            }
+        }
+      // The lists outlive the cache entries, so that flushing the cache
+      // does not invalidate the lists returned before
+      const PortList &group = *m_linearGroups.insert (ports).first;
+      if (m_linearCache.size () >= LINEAR_CACHE_SIZE)
+        {
+          NS_LOG_LOGIC (this << " Flushing the " << m_linearCache.size () << " memoized destinations");
+          m_linearCache.clear ();
+        }
+      m_linearCache[dest] = &group;
+      return group;
+    }
+
+  int32_t group = LookupIndex (dest);
+  return group >= 0 ? m_groups[group] : m_empty;
+}
+
+bool
+Ipv4EgressPortTable::Compile (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_valid)
+    {
+      Build ();
+    }
+  return !m_linear;
+}
+
+uint32_t
+Ipv4EgressPortTable::GetNPortLists (void) const
+{
+  return m_groups.size ();
+}
+
+const Ipv4EgressPortTable::PortList &
+Ipv4EgressPortTable::GetPortList (uint32_t i) const
+{
+  NS_ASSERT (i < m_groups.size ());
+  return m_groups[i];
+}
+
+int32_t
+Ipv4EgressPortTable::LookupIndex (Ipv4Address dest) const
+{
+  NS_ASSERT_MSG (m_valid && !m_linear, "The table is not compiled into a trie");
+  uint32_t addr = dest.Get ();
+  int32_t node = 0;
+  int32_t group = m_trie[0].group;
+  for (uint32_t b = 0; b < 32; b++)
+    {
+      node = m_trie[node].child[(addr >> (31 - b)) & 1];
+      if (node < 0)
+        {
+          break;
+        }
+      group = m_trie[node].group;
+    }
+  return group;
+}
+
+} // namespace ns3
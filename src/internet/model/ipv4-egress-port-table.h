@@ -0,0 +1,132 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef IPV4_EGRESS_PORT_TABLE_H
+#define IPV4_EGRESS_PORT_TABLE_H
+
+#include "ns3/ipv4-address.h"
+
+#include <map>
+#include <set>
+#include <vector>
+
+class Ipv4EgressPortTableMaskTestCase;
+
+namespace ns3 {
+
+/**
+ * \ingroup ipv4
+ *
+ * \brief Egress ports reaching each destination, for the load balancers
+ * that spread packets over every matching route (DRILL, LetFlow, CONGA).
+ *
+ * Routes are (network, mask, port) triples.  A destination is reached
+ * through the ports of all the routes matching it, whatever their prefix
+ * length, in the order the routes were added.
+ *
+ * The table is compiled on the first lookup after a route is added.  The
+ * prefixes are stored in a binary trie whose nodes point to the
+ * precomputed port list of the routes on their path, so a lookup walks at
+ * most 32 nodes and returns a list shared by all the destinations of the
+ * same prefixes.  Tables with a non contiguous mask are resolved by a scan
+ * of the routes.  Each distinct port list of a scan is stored once, and the
+ * list of the last destinations looked up is memoized in a cache of at most
+ * LINEAR_CACHE_SIZE entries, flushed when it is full.
+ *
+ * The ports are opaque to the table.  Ipv4GlobalRouting stores the index
+ * of its network routes in them, and maps each port list to an ECMP group
+ * through the indexed accessors below.
+ */
+class Ipv4EgressPortTable
+{
+public:
+  /// Egress ports of a destination
+  typedef std::vector<uint32_t> PortList;
+
+  Ipv4EgressPortTable ();
+
+  /**
+   * \brief Add a route.
+   * \param network the destination network
+   * \param networkMask the mask of the network
+   * \param port the output interface
+   */
+  void AddRoute (Ipv4Address network, Ipv4Mask networkMask, uint32_t port);
+
+  /**
+   * \brief Get the ports reaching a destination.
+   *
+   * The list is valid until the next call to AddRoute.
+   *
+   * \param dest the destination address
+   * \return the ports of the routes matching dest, empty if none
+   */
+  const PortList &Lookup (Ipv4Address dest);
+
+  /**
+   * \brief Compile the routes now rather than on the first lookup.
+   * \return false if a mask is not contiguous, in which case the table has
+   * no indexed port lists and only Lookup can be used
+   */
+  bool Compile (void);
+
+  /**
+   * \brief Get the number of port lists of the compiled table.
+   * \return the number of port lists
+   */
+  uint32_t GetNPortLists (void) const;
+
+  /**
+   * \brief Get a port list of the compiled table.
+   * \param i the index of the port list, less than GetNPortLists
+   * \return the port list
+   */
+  const PortList &GetPortList (uint32_t i) const;
+
+  /**
+   * \brief Get the index of the port list reaching a destination.
+   *
+   * The table must have been compiled, with contiguous masks only.
+   *
+   * \param dest the destination address
+   * \return the index of the port list of dest, or -1 if no route matches
+   */
+  int32_t LookupIndex (Ipv4Address dest) const;
+
+private:
+  friend class ::Ipv4EgressPortTableMaskTestCase;
+
+  /// Most destinations memoized by the linear mode
+  static const uint32_t LINEAR_CACHE_SIZE = 4096;
+
+  /// A route of the table
+  struct Route
+  {
+    Ipv4Address network;  //!< Destination network
+    Ipv4Mask networkMask; //!< Mask of the network
+    uint32_t port;        //!< Output interface
+  };
+
+  /// A node of the prefix trie
+  struct TrieNode
+  {
+    int32_t child[2];     //!< Children for bit 0 and 1, -1 if none
+    int32_t group;        //!< Port list of the routes on the path, -1 if none
+  };
+
+  /**
+   * \brief Compile the routes into the trie.
+   */
+  void Build (void);
+
+  std::vector<Route> m_routes;                //!< Routes, in insertion order
+  bool m_valid;                               //!< Whether the trie matches the routes
+  bool m_linear;                              //!< A mask is not contiguous
+  std::vector<TrieNode> m_trie;               //!< Prefix trie, root first
+  std::vector<PortList> m_groups;             //!< Port lists of the trie nodes
+  std::set<PortList> m_linearGroups;          //!< Port lists of the linear mode
+  std::map<Ipv4Address, const PortList *> m_linearCache; //!< Lookups of the linear mode
+  PortList m_empty;                           //!< Result of unmatched lookups
+};
+
+} // namespace ns3
+
+#endif /* IPV4_EGRESS_PORT_TABLE_H */
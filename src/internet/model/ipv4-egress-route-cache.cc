@@ -0,0 +1,117 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ipv4-egress-route-cache.h"
+
+#include "ns3/log.h"
+#include "ns3/net-device.h"
+#include "ns3/channel.h"
+#include "ns3/node.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("Ipv4EgressRouteCache");
+
+NS_OBJECT_ENSURE_REGISTERED (Ipv4EgressRouteCache);
+
+TypeId
+Ipv4EgressRouteCache::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::Ipv4EgressRouteCache")
+    .SetParent<Object> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<Ipv4EgressRouteCache> ()
+  ;
+  return tid;
+}
+
+Ipv4EgressRouteCache::Ipv4EgressRouteCache ()
+  : m_ipv4 (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+Ipv4EgressRouteCache::~Ipv4EgressRouteCache ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+Ptr<Ipv4EgressRouteCache>
+Ipv4EgressRouteCache::GetCache (Ptr<Ipv4> ipv4)
+{
+  NS_ASSERT (ipv4 != 0);
+  Ptr<Ipv4EgressRouteCache> cache = ipv4->GetObject<Ipv4EgressRouteCache> ();
+  if (cache == 0)
+    {
+      cache = CreateObject<Ipv4EgressRouteCache> ();
+      cache->m_ipv4 = ipv4;
+      ipv4->AggregateObject (cache);
+    }
+  return cache;
+}
+
+Ptr<Ipv4Route>
+Ipv4EgressRouteCache::Refresh (uint32_t interface)
+{
+  NS_LOG_FUNCTION (this << interface);
+  NS_ASSERT_MSG (m_ipv4 != 0, "Use Ipv4EgressRouteCache::GetCache to create the cache");
+  if (interface >= m_routes.size ())
+    {
+      m_routes.resize (interface + 1);
+    }
+  m_routes[interface] = 0;
+
+  if (!m_ipv4->IsUp (interface) || m_ipv4->GetNAddresses (interface) == 0)
+    {
+      NS_LOG_LOGIC (this << " Interface: " << interface << " is down or has no address");
+      return 0;
+    }
+  Ptr<NetDevice> dev = m_ipv4->GetNetDevice (interface);
+  Ptr<Channel> channel = dev->GetChannel ();
+  if (channel == 0 || channel->GetNDevices () != 2)
+    {
+      NS_LOG_LOGIC (this << " Interface: " << interface << " is not on a point-to-point channel");
+      return 0;
+    }
+  uint32_t otherEnd = (channel->GetDevice (0) == dev) ? 1 : 0;
+  Ptr<Node> nextHop = channel->GetDevice (otherEnd)->GetNode ();
+  uint32_t nextIf = channel->GetDevice (otherEnd)->GetIfIndex ();
+  Ptr<Ipv4> nextIpv4 = nextHop->GetObject<Ipv4> ();
+  // Same next hop as the per packet lookups used: the address of the
+  // interface whose index equals the device index of the peer
+  if (nextIpv4 == 0 || nextIf >= nextIpv4->GetNInterfaces ()
+      || nextIpv4->GetNAddresses (nextIf) == 0)
+    {
+      NS_LOG_LOGIC (this << " Interface: " << interface << " has no addressed next hop yet");
+      return 0;
+    }
+  Ipv4Address nextHopAddr = nextIpv4->GetAddress (nextIf, 0).GetLocal ();
+
+  Ptr<Ipv4Route> route = Create<Ipv4Route> ();
+  route->SetOutputDevice (dev);
+  route->SetGateway (nextHopAddr);
+  route->SetSource (m_ipv4->GetAddress (interface, 0).GetLocal ());
+  m_routes[interface] = route;
+  NS_LOG_LOGIC (this << " Interface: " << interface << " goes to: " << nextHopAddr);
+  return route;
+}
+
+void
+Ipv4EgressRouteCache::Invalidate (uint32_t interface)
+{
+  NS_LOG_FUNCTION (this << interface);
+  if (interface < m_routes.size ())
+    {
+      m_routes[interface] = 0;
+    }
+}
+
+void
+Ipv4EgressRouteCache::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_routes.clear ();
+  m_ipv4 = 0;
+  Object::DoDispose ();
+}
+
+} // namespace ns3
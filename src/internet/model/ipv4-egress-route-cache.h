@@ -0,0 +1,92 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef IPV4_EGRESS_ROUTE_CACHE_H
+#define IPV4_EGRESS_ROUTE_CACHE_H
+
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/ipv4.h"
+#include "ns3/ipv4-route.h"
+
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup ipv4
+ *
+ * \brief Per node cache of the routes leaving through each interface.
+ *
+ * Source routed and per packet load balancers (DRILL, LetFlow, CONGA,
+ * XPath) forward on point-to-point links whose next hop is the device at
+ * the other end of the channel.  The route of an interface only depends
+ * on the interface, so it is built once and shared by every routing
+ * protocol of the node, instead of being rebuilt for every packet.
+ *
+ * The cache is aggregated to the Ipv4 object of the node.  Routes are built
+ * on first use, rebuilt when the routing protocols report an interface up
+ * and dropped when they report it down.  An interface which is down or has
+ * no address has no route.  The destination of a cached route
+ * is not set, as the forwarding path only uses its output device, gateway
+ * and source.  Cached routes are shared and must not be modified.
+ */
+class Ipv4EgressRouteCache : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  Ipv4EgressRouteCache ();
+  virtual ~Ipv4EgressRouteCache ();
+
+  /**
+   * \brief Get the cache of a node, creating it on first use.
+   * \param ipv4 the Ipv4 object of the node
+   * \return the cache aggregated to ipv4
+   */
+  static Ptr<Ipv4EgressRouteCache> GetCache (Ptr<Ipv4> ipv4);
+
+  /**
+   * \brief Get the route leaving through an interface.
+   * \param interface the output interface
+   * \return the cached route, or 0 if the interface cannot be used
+   */
+  Ptr<Ipv4Route> GetRoute (uint32_t interface);
+
+  /**
+   * \brief Rebuild the route of an interface.
+   * \param interface the output interface
+   * \return the new route, or 0 if the interface is down, has no address
+   *         or has no next hop yet
+   */
+  Ptr<Ipv4Route> Refresh (uint32_t interface);
+
+  /**
+   * \brief Drop the route of an interface; it is rebuilt on next use.
+   * \param interface the output interface
+   */
+  void Invalidate (uint32_t interface);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  Ptr<Ipv4> m_ipv4;                        //!< Ipv4 the routes belong to
+  std::vector<Ptr<Ipv4Route> > m_routes;   //!< Routes indexed by interface
+};
+
+inline Ptr<Ipv4Route>
+Ipv4EgressRouteCache::GetRoute (uint32_t interface)
+{
+  if (interface < m_routes.size () && m_routes[interface] != 0)
+    {
+      return m_routes[interface];
+    }
+  return Refresh (interface);
+}
+
+} // namespace ns3
+
+#endif /* IPV4_EGRESS_ROUTE_CACHE_H */
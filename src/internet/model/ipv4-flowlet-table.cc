@@ -0,0 +1,197 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ipv4-flowlet-table.h"
+
+#include "ns3/log.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+
+#include <iomanip>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("Ipv4FlowletTable");
+
+NS_OBJECT_ENSURE_REGISTERED (Ipv4FlowletTable);
+
+TypeId
+Ipv4FlowletTable::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::Ipv4FlowletTable")
+    .SetParent<Object> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<Ipv4FlowletTable> ()
+    .AddAttribute ("Mode",
+                   "Storage of the entries: a fixed size hash table or an unbounded map",
+                   EnumValue (FLOWLET_TABLE_HASH),
+                   MakeEnumAccessor (&Ipv4FlowletTable::m_mode),
+                   MakeEnumChecker (FLOWLET_TABLE_HASH, "Hash",
+                                    FLOWLET_TABLE_MAP, "Map"))
+    .AddAttribute ("Size",
+                   "Number of slots of the hash table, rounded up to a power of two",
+                   UintegerValue (65536),
+                   MakeUintegerAccessor (&Ipv4FlowletTable::m_size),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddTraceSource ("Collision",
+                     "An active flowlet was evicted to make room for another flow",
+                     MakeTraceSourceAccessor (&Ipv4FlowletTable::m_collisionTrace),
+                     "ns3::Ipv4FlowletTable::CollisionTracedCallback")
+  ;
+  return tid;
+}
+
+Ipv4FlowletTable::Ipv4FlowletTable ()
+  : m_timeout (MicroSeconds (50)),
+    m_nEntries (0),
+    m_mask (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+Ipv4FlowletTable::~Ipv4FlowletTable ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+Ipv4FlowletTable::SetTimeout (Time timeout)
+{
+  m_timeout = timeout;
+}
+
+void
+Ipv4FlowletTable::AllocateSlots (void)
+{
+  uint32_t slots = 1;
+  while (slots < m_size)
+    {
+      slots <<= 1;
+    }
+  NS_LOG_FUNCTION (this << slots);
+  m_mask = slots - 1;
+  m_slots.resize (slots);
+  m_used.assign (slots, false);
+}
+
+uint32_t
+Ipv4FlowletTable::HomeSlot (uint32_t flowId) const
+{
+  uint32_t h = flowId * 2654435761U;
+  return (h ^ (h >> 16)) & m_mask;
+}
+
+Ipv4Flowlet *
+Ipv4FlowletTable::Find (uint32_t flowId)
+{
+  if (m_mode == FLOWLET_TABLE_MAP)
+    {
+      std::map<uint32_t, Ipv4Flowlet>::iterator it = m_map.find (flowId);
+      return it != m_map.end () ? &it->second : 0;
+    }
+
+  if (m_slots.empty ())
+    {
+      return 0;
+    }
+  uint32_t slot = HomeSlot (flowId);
+  for (uint32_t i = 0; i < PROBES; i++, slot = (slot + 1) & m_mask)
+    {
+      // Slots are never released, so the probe stops at the first unused one
+      if (!m_used[slot])
+        {
+          return 0;
+        }
+      if (m_slots[slot].flowId == flowId)
+        {
+          return &m_slots[slot];
+        }
+    }
+  return 0;
+}
+
+Ipv4Flowlet *
+Ipv4FlowletTable::Insert (uint32_t flowId, Time now)
+{
+  NS_LOG_FUNCTION (this << flowId << now);
+  Ipv4Flowlet *flowlet;
+  if (m_mode == FLOWLET_TABLE_MAP)
+    {
+      flowlet = &m_map[flowId];
+      m_nEntries = m_map.size ();
+    }
+  else
+    {
+      if (m_slots.empty ())
+        {
+          AllocateSlots ();
+        }
+      uint32_t slot = HomeSlot (flowId);
+      uint32_t victim = slot;
+      bool found = false;
+      for (uint32_t i = 0; i < PROBES; i++, slot = (slot + 1) & m_mask)
+        {
+          if (!m_used[slot])
+            {
+              m_used[slot] = true;
+              m_nEntries++;
+              found = true;
+              break;
+            }
+          if (now - m_slots[slot].activeTime > m_timeout)
+            {
+              // Aged out: the flow may come back but its flowlet is over
+              found = true;
+              break;
+            }
+          if (m_slots[slot].activeTime < m_slots[victim].activeTime)
+            {
+              victim = slot;
+            }
+        }
+      if (!found)
+        {
+          NS_LOG_LOGIC (this << " Flow: " << flowId << " evicts the flowlet of flow: " << m_slots[victim].flowId);
+          m_collisionTrace (flowId, m_slots[victim].flowId);
+          slot = victim;
+        }
+      flowlet = &m_slots[slot];
+    }
+  flowlet->flowId = flowId;
+  flowlet->port = 0;
+  flowlet->activeTime = now;
+  return flowlet;
+}
+
+uint32_t
+Ipv4FlowletTable::GetNEntries (void) const
+{
+  return m_nEntries;
+}
+
+void
+Ipv4FlowletTable::Print (std::ostream &os) const
+{
+  os << "FlowId      Port  Active time" << std::endl;
+  if (m_mode == FLOWLET_TABLE_MAP)
+    {
+      for (std::map<uint32_t, Ipv4Flowlet>::const_iterator it = m_map.begin (); it != m_map.end (); ++it)
+        {
+          os << std::setiosflags (std::ios::left) << std::setw (12) << it->first
+             << std::setw (6) << it->second.port << it->second.activeTime.As (Time::S) << std::endl;
+        }
+    }
+  else
+    {
+      for (uint32_t slot = 0; slot < m_slots.size (); slot++)
+        {
+          if (m_used[slot])
+            {
+              os << std::setiosflags (std::ios::left) << std::setw (12) << m_slots[slot].flowId
+                 << std::setw (6) << m_slots[slot].port << m_slots[slot].activeTime.As (Time::S) << std::endl;
+            }
+        }
+    }
+  os << std::resetiosflags (std::ios::left);
+}
+
+} // namespace ns3
@@ -0,0 +1,133 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef IPV4_FLOWLET_TABLE_H
+#define IPV4_FLOWLET_TABLE_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/traced-callback.h"
+
+#include <map>
+#include <vector>
+#include <ostream>
+
+namespace ns3 {
+
+/**
+ * \ingroup ipv4
+ *
+ * \brief A flowlet table entry.
+ */
+struct Ipv4Flowlet
+{
+  uint32_t flowId;   //!< Flow owning the entry
+  uint32_t port;     //!< Port the flowlet goes through
+  Time activeTime;   //!< Time the flowlet last forwarded a packet
+};
+
+/**
+ * \ingroup ipv4
+ *
+ * \brief Flowlet table of the flowlet based load balancers (CONGA, LetFlow).
+ *
+ * In the default Hash mode the table is a fixed array of slots, indexed by a
+ * hash of the flow id and probed linearly over a small window, like the
+ * flowlet tables of switch hardware.  Memory is bounded whatever the number
+ * of flows.  An entry idle for longer than the flowlet timeout is aged: its
+ * slot is reused by the next flow hashing to it.  When all the slots of the
+ * window hold active flowlets, the least recently active one is evicted and
+ * the Collision trace source fires.
+ *
+ * The Map mode keeps one entry per flow in an unbounded map and never ages
+ * them, which reproduces the results of the original implementation.
+ */
+class Ipv4FlowletTable : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  /// Storage of the entries
+  enum Mode_e
+  {
+    FLOWLET_TABLE_HASH,  //!< Fixed size, open addressed table
+    FLOWLET_TABLE_MAP    //!< Unbounded map, entries never aged
+  };
+
+  /**
+   * TracedCallback signature for flowlet collisions.
+   *
+   * \param [in] flowId The flow inserted in the table.
+   * \param [in] evictedFlowId The flow whose active flowlet was evicted.
+   */
+  typedef void (* CollisionTracedCallback)(uint32_t flowId, uint32_t evictedFlowId);
+
+  Ipv4FlowletTable ();
+  virtual ~Ipv4FlowletTable ();
+
+  /**
+   * \brief Set the idle time after which a flowlet expires.
+   * \param timeout the flowlet timeout
+   */
+  void SetTimeout (Time timeout);
+
+  /**
+   * \brief Find the entry of a flow.
+   * \param flowId the flow id
+   * \return the entry, active or expired, or 0 if the flow has none
+   */
+  Ipv4Flowlet *Find (uint32_t flowId);
+
+  /**
+   * \brief Create the entry of a flow which has none.
+   *
+   * The entry is valid until the next call to Insert.
+   *
+   * \param flowId the flow id
+   * \param now the current time, used to age the entries
+   * \return the new entry, with its port to be set by the caller
+   */
+  Ipv4Flowlet *Insert (uint32_t flowId, Time now);
+
+  /**
+   * \return the number of entries in the table
+   */
+  uint32_t GetNEntries (void) const;
+
+  /**
+   * \brief Print the entries of the table.
+   * \param os the output stream
+   */
+  void Print (std::ostream &os) const;
+
+private:
+  /// Number of slots probed from the home slot of a flow
+  static const uint32_t PROBES = 4;
+
+  /**
+   * \brief Allocate the slots of the Hash mode.
+   */
+  void AllocateSlots (void);
+
+  /**
+   * \param flowId the flow id
+   * \return the home slot of the flow
+   */
+  uint32_t HomeSlot (uint32_t flowId) const;
+
+  Mode_e m_mode;                                //!< Storage of the entries
+  uint32_t m_size;                              //!< Requested number of slots
+  Time m_timeout;                               //!< Flowlet timeout
+  uint32_t m_nEntries;                          //!< Entries in use
+  uint32_t m_mask;                              //!< Number of slots minus one
+  std::vector<Ipv4Flowlet> m_slots;             //!< Slots of the Hash mode
+  std::vector<bool> m_used;                     //!< Used slots of the Hash mode
+  std::map<uint32_t, Ipv4Flowlet> m_map;        //!< Entries of the Map mode
+  TracedCallback<uint32_t, uint32_t> m_collisionTrace; //!< Active flowlet evicted
+};
+
+} // namespace ns3
+
+#endif /* IPV4_FLOWLET_TABLE_H */
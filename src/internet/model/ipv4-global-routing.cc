@@ -27,6 +27,8 @@
 #include "ns3/ipv4-route.h"
 #include "ns3/ipv4-routing-table-entry.h"
 #include "ns3/boolean.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
 #include "ns3/node.h"
 #include "ipv4-global-routing.h"
 #include "global-route-manager.h"
@@ -55,6 +57,19 @@ Ipv4GlobalRouting::GetTypeId (void)
                    BooleanValue (false),
                    MakeBooleanAccessor (&Ipv4GlobalRouting::m_perFlowEcmpRouting),
                    MakeBooleanChecker ())
+    .AddAttribute ("EcmpHash",
+                   "Hash function used to select the route of a flow when PerflowEcmpRouting is enabled",
+                   EnumValue (Ipv4GlobalRouting::ECMP_HASH_STRING),
+                   MakeEnumAccessor (&Ipv4GlobalRouting::m_ecmpHash),
+                   MakeEnumChecker (Ipv4GlobalRouting::ECMP_HASH_STRING, "String",
+                                    Ipv4GlobalRouting::ECMP_HASH_CRC32, "Crc32",
+                                    Ipv4GlobalRouting::ECMP_HASH_MURMUR3, "Murmur3",
+                                    Ipv4GlobalRouting::ECMP_HASH_TOEPLITZ, "Toeplitz"))
+    .AddAttribute ("EcmpHashSalt",
+                   "Per switch salt of the Crc32, Murmur3 and Toeplitz ECMP hashes",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&Ipv4GlobalRouting::m_ecmpHashSalt),
+                   MakeUintegerChecker<uint32_t> ())
     .AddAttribute ("RespondToInterfaceEvents",
                    "Set to true if you want to dynamically recompute the global routes upon Interface notification events (up/down, or add/remove address)",
                    BooleanValue (false),
@@ -67,7 +82,12 @@ Ipv4GlobalRouting::GetTypeId (void)
 Ipv4GlobalRouting::Ipv4GlobalRouting ()
   : m_randomEcmpRouting (false),
     m_perFlowEcmpRouting (false),
-    m_respondToInterfaceEvents (false)
+    m_ecmpHash (ECMP_HASH_STRING),
+    m_ecmpHashSalt (0),
+    m_respondToInterfaceEvents (false),
+    m_fibValid (false),
+    m_fibNetworkLinear (false),
+    m_networkFibGroups (0)
 {
   NS_LOG_FUNCTION (this);
 
@@ -88,6 +108,7 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, nextHop, interface);
   m_hostRoutes.push_back (route);
+  InvalidateFib ();
 }
 
 void
@@ -98,6 +119,7 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, interface);
   m_hostRoutes.push_back (route);
+  InvalidateFib ();
 }
 
 void
@@ -113,6 +135,7 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_networkRoutes.push_back (route);
+  InvalidateFib ();
 }
 
 void
@@ -126,6 +149,7 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         networkMask,
                                                         interface);
   m_networkRoutes.push_back (route);
+  InvalidateFib ();
 }
 
 void
@@ -144,62 +168,310 @@ Ipv4GlobalRouting::AddASExternalRouteTo (Ipv4Address network,
 }
 
 
-Ptr<Ipv4Route>
-Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<Packet> packet, const Ipv4Header &header, uint32_t flowId, Ptr<NetDevice> oif)
+namespace {
+
+/**
+ * \brief Spread host addresses over the slots of the host route index.
+ * \param addr the address, in host order
+ * \return the hash value
+ */
+inline uint32_t
+FibHash (uint32_t addr)
 {
-  NS_LOG_FUNCTION (this << dest << oif);
-  NS_LOG_LOGIC ("Looking for route for destination " << dest);
-  Ptr<Ipv4Route> rtentry = 0;
-  // store all available routes that bring packets to their destination
-  typedef std::vector<Ipv4RoutingTableEntry*> RouteVec_t;
-  RouteVec_t allRoutes;
+  uint32_t h = addr * 2654435761U;
+  return h ^ (h >> 16);
+}
+
+/**
+ * \brief Lookup table of the CRC32, filled when the library is loaded so
+ * that the routing of concurrent threads can share it.
+ */
+struct Crc32Table
+{
+  Crc32Table ()
+  {
+    for (uint32_t i = 0; i < 256; i++)
+      {
+        uint32_t c = i;
+        for (uint32_t k = 0; k < 8; k++)
+          {
+            c = (c & 1) ? (0xedb88320U ^ (c >> 1)) : (c >> 1);
+          }
+        entries[i] = c;
+      }
+  }
+  uint32_t entries[256]; //!< CRC of each byte value
+} g_crc32Table;
+
+/**
+ * \brief CRC32 (IEEE 802.3, reflected) of a buffer.
+ * \param buffer the bytes to hash
+ * \param size the number of bytes
+ * \return the CRC
+ */
+uint32_t
+Crc32 (const uint8_t *buffer, uint32_t size)
+{
+  uint32_t crc = 0xffffffffU;
+  for (uint32_t i = 0; i < size; i++)
+    {
+      crc = g_crc32Table.entries[(crc ^ buffer[i]) & 0xff] ^ (crc >> 8);
+    }
+  return crc ^ 0xffffffffU;
+}
+
+/**
+ * \brief Toeplitz hash of a buffer, as computed by NIC receive side scaling.
+ * \param buffer the bytes to hash, at most 36
+ * \param size the number of bytes
+ * \return the hash value
+ */
+uint32_t
+Toeplitz (const uint8_t *buffer, uint32_t size)
+{
+  // The default RSS key
+  static const uint8_t key[40] = {
+    0x6d, 0x5a, 0x56, 0xda, 0x25, 0x5b, 0x0e, 0xc2,
+    0x41, 0x67, 0x25, 0x3d, 0x43, 0xa3, 0x8f, 0xb0,
+    0xd0, 0xca, 0x2b, 0xcb, 0xae, 0x7b, 0x30, 0xb4,
+    0x77, 0xcb, 0x2d, 0xa3, 0x80, 0x30, 0xf2, 0x0c,
+    0x6a, 0x42, 0xb7, 0x3b, 0xbe, 0xac, 0x01, 0xfa
+  };
+  NS_ASSERT (size + 4 <= sizeof (key));
+  uint32_t result = 0;
+  uint32_t window = (key[0] << 24) | (key[1] << 16) | (key[2] << 8) | key[3];
+  for (uint32_t i = 0; i < size; i++)
+    {
+      for (uint32_t b = 0; b < 8; b++)
+        {
+          if (buffer[i] & (0x80 >> b))
+            {
+              result ^= window;
+            }
+          window <<= 1;
+          if (key[i + 4] & (0x80 >> b))
+            {
+              window |= 1;
+            }
+        }
+    }
+  return result;
+}
+
+} // anonymous namespace
+
+uint32_t
+Ipv4GlobalRouting::EcmpHash (uint32_t flowId, uint8_t ttl)
+{
+  if (m_ecmpHash == ECMP_HASH_STRING)
+    {
+      std::stringstream hash_string;
+      hash_string << flowId;
+      hash_string << ttl;
+      return Hash32 (hash_string.str ());
+    }
 
-  NS_LOG_LOGIC ("Number of m_hostRoutes = " << m_hostRoutes.size ());
+  uint8_t key[9];
+  key[0] = (m_ecmpHashSalt >> 24) & 0xff;
+  key[1] = (m_ecmpHashSalt >> 16) & 0xff;
+  key[2] = (m_ecmpHashSalt >> 8) & 0xff;
+  key[3] = m_ecmpHashSalt & 0xff;
+  key[4] = (flowId >> 24) & 0xff;
+  key[5] = (flowId >> 16) & 0xff;
+  key[6] = (flowId >> 8) & 0xff;
+  key[7] = flowId & 0xff;
+  key[8] = ttl;
+  uint32_t hash;
+  switch (m_ecmpHash)
+    {
+    case ECMP_HASH_CRC32:
+      hash = Crc32 (key, sizeof (key));
+      break;
+    case ECMP_HASH_TOEPLITZ:
+      hash = Toeplitz (key, sizeof (key));
+      break;
+    default:
+      return m_ecmpHasher.clear ().GetHash32 (reinterpret_cast<const char *> (key), sizeof (key));
+    }
+  // CRC32 and Toeplitz are linear: the salt in the key only XORs every
+  // hash with the same value, which renames the routes but keeps the
+  // flows of one route together at the next switch.  Selecting other
+  // bits of the hash, as the hash offset of switch ASICs does, spreads them.
+  uint32_t rotate = m_ecmpHashSalt % 32;
+  return rotate == 0 ? hash : (hash << rotate) | (hash >> (32 - rotate));
+}
+
+void
+Ipv4GlobalRouting::InvalidateFib (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_fibValid = false;
+}
+
+void
+Ipv4GlobalRouting::BuildFib (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_fibGroups.clear ();
+  m_hostFib.clear ();
+
+  // Host routes: open addressing, kept at most half full so that probing
+  // always reaches an empty slot
+  uint32_t size = 1;
+  while (size < 2 * m_hostRoutes.size ())
+    {
+      size <<= 1;
+    }
+  HostFibSlot emptySlot = { 0, 0 };
+  m_hostFib.assign (size, emptySlot);
   for (HostRoutesCI i = m_hostRoutes.begin ();
        i != m_hostRoutes.end ();
        i++)
     {
-      NS_ASSERT ((*i)->IsHost ());
-      if ((*i)->GetDest ().IsEqual (dest))
+      uint32_t dest = (*i)->GetDest ().Get ();
+      uint32_t slot = FibHash (dest) & (size - 1);
+      while (m_hostFib[slot].group != 0 && m_hostFib[slot].dest != dest)
         {
-          if (oif != 0)
-            {
-              if (oif != m_ipv4->GetNetDevice ((*i)->GetInterface ()))
-                {
-                  NS_LOG_LOGIC ("Not on requested interface, skipping");
-                  continue;
-                }
-            }
-          allRoutes.push_back (*i);
-          NS_LOG_LOGIC (allRoutes.size () << "Found global host route" << *i);
+          slot = (slot + 1) & (size - 1);
         }
+      if (m_hostFib[slot].group == 0)
+        {
+          m_fibGroups.push_back (EcmpGroup ());
+          m_hostFib[slot].dest = dest;
+          m_hostFib[slot].group = m_fibGroups.size ();
+        }
+      m_fibGroups[m_hostFib[slot].group - 1].push_back (*i);
     }
-  if (allRoutes.size () == 0) // if no host route is found
+
+  // Network routes: the prefix trie of an egress port table, whose ports are
+  // the indices of the routes.  A lookup used to return every matching
+  // network route regardless of its prefix length, which is what the port
+  // list of a prefix holds, in table order.
+  std::vector<Ipv4RoutingTableEntry *> bySeq;
+  m_networkFib = Ipv4EgressPortTable ();
+  for (NetworkRoutesCI j = m_networkRoutes.begin ();
+       j != m_networkRoutes.end ();
+       j++)
     {
-      NS_LOG_LOGIC ("Number of m_networkRoutes" << m_networkRoutes.size ());
-      for (NetworkRoutesI j = m_networkRoutes.begin ();
-           j != m_networkRoutes.end ();
-           j++)
+      m_networkFib.AddRoute ((*j)->GetDestNetwork (), (*j)->GetDestNetworkMask (), bySeq.size ());
+      bySeq.push_back (*j);
+    }
+  m_fibNetworkLinear = !m_networkFib.Compile ();
+  if (m_fibNetworkLinear)
+    {
+      NS_LOG_LOGIC ("Non-contiguous mask, network routes are looked up linearly");
+    }
+  m_networkFibGroups = m_fibGroups.size ();
+  for (uint32_t n = 0; n < m_networkFib.GetNPortLists (); n++)
+    {
+      const Ipv4EgressPortTable::PortList &routes = m_networkFib.GetPortList (n);
+      EcmpGroup group;
+      for (Ipv4EgressPortTable::PortList::const_iterator k = routes.begin (); k != routes.end (); k++)
         {
-          Ipv4Mask mask = (*j)->GetDestNetworkMask ();
-          Ipv4Address entry = (*j)->GetDestNetwork ();
-          if (mask.IsMatch (dest, entry))
+          group.push_back (bySeq[*k]);
+        }
+      m_fibGroups.push_back (group);
+    }
+
+  m_fibValid = true;
+  NS_LOG_LOGIC ("Compiled " << m_fibGroups.size () << " ECMP groups from "
+                << m_hostRoutes.size () << " host and " << m_networkRoutes.size () << " network routes");
+}
+
+const Ipv4GlobalRouting::EcmpGroup *
+Ipv4GlobalRouting::LookupHostFib (Ipv4Address dest) const
+{
+  uint32_t addr = dest.Get ();
+  uint32_t mask = m_hostFib.size () - 1;
+  uint32_t slot = FibHash (addr) & mask;
+  while (m_hostFib[slot].group != 0)
+    {
+      if (m_hostFib[slot].dest == addr)
+        {
+          return &m_fibGroups[m_hostFib[slot].group - 1];
+        }
+      slot = (slot + 1) & mask;
+    }
+  return 0;
+}
+
+const Ipv4GlobalRouting::EcmpGroup *
+Ipv4GlobalRouting::LookupNetworkFib (Ipv4Address dest) const
+{
+  int32_t group = m_networkFib.LookupIndex (dest);
+  return group < 0 ? 0 : &m_fibGroups[m_networkFibGroups + group];
+}
+
+const Ipv4GlobalRouting::EcmpGroup *
+Ipv4GlobalRouting::FilterFibGroup (const EcmpGroup *group, Ptr<NetDevice> oif, EcmpGroup &filtered) const
+{
+  if (group == 0 || oif == 0)
+    {
+      return group;
+    }
+  filtered.clear ();
+  for (EcmpGroup::const_iterator i = group->begin (); i != group->end (); i++)
+    {
+      if (oif != m_ipv4->GetNetDevice ((*i)->GetInterface ()))
+        {
+          NS_LOG_LOGIC ("Not on requested interface, skipping");
+          continue;
+        }
+      filtered.push_back (*i);
+    }
+  return filtered.empty () ? 0 : &filtered;
+}
+
+Ptr<Ipv4Route>
+Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<Packet> packet, const Ipv4Header &header, uint32_t flowId, Ptr<NetDevice> oif)
+{
+  NS_LOG_FUNCTION (this << dest << oif);
+  NS_LOG_LOGIC ("Looking for route for destination " << dest);
+  Ptr<Ipv4Route> rtentry = 0;
+  if (!m_fibValid)
+    {
+      BuildFib ();
+    }
+  // all available routes that bring packets to their destination; only
+  // materialized when an output device restricts the precomputed group
+  EcmpGroup filtered;
+
+  const EcmpGroup *allRoutes = FilterFibGroup (LookupHostFib (dest), oif, filtered);
+  if (allRoutes == 0) // if no host route is found
+    {
+      if (m_fibNetworkLinear)
+        {
+          filtered.clear ();
+          for (NetworkRoutesI j = m_networkRoutes.begin ();
+               j != m_networkRoutes.end ();
+               j++)
             {
-              if (oif != 0)
+              Ipv4Mask mask = (*j)->GetDestNetworkMask ();
+              Ipv4Address entry = (*j)->GetDestNetwork ();
+              if (mask.IsMatch (dest, entry))
                 {
-                  if (oif != m_ipv4->GetNetDevice ((*j)->GetInterface ()))
+                  if (oif != 0)
                     {
-                      NS_LOG_LOGIC ("Not on requested interface, skipping");
-                      continue;
+                      if (oif != m_ipv4->GetNetDevice ((*j)->GetInterface ()))
+                        {
+                          NS_LOG_LOGIC ("Not on requested interface, skipping");
+                          continue;
+                        }
                     }
+                  filtered.push_back (*j);
+                  NS_LOG_LOGIC (filtered.size () << "Found global network route" << *j);
                 }
-              allRoutes.push_back (*j);
-              NS_LOG_LOGIC (allRoutes.size () << "Found global network route" << *j);
             }
+          allRoutes = filtered.empty () ? 0 : &filtered;
+        }
+      else
+        {
+          allRoutes = FilterFibGroup (LookupNetworkFib (dest), oif, filtered);
         }
     }
-  if (allRoutes.size () == 0)  // consider external if no host/network found
+  if (allRoutes == 0)  // consider external if no host/network found
     {
+      filtered.clear ();
       for (ASExternalRoutesI k = m_ASexternalRoutes.begin ();
            k != m_ASexternalRoutes.end ();
            k++)
@@ -217,12 +489,13 @@ Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<Packet> packet, const Ipv
                       continue;
                     }
                 }
-              allRoutes.push_back (*k);
+              filtered.push_back (*k);
+              allRoutes = &filtered;
               break;
             }
         }
     }
-  if (allRoutes.size () > 0 ) // if route(s) is found
+  if (allRoutes != 0) // if route(s) is found
     {
       // pick up one of the routes uniformly at random if random
       // ECMP routing is enabled, or always select the first route
@@ -230,22 +503,19 @@ Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<Packet> packet, const Ipv
       uint32_t selectIndex;
       if (m_randomEcmpRouting)
         {
-          selectIndex = m_rand->GetInteger (0, allRoutes.size ()-1);
+          selectIndex = m_rand->GetInteger (0, allRoutes->size ()-1);
         }
       else if (m_perFlowEcmpRouting && flowId != 0) // If the flow id is 0, it may be the socket setup endpoint request, we simply return the first
         {                                           // available route to indicate the address is not local
-          std::stringstream hash_string;
-          hash_string << flowId;
-          hash_string << header.GetTtl ();
-          uint32_t hashPerturbe = Hash32 (hash_string.str ()); // Hash Perturbe
-          selectIndex = hashPerturbe % allRoutes.size();
+          uint32_t hashPerturbe = EcmpHash (flowId, header.GetTtl ()); // Hash Perturbe
+          selectIndex = hashPerturbe % allRoutes->size();
           NS_LOG_LOGIC ("Per flow ECMP is enabled, select index: " << selectIndex << " for flow: " << flowId);
         }
       else
         {
           selectIndex = 0;
         }
-      Ipv4RoutingTableEntry* route = allRoutes.at (selectIndex);
+      Ipv4RoutingTableEntry* route = (*allRoutes)[selectIndex];
       // create a Ipv4Route object from the selected routing table entry
       rtentry = Create<Ipv4Route> ();
       rtentry->SetDestination (route->GetDest ());
@@ -326,6 +596,7 @@ void
 Ipv4GlobalRouting::RemoveRoute (uint32_t index)
 {
   NS_LOG_FUNCTION (this << index);
+  InvalidateFib ();
   if (index < m_hostRoutes.size ())
     {
       uint32_t tmp = 0;
@@ -409,6 +680,10 @@ Ipv4GlobalRouting::DoDispose (void)
     {
       delete (*l);
     }
+  InvalidateFib ();
+  m_fibGroups.clear ();
+  m_hostFib.clear ();
+  m_networkFib = Ipv4EgressPortTable ();
 
   Ipv4RoutingProtocol::DoDispose ();
 }
@@ -578,6 +853,8 @@ void
 Ipv4GlobalRouting::NotifyInterfaceUp (uint32_t i)
 {
   NS_LOG_FUNCTION (this << i);
+  // recompile the forwarding table against the new interface state
+  InvalidateFib ();
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
       GlobalRouteManager::DeleteGlobalRoutes ();
@@ -590,6 +867,8 @@ void
 Ipv4GlobalRouting::NotifyInterfaceDown (uint32_t i)
 {
   NS_LOG_FUNCTION (this << i);
+  // recompile the forwarding table against the new interface state
+  InvalidateFib ();
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
       GlobalRouteManager::DeleteGlobalRoutes ();
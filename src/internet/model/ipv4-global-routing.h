@@ -21,13 +21,18 @@
 #define IPV4_GLOBAL_ROUTING_H
 
 #include <list>
+#include <vector>
 #include <stdint.h>
 #include "ns3/ipv4-address.h"
+#include "ns3/ipv4-egress-port-table.h"
 #include "ns3/ipv4-header.h"
 #include "ns3/ptr.h"
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/random-variable-stream.h"
+#include "ns3/hash.h"
+
+class Ipv4GlobalRoutingEcmpHashTestCase;
 
 namespace ns3 {
 
@@ -74,6 +79,16 @@ public:
    * \return the object TypeId
    */
   static TypeId GetTypeId (void);
+
+  /// Hash functions used to spread flows over ECMP routes
+  enum EcmpHash_e
+  {
+    ECMP_HASH_STRING,   //!< Murmur3 over the flow id as decimal text, followed by the TTL as a raw byte
+    ECMP_HASH_CRC32,    //!< CRC32 over the binary salt, flow id and TTL, rotated by the salt
+    ECMP_HASH_MURMUR3,  //!< Murmur3 over the binary salt, flow id and TTL
+    ECMP_HASH_TOEPLITZ  //!< Toeplitz (RSS) hash over the binary salt, flow id and TTL, rotated by the salt
+  };
+
   /**
    * \brief Construct an empty Ipv4GlobalRouting routing protocol,
    *
@@ -230,11 +245,20 @@ protected:
   void DoDispose (void);
 
 private:
+  friend class ::Ipv4GlobalRoutingEcmpHashTestCase;
+
   /// Set to true if packets are randomly routed among ECMP; set to false for using only one route consistently
   bool m_randomEcmpRouting;
 
   bool m_perFlowEcmpRouting;
 
+  /// Hash function used by per flow ECMP routing
+  EcmpHash_e m_ecmpHash;
+  /// Per switch value mixed into the binary per flow ECMP hashes
+  uint32_t m_ecmpHashSalt;
+  /// Murmur3 hasher reused by the binary per flow ECMP hash
+  Hasher m_ecmpHasher;
+
   /// Set to true if this interface should respond to interface events by globallly recomputing routes
   bool m_respondToInterfaceEvents;
   /// A uniform random number generator for randomly routing packets among ECMP
@@ -261,12 +285,73 @@ private:
   /// iterator of container of Ipv4RoutingTableEntry (routes to external AS)
   typedef std::list<Ipv4RoutingTableEntry *>::iterator ASExternalRoutesI;
 
+  /// All routes that reach one destination (an ECMP group), in table order
+  typedef std::vector<Ipv4RoutingTableEntry *> EcmpGroup;
+
+  /// Slot of the open-addressed host route index
+  struct HostFibSlot
+  {
+    uint32_t dest;  //!< host destination address (host order)
+    uint32_t group; //!< index in m_fibGroups plus one; zero marks an empty slot
+  };
+
+  /**
+   * \brief Hash a flow to select one of its ECMP routes.
+   * \param flowId the flow id carried by the FlowIdTag
+   * \param ttl the TTL of the packet, perturbing the hash at every hop
+   * \return the hash value
+   */
+  uint32_t EcmpHash (uint32_t flowId, uint8_t ttl);
+
   Ptr<Ipv4Route> LookupGlobal (Ipv4Address dest, Ptr<Packet> packet, const Ipv4Header &header, uint32_t flowId, Ptr<NetDevice> oif = 0);
 
+  /**
+   * \brief Compile the host and network routes into the forwarding table.
+   *
+   * Host routes are indexed by a hash table, network routes by the prefix
+   * trie of an Ipv4EgressPortTable.  Every host and every prefix gets a precomputed
+   * ECMP group holding the same routes, in the same order, as a linear scan
+   * of the route lists would have returned.
+   */
+  void BuildFib (void);
+
+  /// Drop the compiled forwarding table; it is rebuilt on the next lookup
+  void InvalidateFib (void);
+
+  /**
+   * \brief Find the ECMP group of the host routes to a destination.
+   * \param dest the destination address
+   * \return the group, or 0 if there is no host route to dest
+   */
+  const EcmpGroup *LookupHostFib (Ipv4Address dest) const;
+
+  /**
+   * \brief Find the ECMP group of the network routes matching a destination.
+   * \param dest the destination address
+   * \return the group, or 0 if no network route matches dest
+   */
+  const EcmpGroup *LookupNetworkFib (Ipv4Address dest) const;
+
+  /**
+   * \brief Restrict an ECMP group to the routes leaving through a device.
+   * \param group the group to filter, may be 0
+   * \param oif the output device, or 0 to keep every route
+   * \param filtered storage for the filtered group
+   * \return group itself if oif is 0, otherwise &filtered, or 0 if no route is left
+   */
+  const EcmpGroup *FilterFibGroup (const EcmpGroup *group, Ptr<NetDevice> oif, EcmpGroup &filtered) const;
+
   HostRoutes m_hostRoutes;             //!< Routes to hosts
   NetworkRoutes m_networkRoutes;       //!< Routes to networks
   ASExternalRoutes m_ASexternalRoutes; //!< External routes imported
 
+  bool m_fibValid;                        //!< True if the compiled forwarding table is up to date
+  bool m_fibNetworkLinear;                //!< True if a non-contiguous mask forces linear network lookups
+  std::vector<EcmpGroup> m_fibGroups;     //!< Precomputed ECMP groups
+  std::vector<HostFibSlot> m_hostFib;     //!< Host route index (power of two size)
+  Ipv4EgressPortTable m_networkFib;       //!< Network route trie, whose ports are network route indices
+  uint32_t m_networkFibGroups;            //!< Index in m_fibGroups of the group of the first port list
+
   Ptr<Ipv4> m_ipv4; //!< associated IPv4 instance
 };
 
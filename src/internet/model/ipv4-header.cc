@@ -52,6 +52,13 @@ Ipv4Header::EnableChecksum (void)
   m_calcChecksum = true;
 }
 
+bool
+Ipv4Header::IsChecksumEnabled (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_calcChecksum;
+}
+
 void
 Ipv4Header::SetPayloadSize (uint16_t size)
 {
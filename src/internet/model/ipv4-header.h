@@ -39,6 +39,10 @@ public:
    * \brief Enable checksum calculation for this header.
    */
   void EnableChecksum (void);
+  /**
+   * \returns true if EnableChecksum was called on this header.
+   */
+  bool IsChecksumEnabled (void) const;
   /**
    * \param size the size of the payload in bytes
    */
@@ -257,6 +261,27 @@ private:
   uint16_t m_headerSize; //!< IP header size
 };
 
+/**
+ * \brief A Packet keeps an Ipv4Header unserialized while its checksum
+ * is disabled.
+ *
+ * The hops which only forward the packet thus read and write the
+ * header without any serialization.
+ */
+template <>
+struct LazyHeaderTraits<Ipv4Header>
+{
+  enum { ENABLED = 1 }; //!< Ipv4Header opted in
+  /**
+   * \param [in] header The header to add or to fill.
+   * \returns true if the checksum of \pname{header} is disabled.
+   */
+  static bool IsLazy (const Ipv4Header &header)
+  {
+    return !header.IsChecksumEnabled ();
+  }
+};
+
 } // namespace ns3
 
 
@@ -410,7 +410,23 @@ Ipv4L3Protocol::AddIpv4Interface (Ptr<Ipv4Interface>interface)
   NS_LOG_FUNCTION (this << interface);
   uint32_t index = m_interfaces.size ();
   m_interfaces.push_back (interface);
-  m_reverseInterfacesContainer[interface->GetDevice ()] = index;
+  Ptr<NetDevice> device = interface->GetDevice ();
+  if (device->GetNode () == 0)
+    {
+      // Its node did not give it an index yet: GetInterfaceForDevice scans
+      return index;
+    }
+  uint32_t ifIndex = device->GetIfIndex ();
+  if (ifIndex >= m_reverseInterfacesContainer.size ())
+    {
+      m_reverseInterfacesContainer.resize (ifIndex + 1, std::pair<const NetDevice *, int32_t> (0, -1));
+    }
+  const NetDevice *owner = m_reverseInterfacesContainer[ifIndex].first;
+  if (owner == 0 || owner == PeekPointer (device))
+    {
+      // A device of another node with the same index is left to the scan
+      m_reverseInterfacesContainer[ifIndex] = std::pair<const NetDevice *, int32_t> (PeekPointer (device), index);
+    }
   return index;
 }
 
@@ -483,12 +499,21 @@ Ipv4L3Protocol::GetInterfaceForDevice (
 {
   NS_LOG_FUNCTION (this << device);
 
-  Ipv4InterfaceReverseContainer::const_iterator iter = m_reverseInterfacesContainer.find (device);
-  if (iter != m_reverseInterfacesContainer.end ())
+  uint32_t ifIndex = device->GetIfIndex ();
+  if (ifIndex < m_reverseInterfacesContainer.size ()
+      && m_reverseInterfacesContainer[ifIndex].first == PeekPointer (device))
     {
-      return (*iter).second;
+      return m_reverseInterfacesContainer[ifIndex].second;
     }
 
+  // The device of another node, or one added to IPv4 before its node
+  for (uint32_t interface = 0; interface < m_interfaces.size (); interface++)
+    {
+      if (m_interfaces[interface]->GetDevice () == device)
+        {
+          return interface;
+        }
+    }
   return -1;
 }
 
@@ -693,6 +718,11 @@ void
 Ipv4L3Protocol::CallTxTrace (const Ipv4Header & ipHeader, Ptr<Packet> packet,
                                     Ptr<Ipv4> ipv4, uint32_t interface)
 {
+  if (m_txTrace.IsEmpty ())
+    {
+      // Do not serialize the header for nobody
+      return;
+    }
   Ptr<Packet> packetCopy = packet->Copy ();
   packetCopy->AddHeader (ipHeader);
   m_txTrace (packetCopy, ipv4, interface);
@@ -187,6 +187,17 @@ public:
 
   int32_t GetInterfaceForAddress (Ipv4Address addr) const;
   int32_t GetInterfaceForPrefix (Ipv4Address addr, Ipv4Mask mask) const;
+  /**
+   * \brief Get the interface of a device.
+   *
+   * A device of this node is found by its NetDevice::GetIfIndex, in
+   * constant time.  A miss, for the device of another node or one added
+   * to IPv4 before its node indexed it, costs a linear scan of the
+   * interfaces.
+   *
+   * \param device the device
+   * \returns the interface number of the device, or -1 if not found
+   */
   int32_t GetInterfaceForDevice (Ptr<const NetDevice> device) const;
   bool IsDestinationAddress (Ipv4Address address, uint32_t iif) const;
 
@@ -428,8 +439,8 @@ private:
    * \param ipv4 the Ipv4 protocol
    * \param interface the interface index
    *
-   * Note: If the TracedCallback API ever is extended, we could consider
-   * to check for connected functions before adding the header
+   * Nothing is copied nor serialized when no function is connected
+   * to the TX trace.
    */
   void CallTxTrace (const Ipv4Header & ipHeader, Ptr<Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface);
 
@@ -438,9 +449,10 @@ private:
    */
   typedef std::vector<Ptr<Ipv4Interface> > Ipv4InterfaceList;
   /**
-   * \brief Container of NetDevices registered to IPv4 and their interface indexes.
+   * \brief NetDevices registered to IPv4 and their interface indexes,
+   * indexed by NetDevice::GetIfIndex.
    */
-  typedef std::map<Ptr<const NetDevice>, uint32_t > Ipv4InterfaceReverseContainer;
+  typedef std::vector<std::pair<const NetDevice *, int32_t> > Ipv4InterfaceReverseContainer;
   /**
    * \brief Container of the IPv4 Raw Sockets.
    */
@@ -0,0 +1,157 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/ipv4-egress-port-table.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Egress port table lookups of nested prefixes.
+ */
+class Ipv4EgressPortTablePrefixTestCase : public TestCase
+{
+public:
+  Ipv4EgressPortTablePrefixTestCase ();
+  virtual void DoRun (void);
+};
+
+Ipv4EgressPortTablePrefixTestCase::Ipv4EgressPortTablePrefixTestCase ()
+  : TestCase ("Egress port table with nested prefixes")
+{
+}
+
+void
+Ipv4EgressPortTablePrefixTestCase::DoRun (void)
+{
+  Ipv4EgressPortTable table;
+  table.AddRoute (Ipv4Address ("10.1.0.0"), Ipv4Mask ("255.255.0.0"), 3);
+  table.AddRoute (Ipv4Address ("10.1.2.0"), Ipv4Mask ("255.255.255.0"), 1);
+  table.AddRoute (Ipv4Address ("10.1.0.0"), Ipv4Mask ("255.255.0.0"), 2);
+  table.AddRoute (Ipv4Address ("10.1.2.7"), Ipv4Mask ("255.255.255.255"), 4);
+
+  Ipv4EgressPortTable::PortList ports = table.Lookup (Ipv4Address ("10.1.2.7"));
+  NS_TEST_ASSERT_MSG_EQ (ports.size (), 4, "All the routes match 10.1.2.7");
+  NS_TEST_EXPECT_MSG_EQ (ports[0], 3, "Ports are in the order of the routes");
+  NS_TEST_EXPECT_MSG_EQ (ports[1], 1, "Ports are in the order of the routes");
+  NS_TEST_EXPECT_MSG_EQ (ports[2], 2, "Ports are in the order of the routes");
+  NS_TEST_EXPECT_MSG_EQ (ports[3], 4, "Ports are in the order of the routes");
+
+  ports = table.Lookup (Ipv4Address ("10.1.2.8"));
+  NS_TEST_ASSERT_MSG_EQ (ports.size (), 3, "The host route does not match 10.1.2.8");
+  NS_TEST_EXPECT_MSG_EQ (ports[1], 1, "Ports are in the order of the routes");
+
+  ports = table.Lookup (Ipv4Address ("10.1.3.1"));
+  NS_TEST_ASSERT_MSG_EQ (ports.size (), 2, "Only the /16 routes match 10.1.3.1");
+  NS_TEST_EXPECT_MSG_EQ (ports[0], 3, "Ports are in the order of the routes");
+  NS_TEST_EXPECT_MSG_EQ (ports[1], 2, "Ports are in the order of the routes");
+
+  NS_TEST_EXPECT_MSG_EQ (table.Lookup (Ipv4Address ("10.2.0.1")).empty (), true, "No route matches 10.2.0.1");
+  NS_TEST_EXPECT_MSG_EQ (&table.Lookup (Ipv4Address ("10.1.3.1")), &table.Lookup (Ipv4Address ("10.1.200.9")),
+                         "Destinations of the same prefixes share their port list");
+
+  NS_TEST_ASSERT_MSG_EQ (table.Compile (), true, "All the masks are contiguous");
+  int32_t index = table.LookupIndex (Ipv4Address ("10.1.3.1"));
+  NS_TEST_ASSERT_MSG_EQ ((index >= 0 && static_cast<uint32_t> (index) < table.GetNPortLists ()), true,
+                         "10.1.3.1 has a port list");
+  NS_TEST_EXPECT_MSG_EQ (&table.GetPortList (index), &table.Lookup (Ipv4Address ("10.1.3.1")),
+                         "The index designates the port list of the destination");
+  NS_TEST_EXPECT_MSG_EQ (table.LookupIndex (Ipv4Address ("10.2.0.1")), -1, "No route matches 10.2.0.1");
+
+  // The table is rebuilt on the first lookup after a route is added
+  table.AddRoute (Ipv4Address ("0.0.0.0"), Ipv4Mask ("0.0.0.0"), 5);
+  ports = table.Lookup (Ipv4Address ("10.2.0.1"));
+  NS_TEST_ASSERT_MSG_EQ (ports.size (), 1, "The default route matches 10.2.0.1");
+  NS_TEST_EXPECT_MSG_EQ (ports[0], 5, "The default route goes through port 5");
+  NS_TEST_EXPECT_MSG_EQ (table.Lookup (Ipv4Address ("10.1.2.7")).size (), 5, "All the routes match 10.1.2.7");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Egress port table lookups with a non contiguous mask.
+ */
+class Ipv4EgressPortTableMaskTestCase : public TestCase
+{
+public:
+  Ipv4EgressPortTableMaskTestCase ();
+  virtual void DoRun (void);
+};
+
+Ipv4EgressPortTableMaskTestCase::Ipv4EgressPortTableMaskTestCase ()
+  : TestCase ("Egress port table with a non contiguous mask")
+{
+}
+
+void
+Ipv4EgressPortTableMaskTestCase::DoRun (void)
+{
+  Ipv4EgressPortTable table;
+  table.AddRoute (Ipv4Address ("10.0.0.1"), Ipv4Mask ("255.0.0.255"), 1);
+  table.AddRoute (Ipv4Address ("10.0.0.0"), Ipv4Mask ("255.0.0.0"), 2);
+
+  Ipv4EgressPortTable::PortList ports = table.Lookup (Ipv4Address ("10.7.7.1"));
+  NS_TEST_ASSERT_MSG_EQ (ports.size (), 2, "Both routes match 10.7.7.1");
+  NS_TEST_EXPECT_MSG_EQ (ports[0], 1, "Ports are in the order of the routes");
+  NS_TEST_EXPECT_MSG_EQ (ports[1], 2, "Ports are in the order of the routes");
+
+  ports = table.Lookup (Ipv4Address ("10.7.7.2"));
+  NS_TEST_ASSERT_MSG_EQ (ports.size (), 1, "Only the /8 route matches 10.7.7.2");
+  NS_TEST_EXPECT_MSG_EQ (ports[0], 2, "The /8 route goes through port 2");
+  NS_TEST_EXPECT_MSG_EQ (table.Lookup (Ipv4Address ("11.7.7.1")).empty (), true, "No route matches 11.7.7.1");
+  NS_TEST_EXPECT_MSG_EQ (table.Compile (), false, "The routes are not compiled into a trie");
+
+  // Scan many more destinations than the cache holds
+  const Ipv4EgressPortTable::PortList &first = table.Lookup (Ipv4Address ("10.7.7.1"));
+  uint32_t scanned = 3 * Ipv4EgressPortTable::LINEAR_CACHE_SIZE;
+  for (uint32_t i = 0; i < scanned; i++)
+    {
+      Ipv4Address dest (Ipv4Address ("10.0.0.0").Get () + i);
+      uint32_t expected = (i & 0xff) == 1 ? 2 : 1;
+      NS_TEST_ASSERT_MSG_EQ (table.Lookup (dest).size (), expected, "Wrong routes for " << dest);
+    }
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (table.m_linearCache.size (), Ipv4EgressPortTable::LINEAR_CACHE_SIZE,
+                               "The memoized destinations are bounded");
+  NS_TEST_EXPECT_MSG_EQ (table.m_linearGroups.size (), 3, "Destinations share their port lists, with the empty one");
+  NS_TEST_ASSERT_MSG_EQ (first.size (), 2, "A list stays valid when the cache is flushed");
+  NS_TEST_EXPECT_MSG_EQ (&table.Lookup (Ipv4Address ("10.7.7.1")), &first,
+                         "The list is shared again after the flush");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Egress port table TestSuite
+ */
+class Ipv4EgressPortTableTestSuite : public TestSuite
+{
+public:
+  Ipv4EgressPortTableTestSuite ();
+};
+
+Ipv4EgressPortTableTestSuite::Ipv4EgressPortTableTestSuite ()
+  : TestSuite ("ipv4-egress-port-table", UNIT)
+{
+  AddTestCase (new Ipv4EgressPortTablePrefixTestCase, TestCase::QUICK);
+  AddTestCase (new Ipv4EgressPortTableMaskTestCase, TestCase::QUICK);
+}
+
+static Ipv4EgressPortTableTestSuite g_ipv4EgressPortTableTestSuite; //!< Static variable for test initialization
@@ -0,0 +1,106 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/ipv4-egress-route-cache.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/node-container.h"
+#include "ns3/simulator.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Egress routes of an interface taken down, or losing its address.
+ */
+class Ipv4EgressRouteCacheDownTestCase : public TestCase
+{
+public:
+  Ipv4EgressRouteCacheDownTestCase ();
+  virtual void DoRun (void);
+};
+
+Ipv4EgressRouteCacheDownTestCase::Ipv4EgressRouteCacheDownTestCase ()
+  : TestCase ("Egress route cache of an interface going down")
+{
+}
+
+void
+Ipv4EgressRouteCacheDownTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (2);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  SimpleNetDeviceHelper devHelper;
+  Ipv4AddressHelper address;
+  address.SetBase ("10.1.1.0", "255.255.255.0");
+  address.Assign (devHelper.Install (nodes));
+
+  Ptr<Ipv4> ipv4 = nodes.Get (0)->GetObject<Ipv4> ();
+  Ptr<Ipv4EgressRouteCache> cache = Ipv4EgressRouteCache::GetCache (ipv4);
+  NS_TEST_EXPECT_MSG_EQ (Ipv4EgressRouteCache::GetCache (ipv4), cache, "The cache is shared");
+
+  Ptr<Ipv4Route> route = cache->GetRoute (1);
+  NS_TEST_ASSERT_MSG_NE (route, 0, "No route on an interface up");
+  NS_TEST_EXPECT_MSG_EQ (route->GetOutputDevice (), ipv4->GetNetDevice (1), "Wrong output device");
+  NS_TEST_EXPECT_MSG_EQ (route->GetGateway (), Ipv4Address ("10.1.1.2"), "Wrong next hop");
+  NS_TEST_EXPECT_MSG_EQ (route->GetSource (), Ipv4Address ("10.1.1.1"), "Wrong source");
+  NS_TEST_EXPECT_MSG_EQ (cache->GetRoute (1), route, "The route is not cached");
+
+  // The routing protocols invalidate the route of an interface going down:
+  // the next lookup must not bring it back
+  ipv4->SetDown (1);
+  cache->Invalidate (1);
+  NS_TEST_EXPECT_MSG_EQ (cache->GetRoute (1), 0, "Route on an interface down");
+  NS_TEST_EXPECT_MSG_EQ (cache->Refresh (1), 0, "Refreshed route on an interface down");
+
+  ipv4->SetUp (1);
+  route = cache->Refresh (1);
+  NS_TEST_ASSERT_MSG_NE (route, 0, "No route on an interface up again");
+  NS_TEST_EXPECT_MSG_EQ (cache->GetRoute (1), route, "The refreshed route is not cached");
+
+  // Same for the removal of the address
+  ipv4->RemoveAddress (1, 0);
+  cache->Invalidate (1);
+  NS_TEST_EXPECT_MSG_EQ (cache->GetRoute (1), 0, "Route on an interface without address");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Egress route cache TestSuite
+ */
+class Ipv4EgressRouteCacheTestSuite : public TestSuite
+{
+public:
+  Ipv4EgressRouteCacheTestSuite ();
+};
+
+Ipv4EgressRouteCacheTestSuite::Ipv4EgressRouteCacheTestSuite ()
+  : TestSuite ("ipv4-egress-route-cache", UNIT)
+{
+  AddTestCase (new Ipv4EgressRouteCacheDownTestCase, TestCase::QUICK);
+}
+
+static Ipv4EgressRouteCacheTestSuite g_ipv4EgressRouteCacheTestSuite; //!< Static variable for test initialization
@@ -0,0 +1,156 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/ipv4-flowlet-table.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Flowlet table aging and collisions in Hash mode.
+ */
+class Ipv4FlowletTableHashTestCase : public TestCase
+{
+public:
+  Ipv4FlowletTableHashTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Record a collision.
+   * \param flowId the inserted flow
+   * \param evictedFlowId the evicted flow
+   */
+  void Collision (uint32_t flowId, uint32_t evictedFlowId);
+
+  uint32_t m_collisions;  //!< Number of collisions
+  uint32_t m_evicted;     //!< Last evicted flow
+};
+
+Ipv4FlowletTableHashTestCase::Ipv4FlowletTableHashTestCase ()
+  : TestCase ("Flowlet table in Hash mode"),
+    m_collisions (0),
+    m_evicted (0)
+{
+}
+
+void
+Ipv4FlowletTableHashTestCase::Collision (uint32_t flowId, uint32_t evictedFlowId)
+{
+  m_collisions++;
+  m_evicted = evictedFlowId;
+}
+
+void
+Ipv4FlowletTableHashTestCase::DoRun (void)
+{
+  // Four slots: every flow probes the whole table
+  Ptr<Ipv4FlowletTable> table = CreateObject<Ipv4FlowletTable> ();
+  table->SetAttribute ("Size", UintegerValue (3));
+  table->SetTimeout (MicroSeconds (50));
+  table->TraceConnectWithoutContext ("Collision", MakeCallback (&Ipv4FlowletTableHashTestCase::Collision, this));
+
+  NS_TEST_EXPECT_MSG_EQ ((table->Find (1) == 0), true, "Empty table has no entry");
+  for (uint32_t flowId = 1; flowId <= 4; flowId++)
+    {
+      Ipv4Flowlet *flowlet = table->Insert (flowId, MicroSeconds (flowId));
+      flowlet->port = flowId + 10;
+    }
+  NS_TEST_EXPECT_MSG_EQ (table->GetNEntries (), 4, "Size is rounded up to four slots");
+  for (uint32_t flowId = 1; flowId <= 4; flowId++)
+    {
+      Ipv4Flowlet *flowlet = table->Find (flowId);
+      NS_TEST_ASSERT_MSG_EQ ((flowlet != 0), true, "Flow " << flowId << " was inserted");
+      NS_TEST_EXPECT_MSG_EQ (flowlet->port, flowId + 10, "Flow " << flowId << " kept its port");
+    }
+
+  // All flowlets are active: the least recently active one is evicted
+  table->Insert (5, MicroSeconds (10));
+  NS_TEST_EXPECT_MSG_EQ (m_collisions, 1, "Active flowlet evicted");
+  NS_TEST_EXPECT_MSG_EQ (m_evicted, 1, "Least recently active flowlet evicted");
+  NS_TEST_EXPECT_MSG_EQ ((table->Find (1) == 0), true, "Evicted flow has no entry");
+  NS_TEST_EXPECT_MSG_EQ ((table->Find (5) != 0), true, "Inserted flow has an entry");
+
+  // Aged flowlets are reused silently
+  table->Insert (6, MicroSeconds (100));
+  NS_TEST_EXPECT_MSG_EQ (m_collisions, 1, "Aged flowlet reused without collision");
+  NS_TEST_EXPECT_MSG_EQ ((table->Find (6) != 0), true, "Inserted flow has an entry");
+  NS_TEST_EXPECT_MSG_EQ (table->GetNEntries (), 4, "Memory is bounded");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Flowlet table in Map mode.
+ */
+class Ipv4FlowletTableMapTestCase : public TestCase
+{
+public:
+  Ipv4FlowletTableMapTestCase ();
+  virtual void DoRun (void);
+};
+
+Ipv4FlowletTableMapTestCase::Ipv4FlowletTableMapTestCase ()
+  : TestCase ("Flowlet table in Map mode")
+{
+}
+
+void
+Ipv4FlowletTableMapTestCase::DoRun (void)
+{
+  Ptr<Ipv4FlowletTable> table = CreateObject<Ipv4FlowletTable> ();
+  table->SetAttribute ("Mode", EnumValue (Ipv4FlowletTable::FLOWLET_TABLE_MAP));
+  table->SetAttribute ("Size", UintegerValue (4));
+
+  for (uint32_t flowId = 1; flowId <= 100; flowId++)
+    {
+      table->Insert (flowId, MicroSeconds (0))->port = flowId;
+    }
+  NS_TEST_EXPECT_MSG_EQ (table->GetNEntries (), 100, "Map mode keeps every flow");
+  for (uint32_t flowId = 1; flowId <= 100; flowId++)
+    {
+      Ipv4Flowlet *flowlet = table->Find (flowId);
+      NS_TEST_ASSERT_MSG_EQ ((flowlet != 0), true, "Flow " << flowId << " was inserted");
+      NS_TEST_EXPECT_MSG_EQ (flowlet->port, flowId, "Flow " << flowId << " kept its port");
+    }
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Flowlet table TestSuite
+ */
+class Ipv4FlowletTableTestSuite : public TestSuite
+{
+public:
+  Ipv4FlowletTableTestSuite ();
+};
+
+Ipv4FlowletTableTestSuite::Ipv4FlowletTableTestSuite ()
+  : TestSuite ("ipv4-flowlet-table", UNIT)
+{
+  AddTestCase (new Ipv4FlowletTableHashTestCase, TestCase::QUICK);
+  AddTestCase (new Ipv4FlowletTableMapTestCase, TestCase::QUICK);
+}
+
+static Ipv4FlowletTableTestSuite g_ipv4FlowletTableTestSuite; //!< Static variable for test initialization
@@ -14,13 +14,18 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <set>
 #include <vector>
 #include "ns3/boolean.h"
 #include "ns3/config.h"
+#include "ns3/enum.h"
+#include "ns3/flow-id-tag.h"
 #include "ns3/inet-socket-address.h"
 #include "ns3/internet-stack-helper.h"
 #include "ns3/ipv4-address-helper.h"
 #include "ns3/ipv4-global-routing-helper.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/ipv4-route.h"
 #include "ns3/ipv4-static-routing-helper.h"
 #include "ns3/node.h"
 #include "ns3/node-container.h"
@@ -419,6 +424,247 @@ Ipv4GlobalRoutingSlash32TestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \brief Check that the compiled forwarding table of Ipv4GlobalRouting
+ * selects the same route as a linear scan of the route lists would.
+ */
+class Ipv4GlobalRoutingFibTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingFibTestCase ();
+  virtual ~Ipv4GlobalRoutingFibTestCase ();
+
+private:
+  /**
+   * \brief Look up a destination.
+   * \param dest the destination address
+   * \param oif the requested output device, or 0
+   * \return the output device of the selected route, or 0 if there is none
+   */
+  Ptr<NetDevice> Lookup (std::string dest, Ptr<NetDevice> oif);
+  virtual void DoRun (void);
+
+  Ptr<Ipv4GlobalRouting> m_routing;
+};
+
+Ipv4GlobalRoutingFibTestCase::Ipv4GlobalRoutingFibTestCase ()
+  : TestCase ("Global routing forwarding table lookups")
+{
+}
+
+Ipv4GlobalRoutingFibTestCase::~Ipv4GlobalRoutingFibTestCase ()
+{
+}
+
+Ptr<NetDevice>
+Ipv4GlobalRoutingFibTestCase::Lookup (std::string dest, Ptr<NetDevice> oif)
+{
+  Ipv4Header header;
+  header.SetDestination (Ipv4Address (dest.c_str ()));
+  Socket::SocketErrno sockerr;
+  Ptr<Ipv4Route> route = m_routing->RouteOutput (Create<Packet> (), header, oif, sockerr);
+  if (route == 0)
+    {
+      NS_TEST_EXPECT_MSG_EQ (sockerr, Socket::ERROR_NOROUTETOHOST, "Missing route not reported");
+      return 0;
+    }
+  return route->GetOutputDevice ();
+}
+
+void
+Ipv4GlobalRoutingFibTestCase::DoRun (void)
+{
+  NodeContainer c;
+  c.Create (2);
+
+  InternetStackHelper internet;
+  internet.Install (c);
+
+  SimpleNetDeviceHelper devHelper;
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("192.168.1.0", "255.255.255.0");
+  ipv4.Assign (devHelper.Install (c));
+  ipv4.SetBase ("192.168.2.0", "255.255.255.0");
+  ipv4.Assign (devHelper.Install (c));
+  ipv4.SetBase ("192.168.3.0", "255.255.255.0");
+  ipv4.Assign (devHelper.Install (c));
+
+  Ptr<Ipv4> ipv40 = c.Get (0)->GetObject<Ipv4> ();
+  m_routing = CreateObject<Ipv4GlobalRouting> ();
+  m_routing->SetIpv4 (ipv40);
+
+  m_routing->AddHostRouteTo (Ipv4Address ("10.9.0.1"), 1);
+  m_routing->AddHostRouteTo (Ipv4Address ("10.9.0.1"), 2);
+  m_routing->AddNetworkRouteTo (Ipv4Address ("10.9.0.0"), Ipv4Mask ("/16"), 3);
+  m_routing->AddNetworkRouteTo (Ipv4Address ("10.0.0.0"), Ipv4Mask ("/8"), 2);
+  m_routing->AddNetworkRouteTo (Ipv4Address ("10.9.1.0"), Ipv4Mask ("/24"), 1);
+
+  // Host routes win over network routes, the first ECMP member is used
+  NS_TEST_EXPECT_MSG_EQ (Lookup ("10.9.0.1", 0), ipv40->GetNetDevice (1), "Wrong host route");
+  NS_TEST_EXPECT_MSG_EQ (Lookup ("10.9.0.1", ipv40->GetNetDevice (2)), ipv40->GetNetDevice (2), "Wrong host route on requested device");
+  // No host route on the requested device: fall back to the network routes
+  NS_TEST_EXPECT_MSG_EQ (Lookup ("10.9.0.1", ipv40->GetNetDevice (3)), ipv40->GetNetDevice (3), "Wrong network route on requested device");
+  // Every matching network route is an ECMP member, in table order
+  NS_TEST_EXPECT_MSG_EQ (Lookup ("10.9.1.5", 0), ipv40->GetNetDevice (3), "Wrong network route for nested prefixes");
+  NS_TEST_EXPECT_MSG_EQ (Lookup ("10.9.1.5", ipv40->GetNetDevice (1)), ipv40->GetNetDevice (1), "Wrong nested network route on requested device");
+  NS_TEST_EXPECT_MSG_EQ (Lookup ("10.200.0.1", 0), ipv40->GetNetDevice (2), "Wrong network route");
+  NS_TEST_EXPECT_MSG_EQ (Lookup ("11.0.0.1", 0), Ptr<NetDevice> (0), "Unexpected route");
+
+  // Changing the table invalidates the compiled lookups
+  m_routing->RemoveRoute (0);
+  NS_TEST_EXPECT_MSG_EQ (Lookup ("10.9.0.1", 0), ipv40->GetNetDevice (2), "Removed host route still used");
+  m_routing->AddNetworkRouteTo (Ipv4Address ("11.0.0.0"), Ipv4Mask ("/8"), 3);
+  NS_TEST_EXPECT_MSG_EQ (Lookup ("11.0.0.1", 0), ipv40->GetNetDevice (3), "Added network route not used");
+
+  m_routing = 0;
+  Simulator::Destroy ();
+}
+
+
+/**
+ * \brief Check the per flow ECMP hashes of Ipv4GlobalRouting against
+ * reference values, and that the salt moves flows to other routes.
+ */
+class Ipv4GlobalRoutingEcmpHashTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingEcmpHashTestCase ();
+  virtual ~Ipv4GlobalRoutingEcmpHashTestCase ();
+
+private:
+  /**
+   * \brief Hash a flow.
+   * \param hash the hash function
+   * \param salt the salt
+   * \param flowId the flow id
+   * \param ttl the TTL
+   * \return the hash value
+   */
+  uint32_t Hash (Ipv4GlobalRouting::EcmpHash_e hash, uint32_t salt, uint32_t flowId, uint8_t ttl);
+  /**
+   * \brief Look up the route of a flow.
+   * \param flowId the flow id
+   * \return the output device of the selected route
+   */
+  Ptr<NetDevice> Lookup (uint32_t flowId);
+  virtual void DoRun (void);
+
+  Ptr<Ipv4GlobalRouting> m_routing;
+};
+
+Ipv4GlobalRoutingEcmpHashTestCase::Ipv4GlobalRoutingEcmpHashTestCase ()
+  : TestCase ("Global routing per flow ECMP hashes")
+{
+}
+
+Ipv4GlobalRoutingEcmpHashTestCase::~Ipv4GlobalRoutingEcmpHashTestCase ()
+{
+}
+
+uint32_t
+Ipv4GlobalRoutingEcmpHashTestCase::Hash (Ipv4GlobalRouting::EcmpHash_e hash, uint32_t salt, uint32_t flowId, uint8_t ttl)
+{
+  m_routing->SetAttribute ("EcmpHash", EnumValue (hash));
+  m_routing->SetAttribute ("EcmpHashSalt", UintegerValue (salt));
+  return m_routing->EcmpHash (flowId, ttl);
+}
+
+Ptr<NetDevice>
+Ipv4GlobalRoutingEcmpHashTestCase::Lookup (uint32_t flowId)
+{
+  Ptr<Packet> packet = Create<Packet> ();
+  packet->AddPacketTag (FlowIdTag (flowId));
+  Ipv4Header header;
+  header.SetDestination (Ipv4Address ("10.1.2.3"));
+  header.SetTtl (64);
+  Socket::SocketErrno sockerr;
+  Ptr<Ipv4Route> route = m_routing->RouteOutput (packet, header, 0, sockerr);
+  NS_TEST_EXPECT_MSG_NE (route, 0, "No route for flow " << flowId);
+  return route != 0 ? route->GetOutputDevice () : 0;
+}
+
+void
+Ipv4GlobalRoutingEcmpHashTestCase::DoRun (void)
+{
+  NodeContainer c;
+  c.Create (2);
+
+  InternetStackHelper internet;
+  internet.Install (c);
+
+  SimpleNetDeviceHelper devHelper;
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("192.168.1.0", "255.255.255.0");
+  ipv4.Assign (devHelper.Install (c));
+  ipv4.SetBase ("192.168.2.0", "255.255.255.0");
+  ipv4.Assign (devHelper.Install (c));
+  ipv4.SetBase ("192.168.3.0", "255.255.255.0");
+  ipv4.Assign (devHelper.Install (c));
+  ipv4.SetBase ("192.168.4.0", "255.255.255.0");
+  ipv4.Assign (devHelper.Install (c));
+
+  m_routing = CreateObject<Ipv4GlobalRouting> ();
+  m_routing->SetIpv4 (c.Get (0)->GetObject<Ipv4> ());
+
+  // Reference values of a flow: Murmur3 over "12345" and the TTL byte for
+  // String, and over the big endian salt, flow id and TTL for the others.
+  // The salt of 0xdeadbeef also rotates Crc32 and Toeplitz by 15 bits.
+  NS_TEST_EXPECT_MSG_EQ (Hash (Ipv4GlobalRouting::ECMP_HASH_STRING, 0, 12345, 64), 0x530cf135U, "Wrong String hash");
+  NS_TEST_EXPECT_MSG_EQ (Hash (Ipv4GlobalRouting::ECMP_HASH_CRC32, 0, 12345, 64), 0xba3a3d14U, "Wrong Crc32 hash");
+  NS_TEST_EXPECT_MSG_EQ (Hash (Ipv4GlobalRouting::ECMP_HASH_CRC32, 0xdeadbeef, 12345, 64), 0xe4246077U, "Wrong salted Crc32 hash");
+  NS_TEST_EXPECT_MSG_EQ (Hash (Ipv4GlobalRouting::ECMP_HASH_MURMUR3, 0, 12345, 64), 0x1d48e97fU, "Wrong Murmur3 hash");
+  NS_TEST_EXPECT_MSG_EQ (Hash (Ipv4GlobalRouting::ECMP_HASH_MURMUR3, 0xdeadbeef, 12345, 64), 0xbcac3288U, "Wrong salted Murmur3 hash");
+  NS_TEST_EXPECT_MSG_EQ (Hash (Ipv4GlobalRouting::ECMP_HASH_TOEPLITZ, 0, 12345, 64), 0xd07e01afU, "Wrong Toeplitz hash");
+  NS_TEST_EXPECT_MSG_EQ (Hash (Ipv4GlobalRouting::ECMP_HASH_TOEPLITZ, 0xdeadbeef, 12345, 64), 0x9656090eU, "Wrong salted Toeplitz hash");
+  // The RSS verification suite of the default key: 66.9.149.187 to
+  // 161.142.100.80, IPv4 addresses only, hashes to 0x323e8fc2.  A zero
+  // TTL adds nothing, the salt rotates the hash by 27 bits.
+  uint32_t rss = 0x323e8fc2U;
+  rss = (rss << 27) | (rss >> 5);
+  NS_TEST_EXPECT_MSG_EQ (Hash (Ipv4GlobalRouting::ECMP_HASH_TOEPLITZ, 0x420995bb, 0xa18e6450, 0), rss, "Wrong RSS hash");
+  // The String hash ignores the salt
+  NS_TEST_EXPECT_MSG_EQ (Hash (Ipv4GlobalRouting::ECMP_HASH_STRING, 0xdeadbeef, 12345, 64), 0x530cf135U, "Salted String hash");
+
+  // Four equal cost routes, as at two switches in a row.  The flows of
+  // one route at the first switch must spread over several routes at a
+  // switch with another salt, and the same salt keeps them on their route.
+  m_routing->SetAttribute ("PerflowEcmpRouting", BooleanValue (true));
+  for (uint32_t i = 1; i <= 4; i++)
+    {
+      m_routing->AddNetworkRouteTo (Ipv4Address ("10.1.0.0"), Ipv4Mask ("/16"), i);
+    }
+  Ipv4GlobalRouting::EcmpHash_e hashes[] = {
+    Ipv4GlobalRouting::ECMP_HASH_CRC32,
+    Ipv4GlobalRouting::ECMP_HASH_MURMUR3,
+    Ipv4GlobalRouting::ECMP_HASH_TOEPLITZ
+  };
+  for (uint32_t h = 0; h < sizeof (hashes) / sizeof (hashes[0]); h++)
+    {
+      m_routing->SetAttribute ("EcmpHash", EnumValue (hashes[h]));
+      Ptr<NetDevice> first = 0;
+      std::set<Ptr<NetDevice> > spread;
+      for (uint32_t flow = 1; flow <= 64; flow++)
+        {
+          m_routing->SetAttribute ("EcmpHashSalt", UintegerValue (0));
+          Ptr<NetDevice> unsalted = Lookup (flow);
+          NS_TEST_EXPECT_MSG_EQ (Lookup (flow), unsalted, "Flow " << flow << " changed route with the same salt");
+          if (first == 0)
+            {
+              first = unsalted;
+            }
+          if (unsalted == first)
+            {
+              m_routing->SetAttribute ("EcmpHashSalt", UintegerValue (0xdeadbeef));
+              spread.insert (Lookup (flow));
+            }
+        }
+      NS_TEST_EXPECT_MSG_GT (spread.size (), 1, "The salt did not spread the flows of a route with hash " << hashes[h]);
+    }
+
+  m_routing = 0;
+  Simulator::Destroy ();
+}
+
 
 class Ipv4GlobalRoutingTestSuite : public TestSuite
 {
@@ -431,6 +677,8 @@ Ipv4GlobalRoutingTestSuite::Ipv4GlobalRoutingTestSuite ()
 {
   AddTestCase (new Ipv4DynamicGlobalRoutingTestCase, TestCase::QUICK);
   AddTestCase (new Ipv4GlobalRoutingSlash32TestCase, TestCase::QUICK);
+  AddTestCase (new Ipv4GlobalRoutingFibTestCase, TestCase::QUICK);
+  AddTestCase (new Ipv4GlobalRoutingEcmpHashTestCase, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite
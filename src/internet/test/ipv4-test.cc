@@ -137,6 +137,37 @@ Ipv4L3ProtocolTestCase::DoRun (void)
   num = interface->GetNAddresses ();
   NS_TEST_ASSERT_MSG_EQ (num, 1, "Should find 1 addresses??");
 
+  /* Look up the interfaces of the devices */
+  Ptr<Ipv4Interface> interface2 = CreateObject<Ipv4Interface> ();
+  Ptr<LoopbackNetDevice> device2 = CreateObject<LoopbackNetDevice> ();
+  node->AddDevice (device2);
+  interface2->SetDevice (device2);
+  interface2->SetNode (node);
+  uint32_t index2 = ipv4->AddIpv4Interface (interface2);
+  NS_TEST_ASSERT_MSG_EQ (ipv4->GetInterfaceForDevice (device), static_cast<int32_t> (index),
+                         "Wrong interface for the first device??");
+  NS_TEST_ASSERT_MSG_EQ (ipv4->GetInterfaceForDevice (device2), static_cast<int32_t> (index2),
+                         "Wrong interface for the second device??");
+
+  /* A device of another node with the same index */
+  Ptr<Node> node2 = CreateObject<Node> ();
+  Ptr<LoopbackNetDevice> device3 = CreateObject<LoopbackNetDevice> ();
+  node2->AddDevice (device3);
+  NS_TEST_ASSERT_MSG_EQ (ipv4->GetInterfaceForDevice (device3), -1,
+                         "Found the device of another node??");
+
+  /* A device given to IPv4 before its node indexed it */
+  Ptr<Ipv4Interface> interface4 = CreateObject<Ipv4Interface> ();
+  Ptr<LoopbackNetDevice> device4 = CreateObject<LoopbackNetDevice> ();
+  interface4->SetDevice (device4);
+  interface4->SetNode (node);
+  uint32_t index4 = ipv4->AddIpv4Interface (interface4);
+  node->AddDevice (device4);
+  NS_TEST_ASSERT_MSG_EQ (ipv4->GetInterfaceForDevice (device), static_cast<int32_t> (index),
+                         "Wrong interface for the first device??");
+  NS_TEST_ASSERT_MSG_EQ (ipv4->GetInterfaceForDevice (device4), static_cast<int32_t> (index4),
+                         "Wrong interface for a device indexed late??");
+
   Simulator::Destroy ();
 }
 
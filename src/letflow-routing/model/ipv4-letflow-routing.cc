@@ -5,9 +5,10 @@
 #include "ns3/log.h"
 #include "ns3/simulator.h"
 #include "ns3/net-device.h"
-#include "ns3/channel.h"
+#include "ns3/ipv4-egress-route-cache.h"
 #include "ns3/node.h"
 #include "ns3/flow-id-tag.h"
+#include "ns3/pointer.h"
 
 #include <algorithm>
 
@@ -22,6 +23,9 @@ Ipv4LetFlowRouting::Ipv4LetFlowRouting ():
     m_ipv4 (0)
 {
   NS_LOG_FUNCTION (this);
+  m_flowletTable = CreateObject<Ipv4FlowletTable> ();
+  m_flowletTable->SetTimeout (m_flowletTimeout);
+  m_rand = CreateObject<UniformRandomVariable> ();
 }
 
 Ipv4LetFlowRouting::~Ipv4LetFlowRouting ()
@@ -36,11 +40,23 @@ Ipv4LetFlowRouting::GetTypeId (void)
       .SetParent<Object>()
       .SetGroupName ("Internet")
       .AddConstructor<Ipv4LetFlowRouting> ()
+      .AddAttribute ("FlowletTable", "The flowlet table",
+                     PointerValue (),
+                     MakePointerAccessor (&Ipv4LetFlowRouting::m_flowletTable),
+                     MakePointerChecker<Ipv4FlowletTable> ())
   ;
 
   return tid;
 }
 
+int64_t
+Ipv4LetFlowRouting::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  m_rand->SetStream (stream);
+  return 1;
+}
+
 void
 Ipv4LetFlowRouting::AddRoute (Ipv4Address network, Ipv4Mask networkMask, uint32_t port)
 {
@@ -50,6 +66,7 @@ Ipv4LetFlowRouting::AddRoute (Ipv4Address network, Ipv4Mask networkMask, uint32_
   letFlowRouteEntry.networkMask = networkMask;
   letFlowRouteEntry.port = port;
   m_routeEntryList.push_back (letFlowRouteEntry);
+  m_portTable.AddRoute (network, networkMask, port);
 }
 
 std::vector<LetFlowRouteEntry>
@@ -70,17 +87,7 @@ Ipv4LetFlowRouting::LookupLetFlowRouteEntries (Ipv4Address dest)
 Ptr<Ipv4Route>
 Ipv4LetFlowRouting::ConstructIpv4Route (uint32_t port, Ipv4Address destAddress)
 {
-  Ptr<NetDevice> dev = m_ipv4->GetNetDevice (port);
-  Ptr<Channel> channel = dev->GetChannel ();
-  uint32_t otherEnd = (channel->GetDevice (0) == dev) ? 1 : 0;
-  Ptr<Node> nextHop = channel->GetDevice (otherEnd)->GetNode ();
-  uint32_t nextIf = channel->GetDevice (otherEnd)->GetIfIndex ();
-  Ipv4Address nextHopAddr = nextHop->GetObject<Ipv4>()->GetAddress(nextIf,0).GetLocal();
-  Ptr<Ipv4Route> route = Create<Ipv4Route> ();
-  route->SetOutputDevice (m_ipv4->GetNetDevice (port));
-  route->SetGateway (nextHopAddr);
-  route->SetSource (m_ipv4->GetAddress (port, 0).GetLocal ());
-  route->SetDestination (destAddress);
+  Ptr<Ipv4Route> route = m_routeCache->GetRoute (port);
   return route;
 }
 
@@ -88,6 +95,7 @@ void
 Ipv4LetFlowRouting::SetFlowletTimeout (Time timeout)
 {
   m_flowletTimeout = timeout;
+  m_flowletTable->SetTimeout (timeout);
 }
 
 Ptr<Ipv4Route>
@@ -140,9 +148,9 @@ Ipv4LetFlowRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, P
   }
   flowId = flowIdTag.GetFlowId ();
 
-  std::vector<LetFlowRouteEntry> routeEntries = Ipv4LetFlowRouting::LookupLetFlowRouteEntries (destAddress);
+  const Ipv4EgressPortTable::PortList &ports = m_portTable.Lookup (destAddress);
 
-  if (routeEntries.empty ())
+  if (ports.empty ())
   {
     NS_LOG_ERROR (this << " LetFlow routing cannot find routing entry");
     ecb (packet, header, Socket::ERROR_NOROUTETOHOST);
@@ -152,61 +160,71 @@ Ipv4LetFlowRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, P
   uint32_t selectedPort;
 
   // If the flowlet table entry is valid, return the port
-  std::map<uint32_t, struct LetFlowFlowlet>::iterator flowletItr = m_flowletTable.find (flowId);
-  if (flowletItr != m_flowletTable.end ())
+  Ipv4Flowlet *flowlet = m_flowletTable->Find (flowId);
+  if (flowlet != 0 && now - flowlet->activeTime <= m_flowletTimeout)
   {
-    LetFlowFlowlet flowlet = flowletItr->second;
-    if (now - flowlet.activeTime <= m_flowletTimeout)
-    {
-      // Do not forget to update the flowlet active time
-      flowlet.activeTime = now;
+    // Do not forget to update the flowlet active time
+    flowlet->activeTime = now;
 
-      // Return the port information used for routing routine to select the port
-      selectedPort = flowlet.port;
+    // Return the port information used for routing routine to select the port
+    selectedPort = flowlet->port;
 
-      Ptr<Ipv4Route> route = Ipv4LetFlowRouting::ConstructIpv4Route (selectedPort, destAddress);
-      ucb (route, packet, header);
-
-      m_flowletTable[flowId] = flowlet;
-
-      return true;
+    Ptr<Ipv4Route> route = Ipv4LetFlowRouting::ConstructIpv4Route (selectedPort, destAddress);
+    if (route == 0)
+    {
+      NS_LOG_LOGIC (this << " No usable next hop on port: " << selectedPort);
+      ecb (packet, header, Socket::ERROR_NOROUTETOHOST);
+      return false;
     }
+    ucb (route, packet, header);
+
+    return true;
   }
 
   // Not hit. Random Select the Port
-  selectedPort = routeEntries[rand () % routeEntries.size ()].port;
+  selectedPort = ports[m_rand->GetInteger (0, ports.size () - 1)];
 
-  LetFlowFlowlet flowlet;
-
-  flowlet.port = selectedPort;
-  flowlet.activeTime = now;
+  if (flowlet == 0)
+  {
+    flowlet = m_flowletTable->Insert (flowId, now);
+  }
+  flowlet->port = selectedPort;
+  flowlet->activeTime = now;
 
   Ptr<Ipv4Route> route = Ipv4LetFlowRouting::ConstructIpv4Route (selectedPort, destAddress);
+  if (route == 0)
+  {
+    NS_LOG_LOGIC (this << " No usable next hop on port: " << selectedPort);
+    ecb (packet, header, Socket::ERROR_NOROUTETOHOST);
+    return false;
+  }
   ucb (route, packet, header);
 
-  m_flowletTable[flowId] = flowlet;
-
   return true;
 }
 
 void
 Ipv4LetFlowRouting::NotifyInterfaceUp (uint32_t interface)
 {
+  m_routeCache->Refresh (interface);
 }
 
 void
 Ipv4LetFlowRouting::NotifyInterfaceDown (uint32_t interface)
 {
+  m_routeCache->Invalidate (interface);
 }
 
 void
 Ipv4LetFlowRouting::NotifyAddAddress (uint32_t interface, Ipv4InterfaceAddress address)
 {
+  m_routeCache->Refresh (interface);
 }
 
 void
 Ipv4LetFlowRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress address)
 {
+  m_routeCache->Invalidate (interface);
 }
 
 void
@@ -215,6 +233,7 @@ Ipv4LetFlowRouting::SetIpv4 (Ptr<Ipv4> ipv4)
   NS_LOG_LOGIC (this << "Setting up Ipv4: " << ipv4);
   NS_ASSERT (m_ipv4 == 0 && ipv4 != 0);
   m_ipv4 = ipv4;
+  m_routeCache = Ipv4EgressRouteCache::GetCache (ipv4);
 }
 
 void
@@ -227,6 +246,9 @@ void
 Ipv4LetFlowRouting::DoDispose (void)
 {
   m_ipv4=0;
+  m_routeCache = 0;
+  m_flowletTable = 0;
+  m_rand = 0;
   Ipv4RoutingProtocol::DoDispose ();
 }
 
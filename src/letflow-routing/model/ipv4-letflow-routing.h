@@ -3,6 +3,9 @@
 #define IPV4_LETFLOW_ROUTING_H
 
 #include "ns3/ipv4-routing-protocol.h"
+#include "ns3/ipv4-egress-route-cache.h"
+#include "ns3/ipv4-egress-port-table.h"
+#include "ns3/ipv4-flowlet-table.h"
 #include "ns3/ipv4-route.h"
 #include "ns3/object.h"
 #include "ns3/packet.h"
@@ -10,14 +13,10 @@
 #include "ns3/data-rate.h"
 #include "ns3/nstime.h"
 #include "ns3/event-id.h"
+#include "ns3/random-variable-stream.h"
 
 namespace ns3 {
 
-struct LetFlowFlowlet {
-  uint32_t port;
-  Time activeTime;
-};
-
 struct LetFlowRouteEntry {
   Ipv4Address network;
   Ipv4Mask networkMask;
@@ -53,6 +52,16 @@ public:
 
   void SetFlowletTimeout (Time timeout);
 
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by this model.  Return the number of streams (possibly zero) that
+   * have been assigned.
+   *
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned by this model
+   */
+  int64_t AssignStreams (int64_t stream);
+
 private:
   // Flowlet Timeout
   Time m_flowletTimeout;
@@ -60,11 +69,20 @@ private:
   // Ipv4 associated with this router
   Ptr<Ipv4> m_ipv4;
 
+  // Routes through each port, shared with the other routing protocols of the node
+  Ptr<Ipv4EgressRouteCache> m_routeCache;
+
   // Flowlet Table
-  std::map<uint32_t, LetFlowFlowlet> m_flowletTable;
+  Ptr<Ipv4FlowletTable> m_flowletTable;
 
   // Route table
   std::vector<LetFlowRouteEntry> m_routeEntryList;
+
+  // Ports reaching each destination, compiled from the route table
+  Ipv4EgressPortTable m_portTable;
+
+  // Draws the port of the new flowlets
+  Ptr<UniformRandomVariable> m_rand;
 };
 
 }
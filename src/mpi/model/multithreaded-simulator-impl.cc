@@ -0,0 +1,873 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "multithreaded-simulator-impl.h"
+
+#include "ns3/simulator.h"
+#include "ns3/make-event.h"
+#include "ns3/uinteger.h"
+#include "ns3/nstime.h"
+#include "ns3/node.h"
+#include "ns3/node-list.h"
+#include "ns3/net-device.h"
+#include "ns3/channel.h"
+#include "ns3/packet-metadata.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <limits>
+#include <sched.h>
+#include <unistd.h>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MultithreadedSimulatorImpl");
+
+NS_OBJECT_ENSURE_REGISTERED (MultithreadedSimulatorImpl);
+
+namespace {
+
+/// Timestamp of no event
+const uint64_t NO_EVENT = std::numeric_limits<uint64_t>::max ();
+
+/// Context of the events which are not attached to a node
+const uint32_t NO_CONTEXT = 0xffffffff;
+
+/// Partition running the current event of each thread
+__thread void *g_current = 0;
+
+} // anonymous namespace
+
+TypeId
+MultithreadedSimulatorImpl::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MultithreadedSimulatorImpl")
+    .SetParent<SimulatorImpl> ()
+    .SetGroupName ("Mpi")
+    .AddConstructor<MultithreadedSimulatorImpl> ()
+    .AddAttribute ("ThreadCount",
+                   "Number of threads running the nodes, 0 for one per processor. "
+                   "The nodes created with a system id are run by the thread of "
+                   "that index.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&MultithreadedSimulatorImpl::m_threadCount),
+                   MakeUintegerChecker<uint32_t> ())
+  ;
+  return tid;
+}
+
+MultithreadedSimulatorImpl::MultithreadedSimulatorImpl ()
+  : m_threadCount (0),
+    m_nThreads (1),
+    m_lookahead (0),
+    m_mainChild (0),
+    m_nextRank (1),
+    m_windowBase (0),
+    m_windowEnd (0),
+    m_window (0),
+    m_sequential (true),
+    m_running (false),
+    m_stop (false),
+    m_currentTs (0),
+    m_currentContext (NO_CONTEXT),
+    m_uid (4),
+    m_nextWorker (0),
+    m_barrierArrived (0),
+    m_barrierGeneration (0)
+{
+  NS_LOG_FUNCTION (this);
+  // uids 0 to 3 have a special meaning, see DefaultSimulatorImpl
+  m_mainOrigin = new Origin ();
+  m_mainOrigin->rank = 0;
+  m_mainOrigin->ts = 0;
+  m_mainOrigin->parent = 0;
+  m_mainOrigin->child = 0;
+  m_mainOrigin->refs = 1;
+  m_main = SystemThread::Self ();
+}
+
+MultithreadedSimulatorImpl::~MultithreadedSimulatorImpl ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+MultithreadedSimulatorImpl::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (std::vector<Event>::iterator i = m_pending.begin (); i != m_pending.end (); ++i)
+    {
+      i->impl->Unref ();
+      UnrefOrigin (i->origin);
+    }
+  m_pending.clear ();
+  for (std::vector<DestroyEvent>::iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); ++i)
+    {
+      UnrefOrigin (i->origin);
+    }
+  m_destroyEvents.clear ();
+  if (m_mainOrigin != 0)
+    {
+      UnrefOrigin (m_mainOrigin);
+      m_mainOrigin = 0;
+    }
+  SimulatorImpl::DoDispose ();
+}
+
+bool
+MultithreadedSimulatorImpl::EventLater::operator () (const Event &a, const Event &b) const
+{
+  if (a.ts != b.ts)
+    {
+      return a.ts > b.ts;
+    }
+  if (a.origin != b.origin)
+    {
+      return a.origin->rank > b.origin->rank;
+    }
+  return a.child > b.child;
+}
+
+bool
+MultithreadedSimulatorImpl::OriginLater::operator () (const OriginHead &a, const OriginHead &b) const
+{
+  const Origin *x = a.first;
+  const Origin *y = b.first;
+  if (x->ts != y->ts)
+    {
+      return x->ts > y->ts;
+    }
+  if (x->parent != y->parent)
+    {
+      return x->parent->rank > y->parent->rank;
+    }
+  return x->child > y->child;
+}
+
+MultithreadedSimulatorImpl::Origin *
+MultithreadedSimulatorImpl::RefOrigin (Origin *origin)
+{
+  __atomic_add_fetch (&origin->refs, 1, __ATOMIC_RELAXED);
+  return origin;
+}
+
+void
+MultithreadedSimulatorImpl::UnrefOrigin (Origin *origin)
+{
+  while (origin != 0 && __atomic_sub_fetch (&origin->refs, 1, __ATOMIC_ACQ_REL) == 0)
+    {
+      Origin *parent = origin->parent;
+      delete origin;
+      origin = parent;
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Destroy ()
+{
+  NS_LOG_FUNCTION (this);
+  // Run the events in the order they were scheduled, including the ones
+  // they schedule themselves
+  std::sort (m_destroyEvents.begin (), m_destroyEvents.end (), DestroyEventEarlier ());
+  for (uint32_t i = 0; i < m_destroyEvents.size (); i++)
+    {
+      EventId id = m_destroyEvents[i].id;
+      Ptr<EventImpl> ev = id.PeekEventImpl ();
+      NS_LOG_LOGIC ("handle destroy " << ev);
+      if (!ev->IsCancelled ())
+        {
+          ev->Invoke ();
+          ev->Cancel ();
+        }
+    }
+  for (std::vector<DestroyEvent>::iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); ++i)
+    {
+      UnrefOrigin (i->origin);
+    }
+  m_destroyEvents.clear ();
+}
+
+bool
+MultithreadedSimulatorImpl::DestroyEventEarlier::operator () (const DestroyEvent &a, const DestroyEvent &b) const
+{
+  if (a.origin != b.origin)
+    {
+      return a.origin->rank < b.origin->rank;
+    }
+  return a.child < b.child;
+}
+
+bool
+MultithreadedSimulatorImpl::IsFinished (void) const
+{
+  return m_stop || (m_partitions.empty () && m_pending.empty ());
+}
+
+void
+MultithreadedSimulatorImpl::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+  __atomic_store_n (&m_stop, true, __ATOMIC_RELAXED);
+}
+
+void
+MultithreadedSimulatorImpl::Stop (Time const &delay)
+{
+  NS_LOG_FUNCTION (this << delay.GetTimeStep ());
+  // Stop between the nodes, whatever the caller
+  Insert (NO_CONTEXT, delay, MakeEvent (&Simulator::Stop));
+}
+
+EventId
+MultithreadedSimulatorImpl::Schedule (Time const &delay, EventImpl *event)
+{
+  return Insert (GetContext (), delay, event);
+}
+
+void
+MultithreadedSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay, EventImpl *event)
+{
+  Insert (context, delay, event);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleNow (EventImpl *event)
+{
+  return Insert (GetContext (), TimeStep (0), event);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleDestroy (EventImpl *event)
+{
+  Partition *p = GetCurrent ();
+  DestroyEvent ev;
+  ev.id = EventId (Ptr<EventImpl> (event, false), Now ().GetTimeStep (), NO_CONTEXT, 2);
+  if (p == 0)
+    {
+      NS_ASSERT_MSG (SystemThread::Equals (m_main), "Simulator::ScheduleDestroy Thread-unsafe invocation!");
+      ev.origin = RefOrigin (m_mainOrigin);
+      ev.child = m_mainChild++;
+      m_destroyEvents.push_back (ev);
+    }
+  else
+    {
+      ev.origin = RefOrigin (GetOrigin (p));
+      ev.child = p->nextChild++;
+      p->destroyEvents.push_back (ev);
+    }
+  return ev.id;
+}
+
+EventId
+MultithreadedSimulatorImpl::Insert (uint32_t context, Time const &delay, EventImpl *event)
+{
+  NS_ASSERT (delay.IsPositive ());
+  Partition *p = GetCurrent ();
+  Event ev;
+  ev.impl = event;
+  ev.context = context;
+  uint32_t uid;
+  if (p == 0)
+    {
+      // Main program, between the runs
+      NS_ASSERT_MSG (SystemThread::Equals (m_main), "Simulator::Schedule Thread-unsafe invocation!");
+      ev.ts = m_currentTs + delay.GetTimeStep ();
+      ev.origin = RefOrigin (m_mainOrigin);
+      ev.child = m_mainChild++;
+      m_pending.push_back (ev);
+      uid = m_uid++;
+    }
+  else
+    {
+      ev.ts = p->currentTs + delay.GetTimeStep ();
+      ev.origin = RefOrigin (GetOrigin (p));
+      ev.child = p->nextChild++;
+      Partition *target = GetPartition (context);
+      if (target == p || m_sequential)
+        {
+          target->events.push_back (ev);
+          std::push_heap (target->events.begin (), target->events.end (), EventLater ());
+        }
+      else
+        {
+          if (ev.ts < m_windowEnd)
+            {
+              NS_FATAL_ERROR ("Event scheduled in context " << context << " at " << ev.ts <<
+                              " from context " << p->currentContext << " at " << p->currentTs <<
+                              ", before the end of the window at " << m_windowEnd <<
+                              ": the nodes of different threads must only interact "
+                              "through channels with a Delay attribute");
+            }
+          p->outbox[m_window & 1][target->index].push_back (ev);
+          p->minSent = std::min (p->minSent, ev.ts);
+        }
+      uid = p->uid++;
+    }
+  return EventId (event, ev.ts, context, uid);
+}
+
+MultithreadedSimulatorImpl::Origin *
+MultithreadedSimulatorImpl::GetOrigin (Partition *p)
+{
+  if (p->currentOrigin == 0)
+    {
+      Origin *origin = new Origin ();
+      origin->ts = p->currentTs;
+      origin->child = p->currentChild;
+      origin->refs = 1;
+      if (m_sequential)
+        {
+          origin->rank = m_nextRank++;
+          origin->parent = 0;
+        }
+      else
+        {
+          // Keeps the order of the partition until SettleRanks
+          origin->rank = m_windowBase + p->origins.size ();
+          origin->parent = RefOrigin (p->currentParent);
+          p->origins.push_back (origin);
+        }
+      p->currentOrigin = origin;
+    }
+  return p->currentOrigin;
+}
+
+void
+MultithreadedSimulatorImpl::Remove (const EventId &id)
+{
+  // The events are left in the heaps, and skipped when they expire
+  Cancel (id);
+}
+
+void
+MultithreadedSimulatorImpl::Cancel (const EventId &id)
+{
+  if (!IsExpired (id))
+    {
+      id.PeekEventImpl ()->Cancel ();
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsExpired (const EventId &id) const
+{
+  // The events are cancelled once run
+  EventImpl *ev = id.PeekEventImpl ();
+  if (ev == 0 || ev->IsCancelled ())
+    {
+      return true;
+    }
+  Partition *p = GetCurrent ();
+  return id.GetUid () != 2 && p != 0 && p->currentEvent == ev;
+}
+
+Time
+MultithreadedSimulatorImpl::Now (void) const
+{
+  // Do not add function logging here, to avoid stack overflow
+  Partition *p = GetCurrent ();
+  return TimeStep (p != 0 ? p->currentTs : m_currentTs);
+}
+
+Time
+MultithreadedSimulatorImpl::GetDelayLeft (const EventId &id) const
+{
+  if (IsExpired (id))
+    {
+      return TimeStep (0);
+    }
+  return TimeStep (id.GetTs () - Now ().GetTimeStep ());
+}
+
+Time
+MultithreadedSimulatorImpl::GetMaximumSimulationTime (void) const
+{
+  return TimeStep (0x7fffffffffffffffLL);
+}
+
+void
+MultithreadedSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
+{
+  NS_LOG_FUNCTION (this << schedulerFactory);
+  NS_LOG_WARN ("MultithreadedSimulatorImpl keeps the events of each thread in a binary heap, "
+               "the scheduler is ignored");
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetSystemId (void) const
+{
+  return 0;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetContext (void) const
+{
+  Partition *p = GetCurrent ();
+  return p != 0 ? p->currentContext : m_currentContext;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetNThreads (void) const
+{
+  return m_nThreads;
+}
+
+Time
+MultithreadedSimulatorImpl::GetLookahead (void) const
+{
+  return m_lookahead;
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::GetPartition (uint32_t context) const
+{
+  if (context < m_nodePartition.size ())
+    {
+      return m_partitions[m_nodePartition[context]];
+    }
+  return m_partitions.back ();
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::GetCurrent (void) const
+{
+  return static_cast<Partition *> (g_current);
+}
+
+void
+MultithreadedSimulatorImpl::AssignPartitions (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t nNodes = NodeList::GetNNodes ();
+  std::vector<std::vector<uint32_t> > neighbours (nNodes);
+  uint32_t maxSystemId = 0;
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      Ptr<Node> node = NodeList::GetNode (i);
+      maxSystemId = std::max (maxSystemId, node->GetSystemId ());
+      for (uint32_t d = 0; d < node->GetNDevices (); d++)
+        {
+          Ptr<Channel> channel = node->GetDevice (d)->GetChannel ();
+          if (channel == 0)
+            {
+              continue;
+            }
+          for (uint32_t j = 0; j < channel->GetNDevices (); j++)
+            {
+              uint32_t other = channel->GetDevice (j)->GetNode ()->GetId ();
+              if (other != i)
+                {
+                  neighbours[i].push_back (other);
+                }
+            }
+        }
+      std::sort (neighbours[i].begin (), neighbours[i].end ());
+      neighbours[i].erase (std::unique (neighbours[i].begin (), neighbours[i].end ()), neighbours[i].end ());
+    }
+
+  uint32_t nThreads = m_threadCount;
+  if (nThreads == 0)
+    {
+      nThreads = maxSystemId > 0 ? maxSystemId + 1 : std::max (sysconf (_SC_NPROCESSORS_ONLN), 1L);
+    }
+  m_nodePartition.assign (nNodes, 0);
+  if (maxSystemId > 0)
+    {
+      if (maxSystemId >= nThreads)
+        {
+          NS_FATAL_ERROR ("Node system id " << maxSystemId << " but only " << nThreads << " threads");
+        }
+      for (uint32_t i = 0; i < nNodes; i++)
+        {
+          m_nodePartition[i] = NodeList::GetNode (i)->GetSystemId ();
+        }
+      m_nThreads = nThreads;
+    }
+  else
+    {
+      // The nodes with a single neighbour follow it, the others are spread
+      // over the threads, the heaviest first
+      std::vector<uint32_t> weight (nNodes, 0);
+      std::vector<std::pair<uint32_t, uint32_t> > roots;
+      for (uint32_t i = 0; i < nNodes; i++)
+        {
+          if (neighbours[i].size () == 1 && neighbours[neighbours[i][0]].size () > 1)
+            {
+              weight[neighbours[i][0]]++;
+            }
+        }
+      for (uint32_t i = 0; i < nNodes; i++)
+        {
+          if (!(neighbours[i].size () == 1 && neighbours[neighbours[i][0]].size () > 1))
+            {
+              // sorted by decreasing weight, then by id
+              roots.push_back (std::make_pair (std::numeric_limits<uint32_t>::max () - weight[i], i));
+            }
+        }
+      std::sort (roots.begin (), roots.end ());
+      m_nThreads = std::max<uint32_t> (1, std::min<uint32_t> (nThreads, roots.size ()));
+      std::vector<uint32_t> load (m_nThreads, 0);
+      for (std::vector<std::pair<uint32_t, uint32_t> >::const_iterator it = roots.begin (); it != roots.end (); ++it)
+        {
+          uint32_t thread = std::min_element (load.begin (), load.end ()) - load.begin ();
+          m_nodePartition[it->second] = thread;
+          load[thread] += 1 + weight[it->second];
+        }
+      for (uint32_t i = 0; i < nNodes; i++)
+        {
+          if (neighbours[i].size () == 1 && neighbours[neighbours[i][0]].size () > 1)
+            {
+              m_nodePartition[i] = m_nodePartition[neighbours[i][0]];
+            }
+        }
+    }
+
+  // The lookahead is the smallest delay between two partitions
+  uint64_t lookahead = NO_EVENT;
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      Ptr<Node> node = NodeList::GetNode (i);
+      for (uint32_t d = 0; d < node->GetNDevices (); d++)
+        {
+          Ptr<Channel> channel = node->GetDevice (d)->GetChannel ();
+          if (channel == 0)
+            {
+              continue;
+            }
+          for (uint32_t j = 0; j < channel->GetNDevices (); j++)
+            {
+              uint32_t other = channel->GetDevice (j)->GetNode ()->GetId ();
+              if (m_nodePartition[other] == m_nodePartition[i])
+                {
+                  continue;
+                }
+              TimeValue delay;
+              if (!channel->GetAttributeFailSafe ("Delay", delay))
+                {
+                  NS_FATAL_ERROR ("Channel " << channel->GetInstanceTypeId ().GetName () <<
+                                  " between nodes " << i << " and " << other <<
+                                  " of different threads has no Delay attribute");
+                }
+              lookahead = std::min<uint64_t> (lookahead, delay.Get ().GetTimeStep ());
+            }
+        }
+    }
+  if (lookahead == 0)
+    {
+      NS_FATAL_ERROR ("A channel between nodes of different threads has no delay");
+    }
+  m_lookahead = TimeStep (std::min<uint64_t> (lookahead, 0x7fffffffffffffffLL));
+  NS_LOG_LOGIC ("run " << nNodes << " nodes on " << m_nThreads << " threads, lookahead " << m_lookahead);
+
+  // The partition of the events without node comes last
+  for (uint32_t i = 0; i <= m_nThreads; i++)
+    {
+      Partition *p = new Partition ();
+      p->index = i;
+      p->outbox[0].resize (m_nThreads + 1);
+      p->outbox[1].resize (m_nThreads + 1);
+      p->minSent = NO_EVENT;
+      p->currentTs = m_currentTs;
+      p->currentContext = NO_CONTEXT;
+      p->currentEvent = 0;
+      p->currentParent = 0;
+      p->currentChild = 0;
+      p->currentOrigin = 0;
+      p->nextChild = 0;
+      p->uid = 4;
+      m_partitions.push_back (p);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Invoke (Partition *p, const Event &ev)
+{
+  NS_ASSERT (ev.ts >= p->currentTs);
+  p->currentTs = ev.ts;
+  p->currentContext = ev.context;
+  p->currentEvent = ev.impl;
+  p->currentParent = ev.origin;
+  p->currentChild = ev.child;
+  p->currentOrigin = 0;
+  p->nextChild = 0;
+  ev.impl->Invoke ();
+  ev.impl->Cancel ();
+  p->currentEvent = 0;
+  if (m_sequential && p->currentOrigin != 0)
+    {
+      UnrefOrigin (p->currentOrigin);
+    }
+  p->currentOrigin = 0;
+  ev.impl->Unref ();
+  UnrefOrigin (ev.origin);
+}
+
+void
+MultithreadedSimulatorImpl::Drain (Partition *p, uint32_t parity)
+{
+  for (std::vector<Partition *>::const_iterator src = m_partitions.begin (); src != m_partitions.end (); ++src)
+    {
+      std::vector<Event> &inbox = (*src)->outbox[parity][p->index];
+      for (std::vector<Event>::const_iterator ev = inbox.begin (); ev != inbox.end (); ++ev)
+        {
+          p->events.push_back (*ev);
+          std::push_heap (p->events.begin (), p->events.end (), EventLater ());
+        }
+      inbox.clear ();
+    }
+}
+
+void
+MultithreadedSimulatorImpl::RunWindow (Partition *p)
+{
+  g_current = p;
+  Drain (p, (m_window + 1) & 1);
+  p->minSent = NO_EVENT;
+  while (!p->events.empty () && p->events.front ().ts < m_windowEnd)
+    {
+      std::pop_heap (p->events.begin (), p->events.end (), EventLater ());
+      Event ev = p->events.back ();
+      p->events.pop_back ();
+      Invoke (p, ev);
+      if (__atomic_load_n (&m_stop, __ATOMIC_RELAXED))
+        {
+          break;
+        }
+    }
+  g_current = 0;
+}
+
+void
+MultithreadedSimulatorImpl::RunStep (uint64_t ts)
+{
+  m_sequential = true;
+  for (std::vector<Partition *>::const_iterator p = m_partitions.begin (); p != m_partitions.end (); ++p)
+    {
+      Drain (*p, 0);
+      Drain (*p, 1);
+      (*p)->minSent = NO_EVENT;
+    }
+  while (!m_stop)
+    {
+      // The earliest event of the timestamp, whatever its partition
+      Partition *next = 0;
+      for (std::vector<Partition *>::const_iterator p = m_partitions.begin (); p != m_partitions.end (); ++p)
+        {
+          if (!(*p)->events.empty () && (*p)->events.front ().ts == ts &&
+              (next == 0 || EventLater () (next->events.front (), (*p)->events.front ())))
+            {
+              next = *p;
+            }
+        }
+      if (next == 0)
+        {
+          break;
+        }
+      std::pop_heap (next->events.begin (), next->events.end (), EventLater ());
+      Event ev = next->events.back ();
+      next->events.pop_back ();
+      g_current = next;
+      Invoke (next, ev);
+      g_current = 0;
+    }
+  m_sequential = false;
+}
+
+void
+MultithreadedSimulatorImpl::SettleRanks (void)
+{
+  // Merge the origins of the partitions in the order of their events; the
+  // parent of an origin precedes it in its partition, so its rank is settled
+  std::vector<OriginHead> heads;
+  std::vector<uint32_t> next (m_partitions.size (), 1);
+  for (uint32_t i = 0; i < m_partitions.size (); i++)
+    {
+      if (!m_partitions[i]->origins.empty ())
+        {
+          heads.push_back (std::make_pair (m_partitions[i]->origins.front (), i));
+        }
+    }
+  std::make_heap (heads.begin (), heads.end (), OriginLater ());
+  m_nextRank = m_windowBase;
+  while (!heads.empty ())
+    {
+      std::pop_heap (heads.begin (), heads.end (), OriginLater ());
+      OriginHead head = heads.back ();
+      heads.pop_back ();
+      head.first->rank = m_nextRank++;
+      std::vector<Origin *> &origins = m_partitions[head.second]->origins;
+      if (next[head.second] < origins.size ())
+        {
+          heads.push_back (std::make_pair (origins[next[head.second]++], head.second));
+          std::push_heap (heads.begin (), heads.end (), OriginLater ());
+        }
+    }
+  for (std::vector<Partition *>::const_iterator p = m_partitions.begin (); p != m_partitions.end (); ++p)
+    {
+      for (std::vector<Origin *>::const_iterator o = (*p)->origins.begin (); o != (*p)->origins.end (); ++o)
+        {
+          Origin *parent = (*o)->parent;
+          (*o)->parent = 0;
+          UnrefOrigin (parent);
+          UnrefOrigin (*o);
+        }
+      (*p)->origins.clear ();
+    }
+}
+
+uint64_t
+MultithreadedSimulatorImpl::GetNextTs (void) const
+{
+  uint64_t next = NO_EVENT;
+  for (std::vector<Partition *>::const_iterator p = m_partitions.begin (); p != m_partitions.end (); ++p)
+    {
+      if (!(*p)->events.empty ())
+        {
+          next = std::min (next, (*p)->events.front ().ts);
+        }
+      next = std::min (next, (*p)->minSent);
+    }
+  return next;
+}
+
+void
+MultithreadedSimulatorImpl::Barrier (void)
+{
+  uint32_t generation = __atomic_load_n (&m_barrierGeneration, __ATOMIC_ACQUIRE);
+  if (__atomic_add_fetch (&m_barrierArrived, 1, __ATOMIC_ACQ_REL) == m_nThreads)
+    {
+      __atomic_store_n (&m_barrierArrived, 0, __ATOMIC_RELAXED);
+      __atomic_store_n (&m_barrierGeneration, generation + 1, __ATOMIC_RELEASE);
+      return;
+    }
+  for (uint32_t spin = 0; __atomic_load_n (&m_barrierGeneration, __ATOMIC_ACQUIRE) == generation; spin++)
+    {
+      if (spin >= 1000)
+        {
+          sched_yield ();
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::RunWorker (void)
+{
+  Partition *p = m_partitions[__atomic_add_fetch (&m_nextWorker, 1, __ATOMIC_RELAXED)];
+  for (;;)
+    {
+      Barrier ();
+      if (!m_running)
+        {
+          break;
+        }
+      RunWindow (p);
+      Barrier ();
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Run (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (PacketMetadata::IsEnabled ())
+    {
+      NS_FATAL_ERROR ("The packet metadata is not supported by MultithreadedSimulatorImpl");
+    }
+  m_main = SystemThread::Self ();
+  m_stop = false;
+  AssignPartitions ();
+  for (std::vector<Event>::const_iterator ev = m_pending.begin (); ev != m_pending.end (); ++ev)
+    {
+      std::vector<Event> &events = GetPartition (ev->context)->events;
+      events.push_back (*ev);
+      std::push_heap (events.begin (), events.end (), EventLater ());
+    }
+  m_pending.clear ();
+
+  m_sequential = false;
+  m_running = true;
+  m_window = 0;
+  m_nextWorker = 0;
+  std::vector<Ptr<SystemThread> > threads;
+  for (uint32_t i = 1; i < m_nThreads; i++)
+    {
+      threads.push_back (Create<SystemThread> (MakeCallback (&MultithreadedSimulatorImpl::RunWorker, this)));
+      threads.back ()->Start ();
+    }
+
+  Partition *global = m_partitions.back ();
+  uint64_t lookahead = m_lookahead.GetTimeStep ();
+  for (;;)
+    {
+      Drain (global, 0);
+      Drain (global, 1);
+      uint64_t next = GetNextTs ();
+      if (next == NO_EVENT || m_stop)
+        {
+          break;
+        }
+      uint64_t nextGlobal = global->events.empty () ? NO_EVENT : global->events.front ().ts;
+      if (nextGlobal == next)
+        {
+          RunStep (next);
+          continue;
+        }
+      m_windowEnd = next < NO_EVENT - lookahead ? next + lookahead : NO_EVENT;
+      m_windowEnd = std::min (m_windowEnd, nextGlobal);
+      m_windowBase = m_nextRank;
+      Barrier ();
+      RunWindow (m_partitions.front ());
+      Barrier ();
+      SettleRanks ();
+      m_window++;
+    }
+  m_running = false;
+  Barrier ();
+  for (std::vector<Ptr<SystemThread> >::const_iterator t = threads.begin (); t != threads.end (); ++t)
+    {
+      (*t)->Join ();
+    }
+
+  // Keep the events left for the next run
+  for (std::vector<Partition *>::const_iterator p = m_partitions.begin (); p != m_partitions.end (); ++p)
+    {
+      Drain (*p, 0);
+      Drain (*p, 1);
+      m_pending.insert (m_pending.end (), (*p)->events.begin (), (*p)->events.end ());
+      m_destroyEvents.insert (m_destroyEvents.end (), (*p)->destroyEvents.begin (), (*p)->destroyEvents.end ());
+      m_currentTs = std::max (m_currentTs, (*p)->currentTs);
+    }
+  for (std::vector<Partition *>::const_iterator p = m_partitions.begin (); p != m_partitions.end (); ++p)
+    {
+      delete *p;
+    }
+  m_partitions.clear ();
+  m_sequential = true;
+
+  // The events scheduled by the main program from now on come after all
+  // the events run so far
+  UnrefOrigin (m_mainOrigin);
+  m_mainOrigin = new Origin ();
+  m_mainOrigin->rank = m_nextRank++;
+  m_mainOrigin->ts = m_currentTs;
+  m_mainOrigin->parent = 0;
+  m_mainOrigin->child = 0;
+  m_mainOrigin->refs = 1;
+  m_mainChild = 0;
+}
+
+} // namespace ns3
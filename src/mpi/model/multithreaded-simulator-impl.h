@@ -0,0 +1,287 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MULTITHREADED_SIMULATOR_IMPL_H
+#define MULTITHREADED_SIMULATOR_IMPL_H
+
+#include <ns3/simulator-impl.h>
+#include <ns3/event-impl.h>
+#include <ns3/system-thread.h>
+#include <ns3/ptr.h>
+
+#include <utility>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup mpi
+ *
+ * \brief Simulator implementation running the nodes on several threads
+ * of a single process.
+ *
+ * The nodes are split into partitions, one per thread.  Unless the nodes
+ * were created with distinct system ids, which then name their partition,
+ * every node with a single neighbour is placed with its neighbour (a host
+ * with its ToR switch) and the switches are spread over the threads
+ * according to the number of hosts they carry.
+ *
+ * The threads advance in windows bounded by the lookahead, the smallest
+ * delay of the channels linking two partitions: an event of a window
+ * cannot schedule an event in another partition before the end of the
+ * window.  Those events are exchanged at the end of the window, through
+ * per thread pair queues that are only written by their source thread and
+ * only read by their destination thread.  Events without a node context
+ * (scheduled by the main program, like Simulator::Stop) run alone on the
+ * main thread, along with the node events of the same timestamp.
+ *
+ * Simultaneous events run in the order of DefaultSimulatorImpl: an event
+ * is keyed by its timestamp, the rank of the event that scheduled it in
+ * the order of execution, and its rank among the events scheduled by that
+ * event.  The ranks of the events run in a window are settled at the end
+ * of the window.  A model whose nodes only share state through channels
+ * therefore gives the same results as with DefaultSimulatorImpl.  The
+ * load balancers of the data center modules draw from the random variable
+ * streams of their node rather than from rand (), and the flow monitor,
+ * whose tables are updated by every node, refuses to start.
+ */
+class MultithreadedSimulatorImpl : public SimulatorImpl
+{
+public:
+  static TypeId GetTypeId (void);
+
+  MultithreadedSimulatorImpl ();
+
+  ~MultithreadedSimulatorImpl ();
+
+  // virtual from SimulatorImpl
+  virtual void Destroy ();
+  virtual bool IsFinished (void) const;
+  virtual void Stop (void);
+  virtual void Stop (Time const &delay);
+  virtual EventId Schedule (Time const &delay, EventImpl *event);
+  virtual void ScheduleWithContext (uint32_t context, Time const &delay, EventImpl *event);
+  virtual EventId ScheduleNow (EventImpl *event);
+  virtual EventId ScheduleDestroy (EventImpl *event);
+  virtual void Remove (const EventId &id);
+  virtual void Cancel (const EventId &id);
+  virtual bool IsExpired (const EventId &id) const;
+  virtual void Run (void);
+  virtual Time Now (void) const;
+  virtual Time GetDelayLeft (const EventId &id) const;
+  virtual Time GetMaximumSimulationTime (void) const;
+  virtual void SetScheduler (ObjectFactory schedulerFactory);
+  virtual uint32_t GetSystemId (void) const;
+  virtual uint32_t GetContext (void) const;
+
+  /**
+   * \return the number of threads of the last run
+   */
+  uint32_t GetNThreads (void) const;
+
+  /**
+   * \return the lookahead of the last run
+   */
+  Time GetLookahead (void) const;
+
+private:
+  virtual void DoDispose (void);
+
+  /**
+   * An event which scheduled other events.  Its rank is its position in
+   * the order of execution of the simulation; the rank of the events run
+   * in a window is provisional until the end of the window, when they are
+   * sorted by the key of the event.
+   */
+  struct Origin
+  {
+    uint64_t rank;      //!< Position in the order of execution
+    uint64_t ts;        //!< Timestamp of the event
+    Origin *parent;     //!< Origin of the event, until its rank is settled
+    uint32_t child;     //!< Rank of the event among the children of parent
+    uint32_t refs;      //!< Number of references
+  };
+
+  /// A scheduled event
+  struct Event
+  {
+    EventImpl *impl;    //!< The event, owning one reference
+    uint64_t ts;        //!< Timestamp
+    Origin *origin;     //!< Event which scheduled this one, one reference
+    uint32_t child;     //!< Rank among the events scheduled by origin
+    uint32_t context;   //!< Execution context
+  };
+
+  /// Orders a std heap of events, the earliest event first
+  struct EventLater
+  {
+    bool operator () (const Event &a, const Event &b) const;
+  };
+
+  /// An origin to settle and the index of its partition
+  typedef std::pair<Origin *, uint32_t> OriginHead;
+
+  /// Orders a std heap of origins, the earliest origin first
+  struct OriginLater
+  {
+    bool operator () (const OriginHead &a, const OriginHead &b) const;
+  };
+
+  /// An event run by Simulator::Destroy
+  struct DestroyEvent
+  {
+    EventId id;         //!< The event
+    Origin *origin;     //!< Event which scheduled this one, one reference
+    uint32_t child;     //!< Rank among the events scheduled by origin
+  };
+
+  /// Orders the events run by Simulator::Destroy
+  struct DestroyEventEarlier
+  {
+    bool operator () (const DestroyEvent &a, const DestroyEvent &b) const;
+  };
+
+  /// The events of the nodes run by one thread
+  struct Partition
+  {
+    uint32_t index;                       //!< Index in m_partitions
+    std::vector<Event> events;            //!< Heap of the events
+    /// Events sent to each partition, for the even and odd windows
+    std::vector<std::vector<Event> > outbox[2];
+    std::vector<Origin *> origins;        //!< Origins created in the window
+    std::vector<DestroyEvent> destroyEvents; //!< Events scheduled for Destroy
+    uint64_t minSent;                     //!< Earliest event sent since the last drain
+    uint64_t currentTs;                   //!< Timestamp of the current event
+    uint32_t currentContext;              //!< Context of the current event
+    EventImpl *currentEvent;              //!< The current event
+    Origin *currentParent;                //!< Origin of the current event
+    uint32_t currentChild;                //!< Rank of the current event
+    Origin *currentOrigin;                //!< Origin of the current event's children, or 0
+    uint32_t nextChild;                   //!< Rank of the next child of the current event
+    uint32_t uid;                         //!< Next event id
+  };
+
+  /**
+   * Attach each node to a partition and compute the lookahead.
+   */
+  void AssignPartitions (void);
+  /**
+   * \param context an execution context
+   * \return the partition of the context, the global one if the context
+   *         is not a node
+   */
+  Partition *GetPartition (uint32_t context) const;
+  /**
+   * \return the partition running the current event, or 0 outside Run
+   */
+  Partition *GetCurrent (void) const;
+
+  /**
+   * Schedule an event in the context of the caller.
+   * \param context the execution context of the event
+   * \param delay the delay from now
+   * \param event the event
+   * \return the id of the event
+   */
+  EventId Insert (uint32_t context, Time const &delay, EventImpl *event);
+  /**
+   * \param p the partition of the current event
+   * \return the origin of the events scheduled by the current event
+   */
+  Origin *GetOrigin (Partition *p);
+
+  /**
+   * Run the events of a partition until the end of the window.
+   * \param p the partition
+   */
+  void RunWindow (Partition *p);
+  /**
+   * Run the events with the timestamp of the next global event, on the
+   * main thread.
+   * \param ts the timestamp
+   */
+  void RunStep (uint64_t ts);
+  /**
+   * Run an event.
+   * \param p the partition of the event
+   * \param ev the event
+   */
+  void Invoke (Partition *p, const Event &ev);
+  /**
+   * Move the events sent to a partition in its heap.
+   * \param p the partition
+   * \param parity the windows of the events
+   */
+  void Drain (Partition *p, uint32_t parity);
+  /**
+   * Settle the rank of the origins created in the last window.
+   */
+  void SettleRanks (void);
+  /**
+   * \return the timestamp of the earliest event left, including the
+   *         events not yet drained
+   */
+  uint64_t GetNextTs (void) const;
+  /**
+   * Entry point of the worker threads.
+   */
+  void RunWorker (void);
+  /**
+   * Wait for all the threads.
+   */
+  void Barrier (void);
+
+  /**
+   * \param origin an origin to reference
+   * \return origin
+   */
+  static Origin *RefOrigin (Origin *origin);
+  /**
+   * \param origin an origin to release
+   */
+  static void UnrefOrigin (Origin *origin);
+
+  uint32_t m_threadCount;                 //!< ThreadCount attribute
+  uint32_t m_nThreads;                    //!< Threads of the current run
+  Time m_lookahead;                       //!< Lookahead of the current run
+  std::vector<uint32_t> m_nodePartition;  //!< Partition of each node
+  /// The partitions, the global one last
+  std::vector<Partition *> m_partitions;
+
+  std::vector<Event> m_pending;           //!< Events outside Run
+  std::vector<DestroyEvent> m_destroyEvents; //!< Events scheduled for Destroy
+  Origin *m_mainOrigin;                   //!< Origin of the main program events
+  uint32_t m_mainChild;                   //!< Rank of the next main program event
+  uint64_t m_nextRank;                    //!< Next settled rank
+  uint64_t m_windowBase;                  //!< First rank of the current window
+  uint64_t m_windowEnd;                   //!< End of the current window
+  uint32_t m_window;                      //!< Number of the current window
+  bool m_sequential;                      //!< Events run on the main thread only
+  bool m_running;                         //!< Workers keep running windows
+  bool m_stop;                            //!< Flag calling for the end of Run
+  uint64_t m_currentTs;                   //!< Time outside Run
+  uint32_t m_currentContext;              //!< Context outside Run
+  uint32_t m_uid;                         //!< Next event id outside Run
+  SystemThread::ThreadId m_main;          //!< Thread calling Run
+
+  uint32_t m_nextWorker;                  //!< Partition of the next worker thread
+  uint32_t m_barrierArrived;              //!< Threads waiting at the barrier
+  uint32_t m_barrierGeneration;           //!< Number of barriers passed
+};
+
+} // namespace ns3
+
+#endif /* MULTITHREADED_SIMULATOR_IMPL_H */
@@ -0,0 +1,284 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/default-simulator-impl.h"
+#include "ns3/multithreaded-simulator-impl.h"
+#include "ns3/node.h"
+#include "ns3/node-list.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/mac48-address.h"
+#include "ns3/packet.h"
+#include "ns3/uinteger.h"
+#include "ns3/nstime.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+namespace {
+
+/*
+ * Four switches in a ring, each with two hosts.  The hosts send a packet
+ * which bounces from node to node, one byte longer at each hop, and every
+ * reception re-arms a timer of the node.  The delays are multiples of a
+ * microsecond, so the nodes receive simultaneous packets.  Each node logs
+ * what it sees; the log of a node is only written by the thread running it.
+ */
+const uint32_t N_SWITCHES = 4;
+const uint32_t N_HOSTS = 2;
+const uint32_t PAYLOAD = 10;
+const uint32_t MAX_HOPS = 12;
+
+struct NodeState
+{
+  std::ostringstream log;
+  uint32_t received;
+  EventId timer;
+  Ptr<Packet> last;
+};
+
+std::vector<NodeState *> g_nodes;
+std::ostringstream g_globalLog;
+
+void
+Timeout (uint32_t node)
+{
+  g_nodes[node]->log << Simulator::Now ().GetNanoSeconds () << " timeout "
+                     << g_nodes[node]->received << "\n";
+}
+
+void
+Later (uint32_t node, uint32_t size)
+{
+  g_nodes[node]->log << Simulator::Now ().GetNanoSeconds () << " now " << size << "\n";
+}
+
+void
+Send (Ptr<NetDevice> device, Ptr<Packet> packet)
+{
+  device->Send (packet, Mac48Address::GetBroadcast (), 0x800);
+}
+
+bool
+Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from)
+{
+  Ptr<Node> node = device->GetNode ();
+  uint32_t id = node->GetId ();
+  NodeState *state = g_nodes[id];
+  NS_ASSERT (Simulator::GetContext () == id);
+  state->log << Simulator::Now ().GetNanoSeconds () << " rx " << packet->GetSize ()
+             << " on " << device->GetIfIndex () << "\n";
+  state->received++;
+
+  // Keep the packet around, its buffer is shared with the copies sent on
+  if (state->last != 0 && state->last->GetSize () > PAYLOAD + 2)
+    {
+      state->last->RemoveAtStart (1);
+      state->last->AddPaddingAtEnd (1);
+    }
+  state->last = packet->Copy ();
+
+  uint32_t hops = packet->GetSize () - PAYLOAD;
+  if (hops < MAX_HOPS)
+    {
+      Ptr<Packet> next = packet->Copy ();
+      next->AddPaddingAtEnd (1);
+      Send (node->GetDevice ((id + hops) % node->GetNDevices ()), next);
+    }
+  Simulator::Cancel (state->timer);
+  state->timer = Simulator::Schedule (MicroSeconds (4), &Timeout, id);
+  Simulator::ScheduleNow (&Later, id, packet->GetSize ());
+  return true;
+}
+
+void
+Start (Ptr<Node> node)
+{
+  Send (node->GetDevice (0), Create<Packet> (PAYLOAD));
+}
+
+void
+Snapshot (void)
+{
+  NS_ASSERT (Simulator::GetContext () == 0xffffffff);
+  g_globalLog << Simulator::Now ().GetNanoSeconds () << " snapshot";
+  for (uint32_t i = 0; i < g_nodes.size (); i++)
+    {
+      g_globalLog << " " << g_nodes[i]->received << "/" << g_nodes[i]->timer.IsRunning ();
+    }
+  g_globalLog << "\n";
+  // Send from a node while the others are stopped
+  Send (NodeList::GetNode (0)->GetDevice (0), Create<Packet> (PAYLOAD + 1));
+}
+
+void
+Connect (Ptr<Node> a, Ptr<Node> b, Time delay)
+{
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  channel->SetAttribute ("Delay", TimeValue (delay));
+  Ptr<Node> nodes[2] = { a, b };
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetAddress (Mac48Address::Allocate ());
+      device->SetChannel (channel);
+      nodes[i]->AddDevice (device);
+      device->SetReceiveCallback (MakeCallback (&Receive));
+    }
+}
+
+/**
+ * Run the scenario with a simulator implementation.
+ * \param impl the implementation
+ * \param systemIds whether the switches are created with system ids
+ * \return the logs of the nodes and of the global events
+ */
+std::vector<std::string>
+RunScenario (Ptr<SimulatorImpl> impl, bool systemIds)
+{
+  Simulator::Destroy ();
+  Simulator::SetImplementation (impl);
+  g_globalLog.str ("");
+
+  std::vector<Ptr<Node> > nodes;
+  for (uint32_t i = 0; i < N_SWITCHES; i++)
+    {
+      nodes.push_back (CreateObject<Node> (systemIds ? i % 2 : 0));
+    }
+  for (uint32_t i = 0; i < N_SWITCHES * N_HOSTS; i++)
+    {
+      nodes.push_back (CreateObject<Node> (systemIds ? (i / N_HOSTS) % 2 : 0));
+    }
+  for (uint32_t i = 0; i < N_SWITCHES; i++)
+    {
+      Connect (nodes[i], nodes[(i + 1) % N_SWITCHES], MicroSeconds (i == 0 ? 5 : 3));
+    }
+  for (uint32_t i = 0; i < N_SWITCHES * N_HOSTS; i++)
+    {
+      Connect (nodes[N_SWITCHES + i], nodes[i / N_HOSTS], MicroSeconds (2));
+    }
+  for (uint32_t i = 0; i < nodes.size (); i++)
+    {
+      NodeState *state = new NodeState ();
+      state->received = 0;
+      g_nodes.push_back (state);
+    }
+  for (uint32_t i = N_SWITCHES; i < nodes.size (); i++)
+    {
+      Simulator::ScheduleWithContext (i, MicroSeconds (i % 3), &Start, nodes[i]);
+    }
+  EventId cancelled = Simulator::Schedule (MicroSeconds (7), &Snapshot);
+  Simulator::Schedule (MicroSeconds (12), &Snapshot);
+  Simulator::Cancel (cancelled);
+  Simulator::Stop (MicroSeconds (20));
+
+  Simulator::Run ();
+  g_globalLog << Simulator::Now ().GetNanoSeconds () << " stop\n";
+  Simulator::Schedule (MicroSeconds (1), &Snapshot);
+  Simulator::Run ();
+  g_globalLog << Simulator::Now ().GetNanoSeconds () << " end\n";
+
+  std::vector<std::string> logs;
+  for (uint32_t i = 0; i < g_nodes.size (); i++)
+    {
+      logs.push_back (g_nodes[i]->log.str ());
+      delete g_nodes[i];
+    }
+  g_nodes.clear ();
+  logs.push_back (g_globalLog.str ());
+  Simulator::Destroy ();
+  return logs;
+}
+
+} // anonymous namespace
+
+/**
+ * \ingroup mpi
+ *
+ * Check that the nodes see the same events, in the same order, with
+ * MultithreadedSimulatorImpl and DefaultSimulatorImpl.
+ */
+class MultithreadedSimulatorImplOrderTestCase : public TestCase
+{
+public:
+  /**
+   * \param threads the ThreadCount attribute
+   * \param systemIds whether the switches are created with system ids
+   */
+  MultithreadedSimulatorImplOrderTestCase (uint32_t threads, bool systemIds);
+  virtual void DoRun (void);
+
+private:
+  uint32_t m_threads;   //!< ThreadCount attribute
+  bool m_systemIds;     //!< Whether the nodes have system ids
+};
+
+MultithreadedSimulatorImplOrderTestCase::MultithreadedSimulatorImplOrderTestCase (uint32_t threads,
+                                                                                  bool systemIds)
+  : TestCase ("Check the order of the events with ThreadCount " + std::string (1, '0' + threads) +
+              (systemIds ? " and system ids" : "")),
+    m_threads (threads),
+    m_systemIds (systemIds)
+{
+}
+
+void
+MultithreadedSimulatorImplOrderTestCase::DoRun (void)
+{
+  std::vector<std::string> expected = RunScenario (CreateObject<DefaultSimulatorImpl> (), m_systemIds);
+  Ptr<MultithreadedSimulatorImpl> impl = CreateObject<MultithreadedSimulatorImpl> ();
+  impl->SetAttribute ("ThreadCount", UintegerValue (m_threads));
+  std::vector<std::string> logs = RunScenario (impl, m_systemIds);
+
+  NS_TEST_ASSERT_MSG_EQ (impl->GetNThreads (), std::min<uint32_t> (m_threads, N_SWITCHES), "Wrong number of threads");
+  if (m_threads > 1)
+    {
+      // The hosts are on the thread of their switch
+      NS_TEST_ASSERT_MSG_EQ (impl->GetLookahead (), MicroSeconds (3), "Wrong lookahead");
+    }
+  NS_TEST_ASSERT_MSG_EQ (logs.size (), expected.size (), "Wrong number of nodes");
+  for (uint32_t i = 0; i < logs.size (); i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (logs[i], expected[i], "Different events in log " << i);
+    }
+  NS_TEST_ASSERT_MSG_NE (expected.back ().find ("20000 stop"), std::string::npos, "Not stopped");
+}
+
+/**
+ * \ingroup mpi
+ *
+ * MultithreadedSimulatorImpl test suite
+ */
+class MultithreadedSimulatorImplTestSuite : public TestSuite
+{
+public:
+  MultithreadedSimulatorImplTestSuite ()
+    : TestSuite ("multithreaded-simulator-impl", UNIT)
+  {
+    AddTestCase (new MultithreadedSimulatorImplOrderTestCase (1, false), TestCase::QUICK);
+    AddTestCase (new MultithreadedSimulatorImplOrderTestCase (2, false), TestCase::QUICK);
+    AddTestCase (new MultithreadedSimulatorImplOrderTestCase (3, false), TestCase::QUICK);
+    AddTestCase (new MultithreadedSimulatorImplOrderTestCase (8, false), TestCase::QUICK);
+    AddTestCase (new MultithreadedSimulatorImplOrderTestCase (2, true), TestCase::QUICK);
+  }
+};
+
+static MultithreadedSimulatorImplTestSuite g_multithreadedSimulatorImplTestSuite;
@@ -18,6 +18,7 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 #include "buffer.h"
+#include "packet-pool.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
 
@@ -51,98 +52,7 @@ NS_LOG_COMPONENT_DEFINE ("Buffer");
 
 
 uint32_t Buffer::g_recommendedStart = 0;
-#ifdef BUFFER_FREE_LIST
-/* The following macros are pretty evil but they are needed to allow us to
- * keep track of 3 possible states for the g_freeList variable:
- *  - uninitialized means that no one has created a buffer yet
- *    so no one has created the associated free list (it is created
- *    on-demand when the first buffer is created)
- *  - initialized means that the free list exists and is valid
- *  - destroyed means that the static destructors of this compilation unit
- *    have run so, the free list has been cleared from its content
- * The key is that in destroyed state, we are careful not re-create it
- * which is a typical weakness of lazy evaluation schemes which use 
- * '0' as a special value to indicate both un-initialized and destroyed.
- * Note that it is important to use '0' as the marker for un-initialized state
- * because the variable holding this state information is initialized to zero
- * which the compiler assigns to zero-memory which is initialized to _zero_
- * before the constructors run so this ensures perfect handling of crazy 
- * constructor orderings.
- */
-#define MAGIC_DESTROYED (~(long) 0)
-#define IS_UNINITIALIZED(x) (x == (Buffer::FreeList*)0)
-#define IS_DESTROYED(x) (x == (Buffer::FreeList*)MAGIC_DESTROYED)
-#define IS_INITIALIZED(x) (!IS_UNINITIALIZED (x) && !IS_DESTROYED (x))
-#define DESTROYED ((Buffer::FreeList*)MAGIC_DESTROYED)
-#define UNINITIALIZED ((Buffer::FreeList*)0)
-uint32_t Buffer::g_maxSize = 0;
-Buffer::FreeList *Buffer::g_freeList = 0;
-struct Buffer::LocalStaticDestructor Buffer::g_localStaticDestructor;
-
-Buffer::LocalStaticDestructor::~LocalStaticDestructor(void)
-{
-  NS_LOG_FUNCTION (this);
-  if (IS_INITIALIZED (g_freeList))
-    {
-      for (Buffer::FreeList::iterator i = g_freeList->begin ();
-           i != g_freeList->end (); i++)
-        {
-          Buffer::Deallocate (*i);
-        }
-      delete g_freeList;
-      g_freeList = DESTROYED;
-    }
-}
-
-void
-Buffer::Recycle (struct Buffer::Data *data)
-{
-  NS_LOG_FUNCTION (data);
-  NS_ASSERT (data->m_count == 0);
-  NS_ASSERT (!IS_UNINITIALIZED (g_freeList));
-  g_maxSize = std::max (g_maxSize, data->m_size);
-  /* feed into free list */
-  if (data->m_size < g_maxSize ||
-      IS_DESTROYED (g_freeList) ||
-      g_freeList->size () > 1000)
-    {
-      Buffer::Deallocate (data);
-    }
-  else
-    {
-      NS_ASSERT (IS_INITIALIZED (g_freeList));
-      g_freeList->push_back (data);
-    }
-}
 
-Buffer::Data *
-Buffer::Create (uint32_t dataSize)
-{
-  NS_LOG_FUNCTION (dataSize);
-  /* try to find a buffer correctly sized. */
-  if (IS_UNINITIALIZED (g_freeList))
-    {
-      g_freeList = new Buffer::FreeList ();
-    }
-  else if (IS_INITIALIZED (g_freeList))
-    {
-      while (!g_freeList->empty ()) 
-        {
-          struct Buffer::Data *data = g_freeList->back ();
-          g_freeList->pop_back ();
-          if (data->m_size >= dataSize) 
-            {
-              data->m_count = 1;
-              return data;
-            }
-          Buffer::Deallocate (data);
-        }
-    }
-  struct Buffer::Data *data = Buffer::Allocate (dataSize);
-  NS_ASSERT (data->m_count == 1);
-  return data;
-}
-#else /* BUFFER_FREE_LIST */
 void
 Buffer::Recycle (struct Buffer::Data *data)
 {
@@ -157,7 +67,6 @@ Buffer::Create (uint32_t size)
   NS_LOG_FUNCTION (size);
   return Allocate (size);
 }
-#endif /* BUFFER_FREE_LIST */
 
 struct Buffer::Data *
 Buffer::Allocate (uint32_t reqSize)
@@ -168,10 +77,9 @@ Buffer::Allocate (uint32_t reqSize)
       reqSize = 1;
     }
   NS_ASSERT (reqSize >= 1);
-  uint32_t size = reqSize - 1 + sizeof (struct Buffer::Data);
-  uint8_t *b = new uint8_t [size];
-  struct Buffer::Data *data = reinterpret_cast<struct Buffer::Data*>(b);
-  data->m_size = reqSize;
+  uint32_t size = PacketPool::GetBlockSize (reqSize - 1 + sizeof (struct Buffer::Data));
+  struct Buffer::Data *data = static_cast<struct Buffer::Data *> (PacketPool::Allocate (size));
+  data->m_size = size + 1 - sizeof (struct Buffer::Data);
   data->m_count = 1;
   return data;
 }
@@ -181,8 +89,7 @@ Buffer::Deallocate (struct Buffer::Data *data)
 {
   NS_LOG_FUNCTION (data);
   NS_ASSERT (data->m_count == 0);
-  uint8_t *buf = reinterpret_cast<uint8_t *> (data);
-  delete [] buf;
+  PacketPool::Deallocate (data, data->m_size - 1 + sizeof (struct Buffer::Data));
 }
 
 Buffer::Buffer ()
@@ -244,8 +151,9 @@ void
 Buffer::Initialize (uint32_t zeroSize)
 {
   NS_LOG_FUNCTION (this << zeroSize);
-  m_data = Buffer::Create (0);
-  m_start = std::min (m_data->m_size, g_recommendedStart);
+  uint32_t start = AtomicLoad (&g_recommendedStart);
+  m_data = Buffer::Create (start);
+  m_start = std::min (m_data->m_size, start);
   m_maxZeroAreaStart = m_start;
   m_zeroAreaStart = m_start;
   m_zeroAreaEnd = m_zeroAreaStart + zeroSize;
@@ -255,6 +163,42 @@ Buffer::Initialize (uint32_t zeroSize)
   NS_ASSERT (CheckInternalState ());
 }
 
+void
+Buffer::UpdateRecommendedStart (uint32_t start)
+{
+  uint32_t recommended = AtomicLoad (&g_recommendedStart);
+  while (start > recommended &&
+         !AtomicCompareExchange (&g_recommendedStart, &recommended, start))
+    {
+    }
+}
+
+bool
+Buffer::ClaimDirtyStart (uint32_t start)
+{
+  if (AtomicLoad (&m_data->m_count) == 1)
+    {
+      m_data->m_dirtyStart = start;
+      return true;
+    }
+  // The buffers sharing the data may live in other threads: the one
+  // starting at the dirty start gets the room before it.
+  uint32_t expected = m_start;
+  return AtomicCompareExchange (&m_data->m_dirtyStart, &expected, start);
+}
+
+bool
+Buffer::ClaimDirtyEnd (uint32_t end)
+{
+  if (AtomicLoad (&m_data->m_count) == 1)
+    {
+      m_data->m_dirtyEnd = end;
+      return true;
+    }
+  uint32_t expected = m_end;
+  return AtomicCompareExchange (&m_data->m_dirtyEnd, &expected, end);
+}
+
 Buffer &
 Buffer::operator = (Buffer const&o)
 {
@@ -262,15 +206,14 @@ Buffer::operator = (Buffer const&o)
   if (m_data != o.m_data) 
     {
       // not assignment to self.
-      m_data->m_count--;
-      if (m_data->m_count == 0) 
+      if (AtomicDecrement (&m_data->m_count) == 0)
         {
           Recycle (m_data);
         }
       m_data = o.m_data;
-      m_data->m_count++;
+      AtomicIncrement (&m_data->m_count);
     }
-  g_recommendedStart = std::max (g_recommendedStart, m_maxZeroAreaStart);
+  UpdateRecommendedStart (m_maxZeroAreaStart);
   m_maxZeroAreaStart = o.m_maxZeroAreaStart;
   m_zeroAreaStart = o.m_zeroAreaStart;
   m_zeroAreaEnd = o.m_zeroAreaEnd;
@@ -284,9 +227,8 @@ Buffer::~Buffer ()
 {
   NS_LOG_FUNCTION (this);
   NS_ASSERT (CheckInternalState ());
-  g_recommendedStart = std::max (g_recommendedStart, m_maxZeroAreaStart);
-  m_data->m_count--;
-  if (m_data->m_count == 0) 
+  UpdateRecommendedStart (m_maxZeroAreaStart);
+  if (AtomicDecrement (&m_data->m_count) == 0)
     {
       Recycle (m_data);
     }
@@ -310,32 +252,35 @@ Buffer::AddAtStart (uint32_t start)
 {
   NS_LOG_FUNCTION (this << start);
   NS_ASSERT (CheckInternalState ());
-  bool isDirty = m_data->m_count > 1 && m_start > m_data->m_dirtyStart;
-  if (m_start >= start && !isDirty)
+  if (m_start >= start && ClaimDirtyStart (m_start - start))
     {
       /* enough space in the buffer and not dirty. 
        * To add: |..|
        * Before: |*****---------***|
        * After:  |***..---------***|
        */
-      NS_ASSERT (m_data->m_count == 1 || m_start == m_data->m_dirtyStart);
       m_start -= start;
-      // update dirty area
-      m_data->m_dirtyStart = m_start;
     } 
   else
     {
-      uint32_t newSize = GetInternalSize () + start;
+      /* Leave room for the recommended start in front of the zero
+       * area, so that the headers pushed after this one on a shared
+       * buffer, at a forwarding hop for example, do not copy the
+       * data again.
+       */
+      uint32_t recommended = AtomicLoad (&g_recommendedStart);
+      uint32_t dataStart = m_zeroAreaStart - m_start + start;
+      uint32_t room = recommended > dataStart ? recommended - dataStart : 0;
+      uint32_t newSize = GetInternalSize () + start + room;
       struct Buffer::Data *newData = Buffer::Create (newSize);
-      memcpy (newData->m_data + start, m_data->m_data + m_start, GetInternalSize ());
-      m_data->m_count--;
-      if (m_data->m_count == 0)
+      memcpy (newData->m_data + start + room, m_data->m_data + m_start, GetInternalSize ());
+      if (AtomicDecrement (&m_data->m_count) == 0)
         {
           Buffer::Recycle (m_data);
         }
       m_data = newData;
 
-      int32_t delta = start - m_start;
+      int32_t delta = start + room - m_start;
       m_start += delta;
       m_zeroAreaStart += delta;
       m_zeroAreaEnd += delta;
@@ -355,26 +300,21 @@ Buffer::AddAtEnd (uint32_t end)
 {
   NS_LOG_FUNCTION (this << end);
   NS_ASSERT (CheckInternalState ());
-  bool isDirty = m_data->m_count > 1 && m_end < m_data->m_dirtyEnd;
-  if (GetInternalEnd () + end <= m_data->m_size && !isDirty)
+  if (GetInternalEnd () + end <= m_data->m_size && ClaimDirtyEnd (m_end + end))
     {
       /* enough space in buffer and not dirty
        * Add:    |...|
        * Before: |**----*****|
        * After:  |**----...**|
        */
-      NS_ASSERT (m_data->m_count == 1 || m_end == m_data->m_dirtyEnd);
       m_end += end;
-      // update dirty area.
-      m_data->m_dirtyEnd = m_end;
     } 
   else
     {
       uint32_t newSize = GetInternalSize () + end;
       struct Buffer::Data *newData = Buffer::Create (newSize);
       memcpy (newData->m_data, m_data->m_data + m_start, GetInternalSize ());
-      m_data->m_count--;
-      if (m_data->m_count == 0) 
+      if (AtomicDecrement (&m_data->m_count) == 0)
         {
           Buffer::Recycle (m_data);
         }
@@ -400,22 +340,50 @@ void
 Buffer::AddAtEnd (const Buffer &o)
 {
   NS_LOG_FUNCTION (this << &o);
-  if (m_data->m_count == 1 &&
-      m_end == m_zeroAreaEnd &&
-      m_end == m_data->m_dirtyEnd &&
+  if (m_end == m_zeroAreaEnd &&
       o.m_start == o.m_zeroAreaStart &&
       o.m_zeroAreaEnd - o.m_zeroAreaStart > 0)
     {
       /**
        * This is an optimization which kicks in when
        * we attempt to aggregate two buffers which contain
-       * adjacent zero areas.
+       * adjacent zero areas: the zero areas are merged
+       * and their bytes are never written.
        */
       uint32_t zeroSize = o.m_zeroAreaEnd - o.m_zeroAreaStart;
+      uint32_t endData = o.m_end - o.m_zeroAreaEnd;
+      if (AtomicLoad (&m_data->m_count) != 1)
+        {
+          /* The data is shared, with the fragment this buffer
+           * was cut from for example.  Copy the bytes before the
+           * zero area, usually the headers, in a private data,
+           * with room for the headers added later: the zero area
+           * starts at the recommended start, as in a new buffer.
+           * To add: |000|
+           * Before: |**0000| shared
+           * After:  |..**0000000| private
+           */
+          uint32_t dataStart = m_zeroAreaStart - m_start;
+          uint32_t zeroStart = std::max (AtomicLoad (&g_recommendedStart),
+                                         dataStart);
+          struct Buffer::Data *newData = Buffer::Create (zeroStart);
+          memcpy (newData->m_data + zeroStart - dataStart, m_data->m_data + m_start, dataStart);
+          if (AtomicDecrement (&m_data->m_count) == 0)
+            {
+              Buffer::Recycle (m_data);
+            }
+          m_data = newData;
+
+          int32_t delta = zeroStart - m_zeroAreaStart;
+          m_zeroAreaStart += delta;
+          m_zeroAreaEnd += delta;
+          m_end += delta;
+          m_start += delta;
+          m_data->m_dirtyStart = m_start;
+        }
       m_zeroAreaEnd += zeroSize;
       m_end = m_zeroAreaEnd;
       m_data->m_dirtyEnd = m_zeroAreaEnd;
-      uint32_t endData = o.m_end - o.m_zeroAreaEnd;
       AddAtEnd (endData);
       Buffer::Iterator dst = End ();
       dst.Prev (endData);
@@ -843,10 +811,13 @@ Buffer::Iterator::Write (Iterator start, Iterator end)
   uint32_t size = end.m_current - start.m_current;
   NS_ASSERT_MSG (CheckNoZero (m_current, m_current + size),
                  GetWriteErrorMessage ());
+  // The bytes after the zero area are stored right after the bytes
+  // before it
+  uint32_t shift = m_current >= m_zeroEnd ? m_zeroEnd - m_zeroStart : 0;
   if (start.m_current <= start.m_zeroStart)
     {
       uint32_t toCopy = std::min (size, start.m_zeroStart - start.m_current);
-      memcpy (&m_data[m_current], &start.m_data[start.m_current], toCopy);
+      memcpy (&m_data[m_current - shift], &start.m_data[start.m_current], toCopy);
       start.m_current += toCopy;
       m_current += toCopy;
       size -= toCopy;
@@ -854,14 +825,14 @@ Buffer::Iterator::Write (Iterator start, Iterator end)
   if (start.m_current <= start.m_zeroEnd)
     {
       uint32_t toCopy = std::min (size, start.m_zeroEnd - start.m_current);
-      memset (&m_data[m_current], 0, toCopy);
+      memset (&m_data[m_current - shift], 0, toCopy);
       start.m_current += toCopy;
       m_current += toCopy;
       size -= toCopy;
     }
   uint32_t toCopy = std::min (size, start.m_dataEnd - start.m_current);
   uint8_t *from = &start.m_data[start.m_current - (start.m_zeroEnd-start.m_zeroStart)];
-  uint8_t *to = &m_data[m_current];
+  uint8_t *to = &m_data[m_current - shift];
   memcpy (to, from, toCopy);
   m_current += toCopy;
 }
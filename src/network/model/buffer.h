@@ -24,8 +24,7 @@
 #include <vector>
 #include <ostream>
 #include "ns3/assert.h"
-
-#define BUFFER_FREE_LIST 1
+#include "ns3/atomic-count.h"
 
 namespace ns3 {
 
@@ -38,9 +37,10 @@ namespace ns3 {
  * automatically adjusted to hold any data prepended
  * or appended by the user. Its implementation is optimized
  * to ensure that the number of buffer resizes is minimized,
- * by creating new Buffers of the maximum size ever used.
- * The correct maximum size is learned at runtime during use by 
- * recording the maximum size of each packet.
+ * by creating new Buffers with room for the largest headers
+ * ever added.  That size is learned at runtime during use by
+ * recording the maximum size of the headers of each packet.
+ * The data comes from the PacketPool.
  *
  * \internal
  * The implementation of the Buffer class uses a COW (Copy On Write)
@@ -521,6 +521,11 @@ private:
    * Add bytes at the end of the Buffer.
    * Any call to this method invalidates any Iterator
    * pointing to this Buffer.
+   *
+   * When this buffer ends with its zero area and \p o starts
+   * with its zero area, the two zero areas are merged without
+   * writing any zero byte, even if the data is shared with
+   * other buffers.
    */
   void AddAtEnd (const Buffer &o);
   /**
@@ -699,6 +704,29 @@ private:
    * \returns true if the buffer status is consistent.
    */
   bool CheckInternalState (void) const;
+  /**
+   * \brief Extend the dirty area of the data to a new start.
+   *
+   * The extension only succeeds if this buffer is the only one
+   * referencing the data, or if it starts at the start of the dirty area.
+   *
+   * \param start the new start of the dirty area
+   * \returns true if the room before the start of this buffer was claimed
+   */
+  bool ClaimDirtyStart (uint32_t start);
+  /**
+   * \brief Extend the dirty area of the data to a new end.
+   *
+   * \param end the new end of the dirty area
+   * \returns true if the room after the end of this buffer was claimed
+   * \see ClaimDirtyStart
+   */
+  bool ClaimDirtyEnd (uint32_t end);
+  /**
+   * \brief Raise g_recommendedStart to the start of a zero area.
+   * \param start the largest zero area start seen by a buffer
+   */
+  static void UpdateRecommendedStart (uint32_t start);
 
   /**
    * \brief Initializes the buffer with a number of zeroes.
@@ -783,19 +811,6 @@ private:
    * instance from the start of m_data->m_data
    */
   uint32_t m_end;
-
-#ifdef BUFFER_FREE_LIST
-  /// Container for buffer data
-  typedef std::vector<struct Buffer::Data*> FreeList;
-  /// Local static destructor structure
-  struct LocalStaticDestructor 
-  {
-    ~LocalStaticDestructor ();
-  };
-  static uint32_t g_maxSize; //!< Max observed data size
-  static FreeList *g_freeList; //!< Buffer data container
-  static struct LocalStaticDestructor g_localStaticDestructor; //!< Local static destructor
-#endif
 };
 
 } // namespace ns3
@@ -1049,7 +1064,7 @@ Buffer::Buffer (Buffer const&o)
     m_start (o.m_start),
     m_end (o.m_end)
 {
-  m_data->m_count++;
+  AtomicIncrement (&m_data->m_count);
   NS_ASSERT (CheckInternalState ());
 }
 
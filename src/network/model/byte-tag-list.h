@@ -233,6 +233,17 @@ private:
    */
   ByteTagList::Iterator BeginAll (void) const;
 
+  /**
+   * \brief Extend the area of the data in use to cover new tags.
+   *
+   * The data can be written in place if this list is the only one
+   * referencing it, or if the area in use ends where this list ends.
+   *
+   * \param used the new end of the area in use
+   * \returns true if the room after the end of this list was claimed
+   */
+  bool ClaimDirty (uint32_t used);
+
   /**
    * \brief Allocate the memory for the ByteTagListData
    * \param size the memory to allocate
@@ -101,6 +101,35 @@ public:
   virtual void Print (std::ostream &os) const = 0;
 };
 
+/**
+ * \ingroup packet
+ *
+ * \brief Whether a packet may keep a header unserialized.
+ *
+ * When IsLazy returns \c true, Packet::AddHeader keeps a copy of the
+ * header object and Packet::RemoveHeader gives it back, without going
+ * through the bytes of the packet until something reads them: see
+ * LazyHeaderList.  A header type opts in with a specialization next to
+ * its declaration.  Copying the object must then give the same header
+ * as serializing and deserializing it.
+ *
+ * \tparam T \explicit The type of the header.
+ */
+template <typename T>
+struct LazyHeaderTraits
+{
+  /**
+   * Whether the type opted in.  A specialization which sets it to 1
+   * also defines
+   * \code
+   *   static bool IsLazy (const T &header);
+   * \endcode
+   * which returns \c true if the header, to add or to fill, may skip
+   * the bytes of the packet.
+   */
+  enum { ENABLED = 0 };
+};
+
 
 /**
  * \brief Stream insertion operator.
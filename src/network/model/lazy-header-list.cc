@@ -0,0 +1,104 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+\file   lazy-header-list.cc
+\brief  Implements a linked list of the headers of a Packet which are not serialized yet.
+*/
+
+#include "lazy-header-list.h"
+#include "packet-pool.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LazyHeaderList");
+
+LazyHeaderList::Item::~Item ()
+{
+}
+
+void *
+LazyHeaderList::Item::operator new (std::size_t size)
+{
+  return PacketPool::Allocate (size);
+}
+
+void
+LazyHeaderList::Item::operator delete (void *p, std::size_t size)
+{
+  PacketPool::Deallocate (p, size);
+}
+
+void
+LazyHeaderList::Push (struct Item *item, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << item << size);
+  // The new item takes over the link of the list to the old top
+  item->next = m_next;
+  item->size = size;
+  item->total = size + GetSize ();
+  item->count = 1;
+  m_next = item;
+}
+
+uint32_t
+LazyHeaderList::Remove (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_next != 0);
+  struct Item *top = m_next;
+  uint32_t size = top->size;
+  m_next = top->next;
+  if (AtomicDecrement (&top->count) == 0)
+    {
+      // The list takes over the link of the old top to the next item
+      delete top;
+    }
+  else if (m_next != 0)
+    {
+      AtomicIncrement (&m_next->count);
+    }
+  return size;
+}
+
+void
+LazyHeaderList::Flush (Buffer &buffer)
+{
+  NS_LOG_FUNCTION (this << GetSize ());
+  if (m_next == 0)
+    {
+      return;
+    }
+  buffer.AddAtStart (m_next->total);
+  Write (m_next, buffer.Begin ());
+  RemoveAll ();
+}
+
+void
+LazyHeaderList::Write (const struct Item *item, Buffer::Iterator start)
+{
+  if (item->next != 0)
+    {
+      Buffer::Iterator next = start;
+      next.Next (item->size);
+      Write (item->next, next);
+    }
+  item->GetHeader ().Serialize (start);
+}
+
+} // namespace ns3
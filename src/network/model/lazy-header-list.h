@@ -0,0 +1,306 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef LAZY_HEADER_LIST_H
+#define LAZY_HEADER_LIST_H
+
+/**
+\file   lazy-header-list.h
+\brief  Defines a linked list of the headers of a Packet which are not serialized yet.
+*/
+
+#include <stdint.h>
+#include <cstddef>
+#include "buffer.h"
+#include "header.h"
+#include "ns3/atomic-count.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup packet
+ *
+ * \brief List of the headers of a packet which are not serialized yet.
+ *
+ * This class is private to the Packet implementation and users should
+ * never have to access it directly.
+ *
+ * Packet::AddHeader stores a copy of the header object here, instead
+ * of its bytes, when LazyHeaderTraits allows it.  Packet::RemoveHeader
+ * and Packet::PeekHeader copy the object back when the header on top
+ * of the list has the requested type.  So a hop which only forwards a
+ * packet reads and rewrites its IPv4 and PPP headers without a round
+ * trip through the Buffer.  The headers are written to the Buffer by
+ * Flush as soon as something needs the bytes of the packet.
+ *
+ * The list shares its items with the copies of the packet, as
+ * PacketTagList does: the items are never modified after Add, each
+ * one counts its incoming links, and Remove and RemoveAll only delete
+ * the items up to the first one which is shared.  The items come from
+ * the PacketPool.
+ */
+class LazyHeaderList
+{
+public:
+  /**
+   * A header of the list.
+   */
+  struct Item
+  {
+    /** Destructor, which leaves the next items alone. */
+    virtual ~Item ();
+    /** \returns The header held by this item. */
+    virtual const Header &GetHeader (void) const = 0;
+
+    struct Item *next;        //!< The header which follows this one in the packet
+    uint32_t size;            //!< The serialized size of this header
+    uint32_t total;           //!< The serialized size of this header and of the next ones
+    uint32_t count;           //!< Number of incoming links
+
+    /**
+     * Allocate an Item from the PacketPool.
+     *
+     * \param [in] size The size of the Item.
+     * \returns The memory of the Item.
+     */
+    static void *operator new (std::size_t size);
+    /**
+     * Give an Item back to the PacketPool.
+     *
+     * \param [in] p The memory of the Item.
+     * \param [in] size The size of the Item.
+     */
+    static void operator delete (void *p, std::size_t size);
+  };
+
+  /**
+   * An Item which holds a header of type \p T.
+   *
+   * \tparam T \explicit The type of the header.
+   */
+  template <typename T>
+  struct HeaderItem : public Item
+  {
+    /**
+     * Constructor
+     *
+     * \param [in] h The header to copy.
+     */
+    HeaderItem (const T &h)
+      : header (h)
+    {
+    }
+    virtual const Header &GetHeader (void) const
+    {
+      return header;
+    }
+
+    T header;                 //!< The header
+  };
+
+  /**
+   * Create an empty list.
+   */
+  inline LazyHeaderList ();
+  /**
+   * Copy constructor, which shares the items of \pname{o}.
+   *
+   * \param [in] o The list to copy.
+   */
+  inline LazyHeaderList (const LazyHeaderList &o);
+  /**
+   * Assignment, which shares the items of \pname{o}.
+   *
+   * \param [in] o The list to copy.
+   * \returns This list.
+   */
+  inline LazyHeaderList &operator = (const LazyHeaderList &o);
+  /**
+   * Destructor
+   *
+   * #RemoveAll's the items up to the first shared one.
+   */
+  inline ~LazyHeaderList ();
+
+  /**
+   * Add a header on top of the list.
+   *
+   * \tparam T \deduced The type of the header.
+   * \param [in] header The header to copy.
+   * \param [in] size The serialized size of the header.
+   */
+  template <typename T>
+  void Add (const T &header, uint32_t size);
+  /**
+   * Copy the header on top of the list, if it has type \p T.
+   *
+   * \tparam T \deduced The type of the header.
+   * \param [out] header The header to set.
+   * \returns The serialized size of the header, or 0 if the list is
+   *          empty or starts with a header of another type.
+   */
+  template <typename T>
+  uint32_t Peek (T &header) const;
+  /**
+   * Remove the header on top of the list.
+   *
+   * \returns The serialized size of the header.
+   */
+  uint32_t Remove (void);
+  /**
+   * Write the headers at the start of a buffer, in front of its data,
+   * and empty the list.
+   *
+   * \param [in,out] buffer The buffer.
+   */
+  void Flush (Buffer &buffer);
+  /**
+   * Remove all the headers from this list.
+   */
+  inline void RemoveAll (void);
+  /**
+   * \returns \c true if the list holds no header.
+   */
+  inline bool IsEmpty (void) const;
+  /**
+   * \returns The serialized size of all the headers of the list.
+   */
+  inline uint32_t GetSize (void) const;
+
+private:
+  /**
+   * Put an item on top of the list.
+   *
+   * \param [in] item The new item.
+   * \param [in] size The serialized size of its header.
+   */
+  void Push (struct Item *item, uint32_t size);
+  /**
+   * Serialize the headers from \pname{item} on, the innermost one
+   * first as successive calls to Packet::AddHeader would.
+   *
+   * \param [in] item The first header to write.
+   * \param [in] start Where to write it.
+   */
+  static void Write (const struct Item *item, Buffer::Iterator start);
+
+  /**
+   * Pointer to the header on top of the list
+   */
+  struct Item *m_next;
+};
+
+} // namespace ns3
+
+/****************************************************
+ *  Implementation of inline methods for performance
+ ****************************************************/
+
+namespace ns3 {
+
+LazyHeaderList::LazyHeaderList ()
+  : m_next (0)
+{
+}
+
+LazyHeaderList::LazyHeaderList (const LazyHeaderList &o)
+  : m_next (o.m_next)
+{
+  if (m_next != 0)
+    {
+      AtomicIncrement (&m_next->count);
+    }
+}
+
+LazyHeaderList &
+LazyHeaderList::operator = (const LazyHeaderList &o)
+{
+  // self assignment
+  if (m_next == o.m_next)
+    {
+      return *this;
+    }
+  RemoveAll ();
+  m_next = o.m_next;
+  if (m_next != 0)
+    {
+      AtomicIncrement (&m_next->count);
+    }
+  return *this;
+}
+
+LazyHeaderList::~LazyHeaderList ()
+{
+  RemoveAll ();
+}
+
+void
+LazyHeaderList::RemoveAll (void)
+{
+  struct Item *prev = 0;
+  for (struct Item *cur = m_next; cur != 0; cur = cur->next)
+    {
+      if (AtomicDecrement (&cur->count) > 0)
+        {
+          break;
+        }
+      if (prev != 0)
+        {
+          delete prev;
+        }
+      prev = cur;
+    }
+  if (prev != 0)
+    {
+      delete prev;
+    }
+  m_next = 0;
+}
+
+bool
+LazyHeaderList::IsEmpty (void) const
+{
+  return m_next == 0;
+}
+
+uint32_t
+LazyHeaderList::GetSize (void) const
+{
+  return m_next == 0 ? 0 : m_next->total;
+}
+
+template <typename T>
+void
+LazyHeaderList::Add (const T &header, uint32_t size)
+{
+  Push (new HeaderItem<T> (header), size);
+}
+
+template <typename T>
+uint32_t
+LazyHeaderList::Peek (T &header) const
+{
+  const HeaderItem<T> *item = dynamic_cast<const HeaderItem<T> *> (m_next);
+  if (item == 0)
+    {
+      return 0;
+    }
+  header = item->header;
+  return item->size;
+}
+
+} // namespace ns3
+
+#endif /* LAZY_HEADER_LIST_H */
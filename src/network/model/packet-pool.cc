@@ -0,0 +1,302 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "packet-pool.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include "ns3/core-config.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <new>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif /* HAVE_PTHREAD_H */
+
+namespace {
+
+/**
+ * Sizes of the blocks of the size classes: the powers of two from 32
+ * bytes and the sizes half way between them.
+ */
+const uint32_t g_blockSizes[] = {
+  32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048, 3072,
+  4096, 6144, 8192, 12288, 16384
+};
+/** Number of size classes of pooled blocks. */
+const uint32_t POOL_CLASSES = sizeof (g_blockSizes) / sizeof (g_blockSizes[0]);
+/** Maximum number of free blocks of a class kept by a thread. */
+const uint32_t POOL_CACHE = 1024;
+
+/** A free block. */
+struct FreeBlock
+{
+  FreeBlock *next; //!< Next free block of the class
+};
+
+/** The free blocks and the counters of a size class in a thread. */
+struct PoolClass
+{
+  FreeBlock *head;      //!< Free list
+  uint32_t count;       //!< Length of the free list
+  uint64_t allocations; //!< Number of blocks allocated
+  uint64_t misses;      //!< Number of blocks from the global operator new
+  int64_t inUse;        //!< Blocks allocated minus blocks freed
+  int64_t highWater;    //!< Maximum of inUse
+};
+
+/** The pool of a thread, the last class counts the bigger blocks. */
+struct PoolCache
+{
+  PoolClass classes[POOL_CLASSES + 1]; //!< The size classes
+};
+
+/**
+ * The pool of the current thread, created on first use.  Only the
+ * pointer is thread local, which keeps the initial exec model cheap
+ * in the static TLS block.
+ */
+__thread PoolCache *g_poolCache __attribute__ ((tls_model ("initial-exec")));
+
+/** Whether the static destructors released the pool of the main thread. */
+bool g_poolDestroyed = false;
+
+/**
+ * Free the blocks and the pool of a thread.
+ * \param cache the pool of the thread
+ */
+void
+ReleasePoolCache (void *cache)
+{
+  PoolCache *c = static_cast<PoolCache *> (cache);
+  for (uint32_t i = 0; i < POOL_CLASSES; i++)
+    {
+      while (c->classes[i].head != 0)
+        {
+          FreeBlock *block = c->classes[i].head;
+          c->classes[i].head = block->next;
+          ::operator delete (block);
+        }
+    }
+  delete c;
+  g_poolCache = 0;
+}
+
+#ifdef HAVE_PTHREAD_H
+/** Key whose destructor frees the pool of an exiting thread. */
+pthread_key_t g_poolCacheKey;
+/** Creation of g_poolCacheKey. */
+pthread_once_t g_poolCacheOnce = PTHREAD_ONCE_INIT;
+
+/** Create g_poolCacheKey. */
+void
+CreatePoolCacheKey (void)
+{
+  pthread_key_create (&g_poolCacheKey, &ReleasePoolCache);
+}
+#endif /* HAVE_PTHREAD_H */
+
+/**
+ * Releases the pool of the main thread with the static destructors.
+ * The blocks freed later go straight to the global operator delete.
+ */
+struct PoolDestructor
+{
+  ~PoolDestructor ()
+  {
+    if (g_poolCache != 0)
+      {
+        ReleasePoolCache (g_poolCache);
+      }
+    g_poolDestroyed = true;
+  }
+} g_poolDestructor; //!< Release the pool of the main thread on exit
+
+/**
+ * \returns the pool of the current thread, or 0 after the static
+ * destructors ran.
+ */
+PoolCache *
+GetPoolCache (void)
+{
+  PoolCache *cache = g_poolCache;
+  if (cache != 0 || g_poolDestroyed)
+    {
+      return cache;
+    }
+  cache = new PoolCache ();
+  g_poolCache = cache;
+#ifdef HAVE_PTHREAD_H
+  pthread_once (&g_poolCacheOnce, &CreatePoolCacheKey);
+  pthread_setspecific (g_poolCacheKey, cache);
+#endif /* HAVE_PTHREAD_H */
+  return cache;
+}
+
+/**
+ * \param size a size to allocate
+ * \returns the size class which holds it, POOL_CLASSES if none
+ */
+uint32_t
+GetSizeClass (uint32_t size)
+{
+  if (size <= 32)
+    {
+      return 0;
+    }
+  // The highest bit of size - 1 selects the power of two below size
+  uint32_t bit = 31 - __builtin_clz (size - 1);
+  uint32_t sizeClass = 2 * (bit - 5);
+  sizeClass += size <= (3u << (bit - 1)) ? 1 : 2;
+  return std::min (sizeClass, POOL_CLASSES);
+}
+
+} // anonymous namespace
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("PacketPool");
+
+uint32_t
+PacketPool::GetBlockSize (uint32_t size)
+{
+  uint32_t sizeClass = GetSizeClass (size);
+  return sizeClass < POOL_CLASSES ? g_blockSizes[sizeClass] : size;
+}
+
+void *
+PacketPool::Allocate (uint32_t size)
+{
+  uint32_t sizeClass = GetSizeClass (size);
+  PoolCache *cache = GetPoolCache ();
+  if (cache == 0)
+    {
+      return ::operator new (GetBlockSize (size));
+    }
+  PoolClass *c = &cache->classes[sizeClass];
+  c->allocations++;
+  c->inUse++;
+  c->highWater = std::max (c->highWater, c->inUse);
+  FreeBlock *block = c->head;
+  if (block == 0)
+    {
+      c->misses++;
+      return ::operator new (GetBlockSize (size));
+    }
+  c->head = block->next;
+  c->count--;
+  return block;
+}
+
+void
+PacketPool::Deallocate (void *p, uint32_t size)
+{
+  uint32_t sizeClass = GetSizeClass (size);
+  PoolCache *cache = GetPoolCache ();
+  if (cache == 0)
+    {
+      ::operator delete (p);
+      return;
+    }
+  PoolClass *c = &cache->classes[sizeClass];
+  c->inUse--;
+  if (sizeClass == POOL_CLASSES || c->count >= POOL_CACHE)
+    {
+      ::operator delete (p);
+      return;
+    }
+  FreeBlock *block = static_cast<FreeBlock *> (p);
+  block->next = c->head;
+  c->head = block;
+  c->count++;
+}
+
+uint32_t
+PacketPool::GetNClasses (void)
+{
+  return POOL_CLASSES + 1;
+}
+
+PacketPool::Statistics
+PacketPool::GetStatistics (uint32_t sizeClass)
+{
+  NS_ASSERT (sizeClass <= POOL_CLASSES);
+  Statistics statistics;
+  statistics.blockSize = sizeClass < POOL_CLASSES ? g_blockSizes[sizeClass] : 0;
+  statistics.allocations = 0;
+  statistics.misses = 0;
+  statistics.inUse = 0;
+  statistics.highWater = 0;
+  PoolCache *cache = GetPoolCache ();
+  if (cache != 0)
+    {
+      const PoolClass &c = cache->classes[sizeClass];
+      statistics.allocations = c.allocations;
+      statistics.misses = c.misses;
+      statistics.inUse = c.inUse;
+      statistics.highWater = c.highWater;
+    }
+  return statistics;
+}
+
+void
+PacketPool::ResetStatistics (void)
+{
+  PoolCache *cache = GetPoolCache ();
+  if (cache == 0)
+    {
+      return;
+    }
+  for (uint32_t i = 0; i <= POOL_CLASSES; i++)
+    {
+      PoolClass *c = &cache->classes[i];
+      c->allocations = 0;
+      c->misses = 0;
+      c->highWater = c->inUse;
+    }
+}
+
+void
+PacketPool::PrintStatistics (std::ostream &os)
+{
+  os << std::setw (6) << "block"
+     << std::setw (12) << "allocations"
+     << std::setw (12) << "misses"
+     << std::setw (8) << "in use"
+     << std::setw (12) << "high water" << std::endl;
+  for (uint32_t i = 0; i < GetNClasses (); i++)
+    {
+      Statistics statistics = GetStatistics (i);
+      if (statistics.allocations == 0 && statistics.highWater == 0)
+        {
+          continue;
+        }
+      if (statistics.blockSize == 0)
+        {
+          os << std::setw (6) << ">16384";
+        }
+      else
+        {
+          os << std::setw (6) << statistics.blockSize;
+        }
+      os << std::setw (12) << statistics.allocations
+         << std::setw (12) << statistics.misses
+         << std::setw (8) << statistics.inUse
+         << std::setw (12) << statistics.highWater << std::endl;
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,95 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PACKET_POOL_H
+#define PACKET_POOL_H
+
+#include <stdint.h>
+#include <ostream>
+
+namespace ns3 {
+
+/**
+ * \ingroup packet
+ *
+ * \brief The memory of the packets and of their backing stores.
+ *
+ * The Packet objects, the data of their Buffer, PacketMetadata and
+ * ByteTagList and the nodes of their PacketTagList all come from
+ * this pool.  It rounds each size up to one of a few size classes,
+ * from 32 to 16384 bytes, and keeps up to 1024 free blocks of each
+ * class per thread: the threads of a multithreaded simulation do not
+ * share any state.  A thread may free a block allocated by another
+ * one.  The blocks bigger than 16384 bytes come from the global
+ * operator new.
+ *
+ * Since a block holds the rounded size, the users store the size
+ * returned by GetBlockSize as their capacity, and give it back to
+ * Deallocate.
+ *
+ * Each thread counts, for each class, the blocks it allocated, the
+ * blocks which came from the global operator new, and the high-water
+ * mark of the blocks in use.
+ */
+class PacketPool
+{
+public:
+  /** The counters of a size class in the current thread. */
+  struct Statistics
+  {
+    uint32_t blockSize;   //!< Size of the blocks, 0 for the bigger blocks
+    uint64_t allocations; //!< Number of blocks allocated
+    uint64_t misses;      //!< Number of blocks from the global operator new
+    int64_t inUse;        //!< Blocks allocated minus blocks freed
+    int64_t highWater;    //!< Maximum of inUse
+  };
+
+  /**
+   * \param [in] size The size to allocate.
+   * \returns The size of the block which holds it.
+   */
+  static uint32_t GetBlockSize (uint32_t size);
+  /**
+   * \param [in] size The size to allocate, rounded or not.
+   * \returns A block of GetBlockSize (size) bytes.
+   */
+  static void *Allocate (uint32_t size);
+  /**
+   * \param [in] p A block returned by Allocate.
+   * \param [in] size The size given to Allocate, or the size of the block.
+   */
+  static void Deallocate (void *p, uint32_t size);
+
+  /** \returns The number of size classes, the bigger blocks included. */
+  static uint32_t GetNClasses (void);
+  /**
+   * \param [in] sizeClass A size class, the last one holds the
+   *            blocks bigger than 16384 bytes.
+   * \returns The counters of the class in the current thread.
+   */
+  static Statistics GetStatistics (uint32_t sizeClass);
+  /** Reset the counters of the current thread, but not the blocks in use. */
+  static void ResetStatistics (void);
+  /**
+   * Print the counters of the current thread, one class per line.
+   * \param [in] os The output stream.
+   */
+  static void PrintStatistics (std::ostream &os);
+};
+
+} // namespace ns3
+
+#endif /* PACKET_POOL_H */
@@ -28,12 +28,26 @@
 #include "tag.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
+#include "packet-pool.h"
 #include <cstring>
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("PacketTagList");
 
+void *
+PacketTagList::TagData::operator new (std::size_t size)
+{
+  NS_ASSERT (size == sizeof (TagData));
+  return PacketPool::Allocate (size);
+}
+
+void
+PacketTagList::TagData::operator delete (void *p)
+{
+  PacketPool::Deallocate (p, sizeof (TagData));
+}
+
 bool
 PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
 {
@@ -56,7 +70,7 @@ PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
   // Search from the head of the list until we find tid or a merge
   while (cur != 0)
     {
-      if (cur->count > 1)
+      if (AtomicLoad (&cur->count) > 1)
         {
           // found merge
           NS_LOG_INFO ("found initial merge before tid");
@@ -103,7 +117,6 @@ PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
 
   // At this point cur is a merge, but untested for tid
   NS_ASSERT (cur != 0);
-  NS_ASSERT (cur->count > 1);
 
   /*
      Walk the remainder of the list, copying, until we find tid
@@ -124,6 +137,10 @@ PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
                                                 pNext   cur
 
      When we reach tid, we link past it, decrement count, and we're done.
+
+     The other lists merged into T1 may live in other threads and release
+     it meanwhile: if the count drops to zero, T1 is deleted and T1' takes
+     over its link to T2.
   */
 
   // Should normally check for null cur pointer,
@@ -131,14 +148,19 @@ PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
   while ( /* cur && */ cur->tid != tid)
     {
       NS_ASSERT (cur != 0);
-      NS_ASSERT (cur->count > 1);
-      cur->count--;                       // unmerge cur
       struct TagData * copy = new struct TagData ();
       copy->tid = cur->tid;
       copy->count = 1;
       memcpy (copy->data, cur->data, TagData::MAX_SIZE);
       copy->next = cur->next;             // merge into tail
-      copy->next->count++;                // mark new merge
+      if (AtomicDecrement (&cur->count) == 0)
+        {
+          delete cur;                     // released by the others
+        }
+      else
+        {
+          AtomicIncrement (&copy->next->count); // mark new merge
+        }
       *prevNext = copy;                   // point prior list at copy
       prevNext = &copy->next;             // advance
       cur      =  copy->next;
@@ -146,7 +168,6 @@ PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
   // Sanity check:
   NS_ASSERT (cur != 0);                 // cur should be non-zero
   NS_ASSERT (cur->tid == tid);          // cur->tid should be tid
-  NS_ASSERT (cur->count > 1);           // cur should be a merge
 
   // link around tid, removing it from our list
   found = (this->*Writer)(tag, false, cur, prevNext);
@@ -183,11 +204,15 @@ PacketTagList::RemoveWriter (Tag & tag, bool preMerge,
     {
       // cur is always a merge at this point
       // unmerge cur, since we linked around it already
-      cur->count--;
-      if (cur->next != 0)
+      if (AtomicDecrement (&cur->count) == 0)
+        {
+          // released by the others meanwhile, its link to next is ours
+          delete cur;
+        }
+      else if (cur->next != 0)
         {
           // there's a next, so make it a merge
-          cur->next->count++;
+          AtomicIncrement (&cur->next->count);
         }
     }
   return found;
@@ -224,16 +249,19 @@ PacketTagList::ReplaceWriter (Tag & tag, bool preMerge,
     {
       // cur is always a merge at this point
       // need to copy, replace, and link past cur
-      cur->count--;                     // unmerge cur
       struct TagData * copy = new struct TagData ();
       copy->tid = tag.GetInstanceTypeId ();
       copy->count = 1;
       tag.Serialize (TagBuffer (copy->data,
                                 copy->data + tag.GetSerializedSize ()));
       copy->next = cur->next;           // merge into tail
-      if (copy->next != 0)
+      if (AtomicDecrement (&cur->count) == 0)
+        {
+          delete cur;                   // released by the others
+        }
+      else if (copy->next != 0)
         {
-          copy->next->count++;          // mark new merge
+          AtomicIncrement (&copy->next->count); // mark new merge
         }
       *prevNext = copy;                 // point prior list at copy
     }
@@ -26,8 +26,10 @@
 */
 
 #include <stdint.h>
+#include <cstddef>
 #include <ostream>
 #include "ns3/type-id.h"
+#include "ns3/atomic-count.h"
 
 namespace ns3 {
 
@@ -124,6 +126,10 @@ class Tag;
  * \n
  * Packet tags must serialize to a finite maximum size, see TagData
  *
+ * The TagData come from the PacketPool: the tags added and removed
+ * at each hop reuse the same blocks instead of calling the global
+ * operator new.
+ *
  * This documentation entitles the original author to a free beer.
  */
 class PacketTagList 
@@ -165,6 +171,20 @@ public:
     struct TagData * next;   /**< Pointer to next in list */
     TypeId tid;               /**< Type of the tag serialized into #data */
     uint32_t count;           /**< Number of incoming links */
+
+    /**
+     * Allocate a TagData from the PacketPool.
+     *
+     * \param [in] size The size of a TagData.
+     * \returns The memory of the TagData.
+     */
+    static void *operator new (std::size_t size);
+    /**
+     * Give a TagData back to the PacketPool.
+     *
+     * \param [in] p The memory of the TagData.
+     */
+    static void operator delete (void *p);
   };  /* struct TagData */
 
   /**
@@ -311,7 +331,7 @@ PacketTagList::PacketTagList (PacketTagList const &o)
 {
   if (m_next != 0)
     {
-      m_next->count++;
+      AtomicIncrement (&m_next->count);
     }
 }
 
@@ -327,7 +347,7 @@ PacketTagList::operator = (PacketTagList const &o)
   m_next = o.m_next;
   if (m_next != 0) 
     {
-      m_next->count++;
+      AtomicIncrement (&m_next->count);
     }
   return *this;
 }
@@ -343,8 +363,7 @@ PacketTagList::RemoveAll (void)
   struct TagData *prev = 0;
   for (struct TagData *cur = m_next; cur != 0; cur = cur->next)
     {
-      cur->count--;
-      if (cur->count > 0) 
+      if (AtomicDecrement (&cur->count) > 0)
         {
           break;
         }
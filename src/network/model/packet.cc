@@ -18,6 +18,7 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 #include "packet.h"
+#include "packet-pool.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
@@ -127,8 +128,21 @@ Packet::Copy (void) const
   return Ptr<Packet> (new Packet (*this), false);
 }
 
+void *
+Packet::operator new (std::size_t size)
+{
+  return PacketPool::Allocate (size);
+}
+
+void
+Packet::operator delete (void *p, std::size_t size)
+{
+  PacketPool::Deallocate (p, size);
+}
+
 Packet::Packet ()
   : m_buffer (),
+    m_lazyHeaders (),
     m_byteTagList (),
     m_packetTagList (),
     /* The upper 32 bits of the packet id in 
@@ -137,14 +151,15 @@ Packet::Packet ()
      * zero.  The lower 32 bits are for the 
      * global UID
      */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, 0),
+    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 |
+                AtomicFetchAndIncrement (&m_globalUid), 0),
     m_nixVector (0)
 {
-  m_globalUid++;
 }
 
 Packet::Packet (const Packet &o)
   : m_buffer (o.m_buffer),
+    m_lazyHeaders (o.m_lazyHeaders),
     m_byteTagList (o.m_byteTagList),
     m_packetTagList (o.m_packetTagList),
     m_metadata (o.m_metadata)
@@ -161,6 +176,7 @@ Packet::operator = (const Packet &o)
       return *this;
     }
   m_buffer = o.m_buffer;
+  m_lazyHeaders = o.m_lazyHeaders;
   m_byteTagList = o.m_byteTagList;
   m_packetTagList = o.m_packetTagList;
   m_metadata = o.m_metadata;
@@ -171,6 +187,7 @@ Packet::operator = (const Packet &o)
 
 Packet::Packet (uint32_t size)
   : m_buffer (size),
+    m_lazyHeaders (),
     m_byteTagList (),
     m_packetTagList (),
     /* The upper 32 bits of the packet id in 
@@ -179,13 +196,14 @@ Packet::Packet (uint32_t size)
      * zero.  The lower 32 bits are for the 
      * global UID
      */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, size),
+    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 |
+                AtomicFetchAndIncrement (&m_globalUid), size),
     m_nixVector (0)
 {
-  m_globalUid++;
 }
 Packet::Packet (uint8_t const *buffer, uint32_t size, bool magic)
   : m_buffer (0, false),
+    m_lazyHeaders (),
     m_byteTagList (),
     m_packetTagList (),
     m_metadata (0,0),
@@ -197,6 +215,7 @@ Packet::Packet (uint8_t const *buffer, uint32_t size, bool magic)
 
 Packet::Packet (uint8_t const*buffer, uint32_t size)
   : m_buffer (),
+    m_lazyHeaders (),
     m_byteTagList (),
     m_packetTagList (),
     /* The upper 32 bits of the packet id in 
@@ -205,10 +224,10 @@ Packet::Packet (uint8_t const*buffer, uint32_t size)
      * zero.  The lower 32 bits are for the 
      * global UID
      */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, size),
+    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 |
+                AtomicFetchAndIncrement (&m_globalUid), size),
     m_nixVector (0)
 {
-  m_globalUid++;
   m_buffer.AddAtStart (size);
   Buffer::Iterator i = m_buffer.Begin ();
   i.Write (buffer, size);
@@ -217,6 +236,7 @@ Packet::Packet (uint8_t const*buffer, uint32_t size)
 Packet::Packet (const Buffer &buffer,  const ByteTagList &byteTagList, 
                 const PacketTagList &packetTagList, const PacketMetadata &metadata)
   : m_buffer (buffer),
+    m_lazyHeaders (),
     m_byteTagList (byteTagList),
     m_packetTagList (packetTagList),
     m_metadata (metadata),
@@ -228,6 +248,7 @@ Ptr<Packet>
 Packet::CreateFragment (uint32_t start, uint32_t length) const
 {
   NS_LOG_FUNCTION (this << start << length);
+  FlushHeaders ();
   Buffer buffer = m_buffer.CreateFragment (start, length);
   ByteTagList byteTagList = m_byteTagList;
   byteTagList.Adjust (-start);
@@ -258,6 +279,7 @@ Packet::AddHeader (const Header &header)
 {
   uint32_t size = header.GetSerializedSize ();
   NS_LOG_FUNCTION (this << header.GetInstanceTypeId ().GetName () << size);
+  FlushHeaders ();
   m_buffer.AddAtStart (size);
   m_byteTagList.Adjust (size);
   m_byteTagList.AddAtStart (size);
@@ -267,6 +289,7 @@ Packet::AddHeader (const Header &header)
 uint32_t
 Packet::RemoveHeader (Header &header)
 {
+  FlushHeaders ();
   uint32_t deserialized = header.Deserialize (m_buffer.Begin ());
   NS_LOG_FUNCTION (this << header.GetInstanceTypeId ().GetName () << deserialized);
   m_buffer.RemoveAtStart (deserialized);
@@ -277,11 +300,29 @@ Packet::RemoveHeader (Header &header)
 uint32_t
 Packet::PeekHeader (Header &header) const
 {
+  FlushHeaders ();
   uint32_t deserialized = header.Deserialize (m_buffer.Begin ());
   NS_LOG_FUNCTION (this << header.GetInstanceTypeId ().GetName () << deserialized);
   return deserialized;
 }
 void
+Packet::AddLazyHeader (const Header &header, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << header.GetInstanceTypeId ().GetName () << size);
+  m_byteTagList.Adjust (size);
+  m_byteTagList.AddAtStart (size);
+  m_metadata.AddHeader (header, size);
+}
+uint32_t
+Packet::RemoveLazyHeader (const Header &header)
+{
+  uint32_t size = m_lazyHeaders.Remove ();
+  NS_LOG_FUNCTION (this << header.GetInstanceTypeId ().GetName () << size);
+  m_byteTagList.Adjust (-size);
+  m_metadata.RemoveHeader (header, size);
+  return size;
+}
+void
 Packet::AddTrailer (const Trailer &trailer)
 {
   uint32_t size = trailer.GetSerializedSize ();
@@ -295,6 +336,7 @@ Packet::AddTrailer (const Trailer &trailer)
 uint32_t
 Packet::RemoveTrailer (Trailer &trailer)
 {
+  FlushHeaders ();
   uint32_t deserialized = trailer.Deserialize (m_buffer.End ());
   NS_LOG_FUNCTION (this << trailer.GetInstanceTypeId ().GetName () << deserialized);
   m_buffer.RemoveAtEnd (deserialized);
@@ -304,6 +346,7 @@ Packet::RemoveTrailer (Trailer &trailer)
 uint32_t
 Packet::PeekTrailer (Trailer &trailer)
 {
+  FlushHeaders ();
   uint32_t deserialized = trailer.Deserialize (m_buffer.End ());
   NS_LOG_FUNCTION (this << trailer.GetInstanceTypeId ().GetName () << deserialized);
   return deserialized;
@@ -313,6 +356,7 @@ void
 Packet::AddAtEnd (Ptr<const Packet> packet)
 {
   NS_LOG_FUNCTION (this << packet << packet->GetSize ());
+  packet->FlushHeaders ();
   m_byteTagList.AddAtEnd (GetSize ());
   ByteTagList copy = packet->m_byteTagList;
   copy.AddAtStart (0);
@@ -333,6 +377,7 @@ void
 Packet::RemoveAtEnd (uint32_t size)
 {
   NS_LOG_FUNCTION (this << size);
+  FlushHeaders ();
   m_buffer.RemoveAtEnd (size);
   m_metadata.RemoveAtEnd (size);
 }
@@ -340,6 +385,7 @@ void
 Packet::RemoveAtStart (uint32_t size)
 {
   NS_LOG_FUNCTION (this << size);
+  FlushHeaders ();
   m_buffer.RemoveAtStart (size);
   m_byteTagList.Adjust (-size);
   m_metadata.RemoveAtStart (size);
@@ -355,12 +401,14 @@ Packet::RemoveAllByteTags (void)
 uint32_t 
 Packet::CopyData (uint8_t *buffer, uint32_t size) const
 {
+  FlushHeaders ();
   return m_buffer.CopyData (buffer, size);
 }
 
 void
 Packet::CopyData (std::ostream *os, uint32_t size) const
 {
+  FlushHeaders ();
   return m_buffer.CopyData (os, size);
 }
 
@@ -411,6 +459,7 @@ Packet::ToString() const
 void 
 Packet::Print (std::ostream &os) const
 {
+  FlushHeaders ();
   PacketMetadata::ItemIterator i = m_metadata.BeginItem (m_buffer);
   while (i.HasNext ())
     {
@@ -528,6 +577,7 @@ Packet::Print (std::ostream &os) const
 PacketMetadata::ItemIterator 
 Packet::BeginItem (void) const
 {
+  FlushHeaders ();
   return m_metadata.BeginItem (m_buffer);
 }
 
@@ -549,6 +599,8 @@ uint32_t Packet::GetSerializedSize (void) const
 {
   uint32_t size = 0;
 
+  FlushHeaders ();
+
   if (m_nixVector)
     {
       // increment total size by the size of the nix-vector
@@ -593,6 +645,8 @@ Packet::Serialize (uint8_t* buffer, uint32_t maxSize) const
   uint32_t* p = reinterpret_cast<uint32_t *> (buffer);
   uint32_t size = 0;
 
+  FlushHeaders ();
+
   // if nix-vector exists, serialize it
   if (m_nixVector)
     {
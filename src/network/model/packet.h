@@ -21,6 +21,7 @@
 #define PACKET_H
 
 #include <stdint.h>
+#include <cstddef>
 #include "buffer.h"
 #include "header.h"
 #include "trailer.h"
@@ -28,12 +29,14 @@
 #include "tag.h"
 #include "byte-tag-list.h"
 #include "packet-tag-list.h"
+#include "lazy-header-list.h"
 #include "nix-vector.h"
 #include "ns3/mac48-address.h"
 #include "ns3/callback.h"
 #include "ns3/assert.h"
 #include "ns3/ptr.h"
 #include "ns3/deprecated.h"
+#include "ns3/int-to-type.h"
 
 namespace ns3 {
 
@@ -244,14 +247,29 @@ public:
    * \return the copied object
    */
   Packet &operator = (const Packet &o);
+  /**
+   * \brief Allocate a packet from the PacketPool
+   * \param size the size of a Packet
+   * \returns the memory of the packet
+   */
+  static void *operator new (std::size_t size);
+  /**
+   * \brief Give the memory of a packet back to the PacketPool
+   * \param p the memory of the packet
+   * \param size the size of a Packet
+   */
+  static void operator delete (void *p, std::size_t size);
   /**
    * \brief Create a packet with a zero-filled payload.
    *
    * The memory necessary for the payload is not allocated:
    * it will be allocated at any later point if you attempt
-   * to fragment this packet or to access the zero-filled
-   * bytes. The packet is allocated with a new uid (as 
-   * returned by getUid).
+   * to access the zero-filled bytes. Adding and removing
+   * headers, fragmenting the packet, concatenating it with
+   * other such packets and serializing it never touch the
+   * payload, which makes it a virtual payload for the
+   * simulations which do not read it. The packet is
+   * allocated with a new uid (as returned by getUid).
    * 
    * \param size the size of the zero-filled payload
    */
@@ -327,6 +345,44 @@ public:
    * \returns the number of bytes read from the packet.
    */
   uint32_t PeekHeader (Header &header) const;
+  /**
+   * \brief Add header to this packet, unserialized if its type allows it.
+   *
+   * When LazyHeaderTraits<T>::IsLazy is true for \pname{header}, the
+   * packet keeps a copy of it and writes its bytes only when something
+   * reads the bytes of the packet.  Otherwise this is AddHeader (const
+   * Header &).
+   *
+   * \tparam T \deduced The type of the header.
+   * \param header a reference to the header to add to this packet.
+   */
+  template <typename T>
+  void AddHeader (const T &header);
+  /**
+   * \brief Remove the header from this packet.
+   *
+   * When the header on top of the packet was added unserialized with
+   * the same type, and LazyHeaderTraits<T>::IsLazy is true for
+   * \pname{header}, this copies it back without any Deserialize.
+   * Otherwise this is RemoveHeader (Header &).
+   *
+   * \tparam T \deduced The type of the header.
+   * \param header a reference to the header to remove from the packet.
+   * \returns the number of bytes removed from the packet.
+   */
+  template <typename T>
+  uint32_t RemoveHeader (T &header);
+  /**
+   * \brief Read the header of this packet but do _not_ remove it.
+   *
+   * This is RemoveHeader (T &) without the removal.
+   *
+   * \tparam T \deduced The type of the header.
+   * \param header a reference to the header to read from the packet.
+   * \returns the number of bytes read from the packet.
+   */
+  template <typename T>
+  uint32_t PeekHeader (T &header) const;
   /**
    * \brief Add trailer to this packet.
    *
@@ -713,7 +769,70 @@ private:
 
   uint32_t Deserialize (uint8_t const*buffer, uint32_t size);
 
+  /**
+   * \brief Account for a header which AddHeader (const T &) kept in
+   * m_lazyHeaders.
+   * \param header the header
+   * \param size the serialized size of the header
+   */
+  void AddLazyHeader (const Header &header, uint32_t size);
+  /**
+   * \brief Remove the header on top of m_lazyHeaders.
+   * \param header the header, already copied from the list
+   * \returns the serialized size of the header
+   */
+  uint32_t RemoveLazyHeader (const Header &header);
+  /**
+   * \brief Write the headers of m_lazyHeaders into m_buffer.
+   *
+   * Every method which reads or splits the bytes of the packet calls
+   * it first.  It does not change the content of the packet, hence
+   * it is \c const, as AddByteTag is.
+   */
+  inline void FlushHeaders (void) const;
+  /**
+   * \brief AddHeader (const T &) for the types which did not opt in.
+   * \param header the header
+   */
+  inline void DoAddHeader (const Header &header, IntToType<0>);
+  /**
+   * \brief AddHeader (const T &) for the types which opted in.
+   * \tparam T \deduced The type of the header.
+   * \param header the header
+   */
+  template <typename T>
+  void DoAddHeader (const T &header, IntToType<1>);
+  /**
+   * \brief RemoveHeader (T &) for the types which did not opt in.
+   * \param header the header
+   * \returns the number of bytes removed from the packet.
+   */
+  inline uint32_t DoRemoveHeader (Header &header, IntToType<0>);
+  /**
+   * \brief RemoveHeader (T &) for the types which opted in.
+   * \tparam T \deduced The type of the header.
+   * \param header the header
+   * \returns the number of bytes removed from the packet.
+   */
+  template <typename T>
+  uint32_t DoRemoveHeader (T &header, IntToType<1>);
+  /**
+   * \brief PeekHeader (T &) for the types which did not opt in.
+   * \param header the header
+   * \returns the number of bytes read from the packet.
+   */
+  inline uint32_t DoPeekHeader (Header &header, IntToType<0>) const;
+  /**
+   * \brief PeekHeader (T &) for the types which opted in.
+   * \tparam T \deduced The type of the header.
+   * \param header the header
+   * \returns the number of bytes read from the packet.
+   */
+  template <typename T>
+  uint32_t DoPeekHeader (T &header, IntToType<1>) const;
+
   Buffer m_buffer;                //!< the packet buffer (it's actual contents)
+  LazyHeaderList m_lazyHeaders;   //!< the headers in front of m_buffer, not serialized yet
   ByteTagList m_byteTagList;      //!< the ByteTag list
   PacketTagList m_packetTagList;  //!< the packet's Tag list
   PacketMetadata m_metadata;      //!< the packet's metadata
@@ -772,6 +891,10 @@ std::ostream& operator<< (std::ostream& os, const Packet &packet);
  * dirty operations have been optimized for common use-cases which
  * means that most of the time, these operations will not trigger
  * data copies and will thus be still very fast.
+ *
+ * The headers whose type opted in LazyHeaderTraits are not even
+ * serialized by ns3::Packet::AddHeader: the bytes are written the first
+ * time something reads them.
  */
 
 } // namespace ns3
@@ -785,7 +908,97 @@ namespace ns3 {
 uint32_t 
 Packet::GetSize (void) const
 {
-  return m_buffer.GetSize ();
+  return m_buffer.GetSize () + m_lazyHeaders.GetSize ();
+}
+
+void
+Packet::FlushHeaders (void) const
+{
+  if (!m_lazyHeaders.IsEmpty ())
+    {
+      Packet *self = const_cast<Packet *> (this);
+      self->m_lazyHeaders.Flush (self->m_buffer);
+    }
+}
+
+template <typename T>
+void
+Packet::AddHeader (const T &header)
+{
+  DoAddHeader (header, IntToType<LazyHeaderTraits<T>::ENABLED> ());
+}
+
+template <typename T>
+uint32_t
+Packet::RemoveHeader (T &header)
+{
+  return DoRemoveHeader (header, IntToType<LazyHeaderTraits<T>::ENABLED> ());
+}
+
+template <typename T>
+uint32_t
+Packet::PeekHeader (T &header) const
+{
+  return DoPeekHeader (header, IntToType<LazyHeaderTraits<T>::ENABLED> ());
+}
+
+void
+Packet::DoAddHeader (const Header &header, IntToType<0>)
+{
+  AddHeader (header);
+}
+
+template <typename T>
+void
+Packet::DoAddHeader (const T &header, IntToType<1>)
+{
+  if (!LazyHeaderTraits<T>::IsLazy (header))
+    {
+      AddHeader (static_cast<const Header &> (header));
+      return;
+    }
+  uint32_t size = header.GetSerializedSize ();
+  m_lazyHeaders.Add (header, size);
+  AddLazyHeader (header, size);
+}
+
+uint32_t
+Packet::DoRemoveHeader (Header &header, IntToType<0>)
+{
+  return RemoveHeader (header);
+}
+
+template <typename T>
+uint32_t
+Packet::DoRemoveHeader (T &header, IntToType<1>)
+{
+  if (!LazyHeaderTraits<T>::IsLazy (header) || m_lazyHeaders.Peek (header) == 0)
+    {
+      return RemoveHeader (static_cast<Header &> (header));
+    }
+  return RemoveLazyHeader (header);
+}
+
+uint32_t
+Packet::DoPeekHeader (Header &header, IntToType<0>) const
+{
+  return PeekHeader (header);
+}
+
+template <typename T>
+uint32_t
+Packet::DoPeekHeader (T &header, IntToType<1>) const
+{
+  uint32_t size = 0;
+  if (LazyHeaderTraits<T>::IsLazy (header))
+    {
+      size = m_lazyHeaders.Peek (header);
+    }
+  if (size == 0)
+    {
+      return PeekHeader (static_cast<Header &> (header));
+    }
+  return size;
 }
 
 } // namespace ns3
@@ -359,6 +359,43 @@ BufferTest::DoRun (void)
   val2 <<= 8;
   val2 |= i.ReadU8 ();
   NS_TEST_ASSERT_MSG_EQ (val1, val2, "Bad ReadNtohU16()");
+
+  // The fragments of a zero area are concatenated without writing it
+  buffer = Buffer (1000);
+  buffer.AddAtStart (2);
+  i = buffer.Begin ();
+  i.WriteU8 (0x1);
+  i.WriteU8 (0x2);
+  buffer.AddAtEnd (1);
+  i = buffer.End ();
+  i.Prev (1);
+  i.WriteU8 (0x3);
+  frag0 = buffer.CreateFragment (0, 502);
+  frag1 = buffer.CreateFragment (502, 501);
+  frag0.AddAtEnd (frag1);
+  NS_TEST_ASSERT_MSG_EQ (frag0.GetSize (), 1003, "Bad size of the concatenated fragments");
+  NS_TEST_ASSERT_MSG_EQ (frag0.GetSerializedSize (), buffer.GetSerializedSize (),
+                         "The zero area of the fragments was written");
+  i = frag0.End ();
+  i.Prev (1);
+  NS_TEST_ASSERT_MSG_EQ (i.ReadU8 (), 0x3, "Bad end of the concatenated fragments");
+  ENSURE_WRITTEN_BYTES (frag0, 4, 0x1, 0x2, 0x0, 0x0);
+  ENSURE_WRITTEN_BYTES (buffer, 4, 0x1, 0x2, 0x0, 0x0);
+
+  // A header added to a shared buffer leaves room for the next ones
+  {
+    Buffer headers (0);
+    headers.AddAtStart (64);
+  }
+  buffer = Buffer (0);
+  buffer.AddAtStart (20);
+  frag0 = buffer;
+  frag0.RemoveAtStart (20);
+  frag0.AddAtStart (20);
+  const void *data = frag0.PeekData ();
+  frag0.AddAtStart (2);
+  NS_TEST_ASSERT_MSG_EQ (static_cast<const void *> (frag0.PeekData () + 2), data,
+                         "The second header copied the buffer again");
 }
 //-----------------------------------------------------------------------------
 class BufferTestSuite : public TestSuite
@@ -0,0 +1,89 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/packet-pool.h"
+#include "ns3/packet.h"
+#include "ns3/test.h"
+
+using namespace ns3;
+
+class PacketPoolTestCase : public TestCase
+{
+public:
+  PacketPoolTestCase ();
+  virtual void DoRun (void);
+};
+
+PacketPoolTestCase::PacketPoolTestCase ()
+  : TestCase ("Check the size classes, the reuse and the counters of the pool")
+{
+}
+
+void
+PacketPoolTestCase::DoRun (void)
+{
+  NS_TEST_EXPECT_MSG_EQ (PacketPool::GetBlockSize (1), 32, "Wrong smallest block");
+  NS_TEST_EXPECT_MSG_EQ (PacketPool::GetBlockSize (33), 48, "Wrong rounding");
+  NS_TEST_EXPECT_MSG_EQ (PacketPool::GetBlockSize (4097), 6144, "Wrong rounding");
+  NS_TEST_EXPECT_MSG_EQ (PacketPool::GetBlockSize (16384), 16384, "Wrong biggest block");
+  NS_TEST_EXPECT_MSG_EQ (PacketPool::GetBlockSize (20000), 20000, "A big block was rounded");
+
+  // A freed block is the next one of its class
+  void *block = PacketPool::Allocate (100);
+  PacketPool::Deallocate (block, 100);
+  NS_TEST_EXPECT_MSG_EQ (PacketPool::Allocate (128), block, "The block was not reused");
+  PacketPool::Deallocate (block, 128);
+
+  uint32_t sizeClass = 0;
+  while (PacketPool::GetStatistics (sizeClass).blockSize != 256)
+    {
+      sizeClass++;
+    }
+  PacketPool::ResetStatistics ();
+  PacketPool::Statistics before = PacketPool::GetStatistics (sizeClass);
+  NS_TEST_EXPECT_MSG_EQ (before.allocations, 0, "The counters were not reset");
+  NS_TEST_EXPECT_MSG_EQ (before.highWater, before.inUse, "The high water was not reset");
+  void *blocks[3];
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      blocks[i] = PacketPool::Allocate (200);
+    }
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      PacketPool::Deallocate (blocks[i], 200);
+    }
+  PacketPool::Statistics after = PacketPool::GetStatistics (sizeClass);
+  NS_TEST_EXPECT_MSG_EQ (after.allocations, 3, "Wrong number of allocations");
+  NS_TEST_EXPECT_MSG_EQ (after.inUse, before.inUse, "The blocks are still in use");
+  NS_TEST_EXPECT_MSG_EQ (after.highWater, before.inUse + 3, "Wrong high water");
+
+  // A packet reuses the block of the last packet freed
+  Ptr<Packet> p = Create<Packet> (1000);
+  Packet *first = PeekPointer (p);
+  p = 0;
+  p = Create<Packet> (1000);
+  NS_TEST_EXPECT_MSG_EQ (PeekPointer (p), first, "The packet was not reused");
+}
+
+static class PacketPoolTestSuite : public TestSuite
+{
+public:
+  PacketPoolTestSuite ()
+    : TestSuite ("packet-pool", UNIT)
+  {
+    AddTestCase (new PacketPoolTestCase (), TestCase::QUICK);
+  }
+} g_packetPoolTestSuite;
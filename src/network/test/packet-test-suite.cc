@@ -256,6 +256,53 @@ public:
 
 };
 
+/**
+ * A header which packets may keep unserialized: it writes its value
+ * twice, and counts the calls to Serialize.
+ */
+class ALazyHeader : public Header
+{
+public:
+  /**
+   * Register this type.
+   * \return The TypeId.
+   */
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("anon::ALazyHeader")
+      .SetParent<Header> ()
+      .SetGroupName ("Network")
+      .HideFromDocumentation ()
+      .AddConstructor<ALazyHeader> ()
+    ;
+    return tid;
+  }
+  virtual TypeId GetInstanceTypeId (void) const {
+    return GetTypeId ();
+  }
+  virtual uint32_t GetSerializedSize (void) const {
+    return 2;
+  }
+  virtual void Serialize (Buffer::Iterator iter) const {
+    iter.WriteU8 (m_value);
+    iter.WriteU8 (m_value);
+    m_serialized++;
+  }
+  virtual uint32_t Deserialize (Buffer::Iterator iter) {
+    m_value = iter.ReadU8 ();
+    iter.ReadU8 ();
+    return 2;
+  }
+  virtual void Print (std::ostream &os) const {
+  }
+  ALazyHeader (uint8_t value = 0)
+    : m_value (value) {}
+
+  uint8_t m_value;
+  static uint32_t m_serialized;
+};
+
+uint32_t ALazyHeader::m_serialized = 0;
 
 struct Expected
 {
@@ -269,6 +316,20 @@ struct Expected
 
 }
 
+namespace ns3 {
+
+template <>
+struct LazyHeaderTraits<ALazyHeader>
+{
+  enum { ENABLED = 1 };
+  static bool IsLazy (const ALazyHeader &)
+  {
+    return true;
+  }
+};
+
+} // namespace ns3
+
 // tag name, start, end
 #define E(a,b,c) a,b,c
 
@@ -584,6 +645,77 @@ PacketTest::DoRun (void)
   }
 }
 //--------------------------------------
+class LazyHeaderTest : public TestCase
+{
+public:
+  LazyHeaderTest ();
+private:
+  void DoRun (void);
+  std::string GetBytes (Ptr<const Packet> p);
+};
+
+LazyHeaderTest::LazyHeaderTest ()
+  : TestCase ("Headers kept unserialized by the packets")
+{
+}
+
+std::string
+LazyHeaderTest::GetBytes (Ptr<const Packet> p)
+{
+  std::string bytes (p->GetSize (), '\0');
+  p->CopyData (reinterpret_cast<uint8_t *> (&bytes[0]), bytes.size ());
+  return bytes;
+}
+
+void
+LazyHeaderTest::DoRun (void)
+{
+  ALazyHeader::m_serialized = 0;
+  Ptr<Packet> p = Create<Packet> (4);
+  p->AddByteTag (ATestTag<1> ());
+  p->AddHeader (ALazyHeader (7));
+  NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 6, "The size counts the header");
+  ByteTagIterator tags = p->GetByteTagIterator ();
+  NS_TEST_ASSERT_MSG_EQ (tags.HasNext (), true, "Lost the byte tag");
+  ByteTagIterator::Item tag = tags.Next ();
+  NS_TEST_EXPECT_MSG_EQ (tag.GetStart (), 2, "The byte tag did not move behind the header");
+  NS_TEST_EXPECT_MSG_EQ (tag.GetEnd (), 6, "The byte tag did not move behind the header");
+
+  // A forwarding hop: the copy reads and rewrites the header
+  Ptr<Packet> copy = p->Copy ();
+  ALazyHeader header;
+  NS_TEST_EXPECT_MSG_EQ (copy->PeekHeader (header), 2, "Bad size of the peeked header");
+  NS_TEST_EXPECT_MSG_EQ (static_cast<uint32_t> (header.m_value), 7, "Bad peeked header");
+  header = ALazyHeader ();
+  NS_TEST_EXPECT_MSG_EQ (copy->RemoveHeader (header), 2, "Bad size of the removed header");
+  NS_TEST_EXPECT_MSG_EQ (static_cast<uint32_t> (header.m_value), 7, "Bad removed header");
+  NS_TEST_EXPECT_MSG_EQ (copy->GetSize (), 4, "The header was not removed");
+  header.m_value = 8;
+  copy->AddHeader (header);
+  copy->AddHeader (ALazyHeader (9));
+  NS_TEST_EXPECT_MSG_EQ (ALazyHeader::m_serialized, 0, "A header was serialized");
+  NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 6, "The copy changed the original");
+
+  // Reading the bytes writes the headers, the outermost one first
+  NS_TEST_EXPECT_MSG_EQ (GetBytes (copy), std::string ("\x9\x9\x8\x8\0\0\0\0", 8),
+                         "Bad bytes of the lazy headers");
+  NS_TEST_EXPECT_MSG_EQ (ALazyHeader::m_serialized, 2, "The headers were not serialized once");
+  NS_TEST_EXPECT_MSG_EQ (copy->GetSize (), 8, "The flush changed the size");
+  NS_TEST_EXPECT_MSG_EQ (copy->RemoveHeader (header), 2, "Bad size of the serialized header");
+  NS_TEST_EXPECT_MSG_EQ (static_cast<uint32_t> (header.m_value), 9, "Bad serialized header");
+
+  // A header of another type goes on top of the serialized ones
+  p->AddHeader (ATestHeader<3> ());
+  NS_TEST_EXPECT_MSG_EQ (GetBytes (p), std::string ("\x3\x3\x3\x7\x7\0\0\0\0", 9),
+                         "Bad bytes under a serialized header");
+  ATestHeader<3> other;
+  p->RemoveHeader (other);
+  NS_TEST_EXPECT_MSG_EQ (other.m_error, false, "Bad serialized header");
+  p->RemoveHeader (header);
+  NS_TEST_EXPECT_MSG_EQ (static_cast<uint32_t> (header.m_value), 7, "Bad deserialized header");
+  NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 4, "The headers were not removed");
+}
+//--------------------------------------
 class PacketTagListTest : public TestCase
 {
 public:
@@ -805,6 +937,16 @@ PacketTagListTest::DoRun (void)
     ReplaceCheck (6);
     ReplaceCheck (7);
   }
+
+  { // Recycling
+    std::cout << GetName () << "check the TagData are recycled" << std::endl;
+    PacketTagList ptl;
+    ptl.Add (t1);
+    const PacketTagList::TagData * first = ptl.Head ();
+    ptl.Remove (t1);
+    ptl.Add (t1);
+    NS_TEST_EXPECT_MSG_EQ (ptl.Head (), first, "TagData not recycled");
+  }
   
   { // Timing
     std::cout << GetName () << "add+remove timing" << std::endl;
@@ -858,6 +1000,7 @@ PacketTestSuite::PacketTestSuite ()
   : TestSuite ("packet", UNIT)
 {
   AddTestCase (new PacketTest, TestCase::QUICK);
+  AddTestCase (new LazyHeaderTest, TestCase::QUICK);
   AddTestCase (new PacketTagListTest, TestCase::QUICK);
 }
 
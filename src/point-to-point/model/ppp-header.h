@@ -105,6 +105,23 @@ private:
   uint16_t m_protocol;
 };
 
+/**
+ * \brief A Packet keeps a PppHeader unserialized until something reads
+ * its bytes, a pcap trace for example.
+ */
+template <>
+struct LazyHeaderTraits<PppHeader>
+{
+  enum { ENABLED = 1 }; //!< PppHeader opted in
+  /**
+   * \returns true
+   */
+  static bool IsLazy (const PppHeader &)
+  {
+    return true;
+  }
+};
+
 } // namespace ns3
 
 
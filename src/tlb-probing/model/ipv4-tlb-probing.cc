@@ -61,6 +61,7 @@ Ipv4TLBProbing::Ipv4TLBProbing ()
       m_node ()
 {
     NS_LOG_FUNCTION (this);
+    m_rand = CreateObject<UniformRandomVariable> ();
 }
 
 Ipv4TLBProbing::Ipv4TLBProbing (const Ipv4TLBProbing &other)
@@ -77,6 +78,7 @@ Ipv4TLBProbing::Ipv4TLBProbing (const Ipv4TLBProbing &other)
       m_node ()
 {
     NS_LOG_FUNCTION (this);
+    m_rand = CreateObject<UniformRandomVariable> ();
 }
 
 Ipv4TLBProbing::~Ipv4TLBProbing ()
@@ -84,6 +86,14 @@ Ipv4TLBProbing::~Ipv4TLBProbing ()
     NS_LOG_FUNCTION (this);
 }
 
+int64_t
+Ipv4TLBProbing::AssignStreams (int64_t stream)
+{
+    NS_LOG_FUNCTION (this << stream);
+    m_rand->SetStream (stream);
+    return 1;
+}
+
 void
 Ipv4TLBProbing::DoDispose ()
 {
@@ -316,7 +326,7 @@ Ipv4TLBProbing::DoProbe ()
     {
         for (uint32_t i = 0; i < 10; i++) // Try 8 times
         {
-            uint32_t path = availPaths[rand() % availPaths.size ()];
+            uint32_t path = availPaths[m_rand->GetInteger (0, availPaths.size () - 1)];
             if (pathSet.find (path) != pathSet.end ())
             {
                 continue;
@@ -8,6 +8,7 @@
 #include "ns3/ipv4-address.h"
 #include "ns3/nstime.h"
 #include "ns3/event-id.h"
+#include "ns3/random-variable-stream.h"
 
 #include <vector>
 #include <map>
@@ -50,6 +51,9 @@ public:
 
     void StopProbe (Time stopTime);
 
+    // Use fixed streams for the random path choices, returns the number of streams assigned
+    int64_t AssignStreams (int64_t stream);
+
 private:
 
     void DoProbe ();
@@ -87,6 +91,8 @@ private:
 
     Ptr<Node> m_node;
 
+    Ptr<UniformRandomVariable> m_rand; // Paths probed without a best path
+
 };
 
 }
@@ -61,9 +61,12 @@ Ipv4TLB::Ipv4TLB ():
     m_epAgingTime (MicroSeconds (10000)),
     */
     // Added at Jan 12nd
-    m_flowletTimeout (MicroSeconds (5000000))
+    m_flowletTimeout (MicroSeconds (5000000)),
+    m_agingTicks (0),
+    m_dreTicks (0)
 {
     NS_LOG_FUNCTION (this);
+    m_rand = CreateObject<UniformRandomVariable> ();
 }
 
 Ipv4TLB::Ipv4TLB (const Ipv4TLB &other):
@@ -105,9 +108,12 @@ Ipv4TLB::Ipv4TLB (const Ipv4TLB &other):
     m_epCheckTime (other.m_epCheckTime),
     m_epAgingTime (other.m_epAgingTime),
     */
-    m_flowletTimeout (other.m_flowletTimeout)
+    m_flowletTimeout (other.m_flowletTimeout),
+    m_agingTicks (0),
+    m_dreTicks (0)
 {
     NS_LOG_FUNCTION (this);
+    m_rand = CreateObject<UniformRandomVariable> ();
 }
 
 TypeId
@@ -186,23 +192,26 @@ Ipv4TLB::GetTypeId (void)
     return tid;
 }
 
+int64_t
+Ipv4TLB::AssignStreams (int64_t stream)
+{
+    NS_LOG_FUNCTION (this << stream);
+    m_rand->SetStream (stream);
+    return 1;
+}
+
 void
 Ipv4TLB::AddAddressWithTor (Ipv4Address address, uint32_t torId)
 {
-    m_ipTorMap[address] = torId;
+    m_ipTorMap[address.Get ()] = torId;
 }
 
 void
 Ipv4TLB::AddAvailPath (uint32_t destTor, uint32_t path)
 {
-    std::map<uint32_t, std::vector<uint32_t> >::iterator itr = m_availablePath.find (destTor);
-    if (itr == m_availablePath.end ())
-    {
-        std::vector<uint32_t> paths;
-        m_availablePath[destTor] = paths;
-        itr = m_availablePath.find (destTor);
-    }
-    (itr->second).push_back (path);
+    TLBTorPaths &torPaths = Ipv4TLB::GetTorPaths (destTor);
+    torPaths.availPaths.push_back (path);
+    torPaths.availSlots.push_back (Ipv4TLB::GetPathSlot (torPaths, path));
 }
 
 std::vector<uint32_t>
@@ -216,33 +225,30 @@ Ipv4TLB::GetAvailPath (Ipv4Address daddr)
         return emptyVector;
     }
 
-    std::map<uint32_t, std::vector<uint32_t> >::iterator itr = m_availablePath.find (destTor);
-    if (itr == m_availablePath.end ())
+    TLBTorPaths *torPaths = Ipv4TLB::FindTorPaths (destTor);
+    if (torPaths == 0)
     {
         return emptyVector;
     }
-    return itr->second;
+    return torPaths->availPaths;
 }
 
 uint32_t
 Ipv4TLB::GetAckPath (uint32_t flowId, Ipv4Address saddr, Ipv4Address daddr)
 {
-    struct TLBAcklet acklet;
-    std::map<uint32_t, TLBAcklet>::iterator ackletItr = m_acklets.find (flowId);
+    TLBAcklet *acklet = m_acklets.Find (flowId);
 
-    if (ackletItr != m_acklets.end ())
+    if (acklet != 0)
     {
         // Existing flow
-        acklet = ackletItr->second;
-        if (Simulator::Now () - acklet.activeTime <= m_ackletTimeout) // Timeout
+        if (Simulator::Now () - acklet->activeTime <= m_ackletTimeout) // Timeout
         {
-            acklet.activeTime = Simulator::Now ();
-            m_acklets[flowId] = acklet;
-            return acklet.pathId;
+            acklet->activeTime = Simulator::Now ();
+            return acklet->pathId;
         }
 
         // Bug Fix for bad small flow FCT in black hole case
-        if (Simulator:: Now () - acklet.activeTime >= MilliSeconds (1))
+        if (Simulator:: Now () - acklet->activeTime >= MilliSeconds (1))
         {
             uint32_t destTor = 0;
             if (!Ipv4TLB::FindTorId (daddr, destTor))
@@ -251,7 +257,7 @@ Ipv4TLB::GetAckPath (uint32_t flowId, Ipv4Address saddr, Ipv4Address daddr)
                 return 0;
             }
 
-            uint32_t oldPath = acklet.pathId;
+            uint32_t oldPath = acklet->pathId;
 
             // Ipv4TLB::TimeoutPath (destTor, oldPath, false, true);
 
@@ -265,10 +271,8 @@ Ipv4TLB::GetAckPath (uint32_t flowId, Ipv4Address saddr, Ipv4Address daddr)
                 }
             }
 
-            acklet.pathId = newPath.pathId;
-            acklet.activeTime = Simulator::Now ();
-
-            m_acklets[flowId] = acklet;
+            acklet->pathId = newPath.pathId;
+            acklet->activeTime = Simulator::Now ();
 
             return newPath.pathId;
         }
@@ -288,10 +292,9 @@ Ipv4TLB::GetAckPath (uint32_t flowId, Ipv4Address saddr, Ipv4Address daddr)
         newPath = Ipv4TLB::SelectRandomPath (destTor);
     }
 
-    acklet.pathId = newPath.pathId;
-    acklet.activeTime = Simulator::Now ();
-
-    m_acklets[flowId] = acklet;
+    TLBAcklet &newAcklet = m_acklets[flowId];
+    newAcklet.pathId = newPath.pathId;
+    newAcklet.activeTime = Simulator::Now ();
 
     return newPath.pathId;
 }
@@ -322,10 +325,10 @@ Ipv4TLB::GetPath (uint32_t flowId, Ipv4Address saddr, Ipv4Address daddr)
         NS_LOG_ERROR ("Cannot find source tor id based on the given source address");
     }
 
-    std::map<uint32_t, TLBFlowInfo>::iterator flowItr = m_flowInfo.find (flowId);
+    TLBFlowInfo *flowInfo = m_flowInfo.Find (flowId);
 
     // First check if the flow is a new flow
-    if (flowItr == m_flowInfo.end ())
+    if (flowInfo == 0)
     {
         // New flow
         struct PathInfo newPath;
@@ -344,15 +347,15 @@ Ipv4TLB::GetPath (uint32_t flowId, Ipv4Address saddr, Ipv4Address daddr)
     }
     else if (m_rerouteEnable)
     {
-        Time flowActiveTime = (flowItr->second).activeTime;
-        (flowItr->second).activeTime = Simulator::Now ();
+        Time flowActiveTime = flowInfo->activeTime;
+        flowInfo->activeTime = Simulator::Now ();
 
         // Old flow
-        uint32_t oldPath = (flowItr->second).path;
+        uint32_t oldPath = flowInfo->path;
         struct PathInfo oldPathInfo = Ipv4TLB::JudgePath (destTor, oldPath);
         if (0 == 1
-                && ((flowItr->second).retransmissionSize > m_flowRetransVeryHigh
-                || (flowItr->second).timeoutCount >= 1))
+                && (flowInfo->retransmissionSize > m_flowRetransVeryHigh
+                || flowInfo->timeoutCount >= 1))
         {
             struct PathInfo newPath;
             if (Ipv4TLB::WhereToChange (destTor, newPath, true, oldPath))
@@ -383,13 +386,13 @@ Ipv4TLB::GetPath (uint32_t flowId, Ipv4Address saddr, Ipv4Address daddr)
         }
         else if ((oldPathInfo.pathType == BadPath || Simulator::Now () - flowActiveTime > m_flowletTimeout) // Trigger for rerouting
                 && oldPathInfo.quantifiedDre <= m_dreMultiply * 8  // TODO To be fixed
-                && (flowItr->second).size >= m_S
-                /*&& ((static_cast<double> ((flowItr->second).ecnSize) / (flowItr->second).size > m_ecnPortionHigh && Simulator::Now () - (flowItr->second).timeStamp >= m_T) || (flowItr->second).retransmissionSize > m_flowRetransHigh)*/
-                && Simulator::Now() - (flowItr->second).tryChangePath > MicroSeconds (100))
+                && flowInfo->size >= m_S
+                /*&& ((static_cast<double> (flowInfo->ecnSize) / flowInfo->size > m_ecnPortionHigh && Simulator::Now () - flowInfo->timeStamp >= m_T) || flowInfo->retransmissionSize > m_flowRetransHigh)*/
+                && Simulator::Now() - flowInfo->tryChangePath > MicroSeconds (100))
         {
-            if (rand () % RANDOM_BASE < static_cast<int> (RANDOM_BASE - m_pathChangePoss))
+            if (m_rand->GetInteger (0, RANDOM_BASE - 1) + m_pathChangePoss < RANDOM_BASE)
             {
-                (flowItr->second).tryChangePath = Simulator::Now ();
+                flowInfo->tryChangePath = Simulator::Now ();
                 return oldPath;
             }
             struct PathInfo newPath;
@@ -425,9 +428,9 @@ Ipv4TLB::GetPath (uint32_t flowId, Ipv4Address saddr, Ipv4Address daddr)
     }
     else
     {
-        (flowItr->second).activeTime = Simulator::Now ();
+        flowInfo->activeTime = Simulator::Now ();
 
-        uint32_t oldPath = (flowItr->second).path;
+        uint32_t oldPath = flowInfo->path;
         return oldPath;
     }
 }
@@ -435,12 +438,12 @@ Ipv4TLB::GetPath (uint32_t flowId, Ipv4Address saddr, Ipv4Address daddr)
 Time
 Ipv4TLB::GetPauseTime (uint32_t flowId)
 {
-   std::map<uint32_t, Time>::iterator itr = m_pauseTime.find (flowId);
-   if (itr == m_pauseTime.end ())
+   Time *pauseTime = m_pauseTime.Find (flowId);
+   if (pauseTime == 0)
    {
         return MicroSeconds (0);
    }
-   return itr->second;
+   return *pauseTime;
 }
 
 void
@@ -523,14 +526,14 @@ Ipv4TLB::FlowFinish (uint32_t flowId, Ipv4Address daddr)
         NS_LOG_ERROR ("Cannot find dest tor id based on the given dest address");
         return;
     }
-    std::map<uint32_t, TLBFlowInfo>::iterator itr = m_flowInfo.find (flowId);
-    if (itr == m_flowInfo.end ())
+    TLBFlowInfo *flowInfo = m_flowInfo.Find (flowId);
+    if (flowInfo == 0)
     {
         NS_LOG_ERROR ("Cannot finish a non-existing flow");
         return;
     }
 
-    Ipv4TLB::RemoveFlowFromPath (flowId, destTor, (itr->second).path);
+    Ipv4TLB::RemoveFlowFromPath (flowId, destTor, flowInfo->path);
 
 }
 
@@ -543,14 +546,7 @@ Ipv4TLB::ProbeSend (Ipv4Address daddr, uint32_t path)
         NS_LOG_ERROR ("Cannot find dest tor id based on the given dest address");
         return;
     }
-    std::pair<uint32_t, uint32_t> key = std::make_pair(destTor, path);
-    std::map<std::pair<uint32_t, uint32_t>, TLBPathInfo>::iterator itr = m_pathInfo.find (key);
-
-    if (itr == m_pathInfo.end ())
-    {
-        m_pathInfo[key] = Ipv4TLB::GetInitPathInfo (path);
-    }
-
+    Ipv4TLB::GetPathInfo (destTor, path);
 }
 
 void
@@ -605,34 +601,34 @@ Ipv4TLB::PacketReceive (uint32_t flowId, uint32_t path, uint32_t destTorId,
 bool
 Ipv4TLB::UpdateFlowInfo (uint32_t flowId, uint32_t path, uint32_t size, bool withECN, Time rtt)
 {
-    std::map<uint32_t, TLBFlowInfo>::iterator itr = m_flowInfo.find (flowId);
-    if (itr == m_flowInfo.end ())
+    TLBFlowInfo *flowInfo = m_flowInfo.Find (flowId);
+    if (flowInfo == 0)
     {
         NS_LOG_ERROR ("Cannot update info for a non-existing flow");
         return false;
     }
-    if ((itr->second).path != path)
+    if (flowInfo->path != path)
     {
         return false;
     }
-    (itr->second).size += size;
+    flowInfo->size += size;
     if (withECN)
     {
-        (itr->second).ecnSize += size;
+        flowInfo->ecnSize += size;
     }
-    (itr->second).liveTime = Simulator::Now ();
+    flowInfo->liveTime = Simulator::Now ();
 
     // Added Dec 23rd
     /*
     if (m_isSmooth)
     {
-        (itr->second).rtt = (SMOOTH_BASE - m_smoothAlpha) * (itr->second).rtt / SMOOTH_BASE + m_smoothAlpha * rtt / SMOOTH_BASE;
+        flowInfo->rtt = (SMOOTH_BASE - m_smoothAlpha) * flowInfo->rtt / SMOOTH_BASE + m_smoothAlpha * rtt / SMOOTH_BASE;
     }
     else
     {
-        if (rtt < (itr->second).rtt)
+        if (rtt < flowInfo->rtt)
         {
-            (itr->second).rtt = rtt;
+            flowInfo->rtt = rtt;
         }
     }
     */
@@ -640,19 +636,19 @@ Ipv4TLB::UpdateFlowInfo (uint32_t flowId, uint32_t path, uint32_t size, bool wit
 
     // Added Jan 11st
     /*
-    (itr->second).epAckSize += size;
+    flowInfo->epAckSize += size;
     if (withECN)
     {
-        (itr->second).epEcnSize += size;
+        flowInfo->epEcnSize += size;
     }
-    if (Simulator::Now () - (itr->second).epTimeStamp > m_epCheckTime)
+    if (Simulator::Now () - flowInfo->epTimeStamp > m_epCheckTime)
     {
-        double originalEcnPortion = (itr->second).epEcnPortion;
-        double newEcnPortition = static_cast<double> ((itr->second).epEcnSize) / (itr->second).epAckSize;
-        (itr->second).epAckSize = 1;
-        (itr->second).epEcnSize = 0;
-        (itr->second).epEcnPortion = m_epAlpha * originalEcnPortion + (1.0 - m_epAlpha) * newEcnPortition;
-        (itr->second).epTimeStamp = Simulator::Now ();
+        double originalEcnPortion = flowInfo->epEcnPortion;
+        double newEcnPortition = static_cast<double> (flowInfo->epEcnSize) / flowInfo->epAckSize;
+        flowInfo->epAckSize = 1;
+        flowInfo->epEcnSize = 0;
+        flowInfo->epEcnPortion = m_epAlpha * originalEcnPortion + (1.0 - m_epAlpha) * newEcnPortition;
+        flowInfo->epTimeStamp = Simulator::Now ();
     }
     */
     // --
@@ -663,18 +659,7 @@ Ipv4TLB::UpdateFlowInfo (uint32_t flowId, uint32_t path, uint32_t size, bool wit
 void
 Ipv4TLB::UpdatePathInfo (uint32_t destTor, uint32_t path, uint32_t size, bool withECN, Time rtt)
 {
-    std::pair<uint32_t, uint32_t> key = std::make_pair(destTor, path);
-    std::map<std::pair<uint32_t, uint32_t>, TLBPathInfo>::iterator itr = m_pathInfo.find (key);
-
-    TLBPathInfo pathInfo;
-    if (itr == m_pathInfo.end ())
-    {
-        pathInfo = Ipv4TLB::GetInitPathInfo (path);
-    }
-    else
-    {
-        pathInfo = itr->second;
-    }
+    TLBPathInfo &pathInfo = Ipv4TLB::GetPathInfo (destTor, path);
 
     pathInfo.size += size;
     if (withECN)
@@ -712,26 +697,24 @@ Ipv4TLB::UpdatePathInfo (uint32_t destTor, uint32_t path, uint32_t size, bool wi
     }
     */
     // --
-
-    m_pathInfo[key] = pathInfo;
 }
 
 bool
 Ipv4TLB::TimeoutFlow (uint32_t flowId, uint32_t path, bool &isVeryTimeout)
 {
     isVeryTimeout = false;
-    std::map<uint32_t, TLBFlowInfo>::iterator itr = m_flowInfo.find (flowId);
-    if (itr == m_flowInfo.end ())
+    TLBFlowInfo *flowInfo = m_flowInfo.Find (flowId);
+    if (flowInfo == 0)
     {
         NS_LOG_ERROR ("Cannot timeout a non-existing flow");
         return false;
     }
-    if ((itr->second).path != path)
+    if (flowInfo->path != path)
     {
         return false;
     }
-    (itr->second).timeoutCount ++;
-    if ((itr->second).timeoutCount >= m_flowTimeoutCount)
+    flowInfo->timeoutCount ++;
+    if (flowInfo->timeoutCount >= m_flowTimeoutCount)
     {
         isVeryTimeout = true;
     }
@@ -741,33 +724,31 @@ Ipv4TLB::TimeoutFlow (uint32_t flowId, uint32_t path, bool &isVeryTimeout)
 bool
 Ipv4TLB::SendFlow (uint32_t flowId, uint32_t path, uint32_t size)
 {
-    std::map<uint32_t, TLBFlowInfo>::iterator itr = m_flowInfo.find (flowId);
-    if (itr == m_flowInfo.end ())
+    TLBFlowInfo *flowInfo = m_flowInfo.Find (flowId);
+    if (flowInfo == 0)
     {
         NS_LOG_ERROR ("Cannot retransmit a non-existing flow");
         return false;
     }
-    if ((itr->second).path != path)
+    if (flowInfo->path != path)
     {
         return false;
     }
-    (itr->second).sendSize += size;
+    flowInfo->sendSize += size;
     return true;
 }
 
 void
 Ipv4TLB::SendPath (uint32_t destTor, uint32_t path, uint32_t size)
 {
-    std::pair<uint32_t, uint32_t> key = std::make_pair(destTor, path);
-    std::map<std::pair<uint32_t, uint32_t>, TLBPathInfo>::iterator itr = m_pathInfo.find (key);
-
-    if (itr == m_pathInfo.end ())
+    TLBPathInfo *pathInfo = Ipv4TLB::FindPathInfo (destTor, path);
+    if (pathInfo == 0)
     {
         NS_LOG_ERROR ("Cannot send a non-existing path");
         return;
     }
 
-    (itr->second).dreValue += size;
+    pathInfo->dreValue += size;
 }
 
 bool
@@ -775,26 +756,26 @@ Ipv4TLB::RetransFlow (uint32_t flowId, uint32_t path, uint32_t size, bool &needR
 {
     needRetranPath = false;
     needHighRetransPath = false;
-    std::map<uint32_t, TLBFlowInfo>::iterator itr = m_flowInfo.find (flowId);
-    if (itr == m_flowInfo.end ())
+    TLBFlowInfo *flowInfo = m_flowInfo.Find (flowId);
+    if (flowInfo == 0)
     {
         NS_LOG_ERROR ("Cannot retransmit a non-existing flow");
         return false;
     }
-    if ((itr->second).path != path)
+    if (flowInfo->path != path)
     {
         return false;
     }
-    if (Simulator::Now () - (itr->second).timeStamp < MicroSeconds (1000))
+    if (Simulator::Now () - flowInfo->timeStamp < MicroSeconds (1000))
     {
         return false;
     }
-    (itr->second).retransmissionSize += size;
-    if ((itr->second).retransmissionSize > m_flowRetransHigh)
+    flowInfo->retransmissionSize += size;
+    if (flowInfo->retransmissionSize > m_flowRetransHigh)
     {
         needRetranPath = true;
     }
-    if ((itr->second).retransmissionSize > m_flowRetransVeryHigh)
+    if (flowInfo->retransmissionSize > m_flowRetransVeryHigh)
     {
         needHighRetransPath = true;
     }
@@ -805,41 +786,39 @@ Ipv4TLB::RetransFlow (uint32_t flowId, uint32_t path, uint32_t size, bool &needR
 void
 Ipv4TLB::TimeoutPath (uint32_t destTor, uint32_t path, bool isProbing, bool isVeryTimeout)
 {
-    std::pair<uint32_t, uint32_t> key = std::make_pair(destTor, path);
-    std::map<std::pair<uint32_t, uint32_t>, TLBPathInfo>::iterator itr = m_pathInfo.find (key);
-    if (itr == m_pathInfo.end ())
+    TLBPathInfo *pathInfo = Ipv4TLB::FindPathInfo (destTor, path);
+    if (pathInfo == 0)
     {
         NS_LOG_ERROR ("Cannot timeout a non-existing path");
         return;
     }
     if (!isProbing)
     {
-        (itr->second).isTimeout = true;
+        pathInfo->isTimeout = true;
         if (isVeryTimeout)
         {
-            (itr->second).isVeryTimeout = true;
+            pathInfo->isVeryTimeout = true;
         }
     }
     else
     {
-        (itr->second).isProbingTimeout = true;
+        pathInfo->isProbingTimeout = true;
     }
 }
 
 void
 Ipv4TLB::RetransPath (uint32_t destTor, uint32_t path, bool needHighRetransPath)
 {
-    std::pair<uint32_t, uint32_t> key = std::make_pair(destTor, path);
-    std::map<std::pair<uint32_t, uint32_t>, TLBPathInfo>::iterator itr = m_pathInfo.find (key);
-    if (itr == m_pathInfo.end ())
+    TLBPathInfo *pathInfo = Ipv4TLB::FindPathInfo (destTor, path);
+    if (pathInfo == 0)
     {
         NS_LOG_ERROR ("Cannot timeout a non-existing path");
         return;
     }
-    (itr->second).isRetransmission = true;
+    pathInfo->isRetransmission = true;
     if (needHighRetransPath)
     {
-        (itr->second).isHighRetransmission = true;
+        pathInfo->isHighRetransmission = true;
     }
 }
 
@@ -847,6 +826,7 @@ void
 Ipv4TLB::UpdateFlowPath (uint32_t flowId, uint32_t path, uint32_t destTor)
 {
     TLBFlowInfo flowInfo;
+    flowInfo.flowId = flowId;
     flowInfo.path = path;
     flowInfo.destTor = destTor;
     flowInfo.size = 0;
@@ -874,7 +854,18 @@ Ipv4TLB::UpdateFlowPath (uint32_t flowId, uint32_t path, uint32_t destTor)
     // Added Jan 12nd
     flowInfo.activeTime = Simulator::Now ();
 
-    m_flowInfo[flowId] = flowInfo;
+    // A flow changing path keeps its place in the expiry wheel
+    TLBFlowInfo *oldFlowInfo = m_flowInfo.Find (flowId);
+    if (oldFlowInfo != 0)
+    {
+        flowInfo.expiryTick = oldFlowInfo->expiryTick;
+        *oldFlowInfo = flowInfo;
+        return;
+    }
+
+    TLBFlowInfo &newFlowInfo = m_flowInfo[flowId];
+    newFlowInfo = flowInfo;
+    Ipv4TLB::ScheduleFlowExpiry (flowId, newFlowInfo);
 }
 
 TLBPathInfo
@@ -896,6 +887,8 @@ Ipv4TLB::GetInitPathInfo (uint32_t path)
     pathInfo.timeStamp2 = Simulator::Now ();
     pathInfo.timeStamp3 = Simulator::Now ();
     pathInfo.dreValue = 0;
+    pathInfo.agingTick = m_agingTicks;
+    pathInfo.dreTick = m_dreTicks;
 
     // Added Jan 11st
     // Path ECN portion default value
@@ -912,65 +905,52 @@ Ipv4TLB::GetInitPathInfo (uint32_t path)
 void
 Ipv4TLB::AssignFlowToPath (uint32_t flowId, uint32_t destTor, uint32_t path)
 {
-    std::pair<uint32_t, uint32_t> key = std::make_pair(destTor, path);
-    std::map<std::pair<uint32_t, uint32_t>, TLBPathInfo>::iterator itr = m_pathInfo.find (key);
-
-    TLBPathInfo pathInfo;
-    if (itr == m_pathInfo.end ())
-    {
-        pathInfo = Ipv4TLB::GetInitPathInfo (path);
-    }
-    else
-    {
-        pathInfo = itr->second;
-    }
+    TLBPathInfo &pathInfo = Ipv4TLB::GetPathInfo (destTor, path);
 
     pathInfo.flowCounter ++;
-    m_pathInfo[key] = pathInfo;
 }
 
 void
 Ipv4TLB::RemoveFlowFromPath (uint32_t flowId, uint32_t destTor, uint32_t path)
 {
-    std::pair<uint32_t, uint32_t> key = std::make_pair(destTor, path);
-    std::map<std::pair<uint32_t, uint32_t>, TLBPathInfo>::iterator itr = m_pathInfo.find (key);
-    if (itr == m_pathInfo.end ())
+    TLBPathInfo *pathInfo = Ipv4TLB::FindPathInfo (destTor, path);
+    if (pathInfo == 0)
     {
         NS_LOG_ERROR ("Cannot remove flow from a non-existing path");
         return;
     }
-    if ((itr->second).flowCounter == 0)
+    if (pathInfo->flowCounter == 0)
     {
         NS_LOG_ERROR ("Cannot decrease from counter while it has reached 0");
         return;
     }
-    (itr->second).flowCounter --;
+    pathInfo->flowCounter --;
 
 }
 
 bool
 Ipv4TLB::WhereToChange (uint32_t destTor, PathInfo &newPath, bool hasOldPath, uint32_t oldPath)
 {
-    std::map<uint32_t, std::vector<uint32_t> >::iterator itr = m_availablePath.find (destTor);
+    TLBTorPaths *torPaths = Ipv4TLB::FindTorPaths (destTor);
 
-    if (itr == m_availablePath.end ())
+    if (torPaths == 0 || torPaths->availSlots.empty ())
     {
         NS_LOG_ERROR ("Cannot find available paths");
         return false;
     }
 
-    std::vector<uint32_t>::iterator vectorItr = (itr->second).begin ();
+    std::vector<uint32_t>::const_iterator slotItr = torPaths->availSlots.begin ();
 
     // Firstly, checking good path
     uint32_t minCounter = std::numeric_limits<uint32_t>::max ();
     Time minRTT = Seconds (666);
     uint32_t minRTTLevel = 5;
     uint32_t minDre = std::pow (2, m_dreQ);
-    std::vector<PathInfo> candidatePaths;
-    for ( ; vectorItr != (itr->second).end (); ++vectorItr)
+    std::vector<PathInfo> &candidatePaths = m_candidatePaths;
+    candidatePaths.clear ();
+    for ( ; slotItr != torPaths->availSlots.end (); ++slotItr)
     {
-        uint32_t pathId = *vectorItr;
-        struct PathInfo pathInfo = JudgePath (destTor, pathId);
+        struct PathInfo pathInfo = JudgeSlot (*torPaths, *slotItr);
         if (pathInfo.pathType == GoodPath)
         {
             if (m_runMode == TLB_RUNMODE_COUNTER)
@@ -1048,20 +1028,20 @@ Ipv4TLB::WhereToChange (uint32_t destTor, PathInfo &newPath, bool hasOldPath, ui
         {
             if (minCounter <= m_K)
             {
-                newPath = candidatePaths[rand () % candidatePaths.size ()];
+                newPath = candidatePaths[m_rand->GetInteger (0, candidatePaths.size () - 1)];
             }
         }
         else if (m_runMode == TLB_RUNMODE_MINRTT)
         {
-            newPath = candidatePaths[rand () % candidatePaths.size ()];
+            newPath = candidatePaths[m_rand->GetInteger (0, candidatePaths.size () - 1)];
         }
         else if (m_runMode == TLB_RUNMODE_RTT_COUNTER || m_runMode == TLB_RUNMODE_RTT_DRE)
         {
-            newPath = candidatePaths[rand () % candidatePaths.size ()];
+            newPath = candidatePaths[m_rand->GetInteger (0, candidatePaths.size () - 1)];
         }
         else
         {
-            newPath = candidatePaths[rand () % candidatePaths.size ()];
+            newPath = candidatePaths[m_rand->GetInteger (0, candidatePaths.size () - 1)];
         }
         NS_LOG_LOGIC ("Find Good Path: " << newPath.pathId);
         return true;
@@ -1086,11 +1066,10 @@ Ipv4TLB::WhereToChange (uint32_t destTor, PathInfo &newPath, bool hasOldPath, ui
     minRTT = Seconds (666);
     minDre = std::pow (2, m_dreQ);
     candidatePaths.clear ();
-    vectorItr = (itr->second).begin ();
-    for ( ; vectorItr != (itr->second).end (); ++vectorItr)
+    slotItr = torPaths->availSlots.begin ();
+    for ( ; slotItr != torPaths->availSlots.end (); ++slotItr)
     {
-        uint32_t pathId = *vectorItr;
-        struct PathInfo pathInfo = JudgePath (destTor, pathId);
+        struct PathInfo pathInfo = JudgeSlot (*torPaths, *slotItr);
         if (pathInfo.pathType == GreyPath
             && Ipv4TLB::PathLIsBetterR (pathInfo, originalPath))
         {
@@ -1169,32 +1148,31 @@ Ipv4TLB::WhereToChange (uint32_t destTor, PathInfo &newPath, bool hasOldPath, ui
         {
             if (minCounter <= m_K)
             {
-                newPath = candidatePaths[rand () % candidatePaths.size ()];
+                newPath = candidatePaths[m_rand->GetInteger (0, candidatePaths.size () - 1)];
             }
         }
         else if (m_runMode == TLB_RUNMODE_MINRTT)
         {
-            newPath = candidatePaths[rand () % candidatePaths.size ()];
+            newPath = candidatePaths[m_rand->GetInteger (0, candidatePaths.size () - 1)];
         }
         else if (m_runMode == TLB_RUNMODE_RTT_COUNTER || m_runMode == TLB_RUNMODE_RTT_DRE)
         {
-            newPath = candidatePaths[rand () % candidatePaths.size ()];
+            newPath = candidatePaths[m_rand->GetInteger (0, candidatePaths.size () - 1)];
         }
 
         else
         {
-            newPath = candidatePaths[rand () % candidatePaths.size ()];
+            newPath = candidatePaths[m_rand->GetInteger (0, candidatePaths.size () - 1)];
         }
         NS_LOG_LOGIC ("Find Grey Path: " << newPath.pathId);
         return true;
     }
 
    // Thirdly, checking bad path
-    vectorItr = (itr->second).begin ();
-    for ( ; vectorItr != (itr->second).end (); ++vectorItr)
+    slotItr = torPaths->availSlots.begin ();
+    for ( ; slotItr != torPaths->availSlots.end (); ++slotItr)
     {
-        uint32_t pathId = *vectorItr;
-        struct PathInfo pathInfo = JudgePath (destTor, pathId);
+        struct PathInfo pathInfo = JudgeSlot (*torPaths, *slotItr);
         if (pathInfo.pathType == BadPath
             && Ipv4TLB::PathLIsBetterR (pathInfo, originalPath))
         {
@@ -1212,9 +1190,9 @@ Ipv4TLB::WhereToChange (uint32_t destTor, PathInfo &newPath, bool hasOldPath, ui
 struct PathInfo
 Ipv4TLB::SelectRandomPath (uint32_t destTor)
 {
-    std::map<uint32_t, std::vector<uint32_t> >::iterator itr = m_availablePath.find (destTor);
+    TLBTorPaths *torPaths = Ipv4TLB::FindTorPaths (destTor);
 
-    if (itr == m_availablePath.end ())
+    if (torPaths == 0 || torPaths->availSlots.empty ())
     {
         NS_LOG_ERROR ("Cannot find available paths");
         PathInfo pathInfo;
@@ -1222,12 +1200,12 @@ Ipv4TLB::SelectRandomPath (uint32_t destTor)
         return pathInfo;
     }
 
-    std::vector<uint32_t>::iterator vectorItr = (itr->second).begin ();
-    std::vector<PathInfo> availablePaths;
-    for ( ; vectorItr != (itr->second).end (); ++vectorItr)
+    std::vector<uint32_t>::const_iterator slotItr = torPaths->availSlots.begin ();
+    std::vector<PathInfo> &availablePaths = m_candidatePaths;
+    availablePaths.clear ();
+    for ( ; slotItr != torPaths->availSlots.end (); ++slotItr)
     {
-        uint32_t pathId = *vectorItr;
-        struct PathInfo pathInfo = JudgePath (destTor, pathId);
+        struct PathInfo pathInfo = JudgeSlot (*torPaths, *slotItr);
         if (pathInfo.pathType == GoodPath || pathInfo.pathType == GreyPath || pathInfo.pathType == BadPath)
         {
             availablePaths.push_back (pathInfo);
@@ -1237,12 +1215,12 @@ Ipv4TLB::SelectRandomPath (uint32_t destTor)
     struct PathInfo newPath;
     if (!availablePaths.empty ())
     {
-        newPath = availablePaths[rand() % availablePaths.size ()];
+        newPath = availablePaths[m_rand->GetInteger (0, availablePaths.size () - 1)];
     }
     else
     {
-        uint32_t pathId = (itr->second)[rand() % (itr->second).size ()];
-        newPath = Ipv4TLB::JudgePath (destTor, pathId);
+        uint32_t slot = torPaths->availSlots[m_rand->GetInteger (0, torPaths->availSlots.size () - 1)];
+        newPath = Ipv4TLB::JudgeSlot (*torPaths, slot);
     }
     NS_LOG_LOGIC ("Random selection return path: " << newPath.pathId);
     return newPath;
@@ -1251,12 +1229,26 @@ Ipv4TLB::SelectRandomPath (uint32_t destTor)
 struct PathInfo
 Ipv4TLB::JudgePath (uint32_t destTor, uint32_t pathId)
 {
-    std::pair<uint32_t, uint32_t> key = std::make_pair (destTor, pathId);
-    std::map<std::pair<uint32_t, uint32_t>, TLBPathInfo>::iterator itr = m_pathInfo.find (key);
+    return Ipv4TLB::JudgePathInfo (pathId, Ipv4TLB::FindPathInfo (destTor, pathId));
+}
+
+struct PathInfo
+Ipv4TLB::JudgeSlot (TLBTorPaths &torPaths, uint32_t slot)
+{
+    if (!torPaths.hasInfo[slot])
+    {
+        return Ipv4TLB::JudgePathInfo (torPaths.pathIds[slot], 0);
+    }
+    Ipv4TLB::AgePath (torPaths.pathInfo[slot]);
+    return Ipv4TLB::JudgePathInfo (torPaths.pathIds[slot], &torPaths.pathInfo[slot]);
+}
 
+struct PathInfo
+Ipv4TLB::JudgePathInfo (uint32_t pathId, const TLBPathInfo *info)
+{
     struct PathInfo path;
     path.pathId = pathId;
-    if (itr == m_pathInfo.end ())
+    if (info == 0)
     {
         path.pathType = GreyPath;
         /*path.pathType = GoodPath;*/
@@ -1268,7 +1260,7 @@ Ipv4TLB::JudgePath (uint32_t destTor, uint32_t pathId)
         path.quantifiedDre = 0;
         return path;
     }
-    TLBPathInfo pathInfo = itr->second;
+    const TLBPathInfo &pathInfo = *info;
     path.rttMin = pathInfo.minRtt;
     path.size = pathInfo.size;
     path.ecnPortion = static_cast<double>(pathInfo.ecnSize) / pathInfo.size;
@@ -1323,101 +1315,230 @@ Ipv4TLB::PathLIsBetterR (struct PathInfo pathL, struct PathInfo pathR)
 bool
 Ipv4TLB::FindTorId (Ipv4Address daddr, uint32_t &destTorId)
 {
-    std::map<Ipv4Address, uint32_t>::iterator torItr = m_ipTorMap.find (daddr);
+    uint32_t *torId = m_ipTorMap.Find (daddr.Get ());
 
-    if (torItr == m_ipTorMap.end ())
+    if (torId == 0)
     {
         return false;
     }
-    destTorId = torItr->second;
+    destTorId = *torId;
     return true;
 }
 
+TLBTorPaths *
+Ipv4TLB::FindTorPaths (uint32_t destTor)
+{
+    uint32_t *index = m_torIndex.Find (destTor);
+    return index != 0 ? &m_torPaths[*index] : 0;
+}
+
+TLBTorPaths &
+Ipv4TLB::GetTorPaths (uint32_t destTor)
+{
+    uint32_t *index = m_torIndex.Find (destTor);
+    if (index != 0)
+    {
+        return m_torPaths[*index];
+    }
+    m_torIndex[destTor] = m_torPaths.size ();
+    m_torPaths.push_back (TLBTorPaths ());
+    m_torPaths.back ().torId = destTor;
+    return m_torPaths.back ();
+}
+
+uint32_t
+Ipv4TLB::GetPathSlot (TLBTorPaths &torPaths, uint32_t path)
+{
+    // A ToR has a handful of paths, their ids are scanned
+    for (uint32_t slot = 0; slot < torPaths.pathIds.size (); slot++)
+    {
+        if (torPaths.pathIds[slot] == path)
+        {
+            return slot;
+        }
+    }
+    torPaths.pathIds.push_back (path);
+    torPaths.hasInfo.push_back (false);
+    torPaths.pathInfo.push_back (TLBPathInfo ());
+    return torPaths.pathIds.size () - 1;
+}
+
+TLBPathInfo *
+Ipv4TLB::FindPathInfo (uint32_t destTor, uint32_t path)
+{
+    TLBTorPaths *torPaths = Ipv4TLB::FindTorPaths (destTor);
+    if (torPaths == 0)
+    {
+        return 0;
+    }
+    for (uint32_t slot = 0; slot < torPaths->pathIds.size (); slot++)
+    {
+        if (torPaths->pathIds[slot] == path)
+        {
+            if (!torPaths->hasInfo[slot])
+            {
+                return 0;
+            }
+            Ipv4TLB::AgePath (torPaths->pathInfo[slot]);
+            return &torPaths->pathInfo[slot];
+        }
+    }
+    return 0;
+}
+
+TLBPathInfo &
+Ipv4TLB::GetPathInfo (uint32_t destTor, uint32_t path)
+{
+    TLBTorPaths &torPaths = Ipv4TLB::GetTorPaths (destTor);
+    uint32_t slot = Ipv4TLB::GetPathSlot (torPaths, path);
+    if (!torPaths.hasInfo[slot])
+    {
+        torPaths.pathInfo[slot] = Ipv4TLB::GetInitPathInfo (path);
+        torPaths.hasInfo[slot] = true;
+    }
+    else
+    {
+        Ipv4TLB::AgePath (torPaths.pathInfo[slot]);
+    }
+    return torPaths.pathInfo[slot];
+}
+
 void
 Ipv4TLB::PathAging (void)
 {
-    NS_LOG_LOGIC (this << " Path Info: " << (Simulator::Now ()));
-    std::map<std::pair<uint32_t, uint32_t>, TLBPathInfo>::iterator itr = m_pathInfo.begin ();
-    for ( ; itr != m_pathInfo.end (); ++itr)
-    {
-        NS_LOG_LOGIC ("<" << (itr->first).first << "," << (itr->first).second << ">");
-        NS_LOG_LOGIC ("\t" << " Size: " << (itr->second).size
-                           << " ECN Size: " << (itr->second).ecnSize
-                           << " Min RTT: " << (itr->second).minRtt
-                           << " Is Retransmission: " << (itr->second).isRetransmission
-                           << " Is HRetransmission: " << (itr->second).isHighRetransmission
-                           << " Is Timeout: " << (itr->second).isTimeout
-                           << " Is VTimeout: " << (itr->second).isVeryTimeout
-                           << " Is ProbingTimeout: " << (itr->second).isProbingTimeout
-                           << " Flow Counter: " << (itr->second).flowCounter);
-        if (Simulator::Now() - (itr->second).timeStamp1 > m_T1)
+    m_agingEvent = Simulator::Schedule (m_agingCheckTime, &Ipv4TLB::PathAging, this);
+
+    // The paths apply the round when they are next used, see AgePath
+    if (m_agingTicks == 0)
+    {
+        m_firstAgingTime = Simulator::Now ();
+    }
+    m_agingTicks++;
+    NS_LOG_LOGIC (this << " Aging round " << m_agingTicks << " at " << Simulator::Now ());
+
+    if (m_expiryWheel.empty ())
+    {
+        return;
+    }
+
+    // Only the flows which may have reached their die time are checked
+    m_expiringFlows.clear ();
+    m_expiringFlows.swap (m_expiryWheel[m_agingTicks % m_expiryWheel.size ()]);
+    for (std::vector<uint32_t>::const_iterator flowItr = m_expiringFlows.begin (); flowItr != m_expiringFlows.end (); ++flowItr)
+    {
+        TLBFlowInfo *flowInfo = m_flowInfo.Find (*flowItr);
+        if (flowInfo == 0 || flowInfo->expiryTick != m_agingTicks)
         {
-            (itr->second).size = 1;
-            (itr->second).ecnSize = 0;
-            (itr->second).isTimeout = false;
-            (itr->second).timeStamp1 = Simulator::Now ();
+            continue;
         }
-        if (Simulator::Now () - (itr->second).timeStamp2 > m_T2)
+        if (Simulator::Now () - flowInfo->liveTime >= m_flowDieTime)
         {
-            (itr->second).isRetransmission = false;
-            (itr->second).isHighRetransmission = false;
-            (itr->second).isVeryTimeout = false;
-            (itr->second).isProbingTimeout = false;
-            (itr->second).timeStamp2 = Simulator::Now ();
+            Ipv4TLB::RemoveFlowFromPath (flowInfo->flowId, flowInfo->destTor, flowInfo->path);
+            m_flowInfo.Erase (*flowItr);
         }
-        if (Simulator::Now () - (itr->second).timeStamp3 > m_T1)
+        else
+        {
+            // The flow has been alive since it was scheduled
+            Ipv4TLB::ScheduleFlowExpiry (*flowItr, *flowInfo);
+        }
+    }
+}
+
+void
+Ipv4TLB::ScheduleFlowExpiry (uint32_t flowId, TLBFlowInfo &flowInfo)
+{
+    if (m_expiryWheel.empty ())
+    {
+        m_expiryWheel.resize (m_flowDieTime.GetTimeStep () / m_agingCheckTime.GetTimeStep () + 2);
+    }
+
+    // First aging round at or after the die time of the flow
+    int64_t step = m_agingCheckTime.GetTimeStep ();
+    Time nextRound = Simulator::Now () + Simulator::GetDelayLeft (m_agingEvent);
+    int64_t wait = (flowInfo.liveTime + m_flowDieTime - nextRound).GetTimeStep ();
+    uint64_t rounds = wait <= 0 ? 0 : (wait + step - 1) / step;
+    flowInfo.expiryTick = m_agingTicks + 1 + rounds;
+    m_expiryWheel[flowInfo.expiryTick % m_expiryWheel.size ()].push_back (flowId);
+}
+
+uint64_t
+Ipv4TLB::CountAgingResets (Time &timeStamp, Time period, uint64_t fromTick, uint64_t toTick) const
+{
+    // Round i runs at m_firstAgingTime + (i - 1) * m_agingCheckTime and resets the
+    // time stamp when it is more than period old
+    int64_t step = m_agingCheckTime.GetTimeStep ();
+    int64_t late = (timeStamp + period - m_firstAgingTime).GetTimeStep ();
+    uint64_t first = late < 0 ? 1 : late / step + 2;
+    first = std::max (first, fromTick + 1);
+    if (first > toTick)
+    {
+        return 0;
+    }
+
+    // After a reset, the next one happens every rounds
+    uint64_t every = period.GetTimeStep () / step + 1;
+    uint64_t resets = (toTick - first) / every + 1;
+    timeStamp = m_firstAgingTime + TimeStep ((first - 1 + (resets - 1) * every) * step);
+    return resets;
+}
+
+void
+Ipv4TLB::AgePath (TLBPathInfo &pathInfo)
+{
+    // Replay the PathAging rounds run since the entry was last used
+    if (pathInfo.agingTick < m_agingTicks)
+    {
+        if (Ipv4TLB::CountAgingResets (pathInfo.timeStamp1, m_T1, pathInfo.agingTick, m_agingTicks) > 0)
+        {
+            pathInfo.size = 1;
+            pathInfo.ecnSize = 0;
+            pathInfo.isTimeout = false;
+        }
+        if (Ipv4TLB::CountAgingResets (pathInfo.timeStamp2, m_T2, pathInfo.agingTick, m_agingTicks) > 0)
+        {
+            pathInfo.isRetransmission = false;
+            pathInfo.isHighRetransmission = false;
+            pathInfo.isVeryTimeout = false;
+            pathInfo.isProbingTimeout = false;
+        }
+        uint64_t rttResets = Ipv4TLB::CountAgingResets (pathInfo.timeStamp3, m_T1, pathInfo.agingTick, m_agingTicks);
+        if (rttResets > 0)
         {
             if (m_isSmooth)
             {
+                // Each reset moves the RTT towards the desired one, until it stops changing
                 Time desiredRtt = m_minRtt * m_smoothDesired / SMOOTH_BASE;
-                if ((itr->second).minRtt < desiredRtt)
+                for (uint64_t i = 0; i < rttResets; i++)
                 {
-                    (itr->second).minRtt = std::min (desiredRtt, (itr->second).minRtt * m_smoothBeta1 / SMOOTH_BASE);
-                }
-                else
-                {
-                    (itr->second).minRtt = std::max (desiredRtt, (itr->second).minRtt * m_smoothBeta2 / SMOOTH_BASE);
+                    Time minRtt = pathInfo.minRtt;
+                    if (minRtt < desiredRtt)
+                    {
+                        pathInfo.minRtt = std::min (desiredRtt, minRtt * m_smoothBeta1 / SMOOTH_BASE);
+                    }
+                    else
+                    {
+                        pathInfo.minRtt = std::max (desiredRtt, minRtt * m_smoothBeta2 / SMOOTH_BASE);
+                    }
+                    if (pathInfo.minRtt == minRtt)
+                    {
+                        break;
+                    }
                 }
             }
             else
             {
-                (itr->second).minRtt = Seconds (666);
+                pathInfo.minRtt = Seconds (666);
             }
-            (itr->second).timeStamp3 = Simulator::Now ();
         }
-
-        /*
-        if (Simulator::Now () - (itr->second).epTimeStamp > m_epAgingTime)
-        {
-            (itr->second).epAckSize = 1;
-            (itr->second).epEcnSize = 0;
-            (itr->second).epEcnPortion = m_epDefaultEcnPortion;
-            (itr->second).epTimeStamp = Simulator::Now ();
-        }
-        */
+        pathInfo.agingTick = m_agingTicks;
     }
 
-    std::map<uint32_t, TLBFlowInfo>::iterator itr2 = m_flowInfo.begin ();
-    for ( ; itr2 != m_flowInfo.end (); ++itr2)
+    // Replay the DreAging rounds, the value reaches 0 after a few of them
+    for ( ; pathInfo.dreTick < m_dreTicks && pathInfo.dreValue != 0; pathInfo.dreTick++)
     {
-        if (Simulator::Now () - (itr2->second).liveTime >= m_flowDieTime)
-        {
-            Ipv4TLB::RemoveFlowFromPath ((itr2->second).flowId, (itr2->second).destTor, (itr2->second).path);
-            m_flowInfo.erase (itr2);
-        }
-
-        /*
-        else if (Simulator::Now () - (itr2->second).epTimeStamp > m_epAgingTime)
-        {
-            (itr2->second).epAckSize = 1;
-            (itr2->second).epEcnSize = 0;
-            (itr2->second).epEcnPortion = m_epDefaultEcnPortion;
-            (itr2->second).epTimeStamp = Simulator::Now ();
-        }
-        */
+        pathInfo.dreValue *= (1 - m_dreAlpha);
     }
-
-    m_agingEvent = Simulator::Schedule (m_agingCheckTime, &Ipv4TLB::PathAging, this);
+    pathInfo.dreTick = m_dreTicks;
 }
 
 std::vector<PathInfo>
@@ -1425,16 +1546,16 @@ Ipv4TLB::GatherParallelPaths (uint32_t destTor)
 {
     std::vector<PathInfo> paths;
 
-    std::map<uint32_t, std::vector<uint32_t> >::iterator itr = m_availablePath.find (destTor);
-    if (itr == m_availablePath.end ())
+    TLBTorPaths *torPaths = Ipv4TLB::FindTorPaths (destTor);
+    if (torPaths == 0)
     {
         return paths;
     }
 
-    std::vector<uint32_t>::iterator innerItr = (itr->second).begin ();
-    for ( ; innerItr != (itr->second).end (); ++innerItr )
+    std::vector<uint32_t>::const_iterator slotItr = torPaths->availSlots.begin ();
+    for ( ; slotItr != torPaths->availSlots.end (); ++slotItr)
     {
-        paths.push_back(Ipv4TLB::JudgePath ((itr->first), *innerItr));
+        paths.push_back (Ipv4TLB::JudgeSlot (*torPaths, *slotItr));
     }
 
     return paths;
@@ -1443,13 +1564,8 @@ Ipv4TLB::GatherParallelPaths (uint32_t destTor)
 void
 Ipv4TLB::DreAging (void)
 {
-    std::map<std::pair<uint32_t, uint32_t>, TLBPathInfo>::iterator itr = m_pathInfo.begin ();
-    for ( ; itr != m_pathInfo.end (); ++itr)
-    {
-        NS_LOG_LOGIC ("<" << (itr->first).first << "," << (itr->first).second << ">");
-        (itr->second).dreValue *= (1 - m_dreAlpha);
-        NS_LOG_LOGIC ("\tDre value :" << Ipv4TLB::QuantifyDre ((itr->second).dreValue));
-    }
+    // The paths apply the round when they are next used, see AgePath
+    m_dreTicks++;
 
     m_dreEvent = Simulator::Schedule (m_dreTime, &Ipv4TLB::DreAging, this);
 }
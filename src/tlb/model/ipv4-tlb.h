@@ -8,8 +8,10 @@
 #include "ns3/ipv4-address.h"
 #include "ns3/data-rate.h"
 #include "ns3/event-id.h"
+#include "ns3/random-variable-stream.h"
 #include "tlb-flow-info.h"
 #include "tlb-path-info.h"
+#include "tlb-hash-map.h"
 
 #include <vector>
 #include <map>
@@ -22,6 +24,8 @@
 #define TLB_RUNMODE_RTT_COUNTER 11
 #define TLB_RUNMODE_RTT_DRE 12
 
+class TlbPathAgingTestCase;
+
 namespace ns3 {
 
 enum PathType {
@@ -46,6 +50,16 @@ struct TLBAcklet {
     Time activeTime;
 };
 
+// Paths towards a destination ToR, the slots of a path are the same in every array
+struct TLBTorPaths {
+    uint32_t torId;
+    std::vector<uint32_t> availPaths; // Available paths, in the order they were added
+    std::vector<uint32_t> availSlots; // Slot of each available path
+    std::vector<uint32_t> pathIds; // Path of each slot
+    std::vector<uint8_t> hasInfo; // Whether the slot has its path information yet
+    std::vector<TLBPathInfo> pathInfo; // Path information of each slot
+};
+
 class Node;
 
 class Ipv4TLB : public Object
@@ -90,12 +104,17 @@ public:
     // Node
     void SetNode (Ptr<Node> node);
 
+    // Use fixed streams for the random path choices, returns the number of streams assigned
+    int64_t AssignStreams (int64_t stream);
+
     static std::string GetPathType (PathType type);
 
     static std::string GetLogo (void);
 
 private:
 
+    friend class ::TlbPathAgingTestCase;
+
     void PacketReceive (uint32_t flowId, uint32_t path, uint32_t destTorId,
                         uint32_t size, bool withECN, Time rtt, bool isProbing);
 
@@ -129,14 +148,34 @@ private:
 
     struct PathInfo JudgePath (uint32_t destTor, uint32_t path);
 
+    struct PathInfo JudgeSlot (TLBTorPaths &torPaths, uint32_t slot);
+
+    struct PathInfo JudgePathInfo (uint32_t path, const TLBPathInfo *pathInfo);
+
     bool PathLIsBetterR (struct PathInfo pathL, struct PathInfo pathR);
 
     bool FindTorId (Ipv4Address daddr, uint32_t &destTorId);
 
+    TLBTorPaths *FindTorPaths (uint32_t destTor);
+
+    TLBTorPaths &GetTorPaths (uint32_t destTor);
+
+    uint32_t GetPathSlot (TLBTorPaths &torPaths, uint32_t path);
+
+    TLBPathInfo *FindPathInfo (uint32_t destTor, uint32_t path);
+
+    TLBPathInfo &GetPathInfo (uint32_t destTor, uint32_t path);
+
     void PathAging (void);
 
     void DreAging (void);
 
+    void AgePath (TLBPathInfo &pathInfo);
+
+    uint64_t CountAgingResets (Time &timeStamp, Time period, uint64_t fromTick, uint64_t toTick) const;
+
+    void ScheduleFlowExpiry (uint32_t flowId, TLBFlowInfo &flowInfo);
+
     std::vector<PathInfo> GatherParallelPaths (uint32_t destTor);
 
     uint32_t QuantifyRtt (Time rtt);
@@ -216,14 +255,14 @@ private:
     // --
 
     // Variables
-    std::map<uint32_t, TLBFlowInfo> m_flowInfo; /* <FlowId, TLBFlowInfo> */
-    std::map<std::pair<uint32_t, uint32_t>, TLBPathInfo> m_pathInfo; /* <DestTorId, PathId>, TLBPathInfo> */
+    TLBHashMap<TLBFlowInfo> m_flowInfo; /* <FlowId, TLBFlowInfo> */
 
-    std::map<uint32_t, TLBAcklet> m_acklets; /* <FlowId, TLBAcklet> */
+    std::vector<TLBTorPaths> m_torPaths; /* Available paths and path information of each destination ToR */
+    TLBHashMap<uint32_t> m_torIndex; /* <DestTorId, Index in m_torPaths> */
 
-    std::map<Ipv4Address, uint32_t> m_ipTorMap; /* <DestAddress, DestTorId> */
+    TLBHashMap<TLBAcklet> m_acklets; /* <FlowId, TLBAcklet> */
 
-    std::map<uint32_t, std::vector<uint32_t> > m_availablePath; /* <DestTorId, List<PathId>> */
+    TLBHashMap<uint32_t> m_ipTorMap; /* <DestAddress, DestTorId> */
 
     std::map<uint32_t, Ipv4Address> m_probingAgent; /* <DestTorId, ProbingAgentAddress>*/
 
@@ -233,7 +272,19 @@ private:
 
     Ptr<Node> m_node;
 
-    std::map<uint32_t, Time> m_pauseTime; // Used in the TCP pause, not mandatory
+    TLBHashMap<Time> m_pauseTime; // Used in the TCP pause, not mandatory
+
+    std::vector<PathInfo> m_candidatePaths; // Candidates of a path selection, reused across calls
+
+    // The aging rounds only count themselves, a path replays the rounds it missed when it is next used
+    uint64_t m_agingTicks; // PathAging rounds run so far
+    Time m_firstAgingTime; // Time of the first PathAging round, the next ones follow every m_agingCheckTime
+    uint64_t m_dreTicks; // DreAging rounds run so far
+
+    std::vector<std::vector<uint32_t> > m_expiryWheel; // Flows to check at each PathAging round, by round modulo the size
+    std::vector<uint32_t> m_expiringFlows; // Flows checked by the current round
+
+    Ptr<UniformRandomVariable> m_rand; // Random path choices
 
     typedef void (* TLBPathCallback) (uint32_t flowId, uint32_t fromTor,
             uint32_t toTor, uint32_t path, bool isRandom, PathInfo info, std::vector<PathInfo> parallelPaths);
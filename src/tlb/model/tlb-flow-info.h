@@ -24,6 +24,9 @@ public:
   Time activeTime;
   // --
 
+  // Aging round checking whether the flow is dead
+  uint64_t expiryTick;
+
   // Added at Jan 12nd
 //  Time tlbFlowletActiveTime;
   // --
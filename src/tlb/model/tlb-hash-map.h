@@ -0,0 +1,208 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef TLB_HASH_MAP_H
+#define TLB_HASH_MAP_H
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/*
+ * Open addressed hash map from 32 bit keys (flow ids, ToR ids, addresses)
+ * to the state Ipv4TLB keeps for them.  The entries live in one array,
+ * probed linearly from the home slot of the key.  The array doubles when it
+ * gets half full, and an erase shifts the following entries of the probe
+ * sequence back, so a lookup stops at the first unused slot.
+ *
+ * Pointers returned by Find are invalidated by the next insertion or erase.
+ */
+template <typename T>
+class TLBHashMap
+{
+public:
+  TLBHashMap ();
+
+  T *Find (uint32_t key);
+
+  // Find the entry of key, inserting a default one if there is none
+  T &operator[] (uint32_t key);
+
+  void Erase (uint32_t key);
+
+  uint32_t GetSize (void) const;
+
+  // The entries are visited through the slots of the array
+  uint32_t GetNSlots (void) const;
+  bool IsUsed (uint32_t slot) const;
+  uint32_t GetKey (uint32_t slot) const;
+  T &GetValue (uint32_t slot);
+
+private:
+  struct Slot
+  {
+    uint32_t key;
+    bool used;
+    T value;
+  };
+
+  uint32_t HomeSlot (uint32_t key) const;
+
+  void Grow (void);
+
+  std::vector<Slot> m_slots;
+  uint32_t m_mask;
+  uint32_t m_size;
+};
+
+template <typename T>
+TLBHashMap<T>::TLBHashMap ()
+  : m_mask (0),
+    m_size (0)
+{
+}
+
+template <typename T>
+uint32_t
+TLBHashMap<T>::HomeSlot (uint32_t key) const
+{
+  uint32_t h = key * 2654435761U;
+  return (h ^ (h >> 16)) & m_mask;
+}
+
+template <typename T>
+T *
+TLBHashMap<T>::Find (uint32_t key)
+{
+  if (m_slots.empty ())
+    {
+      return 0;
+    }
+  for (uint32_t slot = HomeSlot (key); m_slots[slot].used; slot = (slot + 1) & m_mask)
+    {
+      if (m_slots[slot].key == key)
+        {
+          return &m_slots[slot].value;
+        }
+    }
+  return 0;
+}
+
+template <typename T>
+T &
+TLBHashMap<T>::operator[] (uint32_t key)
+{
+  T *value = Find (key);
+  if (value != 0)
+    {
+      return *value;
+    }
+  if (2 * (m_size + 1) > m_slots.size ())
+    {
+      Grow ();
+    }
+  uint32_t slot = HomeSlot (key);
+  while (m_slots[slot].used)
+    {
+      slot = (slot + 1) & m_mask;
+    }
+  m_slots[slot].key = key;
+  m_slots[slot].used = true;
+  m_slots[slot].value = T ();
+  m_size++;
+  return m_slots[slot].value;
+}
+
+template <typename T>
+void
+TLBHashMap<T>::Erase (uint32_t key)
+{
+  if (m_slots.empty ())
+    {
+      return;
+    }
+  uint32_t hole = HomeSlot (key);
+  while (m_slots[hole].used && m_slots[hole].key != key)
+    {
+      hole = (hole + 1) & m_mask;
+    }
+  if (!m_slots[hole].used)
+    {
+      return;
+    }
+  m_slots[hole].used = false;
+  m_size--;
+
+  // Move back the entries whose probe sequence crosses the hole
+  for (uint32_t slot = (hole + 1) & m_mask; m_slots[slot].used; slot = (slot + 1) & m_mask)
+    {
+      uint32_t home = HomeSlot (m_slots[slot].key);
+      bool reachable = hole <= slot ? (hole < home && home <= slot) : (hole < home || home <= slot);
+      if (!reachable)
+        {
+          m_slots[hole] = m_slots[slot];
+          m_slots[slot].used = false;
+          hole = slot;
+        }
+    }
+}
+
+template <typename T>
+uint32_t
+TLBHashMap<T>::GetSize (void) const
+{
+  return m_size;
+}
+
+template <typename T>
+uint32_t
+TLBHashMap<T>::GetNSlots (void) const
+{
+  return m_slots.size ();
+}
+
+template <typename T>
+bool
+TLBHashMap<T>::IsUsed (uint32_t slot) const
+{
+  return m_slots[slot].used;
+}
+
+template <typename T>
+uint32_t
+TLBHashMap<T>::GetKey (uint32_t slot) const
+{
+  return m_slots[slot].key;
+}
+
+template <typename T>
+T &
+TLBHashMap<T>::GetValue (uint32_t slot)
+{
+  return m_slots[slot].value;
+}
+
+template <typename T>
+void
+TLBHashMap<T>::Grow (void)
+{
+  std::vector<Slot> slots;
+  slots.swap (m_slots);
+  m_slots.assign (slots.empty () ? 16 : 2 * slots.size (), Slot ());
+  m_mask = m_slots.size () - 1;
+  for (typename std::vector<Slot>::const_iterator it = slots.begin (); it != slots.end (); ++it)
+    {
+      if (it->used)
+        {
+          uint32_t slot = HomeSlot (it->key);
+          while (m_slots[slot].used)
+            {
+              slot = (slot + 1) & m_mask;
+            }
+          m_slots[slot] = *it;
+        }
+    }
+}
+
+}
+
+#endif /* TLB_HASH_MAP_H */
@@ -23,6 +23,10 @@ public:
   Time timeStamp3;
   uint32_t dreValue;
 
+  // Aging rounds of Ipv4TLB already applied to the entry
+  uint64_t agingTick;
+  uint64_t dreTick;
+
   // Added at Jan 11st
   /*
   uint32_t epAckSize;
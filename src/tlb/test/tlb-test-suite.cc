@@ -2,9 +2,12 @@
 
 // Include a header file from your module to test.
 #include "ns3/ipv4-tlb.h"
+#include "ns3/tlb-hash-map.h"
 
 // An essential include is test.h
 #include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/boolean.h"
 
 // Do not put your test classes in namespace ns3.  You may find it useful
 // to use the using directive to access the ns3 namespace directly
@@ -46,6 +49,400 @@ TlbTestCase1::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ_TOL (0.01, 0.01, 0.001, "Numbers are not equal within tolerance");
 }
 
+/**
+ * \ingroup tlb
+ * \ingroup tests
+ *
+ * \brief Insertion, lookup and erase of the TLB hash map, in probe
+ * sequences wrapping around the end of the slots.
+ */
+class TlbHashMapClusterTestCase : public TestCase
+{
+public:
+  TlbHashMapClusterTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \brief Find a key whose home slot is given, in a map of 16 slots.
+   * \param home the home slot
+   * \param after the key to search from
+   * \return the first key after after with this home slot
+   */
+  uint32_t FindKey (uint32_t home, uint32_t after);
+  /**
+   * \brief Check that each entry is found from its home slot.
+   * \param map the map
+   * \param homes the home slot of each key
+   */
+  void CheckProbes (TLBHashMap<uint32_t> &map, const std::map<uint32_t, uint32_t> &homes);
+};
+
+TlbHashMapClusterTestCase::TlbHashMapClusterTestCase ()
+  : TestCase ("TLB hash map with wrapping collision clusters")
+{
+}
+
+uint32_t
+TlbHashMapClusterTestCase::FindKey (uint32_t home, uint32_t after)
+{
+  for (uint32_t key = after + 1; ; key++)
+    {
+      TLBHashMap<uint32_t> map;
+      map[key] = 0;
+      if (map.IsUsed (home))
+        {
+          return key;
+        }
+    }
+}
+
+void
+TlbHashMapClusterTestCase::CheckProbes (TLBHashMap<uint32_t> &map, const std::map<uint32_t, uint32_t> &homes)
+{
+  uint32_t n = map.GetNSlots ();
+  uint32_t used = 0;
+  for (uint32_t slot = 0; slot < n; slot++)
+    {
+      if (!map.IsUsed (slot))
+        {
+          continue;
+        }
+      used++;
+      uint32_t key = map.GetKey (slot);
+      NS_TEST_EXPECT_MSG_EQ (map.GetValue (slot), key + 1, "Wrong value in slot " << slot);
+      std::map<uint32_t, uint32_t>::const_iterator home = homes.find (key);
+      NS_TEST_ASSERT_MSG_EQ ((home != homes.end ()), true, "Erased key " << key << " in slot " << slot);
+      // No unused slot between the home slot and the entry
+      for (uint32_t probe = home->second; probe != slot; probe = (probe + 1) % n)
+        {
+          NS_TEST_EXPECT_MSG_EQ (map.IsUsed (probe), true, "Key " << key << " unreachable from slot " << home->second);
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (used, map.GetSize (), "Wrong number of entries");
+  NS_TEST_EXPECT_MSG_EQ (used, homes.size (), "Wrong number of entries");
+  for (std::map<uint32_t, uint32_t>::const_iterator it = homes.begin (); it != homes.end (); ++it)
+    {
+      uint32_t *value = map.Find (it->first);
+      NS_TEST_ASSERT_MSG_NE (value, 0, "Key " << it->first << " not found");
+      NS_TEST_EXPECT_MSG_EQ (*value, it->first + 1, "Wrong value of key " << it->first);
+    }
+}
+
+void
+TlbHashMapClusterTestCase::DoRun (void)
+{
+  // A cluster from slot 14 to slot 2, of keys homed in 14, 15 and 0
+  uint32_t homeOf[] = { 14, 14, 15, 0, 14, 0 };
+  std::map<uint32_t, uint32_t> homes;
+  std::vector<uint32_t> keys;
+  uint32_t key = 0;
+  for (uint32_t i = 0; i < sizeof (homeOf) / sizeof (homeOf[0]); i++)
+    {
+      key = FindKey (homeOf[i], key);
+      keys.push_back (key);
+    }
+
+  TLBHashMap<uint32_t> map;
+  NS_TEST_EXPECT_MSG_EQ (map.Find (keys[0]), 0, "An empty map has no entry");
+  map.Erase (keys[0]);
+  for (uint32_t i = 0; i < keys.size (); i++)
+    {
+      map[keys[i]] = keys[i] + 1;
+      homes[keys[i]] = homeOf[i];
+    }
+  NS_TEST_ASSERT_MSG_EQ (map.GetNSlots (), 16, "The map has not grown");
+  for (uint32_t i = 0; i < keys.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (map.GetKey ((14 + i) % 16), keys[i], "Keys are placed in insertion order");
+    }
+  NS_TEST_EXPECT_MSG_EQ (map.IsUsed (4), false, "The cluster ends in slot 3");
+  NS_TEST_EXPECT_MSG_EQ (map[keys[2]], keys[2] + 1, "operator[] finds an existing entry");
+  NS_TEST_EXPECT_MSG_EQ (map.GetSize (), keys.size (), "operator[] of an existing key does not insert");
+  CheckProbes (map, homes);
+
+  // Erasing the head shifts back the entries of slots 15 to 2 across the
+  // end of the array; the last one stays, home in slot 0
+  map.Erase (keys[0]);
+  homes.erase (keys[0]);
+  NS_TEST_EXPECT_MSG_EQ (map.GetKey (14), keys[1], "The entry of slot 15 moved back to 14");
+  NS_TEST_EXPECT_MSG_EQ (map.GetKey (15), keys[2], "The entry of slot 0 moved back to 15");
+  NS_TEST_EXPECT_MSG_EQ (map.GetKey (0), keys[3], "The entry of slot 1 moved back to 0");
+  NS_TEST_EXPECT_MSG_EQ (map.GetKey (1), keys[4], "The entry of slot 2 moved back to 1");
+  NS_TEST_EXPECT_MSG_EQ (map.GetKey (2), keys[5], "The entry of slot 3 moved back to 2");
+  NS_TEST_EXPECT_MSG_EQ (map.IsUsed (3), false, "The last slot of the cluster is freed");
+  CheckProbes (map, homes);
+
+  // Erasing an entry at its home slot leaves the entries homed after it
+  map.Erase (keys[3]);
+  homes.erase (keys[3]);
+  NS_TEST_EXPECT_MSG_EQ (map.GetKey (0), keys[4], "The entry homed in 14 moved back to 0");
+  NS_TEST_EXPECT_MSG_EQ (map.GetKey (1), keys[5], "The entry homed in 0 moved back to 1");
+  CheckProbes (map, homes);
+
+  // Erasing a missing key, homed inside the cluster, changes nothing
+  map.Erase (FindKey (15, keys.back () + 1000));
+  CheckProbes (map, homes);
+
+  for (std::map<uint32_t, uint32_t>::const_iterator it = homes.begin (); it != homes.end (); )
+    {
+      map.Erase ((it++)->first);
+    }
+  homes.clear ();
+  CheckProbes (map, homes);
+  NS_TEST_EXPECT_MSG_EQ (map.GetSize (), 0, "All entries are erased");
+}
+
+/**
+ * \ingroup tlb
+ * \ingroup tests
+ *
+ * \brief Growth of the TLB hash map, and random insertions and erases
+ * checked against a std::map.
+ */
+class TlbHashMapGrowthTestCase : public TestCase
+{
+public:
+  TlbHashMapGrowthTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+TlbHashMapGrowthTestCase::TlbHashMapGrowthTestCase ()
+  : TestCase ("TLB hash map growth and random operations")
+{
+}
+
+void
+TlbHashMapGrowthTestCase::DoRun (void)
+{
+  TLBHashMap<uint32_t> map;
+  for (uint32_t key = 0; key < 8; key++)
+    {
+      map[key * 16] = key;
+    }
+  NS_TEST_EXPECT_MSG_EQ (map.GetNSlots (), 16, "Eight entries fit in 16 slots");
+  map[8 * 16] = 8;
+  NS_TEST_EXPECT_MSG_EQ (map.GetNSlots (), 32, "The map doubles when half full");
+  for (uint32_t key = 0; key <= 8; key++)
+    {
+      uint32_t *value = map.Find (key * 16);
+      NS_TEST_ASSERT_MSG_NE (value, 0, "Key " << key * 16 << " lost by the growth");
+      NS_TEST_EXPECT_MSG_EQ (*value, key, "Wrong value of key " << key * 16);
+    }
+
+  // Keys from a small range collide often; the map must agree with a
+  // std::map through growths and erases
+  map = TLBHashMap<uint32_t> ();
+  std::map<uint32_t, uint32_t> reference;
+  uint32_t state = 12345;
+  for (uint32_t i = 0; i < 20000; i++)
+    {
+      state = state * 1103515245 + 12345;
+      uint32_t key = (state >> 8) % 700;
+      if ((state >> 28) < 9)
+        {
+          map[key] = i;
+          reference[key] = i;
+        }
+      else
+        {
+          map.Erase (key);
+          reference.erase (key);
+        }
+      NS_TEST_ASSERT_MSG_EQ (map.GetSize (), reference.size (), "Wrong size after operation " << i);
+    }
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (2 * map.GetSize (), map.GetNSlots (), "The map is at most half full");
+  for (uint32_t key = 0; key < 700; key++)
+    {
+      std::map<uint32_t, uint32_t>::const_iterator it = reference.find (key);
+      uint32_t *value = map.Find (key);
+      NS_TEST_ASSERT_MSG_EQ ((value != 0), (it != reference.end ()), "Wrong presence of key " << key);
+      if (value != 0)
+        {
+          NS_TEST_EXPECT_MSG_EQ (*value, it->second, "Wrong value of key " << key);
+        }
+    }
+}
+
+/**
+ * \ingroup tlb
+ * \ingroup tests
+ *
+ * \brief The lazy aging of the TLB paths matches the per round update.
+ *
+ * A path is used at random times, with gaps from a few microseconds to
+ * many aging rounds.  A copy of its information is updated at every round
+ * the way PathAging did before the paths were aged when next used, and
+ * compared with the path at each use.
+ */
+class TlbPathAgingTestCase : public TestCase
+{
+public:
+  TlbPathAgingTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \brief Run the path through the rounds.
+   * \param smooth whether the RTT aging is smooth
+   */
+  void RunMode (bool smooth);
+  /// Create the path and its reference copy
+  void Start (void);
+  /// Apply an aging round to the reference copy
+  void ReferenceRound (void);
+  /// Compare the path with the reference copy, then use it
+  void Step (void);
+  /// \return the next pseudo random number
+  uint32_t Random (void);
+
+  Ptr<Ipv4TLB> m_tlb;    //!< The load balancer
+  TLBPathInfo m_ref;     //!< Reference copy of the path
+  uint32_t m_state;      //!< State of the pseudo random numbers
+  uint32_t m_resets;     //!< Resets of the reference copy
+  uint32_t m_steps;      //!< Uses of the path
+};
+
+TlbPathAgingTestCase::TlbPathAgingTestCase ()
+  : TestCase ("TLB paths aged when used match the per round aging")
+{
+}
+
+uint32_t
+TlbPathAgingTestCase::Random (void)
+{
+  m_state = m_state * 1103515245 + 12345;
+  return m_state >> 8;
+}
+
+void
+TlbPathAgingTestCase::Start (void)
+{
+  m_tlb->AddAvailPath (1, 2);
+  m_ref = m_tlb->GetPathInfo (1, 2);
+  Simulator::Schedule (MicroSeconds (1), &TlbPathAgingTestCase::Step, this);
+}
+
+void
+TlbPathAgingTestCase::ReferenceRound (void)
+{
+  Simulator::Schedule (m_tlb->m_agingCheckTime, &TlbPathAgingTestCase::ReferenceRound, this);
+
+  Time now = Simulator::Now ();
+  if (now - m_ref.timeStamp1 > m_tlb->m_T1)
+    {
+      m_ref.size = 1;
+      m_ref.ecnSize = 0;
+      m_ref.isTimeout = false;
+      m_ref.timeStamp1 = now;
+      m_resets++;
+    }
+  if (now - m_ref.timeStamp2 > m_tlb->m_T2)
+    {
+      m_ref.isRetransmission = false;
+      m_ref.isHighRetransmission = false;
+      m_ref.isVeryTimeout = false;
+      m_ref.isProbingTimeout = false;
+      m_ref.timeStamp2 = now;
+    }
+  if (now - m_ref.timeStamp3 > m_tlb->m_T1)
+    {
+      if (m_tlb->m_isSmooth)
+        {
+          // The smooth factors are percentages
+          Time desiredRtt = m_tlb->m_minRtt * m_tlb->m_smoothDesired / 100;
+          if (m_ref.minRtt < desiredRtt)
+            {
+              m_ref.minRtt = std::min (desiredRtt, m_ref.minRtt * m_tlb->m_smoothBeta1 / 100);
+            }
+          else
+            {
+              m_ref.minRtt = std::max (desiredRtt, m_ref.minRtt * m_tlb->m_smoothBeta2 / 100);
+            }
+        }
+      else
+        {
+          m_ref.minRtt = Seconds (666);
+        }
+      m_ref.timeStamp3 = now;
+    }
+}
+
+void
+TlbPathAgingTestCase::Step (void)
+{
+  TLBPathInfo *path = m_tlb->FindPathInfo (1, 2);
+  NS_TEST_ASSERT_MSG_NE (path, 0, "The path has no information");
+  NS_TEST_EXPECT_MSG_EQ (path->size, m_ref.size, "Wrong size at " << Simulator::Now ());
+  NS_TEST_EXPECT_MSG_EQ (path->ecnSize, m_ref.ecnSize, "Wrong ECN size at " << Simulator::Now ());
+  NS_TEST_EXPECT_MSG_EQ (path->minRtt, m_ref.minRtt, "Wrong min RTT at " << Simulator::Now ());
+  NS_TEST_EXPECT_MSG_EQ (path->isTimeout, m_ref.isTimeout, "Wrong timeout at " << Simulator::Now ());
+  NS_TEST_EXPECT_MSG_EQ (path->isRetransmission, m_ref.isRetransmission,
+                         "Wrong retransmission at " << Simulator::Now ());
+  NS_TEST_EXPECT_MSG_EQ (path->timeStamp1, m_ref.timeStamp1, "Wrong time stamp 1 at " << Simulator::Now ());
+  NS_TEST_EXPECT_MSG_EQ (path->timeStamp2, m_ref.timeStamp2, "Wrong time stamp 2 at " << Simulator::Now ());
+  NS_TEST_EXPECT_MSG_EQ (path->timeStamp3, m_ref.timeStamp3, "Wrong time stamp 3 at " << Simulator::Now ());
+  m_steps++;
+
+  // Update some of the fields, as the packets of the path would
+  uint32_t use = Random ();
+  TLBPathInfo &info = m_tlb->GetPathInfo (1, 2);
+  if (use & 1)
+    {
+      info.size = m_ref.size = m_ref.size + 1500;
+      info.ecnSize = m_ref.ecnSize = m_ref.ecnSize + (use & 2 ? 1500 : 0);
+      info.isTimeout = m_ref.isTimeout = (use & 4) != 0;
+      info.timeStamp1 = m_ref.timeStamp1 = Simulator::Now ();
+    }
+  if (use & 8)
+    {
+      info.isRetransmission = m_ref.isRetransmission = true;
+      info.timeStamp2 = m_ref.timeStamp2 = Simulator::Now ();
+    }
+  if (use & 16)
+    {
+      info.minRtt = m_ref.minRtt = MicroSeconds (20 + (use >> 5) % 400);
+      info.timeStamp3 = m_ref.timeStamp3 = Simulator::Now ();
+    }
+
+  // Short gaps within a round, and long ones over many rounds
+  uint32_t gap = Random ();
+  Time next = gap & 1 ? MicroSeconds ((gap >> 1) % 30 + 1) : MicroSeconds ((gap >> 1) % 4000 + 1);
+  Simulator::Schedule (next, &TlbPathAgingTestCase::Step, this);
+}
+
+void
+TlbPathAgingTestCase::RunMode (bool smooth)
+{
+  m_tlb = CreateObject<Ipv4TLB> ();
+  m_tlb->SetAttribute ("IsSmooth", BooleanValue (smooth));
+  m_tlb->m_T2 = MicroSeconds (1000);
+  m_state = smooth ? 2 : 1;
+  m_resets = 0;
+  m_steps = 0;
+
+  // The uses are 7 ns after a microsecond, never at the time of a round
+  m_tlb->m_agingEvent = Simulator::Schedule (m_tlb->m_agingCheckTime, &Ipv4TLB::PathAging, m_tlb);
+  Simulator::Schedule (m_tlb->m_agingCheckTime, &TlbPathAgingTestCase::ReferenceRound, this);
+  Simulator::Schedule (NanoSeconds (7), &TlbPathAgingTestCase::Start, this);
+  Simulator::Stop (MilliSeconds (400));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_GT (m_steps, 100, "The path was used " << m_steps << " times");
+  NS_TEST_EXPECT_MSG_GT (m_resets, 50, "The path was reset " << m_resets << " times");
+  m_tlb = 0;
+}
+
+void
+TlbPathAgingTestCase::DoRun (void)
+{
+  RunMode (false);
+  RunMode (true);
+}
+
 // The TestSuite class names the TestSuite, identifies what type of TestSuite,
 // and enables the TestCases to be run.  Typically, only the constructor for
 // this class must be defined
@@ -61,6 +458,9 @@ TlbTestSuite::TlbTestSuite ()
 {
   // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
   AddTestCase (new TlbTestCase1, TestCase::QUICK);
+  AddTestCase (new TlbHashMapClusterTestCase, TestCase::QUICK);
+  AddTestCase (new TlbHashMapGrowthTestCase, TestCase::QUICK);
+  AddTestCase (new TlbPathAgingTestCase, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite
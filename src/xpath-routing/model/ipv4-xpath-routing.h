@@ -3,6 +3,7 @@
 #define IPV4_XPATH_ROUTING_H
 
 #include "ns3/ipv4-routing-protocol.h"
+#include "ns3/ipv4-egress-route-cache.h"
 
 #include <map>
 
@@ -34,6 +35,7 @@ public:
 private:
 
   Ptr<Ipv4> m_ipv4;
+  Ptr<Ipv4EgressRouteCache> m_routeCache;
 };
 
 }
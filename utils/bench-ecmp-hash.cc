@@ -0,0 +1,160 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Benchmark the per flow ECMP hash functions of Ipv4GlobalRouting.
+//
+// A switch with n-ports uplinks has one host route per uplink to the same
+// destination.  Every hash function routes the same packets; the program
+// reports the lookup rate and how evenly the flows spread over the uplinks.
+
+#include "ns3/command-line.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/boolean.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/flow-id-tag.h"
+#include "ns3/packet.h"
+#include <iostream>
+#include <vector>
+#include <map>
+#include <cmath>
+#include <stdlib.h> // for exit ()
+
+using namespace ns3;
+
+static void
+runBench (Ptr<Ipv4GlobalRouting> routing, Ptr<Ipv4> ipv4, Ipv4GlobalRouting::EcmpHash_e hash,
+          const std::vector<Ptr<Packet> > &packets, uint32_t n, char const *name)
+{
+  routing->SetAttribute ("EcmpHash", EnumValue (hash));
+
+  Ipv4Header header;
+  header.SetDestination (Ipv4Address ("10.255.0.1"));
+  header.SetTtl (64);
+  Socket::SocketErrno sockerr;
+
+  SystemWallClockMs time;
+  time.Start ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      routing->RouteOutput (packets[i % packets.size ()], header, 0, sockerr);
+    }
+  uint64_t deltaMs = time.End ();
+
+  // Spread: each flow is routed once
+  std::map<Ptr<NetDevice>, uint32_t> flowsPerPort;
+  for (uint32_t i = 1; i < ipv4->GetNInterfaces (); i++)
+    {
+      flowsPerPort[ipv4->GetNetDevice (i)] = 0;
+    }
+  for (uint32_t i = 0; i < packets.size (); i++)
+    {
+      flowsPerPort[routing->RouteOutput (packets[i], header, 0, sockerr)->GetOutputDevice ()]++;
+    }
+  double mean = static_cast<double> (packets.size ()) / flowsPerPort.size ();
+  double variance = 0;
+  uint32_t minFlows = packets.size ();
+  uint32_t maxFlows = 0;
+  for (std::map<Ptr<NetDevice>, uint32_t>::const_iterator it = flowsPerPort.begin (); it != flowsPerPort.end (); it++)
+    {
+      variance += (it->second - mean) * (it->second - mean);
+      minFlows = std::min (minFlows, it->second);
+      maxFlows = std::max (maxFlows, it->second);
+    }
+  variance /= flowsPerPort.size ();
+
+  double ps = n;
+  ps *= 1000;
+  ps /= std::max<uint64_t> (deltaMs, 1);
+  std::cout << ps << " lookups/s"
+            << " (" << deltaMs << " ms elapsed)\t"
+            << "flows per port min " << minFlows << " max " << maxFlows
+            << " cv " << std::sqrt (variance) / mean << "\t"
+            << name
+            << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 0;
+  uint32_t nPorts = 16;
+  uint32_t nFlows = 10000;
+  uint32_t salt = 0;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the per flow ECMP hashes of Ipv4GlobalRouting");
+  cmd.AddValue ("n", "number of lookups", n);
+  cmd.AddValue ("n-ports", "number of ECMP uplinks", nPorts);
+  cmd.AddValue ("n-flows", "number of distinct flows", nFlows);
+  cmd.AddValue ("salt", "per switch salt of the binary hashes", salt);
+  cmd.Parse (argc, argv);
+
+  if (n == 0 || nPorts == 0 || nFlows == 0)
+    {
+      std::cerr << "Error-- number of lookups must be specified " <<
+        "by command-line argument --n=(number of lookups)" << std::endl;
+      exit (1);
+    }
+
+  NodeContainer nodes;
+  nodes.Create (2);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+
+  SimpleNetDeviceHelper devHelper;
+  Ipv4AddressHelper address;
+  address.SetBase ("10.0.0.0", "255.255.255.252");
+  for (uint32_t i = 0; i < nPorts; i++)
+    {
+      address.Assign (devHelper.Install (nodes));
+      address.NewNetwork ();
+    }
+
+  Ptr<Ipv4> ipv4 = nodes.Get (0)->GetObject<Ipv4> ();
+  Ptr<Ipv4GlobalRouting> routing = CreateObject<Ipv4GlobalRouting> ();
+  routing->SetAttribute ("PerflowEcmpRouting", BooleanValue (true));
+  routing->SetAttribute ("EcmpHashSalt", UintegerValue (salt));
+  routing->SetIpv4 (ipv4);
+  for (uint32_t i = 1; i <= nPorts; i++)
+    {
+      routing->AddHostRouteTo (Ipv4Address ("10.255.0.1"), i);
+    }
+
+  std::vector<Ptr<Packet> > packets;
+  for (uint32_t i = 1; i <= nFlows; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (1400);
+      p->AddPacketTag (FlowIdTag (i));
+      packets.push_back (p);
+    }
+
+  std::cout << "Running bench-ecmp-hash with n=" << n << ", " << nPorts
+            << " ports and " << nFlows << " flows" << std::endl;
+
+  runBench (routing, ipv4, Ipv4GlobalRouting::ECMP_HASH_STRING, packets, n, "String");
+  runBench (routing, ipv4, Ipv4GlobalRouting::ECMP_HASH_CRC32, packets, n, "Crc32");
+  runBench (routing, ipv4, Ipv4GlobalRouting::ECMP_HASH_MURMUR3, packets, n, "Murmur3");
+  runBench (routing, ipv4, Ipv4GlobalRouting::ECMP_HASH_TOEPLITZ, packets, n, "Toeplitz");
+
+  return 0;
+}
@@ -21,6 +21,7 @@
 #include "ns3/system-wall-clock-ms.h"
 #include "ns3/packet.h"
 #include "ns3/packet-metadata.h"
+#include "ns3/packet-pool.h"
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -195,6 +196,49 @@ benchD (uint32_t n)
   }
 }
 
+static void 
+benchDcn (uint32_t n)
+{
+  BenchHeader<2> ppp;
+  BenchHeader<20> ipv4;
+  BenchHeader<20> tcp;
+  BenchTag<4> flow;
+  BenchTag<8> path;
+  BenchTag<12> priority;
+  BenchTag<16> timestamp;
+  BenchTag<20> socket;
+
+  // A data segment of a leaf spine fabric: three hops of PPP and IPv4
+  // pops and pushes, with the tags of the load balancers at each hop
+  for (uint32_t i = 0; i < n; i++) {
+    Ptr<Packet> p = Create<Packet> (1400);
+    p->AddPacketTag (socket);
+    p->AddPacketTag (priority);
+    p->AddPacketTag (timestamp);
+    p->AddPacketTag (flow);
+    p->AddHeader (tcp);
+    p->AddHeader (ipv4);
+    p->AddPacketTag (path);
+    p->AddHeader (ppp);
+    for (uint32_t hop = 0; hop < 3; hop++)
+      {
+        Ptr<Packet> q = p->Copy ();
+        q->RemoveHeader (ppp);
+        q->RemoveHeader (ipv4);
+        q->ReplacePacketTag (path);
+        q->RemovePacketTag (priority);
+        q->AddPacketTag (priority);
+        q->AddHeader (ipv4);
+        q->AddHeader (ppp);
+        p = q;
+      }
+    p->RemoveHeader (ppp);
+    p->RemoveHeader (ipv4);
+    p->RemoveHeader (tcp);
+    p->RemoveAllPacketTags ();
+  }
+}
+
 
 
 static void 
@@ -357,8 +401,12 @@ int main (int argc, char *argv[])
   runBench (&benchB, n, minIterations, "Just add headers");
   runBench (&benchC, n, minIterations, "Remove by func call");
   runBench (&benchD, n, minIterations, "Intermixed add/remove headers and tags");
+  runBench (&benchDcn, n, minIterations, "Forward a tagged TCP segment over three hops");
   runBench (&benchFragment, n, minIterations, "Fragmentation and concatenation");
   runBench (&benchByteTags, n, minIterations, "Benchmark byte tags");
 
+  std::cout << "Packet pool of the main thread:" << std::endl;
+  PacketPool::PrintStatistics (std::cout);
+
   return 0;
 }
@@ -21,8 +21,11 @@
 #include <iomanip>
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <string>
 #include <vector>
 #include <string.h>
+#include <stdlib.h>
 
 #include "ns3/core-module.h"
 
@@ -124,12 +127,80 @@ Bench::Cb (void)
 }
 
 
+/*
+ * Read the delays of the events scheduled in a recorded run, from the
+ * NS_LOG output of DefaultSimulatorImpl at level_function, like
+ *
+ *   0.00015395s DefaultSimulatorImpl:ScheduleWithContext(0x..., 4, 11163, 0x...)
+ *
+ * The delays are the third argument of ScheduleWithContext and the second
+ * one of Schedule, in time steps.
+ */
+std::vector<double>
+ReadScheduleLog (std::istream &input)
+{
+  std::vector<double> nsValues;
+  std::string line;
+  while (std::getline (input, line))
+    {
+      std::string::size_type start;
+      uint32_t skip;
+      if ((start = line.find ("DefaultSimulatorImpl:ScheduleWithContext(")) != std::string::npos)
+        {
+          skip = 2;
+        }
+      else if ((start = line.find ("DefaultSimulatorImpl:Schedule(")) != std::string::npos)
+        {
+          skip = 1;
+        }
+      else
+        {
+          continue;
+        }
+      start = line.find ('(', start) + 1;
+      for (uint32_t i = 0; i < skip && start != std::string::npos; i++)
+        {
+          start = line.find (", ", start);
+          if (start != std::string::npos)
+            {
+              start += 2;
+            }
+        }
+      if (start == std::string::npos)
+        {
+          continue;
+        }
+      std::istringstream arg (line.substr (start));
+      uint64_t delay;
+      if (arg >> delay)
+        {
+          nsValues.push_back (delay);
+        }
+    }
+  return nsValues;
+}
+
 Ptr<RandomVariableStream>
-GetRandomStream (std::string filename)
+GetRandomStream (std::string filename, std::string logname)
 {
   Ptr<RandomVariableStream> stream = 0;
   
-  if (filename == "")
+  if (logname != "")
+    {
+      LOGME ("using the event delays recorded in " << logname);
+      std::ifstream input (logname.c_str ());
+      std::vector<double> nsValues = ReadScheduleLog (input);
+      LOGME ("found " << nsValues.size () << " entries");
+      if (nsValues.empty ())
+        {
+          LOGME ("no scheduled event in " << logname);
+          exit (1);
+        }
+      Ptr<DeterministicRandomVariable> drv = CreateObject<DeterministicRandomVariable> ();
+      drv->SetValueArray (&nsValues[0], nsValues.size ());
+      stream = drv;
+    }
+  else if (filename == "")
     {
       LOGME ("using default exponential distribution");
       Ptr<ExponentialRandomVariable> erv = CreateObject<ExponentialRandomVariable> ();
@@ -179,6 +250,52 @@ GetRandomStream (std::string filename)
 
 
 
+void
+RunScheduler (Bench *bench, ObjectFactory factory, uint32_t pop, uint32_t total, uint32_t runs)
+{
+  Simulator::SetScheduler (factory);
+  LOGME ("scheduler: " << factory.GetTypeId ().GetName ());
+
+  // table header
+  LOG ("");
+  LOG (std::left << std::setw (g_fwidth) << "Run #" <<
+       std::left << std::setw (3 * g_fwidth) << "Inititialization:" <<
+       std::left << std::setw (3 * g_fwidth) << "Simulation:");
+  LOG (std::left << std::setw (g_fwidth) << "" <<
+       std::left << std::setw (g_fwidth) << "Time (s)" <<
+       std::left << std::setw (g_fwidth) << "Rate (ev/s)" <<
+       std::left << std::setw (g_fwidth) << "Per (s/ev)" <<
+       std::left << std::setw (g_fwidth) << "Time (s)" <<
+       std::left << std::setw (g_fwidth) << "Rate (ev/s)" <<
+       std::left << std::setw (g_fwidth) << "Per (s/ev)" );
+  LOG (std::setfill ('-') <<
+       std::right << std::setw (g_fwidth) << " " <<
+       std::right << std::setw (g_fwidth) << " " <<       
+       std::right << std::setw (g_fwidth) << " " <<       
+       std::right << std::setw (g_fwidth) << " " <<       
+       std::right << std::setw (g_fwidth) << " " <<       
+       std::right << std::setw (g_fwidth) << " " <<       
+       std::right << std::setw (g_fwidth) << " " <<
+       std::setfill (' ')
+       );
+       
+  // prime
+  DEB ("priming");
+  std::cout << std::left << std::setw (g_fwidth) << "(prime)";
+  bench->RunBench ();
+
+  bench->SetPopulation (pop);
+  bench->SetTotal (total);
+  for (uint32_t i = 0; i < runs; i++)
+    {
+      std::cout << std::setw (g_fwidth) << i;
+      
+      bench->RunBench ();
+    }
+
+}
+
+
 int main (int argc, char *argv[])
 {
 
@@ -186,11 +303,15 @@ int main (int argc, char *argv[])
   bool schedHeap = false;
   bool schedList = false;
   bool schedMap  = true;
+  bool schedDary = false;
+  bool schedWheel = false;
+  bool schedAll  = false;
 
   uint32_t pop   =  100000;
   uint32_t total = 1000000;
   uint32_t runs  =       1;
   std::string filename = "";
+  std::string logname = "";
   
   CommandLine cmd;
   cmd.Usage ("Benchmark the simulator scheduler.\n"
@@ -200,16 +321,29 @@ int main (int argc, char *argv[])
              "  an ascii file, given by the --file=\"<filename>\" argument,\n"
              "  or standard input, by the argument --file=\"-\"\n"
              "In the case of either --file form, the input is expected\n"
-             "to be ascii, giving the relative event times in ns.");
+             "to be ascii, giving the relative event times in ns.\n"
+             "\n"
+             "To replay the event intervals of a recorded run, for example\n"
+             "a data center simulation, run it with\n"
+             "  NS_LOG=\"DefaultSimulatorImpl=level_function\"\n"
+             "and pass its output with --log=\"<filename>\": the delays of\n"
+             "the scheduled events are replayed in order, in time steps.\n"
+             "With --all, the schedulers are compared on the same distribution.\n"
+             "The scheduler attributes can be set on the command line, like\n"
+             "  --ns3::TimingWheelScheduler::BucketWidth=50ns");
   cmd.AddValue ("cal",   "use CalendarSheduler",          schedCal);
   cmd.AddValue ("heap",  "use HeapScheduler",             schedHeap);
   cmd.AddValue ("list",  "use ListSheduler",              schedList);
   cmd.AddValue ("map",   "use MapScheduler (default)",    schedMap);
+  cmd.AddValue ("dary",  "use DaryHeapScheduler",         schedDary);
+  cmd.AddValue ("wheel", "use TimingWheelScheduler",      schedWheel);
+  cmd.AddValue ("all",   "run with each scheduler in turn", schedAll);
   cmd.AddValue ("debug", "enable debugging output",       g_debug);
   cmd.AddValue ("pop",   "event population size (default 1E5)",         pop);
   cmd.AddValue ("total", "total number of events to run (default 1E6)", total);
   cmd.AddValue ("runs",  "number of runs (default 1)",    runs);
   cmd.AddValue ("file",  "file of relative event times",  filename);
+  cmd.AddValue ("log",   "NS_LOG output of a run to replay", logname);
   cmd.AddValue ("prec",  "printed output precision",      g_fwidth);
   cmd.Parse (argc, argv);
   g_me = cmd.GetName () + ": ";
@@ -219,54 +353,38 @@ int main (int argc, char *argv[])
   if (schedCal)  { factory.SetTypeId ("ns3::CalendarScheduler"); }
   if (schedHeap) { factory.SetTypeId ("ns3::HeapScheduler");     }
   if (schedList) { factory.SetTypeId ("ns3::ListScheduler");     }  
-  Simulator::SetScheduler (factory);
+  if (schedDary) { factory.SetTypeId ("ns3::DaryHeapScheduler"); }
+  if (schedWheel) { factory.SetTypeId ("ns3::TimingWheelScheduler"); }
+
+  std::vector<std::string> schedulers;
+  if (schedAll)
+    {
+      schedulers.push_back ("ns3::HeapScheduler");
+      schedulers.push_back ("ns3::MapScheduler");
+      schedulers.push_back ("ns3::ListScheduler");
+      schedulers.push_back ("ns3::CalendarScheduler");
+      schedulers.push_back ("ns3::DaryHeapScheduler");
+      schedulers.push_back ("ns3::TimingWheelScheduler");
+    }
+  else
+    {
+      schedulers.push_back (factory.GetTypeId ().GetName ());
+    }
 
   LOGME (std::setprecision (g_fwidth - 6));
   DEB ("debugging is ON");
 
-  LOGME ("scheduler: " << factory.GetTypeId ().GetName ());
   LOGME ("population: " << pop);
   LOGME ("total events: " << total);
   LOGME ("runs: " << runs);
   
   Bench *bench = new Bench (pop, total);
-  bench->SetRandomStream (GetRandomStream (filename));
-
-  // table header
-  LOG ("");
-  LOG (std::left << std::setw (g_fwidth) << "Run #" <<
-       std::left << std::setw (3 * g_fwidth) << "Inititialization:" <<
-       std::left << std::setw (3 * g_fwidth) << "Simulation:");
-  LOG (std::left << std::setw (g_fwidth) << "" <<
-       std::left << std::setw (g_fwidth) << "Time (s)" <<
-       std::left << std::setw (g_fwidth) << "Rate (ev/s)" <<
-       std::left << std::setw (g_fwidth) << "Per (s/ev)" <<
-       std::left << std::setw (g_fwidth) << "Time (s)" <<
-       std::left << std::setw (g_fwidth) << "Rate (ev/s)" <<
-       std::left << std::setw (g_fwidth) << "Per (s/ev)" );
-  LOG (std::setfill ('-') <<
-       std::right << std::setw (g_fwidth) << " " <<
-       std::right << std::setw (g_fwidth) << " " <<       
-       std::right << std::setw (g_fwidth) << " " <<       
-       std::right << std::setw (g_fwidth) << " " <<       
-       std::right << std::setw (g_fwidth) << " " <<       
-       std::right << std::setw (g_fwidth) << " " <<       
-       std::right << std::setw (g_fwidth) << " " <<
-       std::setfill (' ')
-       );
-       
-  // prime
-  DEB ("priming");
-  std::cout << std::left << std::setw (g_fwidth) << "(prime)";
-  bench->RunBench ();
+  bench->SetRandomStream (GetRandomStream (filename, logname));
 
-  bench->SetPopulation (pop);
-  bench->SetTotal (total);
-  for (uint32_t i = 0; i < runs; i++)
+  for (uint32_t i = 0; i < schedulers.size (); i++)
     {
-      std::cout << std::setw (g_fwidth) << i;
-      
-      bench->RunBench ();
+      factory.SetTypeId (schedulers[i]);
+      RunScheduler (bench, factory, pop, total, runs);
     }
 
   LOG ("");
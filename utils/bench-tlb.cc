@@ -0,0 +1,164 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Benchmark the per segment state of Ipv4TLB.
+//
+// A single Ipv4TLB instance sees n-flows concurrent flows towards n-tors
+// destination ToRs.  Every round, each flow asks for its path, sends a
+// segment and receives its ACK, like TcpSocketBase does; a few flows finish
+// and are replaced by new ones.  The rounds are simulator events, so the
+// path and DRE aging of Ipv4TLB run in between.  The digest of the selected
+// paths only depends on the parameters and the seed.
+
+#include "ns3/command-line.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/simulator.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+#include "ns3/ipv4-tlb.h"
+#include <iostream>
+#include <vector>
+#include <stdlib.h> // for exit ()
+
+using namespace ns3;
+
+struct BenchFlow
+{
+  uint32_t flowId;
+  Ipv4Address daddr;
+};
+
+static uint64_t g_digest = 14695981039346656037ULL;
+static uint64_t g_ops = 0;
+static uint32_t g_nextFlowId = 0;
+
+static void
+Mix (uint32_t value)
+{
+  g_digest = (g_digest ^ value) * 1099511628211ULL;
+}
+
+static void
+RunRound (Ptr<Ipv4TLB> tlb, std::vector<BenchFlow> *flows, Ipv4Address saddr,
+          uint32_t round, uint32_t finishEvery)
+{
+  for (uint32_t i = 0; i < flows->size (); i++)
+    {
+      BenchFlow &flow = (*flows)[i];
+      uint32_t path = tlb->GetPath (flow.flowId, saddr, flow.daddr);
+      tlb->FlowSend (flow.flowId, flow.daddr, path, 1400, (i + round) % 97 == 0);
+      tlb->FlowRecv (flow.flowId, path, flow.daddr, 1400, (i + round) % 5 == 0,
+                     MicroSeconds (40 + (path * 7 + round) % 50));
+      uint32_t ackPath = tlb->GetAckPath (flow.flowId, flow.daddr, saddr);
+      Mix (path);
+      Mix (ackPath);
+      g_ops += 4;
+      if (finishEvery != 0 && (i + round) % finishEvery == 0)
+        {
+          tlb->FlowFinish (flow.flowId, flow.daddr);
+          flow.flowId = g_nextFlowId++;
+          g_ops++;
+        }
+    }
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t nFlows = 100000;
+  uint32_t nTors = 16;
+  uint32_t nHosts = 16;
+  uint32_t nPaths = 8;
+  uint32_t nRounds = 20;
+  uint32_t interval = 100;
+  uint32_t finishEvery = 50;
+  uint32_t runMode = 0;
+  bool reroute = true;
+  uint32_t seed = 1;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the per segment state of Ipv4TLB with many concurrent flows");
+  cmd.AddValue ("n-flows", "number of concurrent flows", nFlows);
+  cmd.AddValue ("n-tors", "number of destination ToRs", nTors);
+  cmd.AddValue ("n-hosts", "number of hosts per ToR", nHosts);
+  cmd.AddValue ("n-paths", "number of paths per ToR", nPaths);
+  cmd.AddValue ("n-rounds", "number of rounds, each flow sends one segment per round", nRounds);
+  cmd.AddValue ("interval", "time between two rounds, in microseconds", interval);
+  cmd.AddValue ("finish-every", "one flow in finish-every is replaced per round, 0 for none", finishEvery);
+  cmd.AddValue ("run-mode", "RunMode attribute of Ipv4TLB", runMode);
+  cmd.AddValue ("reroute", "Rerouting attribute of Ipv4TLB", reroute);
+  cmd.AddValue ("seed", "seed of rand ()", seed);
+  cmd.Parse (argc, argv);
+
+  if (nFlows == 0 || nTors == 0 || nHosts == 0 || nPaths == 0 || nTors > 254 || nHosts > 254)
+    {
+      std::cerr << "Error-- the numbers of flows, paths, ToRs and hosts must be positive, "
+                << "with at most 254 ToRs and hosts per ToR" << std::endl;
+      exit (1);
+    }
+  srand (seed);
+
+  Ptr<Ipv4TLB> tlb = CreateObject<Ipv4TLB> ();
+  tlb->SetAttribute ("RunMode", UintegerValue (runMode));
+  tlb->SetAttribute ("Rerouting", BooleanValue (reroute));
+
+  // ToR 0 is the local one, the flows go to the hosts of the others
+  for (uint32_t tor = 0; tor <= nTors; tor++)
+    {
+      for (uint32_t host = 1; host <= nHosts; host++)
+        {
+          tlb->AddAddressWithTor (Ipv4Address ((10U << 24) | (tor << 16) | (host << 8) | 1), tor);
+        }
+      for (uint32_t path = 0; path < nPaths; path++)
+        {
+          tlb->AddAvailPath (tor, path * 256 + tor);
+        }
+    }
+  Ipv4Address saddr = Ipv4Address ((10U << 24) | (1 << 8) | 1);
+
+  std::vector<BenchFlow> flows (nFlows);
+  for (uint32_t i = 0; i < nFlows; i++)
+    {
+      uint32_t tor = 1 + i % nTors;
+      uint32_t host = 1 + (i / nTors) % nHosts;
+      flows[i].flowId = i + 1;
+      flows[i].daddr = Ipv4Address ((10U << 24) | (tor << 16) | (host << 8) | 1);
+    }
+  g_nextFlowId = nFlows + 1;
+
+  for (uint32_t round = 0; round < nRounds; round++)
+    {
+      Simulator::Schedule (MicroSeconds (interval) * round, &RunRound, tlb, &flows, saddr,
+                           round, finishEvery);
+    }
+  Simulator::Stop (MicroSeconds (interval) * nRounds);
+
+  std::cout << "Running bench-tlb with " << nFlows << " flows, " << nTors << " ToRs, "
+            << nPaths << " paths and " << nRounds << " rounds" << std::endl;
+
+  SystemWallClockMs time;
+  time.Start ();
+  Simulator::Run ();
+  uint64_t deltaMs = time.End ();
+  Simulator::Destroy ();
+
+  double ps = g_ops;
+  ps *= 1000;
+  ps /= std::max<uint64_t> (deltaMs, 1);
+  std::cout << ps << " calls/s (" << g_ops << " calls in " << deltaMs << " ms)\t"
+            << "digest " << g_digest << std::endl;
+
+  return 0;
+}